@@ -6,11 +6,14 @@
 #include "base_def.h"
 #include "common_def.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
 #include <memory>
+#include <functional>
 
 // Forward declarations (global namespace)
 class normal_msg;
@@ -75,22 +78,69 @@ struct HttpRequest {
         return it != headers.end() ? it->second : std::string();
     }
 
-    // 解析 query 参数（简单实现）
+    // 取 query 参数(未解码), 在 url 上原地逐项比对参数名; 同一请求要取多个时用 HttpRouter 的 HttpRouteParams::query
     std::string query_param(const std::string& name) const {
-        size_t query_pos = url.find('?');
-        if (query_pos == std::string::npos) return std::string();
-
-        std::string query = url.substr(query_pos + 1);
-        std::string search = name + "=";
-        size_t pos = query.find(search);
+        size_t pos = url.find('?');
         if (pos == std::string::npos) return std::string();
 
-        size_t start = pos + search.length();
-        size_t end = query.find('&', start);
-        if (end == std::string::npos) end = query.length();
+        const char* p = url.data() + pos + 1;
+        const char* end = url.data() + url.size();
+        while (p < end) {
+            const char* amp = static_cast<const char*>(memchr(p, '&', end - p));
+            if (!amp) amp = end;
+            size_t n = name.size();
+            if ((size_t)(amp - p) >= n && memcmp(p, name.data(), n) == 0 && (p + n == amp || p[n] == '=')) {
+                const char* v = p + n == amp ? amp : p + n + 1;
+                return std::string(v, amp - v);
+            }
+            if (amp == end) break;
+            p = amp + 1;
+        }
+        return std::string();
+    }
+};
+
+// 流式 body 的公共部分: 框架持有期间绑定的恢复入口
+class HttpBodyStream {
+public:
+    virtual ~HttpBodyStream() {}
 
-        return query.substr(start, end - start);
+    // 暂停后可以继续时调用, 须在连接所在线程(如 handle_msg/handle_timeout 里); 框架已释放时什么也不做
+    void resume() {
+        // 恢复过程中框架可能处理完并解绑, 先拷一份再调
+        std::function<void()> fn = _resume;
+        if (fn) fn();
     }
+
+    // 框架内部使用: 持有期间绑定恢复入口
+    void bind_resume(std::function<void()> fn) { _resume = std::move(fn); }
+
+private:
+    std::function<void()> _resume;
+};
+
+// 拉取式响应体(可选): body 不必在内存里攒齐, 连接可写时框架才来取下一段
+// - pull 往 out 追加不超过 max 字节: MORE 还有后续; WAIT 暂时没有, 有数据后调 resume();
+//   DONE 结束(本次追加的照常发出)
+// - HTTP/1 按 chunked 编码发送(业务自己设了 Content-Length 时原样发送, HTTP/1.0 客户端发完关闭连接);
+//   HTTP/2 在流量控制窗口内按 DATA 帧发送
+// - 连接关闭或流被重置时 source 直接释放, 不会再被调用
+class HttpBodySource : public HttpBodyStream {
+public:
+    enum { MORE = 0, WAIT = 1, DONE = 2 };
+
+    virtual int pull(std::string& out, size_t max) = 0;
+};
+
+// 用回调当 source: gen(out, max) 的约定同 HttpBodySource::pull
+class HttpBodyGenerator : public HttpBodySource {
+public:
+    explicit HttpBodyGenerator(std::function<int(std::string&, size_t)> gen) : _gen(std::move(gen)) {}
+
+    int pull(std::string& out, size_t max) override { return _gen(out, max); }
+
+private:
+    std::function<int(std::string&, size_t)> _gen;
 };
 
 // HTTP 响应对象
@@ -100,7 +150,27 @@ struct HttpResponse {
     std::map<std::string, std::string> headers;
     std::string body;
 
-    HttpResponse() : status(200), reason("OK") {}
+    // 非空时 body 由 stream 拉取产生, 忽略 body 字段
+    std::shared_ptr<HttpBodySource> stream;
+
+    // 非空时发送这个共享缓冲区(不拷贝, 可以同时发给多个连接), 忽略 body 字段; 压缩缓存命中时由框架填上
+    std::shared_ptr<const std::string> shared_body;
+
+    // 非空时压缩结果按这个 key 缓存(如 "snapshot:/api/quotes"), 同样的 body 只压缩一次; 见 http_compress.h
+    // 缓存按 body 长度和 compress_version 校验, 不看内容: body 变了业务要换一个 compress_version(如快照序号)
+    std::string compress_key;
+    uint64_t compress_version;
+
+    // 大于 0 时响应进 HTTP/1 响应缓存, 有效 cache_ttl_ms, 过期后 cache_stale_ms 内先返回旧的再刷新; 见 http_response_cache.h
+    uint32_t cache_ttl_ms;
+    uint32_t cache_stale_ms;
+
+    HttpResponse() : status(200), reason("OK"), compress_version(0), cache_ttl_ms(0), cache_stale_ms(0) {}
+
+    // 要发送的 body: shared_body 或 body
+    std::string_view body_view() const {
+        return shared_body ? std::string_view(*shared_body) : std::string_view(body);
+    }
 
     // 便捷方法
     void set_header(const std::string& name, const std::string& value) {
@@ -125,6 +195,33 @@ struct HttpResponse {
         headers["Content-Type"] = "text/plain; charset=utf-8";
         body = text_body;
     }
+
+    void set_stream(std::shared_ptr<HttpBodySource> source) {
+        stream = std::move(source);
+    }
+
+    void set_cache(uint32_t ttl_ms, uint32_t stale_ms = 0) {
+        cache_ttl_ms = ttl_ms;
+        cache_stale_ms = stale_ms;
+    }
+
+    // 返回包装好的 source, 长轮询等 WAIT 的场景用它 resume()
+    std::shared_ptr<HttpBodySource> set_generator(std::function<int(std::string&, size_t)> gen) {
+        stream = std::make_shared<HttpBodyGenerator>(std::move(gen));
+        return stream;
+    }
+};
+
+// 流式请求体(可选): 大 body 不在内存里攒齐, 边收边交给业务
+// - on_body_chunk 返回收下的字节数; 少于 len 时框架暂停读这个请求
+//   (HTTP/1 停止监听可读, HTTP/2 不再给对端发 WINDOW_UPDATE), 没收下的部分在 resume() 后重新交付
+// - body 收完调用 on_body_end 填响应, 此时 req.body 为空
+// - 连接关闭或流被重置时 sink 直接释放, 不会调用 on_body_end
+class HttpBodySink : public HttpBodyStream {
+public:
+    virtual size_t on_body_chunk(const char* data, size_t len) = 0;
+
+    virtual void on_body_end(const HttpRequest& req, HttpResponse& res) = 0;
 };
 
 // ============================================================================
@@ -230,6 +327,14 @@ public:
         res.set_text("HTTP handler not implemented");
     }
 
+    // 流式请求体 - 子类可选实现
+    // 请求带 body 时, 头部收完先调用; 返回 sink 则 body 逐段交给它, 由 sink 的 on_body_end 代替 on_http
+    // 返回 nullptr(默认)时照旧收齐整个 body 再调 on_http
+    virtual std::shared_ptr<HttpBodySink> on_body_begin(const HttpRequest& req) {
+        (void)req;
+        return nullptr;
+    }
+
     // WebSocket 处理 - 子类可选实现
     virtual void on_ws(const WsFrame& recv, WsFrame& send) {
         send = WsFrame::text("WebSocket handler not implemented");
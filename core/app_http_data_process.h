@@ -2,81 +2,98 @@
 
 #include "http_base_data_process.h"
 #include "app_handler_v2.h"
+#include "http_body_sink.h"
+#include "http_response_head.h"
+#include "http_compress.h"
+#include "http_response_cache.h"
+#include "http_base_process.h"
 
 class app_http_data_process : public http_base_data_process {
 public:
     app_http_data_process(http_base_process* p, myframe::IApplicationHandler* h)
         : http_base_data_process(p), _handler(h), _head_ready(false), _body_ready(false) {}
 
-    virtual void header_recv_finish() override {}
+    virtual void header_recv_finish() override {
+        // 带 body 的请求先问业务要不要流式接收
+        if (!_handler || !_base_process->has_request_body()) return;
+        myframe::HttpRequest req;
+        build_request(req);
+        std::shared_ptr<myframe::HttpBodySink> sink;
+        {
+            myframe::detail::HandlerContextScope scope(this);
+            sink = _handler->on_body_begin(req);
+        }
+        if (!sink) return;
+        _stream_req = std::move(req);
+        http_base_process* process = _base_process;
+        _sink.reset(std::move(sink), [process]() { process->resume_body(); });
+    }
     virtual size_t process_recv_body(const char* buf, size_t len, int& result) override {
-        // 仅累积，由 http_res_process 判定 Content-Length 并设置 result
-        if (buf && len) _body.append(buf, len);
+        // 仅累积(或交给 sink)，由 http_res_process 判定 Content-Length 并设置 result
         result = 0;
+        if (_sink) {
+            if (!len) return 0;
+            size_t took;
+            {
+                myframe::detail::HandlerContextScope scope(this);
+                took = _sink.get()->on_body_chunk(buf, len);
+            }
+            if (took > len) took = len;
+            // 没收下的留在接收缓冲, sink 调 resume() 后再交付
+            if (took < len) _base_process->pause_body();
+            return took;
+        }
+        if (buf && len) _body.append(buf, len);
         return len;
     }
     virtual void msg_recv_finish() override {
-        // 组装 HttpRequest -> 调用 handler -> 生成响应缓存
-        myframe::HttpRequest req;
-        auto& rh = _base_process->get_req_head_para();
-        req.method = rh._method;
-        req.url = rh._url_path;
-        req.version = rh._version;
-        for (auto it = rh._headers.begin(); it != rh._headers.end(); ++it) {
-            req.headers[it->first] = it->second;
-        }
-        // 注入对端地址到请求头，方便上层读取真实客户端IP/端口
-        if (auto conn = get_base_net()) {
-            auto& addr = conn->get_peer_addr();
-            if (!addr.ip.empty()) {
-                req.headers["X-Remote-IP"] = addr.ip;
-                req.headers["X-Remote-Port"] = std::to_string(addr.port);
+        // 响应缓存命中(或挂起等别的线程的结果)时不调 handler
+        if (!_sink && _handler && _cache.lookup(_base_process, this) != myframe::http_cache_session::PASS) {
+            if (_cache.need_refresh()) {
+                myframe::HttpRequest req;
+                build_request(req);
+                _cache.refresh(this, std::move(req),
+                               _base_process->get_req_head_para().header_view(myframe::HDR_ACCEPT_ENCODING));
             }
+            return;
         }
-        req.body.swap(_body);
-
-        myframe::HttpResponse rsp;
-        if (_handler) {
-            myframe::detail::HandlerContextScope scope(this);
-            _handler->on_http(req, rsp);
-        } else {
-            rsp.status = 200; rsp.reason = "OK";
-            rsp.set_header("Content-Type", "text/plain");
-            rsp.body = "OK";
-        }
-
-        // 生成发送头
-        if (rsp.headers.find("Content-Length") == rsp.headers.end()) {
-            rsp.headers["Content-Length"] = std::to_string(rsp.body.size());
-        }
-        if (rsp.headers.find("Connection") == rsp.headers.end()) {
-            rsp.headers["Connection"] = "close";
-        }
-
-        _p_head.reset(new std::string);
-        *_p_head += "HTTP/1.1 ";
-        *_p_head += std::to_string(rsp.status);
-        *_p_head += " ";
-        *_p_head += rsp.reason;
-        *_p_head += "\r\n";
-        for (auto it = rsp.headers.begin(); it != rsp.headers.end(); ++it) {
-            *_p_head += it->first; *_p_head += ": "; *_p_head += it->second; *_p_head += "\r\n";
-        }
-        *_p_head += "\r\n";
-        _head_ready = true;
-
-        _p_body.reset(new std::string); _p_body->swap(rsp.body);
-        _body_ready = true;
+        respond();
     }
     virtual std::string* get_send_head() override {
+        if (std::string* head = _cache.take_head()) return head;
         if (!_head_ready || !_p_head) return 0;
         _head_ready = false; return _p_head.release();
     }
+    virtual bool get_send_body_shared(myframe::shared_buffer& buf) override {
+        if (_cache.take_body(buf)) return true;
+        if (!_shared_body) return false;
+        buf = std::move(_shared_body);
+        return true;
+    }
     virtual std::string* get_send_body(int& result) override {
+        if (_pump) {
+            bool done;
+            std::string* p;
+            {
+                myframe::detail::HandlerContextScope scope(this);
+                p = _pump.pull(done);
+            }
+            result = done ? 1 : 0;
+            return p;
+        }
         if (!_body_ready || !_p_body) { result = 1; return 0; }
         _body_ready = false; result = 1; return _p_body.release();
     }
+    virtual bool streaming_response() const override { return (bool)_pump; }
     void handle_msg(std::shared_ptr<normal_msg>& msg) override {
+        if (msg && msg->_msg_op == myframe::HTTP_CACHE_FILL_MSG_OP) {
+            // 别的线程取完了, 再查一次; 还是没有就自己调 handler
+            if (!async_response_pending()) return;
+            if (_cache.lookup(_base_process, this, false) == myframe::http_cache_session::PASS) respond();
+            complete_async_response();
+            return;
+        }
+        if (myframe::http_cache_session::handle_refresh(msg, _handler, this)) return;
         if (_handler) {
             myframe::detail::HandlerContextScope scope(this);
             _handler->handle_thread_msg(msg);
@@ -90,10 +107,94 @@ public:
     }
 
 private:
+    // 组装 HttpRequest -> 调用 handler -> 生成响应
+    void respond() {
+        myframe::HttpRequest req;
+        if (_sink) {
+            req = std::move(_stream_req);
+        } else {
+            build_request(req);
+            req.body.swap(_body);
+        }
+
+        myframe::HttpResponse rsp;
+        if (_handler) {
+            myframe::detail::HandlerContextScope scope(this);
+            if (_sink) _sink.get()->on_body_end(req, rsp);
+            else _handler->on_http(req, rsp);
+        } else {
+            rsp.status = 200; rsp.reason = "OK";
+            rsp.set_header("Content-Type", "text/plain");
+            rsp.body = "OK";
+        }
+        _sink.reset();
+
+        // 客户端接受时压缩(gzip/deflate)
+        myframe::http_compress_response(
+            _base_process->get_req_head_para().header_view(myframe::HDR_ACCEPT_ENCODING), rsp);
+        // 业务要求缓存的响应存进缓存, 这次也从缓存发出
+        if (_cache.store(_base_process, rsp)) return;
+
+        // 生成发送头
+        bool chunked = false;
+        if (rsp.stream) {
+            chunked = _base_process->prepare_stream_headers(rsp.headers);
+        }
+        _base_process->fill_connection_header(rsp.headers);
+
+        _p_head.reset(myframe::http_response_head(rsp.status, rsp.reason, rsp.headers,
+                                                  rsp.stream ? -1 : (int64_t)rsp.body_view().size()));
+        _head_ready = true;
+
+        if (rsp.stream) {
+            _pump.reset(std::move(rsp.stream), chunked, [this]() { resume_send_body(); });
+            return;
+        }
+        if (rsp.shared_body) { _shared_body = std::move(rsp.shared_body); return; }
+        _p_body.reset(new std::string); _p_body->swap(rsp.body);
+        _body_ready = true;
+    }
+
+    void build_request(myframe::HttpRequest& req) {
+        auto& rh = _base_process->get_req_head_para();
+        req.method = rh._method;
+        req.url = rh._url_path;
+        req.version = rh._version;
+        if (rh._parsed && !rh._headers_built) {
+            // 直接从解析结果填, 不经过 _headers 中转
+            for (size_t i = 0; i < rh._parsed->header_count(); ++i) {
+                std::string_view n = rh._parsed->header_name(i);
+                std::string_view v = rh._parsed->header_value(i);
+                req.headers.emplace(std::string(n.data(), n.size()), std::string(v.data(), v.size()));
+            }
+        } else {
+            for (auto it = rh._headers.begin(); it != rh._headers.end(); ++it) {
+                req.headers[it->first] = it->second;
+            }
+        }
+        // 注入对端地址到请求头，方便上层读取真实客户端IP/端口
+        if (auto conn = get_base_net()) {
+            auto& addr = conn->get_peer_addr();
+            if (!addr.ip.empty()) {
+                req.headers["X-Remote-IP"] = addr.ip;
+                req.headers["X-Remote-Port"] = std::to_string(addr.port);
+            }
+        }
+    }
+
     myframe::IApplicationHandler* _handler;
     std::string _body;
+    // 响应缓存的命中/存入状态
+    myframe::http_cache_session _cache;
+    // 流式接收时的 sink 和头部收完时组好的请求
+    myframe::body_sink_holder _sink;
+    myframe::HttpRequest _stream_req;
+    // 拉取式响应体
+    myframe::body_source_pump _pump;
     std::unique_ptr<std::string> _p_head;
     std::unique_ptr<std::string> _p_body;
+    // 响应体是共享缓冲区时(如压缩缓存命中)按引用发出
+    myframe::shared_buffer _shared_body;
     bool _head_ready;
     bool _body_ready;
 };
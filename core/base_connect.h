@@ -7,9 +7,11 @@
 
 #include "common_exception.h"
 #include "common_epoll.h"
+#include "io_engine.h"
 #include "codec.h"
 #include "protocol_detect_process.h"
 #include "string_pool.h"
+#include "recv_buffer.h"
 #include <algorithm>
 #include <memory>
 #include <deque>
@@ -26,16 +28,18 @@ class base_connect:public base_net_obj
             _fd = sock;
             int bReuseAddr = 1;
             setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &bReuseAddr, sizeof(bReuseAddr));
-            _p_send_buf.reset();
             _process.reset();
             get_peer_addr();
+            if (common_epoll::edge_triggered_default())
+                set_edge_triggered(true);
         }
 
         base_connect()
             : _peek_drain_backlog(0)
         {
-            _p_send_buf.reset();
             _process.reset();
+            if (common_epoll::edge_triggered_default())
+                set_edge_triggered(true);
         }
 
         virtual ~base_connect()
@@ -65,12 +69,24 @@ class base_connect:public base_net_obj
                 if (_codec) { _codec->on_writable_event(); }
                 touch_active(GetMilliSecond());
                 real_send();
-            }	
+            }
+
+            // codec 还有不依赖 epoll 事件的推进工作(如 TLS 握手), 挂入就绪链表下一轮再 tick
+            if (_codec && _codec->poll_events_hint() != 0)
+            {
+                request_tick();
+            }
         }
         virtual int real_net_process()
         {
             int32_t ret = 0;
 
+            if (_recv_resume) {
+                _recv_resume = false;
+                if (!_recv_buf.empty() && _process && _process->want_recv())
+                    process_recv_data(false);
+            }
+
             if ((get_event() & EPOLLIN) == EPOLLIN) {
                 PDEBUG("real_net_process real_recv");
                 // Only force process when codec explicitly needs it (e.g., TLS handshake write→read)
@@ -124,6 +140,19 @@ class base_connect:public base_net_obj
         {
             if (t_msg->_timer_type == DELAY_CLOSE_TIMER_TYPE) 
             {
+                // 已排队的数据(如流水线里 close 请求之前的响应)先发完再关, 对端不读时最多等 CLOSE_LINGER_MS
+                const uint32_t CLOSE_LINGER_MS = 1000;
+                const uint32_t CLOSE_RETRY_MS = 5;
+                if (send_pending() && _close_linger_ms < CLOSE_LINGER_MS)
+                {
+                    _close_linger_ms += CLOSE_RETRY_MS;
+                    std::shared_ptr<timer_msg> retry(new timer_msg);
+                    retry->_obj_id = t_msg->_obj_id;
+                    retry->_timer_type = DELAY_CLOSE_TIMER_TYPE;
+                    retry->_time_length = CLOSE_RETRY_MS;
+                    add_timer(retry);
+                    return;
+                }
                 THROW_COMMON_EXCEPT("the connect obj delay close, delete it");
             }
             else if (t_msg->_timer_type == NONE_DATA_TIMER_TYPE) 
@@ -139,11 +168,108 @@ class base_connect:public base_net_obj
             _process->handle_msg(p_msg);
         }
 
+        virtual void pause_recv() override
+        {
+            if (_recv_paused)
+                return;
+            // 去掉 EPOLLIN: 水平触发下不会因为内核里有数据而空转, io_uring 下取消 multishot recv
+            _recv_paused = true;
+            update_event(get_event() & ~EPOLLIN);
+        }
+
+        virtual void resume_recv() override
+        {
+            if (_recv_paused)
+            {
+                _recv_paused = false;
+                update_event(get_event() | EPOLLIN);
+            }
+            if (_recv_buf.empty())
+                return;
+            _recv_resume = true;
+            request_tick();
+        }
+
         virtual bool wants_tick() const override {
+            if (_recv_resume) return true;
             if (_codec && _codec->poll_events_hint() != 0) return true;
+            if (_et_recv_more) return true;
             return (_epoll_event & EPOLLOUT) == EPOLLOUT;
         }
 
+        // io_uring 引擎: 明文连接走 multishot recv + 异步 sendmsg; TLS/自定义编解码和协议探测(peek)阶段走 poll
+        virtual int io_caps() const override
+        {
+            if (_codec || !_process)
+                return 0;
+            int caps = IO_CAP_SEND;
+            if (_peek_drain_backlog == 0 && !_process->want_peek() && _process->want_recv()
+                    && _recv_buf.length() < (size_t)MAX_RECV_SIZE)
+                caps |= IO_CAP_RECV;
+            return caps;
+        }
+
+        virtual void on_io_recv(const char * buf, size_t len) override
+        {
+            if (!len)
+            {
+                _process->notify_peer_close();
+                THROW_COMMON_EXCEPT("the client close the socket(" << _fd << ")");
+            }
+
+            touch_active(GetMilliSecond());
+            if (_recv_buf.empty() && _process->want_recv())
+            {
+                // 没有残留数据时直接解析引擎的接收缓冲, 只把没消费完的尾巴拷进 _recv_buf
+                size_t p_ret = _process->process_recv_buf(buf, len);
+                if (p_ret < len)
+                    _recv_buf.append(buf + p_ret, len - p_ret);
+                return;
+            }
+
+            _recv_buf.append(buf, len);
+            // 协议暂时不收时先留在 _recv_buf, 等 want_recv 恢复后由 tick 处理
+            if (_process->want_recv())
+                process_recv_data(false);
+        }
+
+        virtual void on_io_send(std::unique_ptr<io_send_req> & req, int res) override
+        {
+            _io_send_inflight = false;
+            if (res < 0 && res != -EAGAIN)
+            {
+                THROW_COMMON_EXCEPT("send data error " << strError(-res).c_str());
+            }
+
+            size_t left = res > 0 ? (size_t)res : 0;
+            if (left > 0) touch_active(GetMilliSecond());
+
+            // 没发完的部分按原顺序放回发送队列头部
+            size_t rest = 0;
+            std::vector<myframe::send_slice> & bufs = req->bufs;
+            size_t first = 0;
+            while (first < bufs.size() && left >= bufs[first].size())
+            {
+                left -= bufs[first].size();
+                first++;
+            }
+            if (first < bufs.size())
+                bufs[first].advance(left);
+            for (size_t i = bufs.size(); i > first; i--)
+            {
+                _send_queue.push_front(std::move(bufs[i - 1]));
+                rest++;
+            }
+
+            if (rest)
+                update_event(get_event() | EPOLLOUT); // 套接字写满, 等可写再续发
+            else
+                real_send();
+
+            if (!_recv_buf.empty() && _process->want_recv())
+                request_tick();
+        }
+
     protected:
         virtual int RECV(void *buf, size_t len)
         {
@@ -237,16 +363,30 @@ class base_connect:public base_net_obj
             // that may still need read events (e.g., TLS handshake), skip.
             if (_process && !_process->want_recv() && !_codec) {
                 // Protocol not ready to receive (e.g., HTTP client still sending)
+                // 边缘触发下这次事件不会再来, 记下内核里可能还有数据
+                if (edge_triggered()) _et_recv_more = true;
+                return;
+            }
+            if (io_recv_owned()) {
+                // io_uring 的 multishot recv 持有 fd 的读取, 这里只处理已交付的数据
+                process_recv_data(flag);
                 return;
             }
             size_t _recv_buf_len = _recv_buf.length();
-            size_t tmp_len = MAX_RECV_SIZE - _recv_buf_len; 	
             ssize_t ret = 0;
-            size_t p_ret = 0;
-            if (tmp_len > 0) //接收缓冲满了也可以先不接收
+            // 水平触发每次只读一块; 边缘触发读到 EAGAIN 或用完本次预算
+            size_t budget = edge_triggered() ? common_epoll::edge_io_budget() : 0;
+            size_t total = 0;
+            bool drained = false;
+            while (_recv_buf_len < (size_t)MAX_RECV_SIZE) //接收缓冲满了也可以先不接收
             {
-                char t_buf[SIZE_LEN_32768];
-                int r_len = tmp_len <= sizeof(t_buf) ? (int)tmp_len:(int)sizeof(t_buf);
+                // 直接读进接收缓冲的空闲区
+                size_t tmp_len = MAX_RECV_SIZE - _recv_buf_len;
+                _recv_buf.reserve(tmp_len < (size_t)SIZE_LEN_32768 ? tmp_len : (size_t)SIZE_LEN_32768);
+                if (tmp_len > _recv_buf.writable())
+                    tmp_len = _recv_buf.writable();
+                int r_len = (int)tmp_len;
+                char * t_buf = _recv_buf.write_ptr();
 
                 // During protocol detection (pre-TLS), peek bytes so we don't consume
                 // the ClientHello before SSL_accept can read it. Once over TLS, do not peek.
@@ -268,27 +408,45 @@ class base_connect:public base_net_obj
                 }
 
                 if (ret > 0){
-                    _recv_buf.append(t_buf, ret);
+                    _recv_buf.commit(ret);
                     _recv_buf_len += ret;
+                    total += ret;
                     touch_active(GetMilliSecond());
                     if (did_peek) {
                         _peek_drain_backlog += peek_len;
                     }
                 }
+
+                // 明文短读说明内核缓冲已空; TLS 一次只交出一个 record, 要读到 EAGAIN
+                if (ret <= 0 || (!_codec && !did_peek && ret < r_len)) {
+                    drained = true;
+                    break;
+                }
+                if (!budget || did_peek || total >= budget) {
+                    break;
+                }
             }
 
+            process_recv_data(flag);
+
+            if (edge_triggered()) {
+                _et_recv_more = !drained;
+                // 没读空又不会再有新的边沿: 能继续读时挂到就绪链表, 下一轮接着读
+                if (_et_recv_more && can_recv_more()) {
+                    request_tick();
+                }
+            }
+        }
+
+        void process_recv_data(bool flag)
+        {
+            size_t _recv_buf_len = _recv_buf.length();
+            size_t p_ret = 0;
             if (_recv_buf_len > 0 || flag)
             {
                 PDEBUG("process_recv_buf _recv_buf_len[%zu] fd[%d], flag[%d]", _recv_buf_len, _fd, flag);
                 p_ret = _process->process_recv_buf(_recv_buf.data(), _recv_buf_len);
-                if (p_ret && p_ret <= _recv_buf_len)
-                {
-                    _recv_buf.erase(0, p_ret); 
-                }
-                else if (p_ret > _recv_buf_len)
-                {
-                    _recv_buf.erase(0, _recv_buf_len); 
-                }
+                _recv_buf.consume(p_ret);
                 if (p_ret > 0 && _peek_drain_backlog > 0) {
                     size_t need = std::min(_peek_drain_backlog, static_cast<size_t>(p_ret));
                     size_t flushed = drain_peek_bytes(need);
@@ -297,103 +455,189 @@ class base_connect:public base_net_obj
             }        
 
             PDEBUG("process_recv_buf _recv_buf[%zu] ip[%s] flag[%d]", _recv_buf.length(), _peer_net.ip.c_str(), flag);
+            // 读空了就把内存块还给线程的块池
+            _recv_buf.shrink();
         }
 
         void real_send()
         {
-            // If SSL or custom codec is installed, fall back to single-buffer SEND path
-            if (_codec) {
-                int i = 0;
-                while (1) {
-                    if (i >= MAX_SEND_NUM) break;
-                    if (!_p_send_buf) {
-                        std::string* next = _process->get_send_buf();
-                        if (next) _p_send_buf.reset(next);
-                    }
-                    if (!_p_send_buf) { update_event(get_event() & ~EPOLLOUT); break; }
-                    i++;
-                    size_t len = _p_send_buf->length();
-                    if (len) {
-                        ssize_t ret = SEND(_p_send_buf->c_str(), len);
-                        if (ret == (ssize_t)len) { _p_send_buf.reset(); }
-                        else if (ret > 0) { _p_send_buf->erase(0, ret); PDEBUG("_p_send_buf erase %zd", ret); }
-                    }
-                    if (_p_send_buf && !_p_send_buf->length()) { _p_send_buf.reset(); }
-                }
-                return;
+            io_engine * engine = _p_net_container ? _p_net_container->get_io_engine() : NULL;
+            if (engine && engine->async_send() && (io_caps() & IO_CAP_SEND))
+            {
+                if (send_async(engine))
+                    return;
             }
 
-            // Aggregated writev path (plain TCP)
-            const int MAX_IOV = 16;
-            const size_t MAX_BATCH = 64 * 1024; // 64KB per batch
-            // Ensure we have a current buffer
-            if (!_p_send_buf) {
-                if (auto* next = _process->get_send_buf()) {
-                    _p_send_buf.reset(next);
+            // 水平触发每次事件发一批; 边缘触发写到 EAGAIN 或用完本次预算
+            size_t budget = edge_triggered() ? common_epoll::edge_io_budget() : 0;
+            size_t total = 0;
+            for (;;)
+            {
+                bool blocked = false;
+                ssize_t n = _codec ? send_codec_batch(blocked) : send_iov_batch(blocked);
+                if (n <= 0 || blocked || !budget)
+                    break;
+
+                total += n;
+                if (total >= budget)
+                {
+                    // 套接字仍可写, 不会再来 EPOLLOUT 边沿, 交给下一轮 tick
+                    if ((get_event() & EPOLLOUT) == EPOLLOUT)
+                        request_tick();
+                    break;
                 }
             }
-            if (!_p_send_buf && _pending_send.empty()) {
+
+            // 发送完成后协议可能重新允许接收(如 HTTP 客户端), 补读边缘触发下留在内核里的数据
+            if (_et_recv_more && can_recv_more())
+                request_tick();
+        }
+
+    protected:
+        // 完成式引擎: 每个连接同时最多一个在途 sendmsg, 完成后由 on_io_send 续发
+        // 返回 false 表示引擎拒绝提交, 由调用方走同步发送
+        bool send_async(io_engine * engine)
+        {
+            if (_io_send_inflight)
+            {
+                // 完成回调会把协议层新产生的数据一起带走, 不需要 EPOLLOUT
                 update_event(get_event() & ~EPOLLOUT);
-                return;
+                return true;
+            }
+
+            const size_t MAX_BATCH = 256 * 1024;
+            std::unique_ptr<io_send_req> req(new io_send_req());
+            while (req->bufs.size() < (size_t)io_send_req::MAX_IOV && req->bytes < MAX_BATCH)
+            {
+                if (_send_queue.empty() && !pull_send_slice())
+                    break;
+                myframe::send_slice next = std::move(_send_queue.front());
+                _send_queue.pop_front();
+                if (next.empty())
+                    continue;
+                req->bytes += next.size();
+                req->bufs.push_back(std::move(next));
+            }
+
+            if (req->bufs.empty())
+            {
+                update_event(get_event() & ~EPOLLOUT);
+                return true;
             }
 
-            // Try to top up pending from process
-            while ((int)_pending_send.size() + (_p_send_buf ? 1 : 0) < MAX_IOV) {
-                std::string* nxt = _process->get_send_buf();
-                if (!nxt) break;
-                _pending_send.emplace_back(myframe::make_pooled_string(nxt));
+            if (!engine->submit_send(this, req))
+            {
+                for (auto it = req->bufs.rbegin(); it != req->bufs.rend(); ++it)
+                    _send_queue.push_front(std::move(*it));
+                return false;
             }
 
+            _io_send_inflight = true;
+            update_event(get_event() & ~EPOLLOUT);
+            return true;
+        }
+
+        bool send_pending() const
+        {
+            return _io_send_inflight || !_send_queue.empty() || (_epoll_event & EPOLLOUT) == EPOLLOUT;
+        }
+
+        bool can_recv_more() const
+        {
+            if (_recv_buf.length() >= (size_t)MAX_RECV_SIZE)
+                return false;
+            if (_process && !_codec && (!_process->want_recv() || _process->want_peek()))
+                return false;
+            return true;
+        }
+
+        // 从协议层取一段待发送数据放到队尾
+        bool pull_send_slice()
+        {
+            myframe::send_slice next;
+            if (!_process->get_send_slice(next))
+                return false;
+            _send_queue.push_back(std::move(next));
+            return true;
+        }
+
+        // 丢掉已写出的 n 字节: 整段写完的出队, 写了一半的只前移起始位置
+        void consume_send_queue(size_t n)
+        {
+            while (!_send_queue.empty())
+            {
+                myframe::send_slice & front = _send_queue.front();
+                if (front.size() > n)
+                {
+                    front.advance(n);
+                    break;
+                }
+                n -= front.size();
+                _send_queue.pop_front();
+            }
+        }
+
+        // If SSL or custom codec is installed, fall back to single-buffer SEND path
+        ssize_t send_codec_batch(bool & blocked)
+        {
+            ssize_t sent = 0;
+            int i = 0;
+            while (1) {
+                if (i >= MAX_SEND_NUM) break;
+                if (_send_queue.empty() && !pull_send_slice()) { update_event(get_event() & ~EPOLLOUT); break; }
+                i++;
+                myframe::send_slice & front = _send_queue.front();
+                size_t len = front.size();
+                if (len) {
+                    ssize_t ret = SEND(front.data(), len);
+                    if (ret > 0) { front.advance(ret); sent += ret; }
+                    if (ret < (ssize_t)len) { blocked = true; break; }
+                }
+                _send_queue.pop_front();
+            }
+            return sent;
+        }
+
+        // Aggregated writev path (plain TCP): 片段直接组成 iovec, 共享的 body 不复制
+        ssize_t send_iov_batch(bool & blocked)
+        {
+            const int MAX_IOV = 64;
+            const size_t MAX_BATCH = 256 * 1024; // 256KB per batch
+
+            // Try to top up pending from process; 凑够一批就停, 拉取式响应体不会被提前取出太多
+            size_t queued = 0;
+            for (size_t i = 0; i < _send_queue.size(); ++i) queued += _send_queue[i].size();
+            while ((int)_send_queue.size() < MAX_IOV && queued < MAX_BATCH && pull_send_slice())
+                queued += _send_queue.back().size();
+
             // Build iovec array
             struct iovec iov[MAX_IOV]; int iovcnt = 0; size_t total = 0;
-            if (_p_send_buf && !_p_send_buf->empty()) {
-                iov[iovcnt].iov_base = (void*)_p_send_buf->data();
-                iov[iovcnt].iov_len  = _p_send_buf->size();
-                total += iov[iovcnt].iov_len; iovcnt++;
-            }
-            for (size_t i=0; i<_pending_send.size() && iovcnt < MAX_IOV; ++i) {
-                auto& sp = _pending_send[i]; if (!sp || sp->empty()) continue;
-                iov[iovcnt].iov_base = (void*)sp->data();
-                iov[iovcnt].iov_len  = sp->size();
+            for (size_t i=0; i<_send_queue.size() && iovcnt < MAX_IOV; ++i) {
+                const myframe::send_slice & sl = _send_queue[i]; if (sl.empty()) continue;
+                iov[iovcnt].iov_base = (void*)sl.data();
+                iov[iovcnt].iov_len  = sl.size();
                 total += iov[iovcnt].iov_len; iovcnt++;
                 if (total >= MAX_BATCH) break;
             }
-            if (iovcnt == 0) { update_event(get_event() & ~EPOLLOUT); return; }
+            if (iovcnt == 0) { _send_queue.clear(); update_event(get_event() & ~EPOLLOUT); return 0; }
 
             ssize_t wr = ::writev(_fd, iov, iovcnt);
             if (wr < 0) {
                 if (errno == EAGAIN || errno == EWOULDBLOCK) {
                     // keep EPOLLOUT
-                    return;
+                    blocked = true;
+                    return 0;
                 }
                 THROW_COMMON_EXCEPT("sendv error " << strError(errno).c_str());
             }
-            size_t left = (size_t)wr;
-            if (left > 0) touch_active(GetMilliSecond());
-            // Consume from _p_send_buf then pending
-            if (_p_send_buf && left > 0) {
-                size_t blen = _p_send_buf->size();
-                if (left >= blen) { left -= blen; _p_send_buf.reset(); }
-                else { _p_send_buf->erase(0, left); left = 0; }
-            }
-            // consume from pending deque
-            while (left > 0 && !_pending_send.empty()) {
-                auto& front = _pending_send.front();
-                size_t blen = front->size();
-                if (left >= blen) { left -= blen; _pending_send.pop_front(); }
-                else { front->erase(0, left); left = 0; }
-            }
-            // Move partially-consumed first pending to _p_send_buf if needed
-            if (!_p_send_buf && !_pending_send.empty()) {
-                if (!_pending_send.front()->empty()) {
-                    _p_send_buf = std::move(_pending_send.front());
-                }
-                _pending_send.pop_front();
-            }
-            // If nothing left, clear EPOLLOUT
-            if (!_p_send_buf && _pending_send.empty()) {
+            if ((size_t)wr < total) blocked = true;
+            if (wr > 0) touch_active(GetMilliSecond());
+            consume_send_queue((size_t)wr);
+            // If nothing left, clear EPOLLOUT; 一批只取 MAX_IOV 片, 协议层还有数据(如流水线响应)时保留 EPOLLOUT
+            if (_send_queue.empty() && !pull_send_slice()) {
                 update_event(get_event() & ~EPOLLOUT);
             }
+            return wr;
         }
 
     protected:
@@ -418,13 +662,22 @@ class base_connect:public base_net_obj
             }
             return flushed;
         }
-        std::string _recv_buf;
-        using send_buf_ptr = myframe::pooled_string_ptr;
-        send_buf_ptr _p_send_buf;
+        myframe::recv_buffer _recv_buf;
         std::unique_ptr<PROCESS> _process;
         std::unique_ptr<ICodec> _codec;
-        std::deque<send_buf_ptr> _pending_send;
+        // 待发送的片段(独占字符串或共享缓冲区), 部分写出只前移片段起点
+        std::deque<myframe::send_slice> _send_queue;
         size_t _peek_drain_backlog;
+        // 边缘触发下上次读取没读到 EAGAIN, 内核里可能还有数据
+        bool _et_recv_more{false};
+        // 协议层要求继续处理接收缓冲里已到达的数据
+        bool _recv_resume{false};
+        // pause_recv() 去掉了 EPOLLIN
+        bool _recv_paused{false};
+        // 延迟关闭时为等待发送队列已经推迟的时间
+        uint32_t _close_linger_ms{0};
+        // io_uring 下有 sendmsg 在途
+        bool _io_send_inflight{false};
 
     public:
         void set_codec(std::unique_ptr<ICodec> codec) { _codec = std::move(codec); }
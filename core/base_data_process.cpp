@@ -30,12 +30,38 @@ std::string * base_data_process::get_send_buf()
         return NULL;
     }
 
-    std::string *p = _send_list.front();
+    std::string *p = _send_list.front().release_string();
     _send_list.pop_front();
 
     return p;
 }
 
+bool base_data_process::get_send_slice(myframe::send_slice & out)
+{
+    if (!_send_pulling && pop_send_list(out))
+        return true;
+
+    std::string *p = get_send_buf();
+    if (p) {
+        _send_pulling = true;
+        out = myframe::send_slice(myframe::make_pooled_string(p));
+        return true;
+    }
+
+    _send_pulling = false;
+    return pop_send_list(out);
+}
+
+bool base_data_process::pop_send_list(myframe::send_slice & out)
+{
+    if (_send_list.empty())
+        return false;
+
+    out = std::move(_send_list.front());
+    _send_list.pop_front();
+    return true;
+}
+
 void base_data_process::reset()
 {
     clear_send_list();
@@ -56,20 +82,31 @@ void base_data_process::handle_msg(std::shared_ptr<normal_msg> & p_msg)
 
 void base_data_process::clear_send_list()
 {
-    for (auto* ptr : _send_list) { myframe::string_release(ptr); }
     _send_list.clear();
+    _send_pulling = false;
 }
 
 void base_data_process::put_send_buf(std::string * str)
 {
     if (_closing) { delete str; return; }
-    _send_list.push_back(str);
+    put_send_slice(myframe::send_slice(myframe::make_pooled_string(str)));
+}
+
+void base_data_process::put_send_slice(myframe::send_slice && slice)
+{
+    if (_closing) return;
+    _send_list.push_back(std::move(slice));
     if (auto sp = _p_connect.lock())
     {
         sp->notice_send();  
     }
 }
 
+void base_data_process::put_send_shared(const myframe::shared_buffer & buf, size_t off, size_t len)
+{
+    put_send_slice(myframe::send_slice(buf, off, len));
+}
+
 void base_data_process::put_send_copy(const std::string& data)
 {
     if (_closing) return;
@@ -104,6 +141,15 @@ void base_data_process::add_timer(std::shared_ptr<timer_msg> & t_msg)
         sp->add_timer(t_msg);
 }
 
+bool base_data_process::cancel_timer(uint32_t timer_id)
+{
+    auto sp = _p_connect.lock();
+    if (sp)
+        return sp->cancel_timer(timer_id);
+
+    return false;
+}
+
 void base_data_process::handle_timeout(std::shared_ptr<timer_msg> & t_msg)
 {
     PDEBUG("%p", this);
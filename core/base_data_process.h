@@ -2,6 +2,8 @@
 #define _BASE_DATA_PROCESS_H_
 
 #include "common_util.h"
+#include "send_slice.h"
+#include "obj_pool.h"
 #include <deque>
 
 class base_net_obj;
@@ -12,10 +14,18 @@ class base_data_process
 
         virtual ~base_data_process();
 
+        // 协议处理对象(含派生类)按实际大小从线程内的 obj_pool 分配
+        MYFRAME_POOLED_NEW
+
         virtual void peer_close();
 
         virtual std::string *get_send_buf();
 
+        // 连接取发送数据的入口, put_send_* 排队的片段和协议层 get_send_buf() 的输出按先来后到发出:
+        // get_send_buf() 一旦开始交出数据, 就一直取到它返回 NULL, 之后排队的片段不会插进这段输出中间;
+        // 它返回 NULL (取完或暂时没有数据) 后才轮到队列
+        virtual bool get_send_slice(myframe::send_slice & out);
+
         virtual void reset();
 
         virtual size_t process_recv_buf(const char *buf, size_t len);
@@ -24,6 +34,9 @@ class base_data_process
 
         void add_timer(std::shared_ptr<timer_msg> & t_msg);
 
+        // 取消由 add_timer 注册且尚未触发的定时器
+        bool cancel_timer(uint32_t timer_id);
+
         virtual void handle_timeout(std::shared_ptr<timer_msg> & t_msg);
 
         // Ensure peer_close() callback fires exactly once across all teardown paths.
@@ -33,6 +46,9 @@ class base_data_process
         // Helpers that leverage per-thread string pool
         void put_send_copy(const std::string& data);
         void put_send_move(std::string&& data);
+        // 零拷贝: 共享缓冲区按引用计数挂到发送队列, 可以同时发给多个连接
+        void put_send_slice(myframe::send_slice && slice);
+        void put_send_shared(const myframe::shared_buffer & buf, size_t off = 0, size_t len = std::string::npos);
 
         std::shared_ptr<base_net_obj>  get_base_net();
 
@@ -67,10 +83,14 @@ class base_data_process
 
     protected:
         void clear_send_list();
+        // 取 _send_list 队首片段, 队列为空返回 false
+        bool pop_send_list(myframe::send_slice & out);
 
     protected:
         std::weak_ptr<base_net_obj> _p_connect;
-        std::deque<std::string*> _send_list;
+        std::deque<myframe::send_slice> _send_list;
+        // get_send_buf() 的一段输出还没取完, 排队的片段要等它
+        bool _send_pulling{false};
         bool _closing{false};
         bool _peer_close_notified{false};
 };
@@ -163,12 +163,18 @@ const int URLESCAPE[] =
 /** 外边业务用起始的timer id **/
 #define TIMER_ID_BEGIN 1000
 
+/** 连接加入容器前先挂起的定时器用最高位置 1 的 id, 容器生成的 id 不会进入这个区间 **/
+#define TIMER_ID_PARKED 0x80000000u
+
 /** 域名缓存默认超时时间 单位是毫秒***/
 #define MAX_DOMAIN_TIMEOUT (3 * 60 * 60 * 1000)
 
 /***channel 没有接收到event 的最长检测时间***/
 #define MAX_CHANNEL_EVENT_TIMEOUT  1000
 
+/***channel 单次唤醒最多处理的消息数, 超出部分留到下一轮***/
+#define MAX_CHANNEL_BATCH 4096
+
 #define CRLF "\r\n"
 #define CRLF2 "\r\n\r\n"
 
@@ -189,6 +195,8 @@ const int URLESCAPE[] =
 // HTTP/2 client timers
 #define H2_PING_TIMER_TYPE 9
 #define H2_TOTAL_TIMEOUT_TIMER_TYPE 10
+// HTTP keep-alive idle timeout (server side)
+#define HTTP_KEEPALIVE_TIMER_TYPE 11
 // Level 1 application handlers may request timers using this type
 #define APPLICATION_TIMER_TYPE 100
 
@@ -1,5 +1,5 @@
 #include "base_net_obj.h"
-#include "common_epoll.h"
+#include "io_engine.h"
 #include "common_obj_container.h"
 #include "common_def.h"
 #include "common_exception.h"
@@ -7,6 +7,8 @@
 #include "base_data_process.h"
 #include "common_util.h"
 
+#include <atomic>
+
 
 base_net_obj::base_net_obj()
 {
@@ -24,12 +26,15 @@ base_net_obj::base_net_obj()
 
 base_net_obj::~base_net_obj()
 {
+    if (_in_ready && _p_net_container) {
+        _p_net_container->unmark_ready(this);
+    }
 
     try {
         if (_p_net_container) {
-            common_epoll * p_epoll = _p_net_container->get_epoll();
-            if (p_epoll) {
-                p_epoll->del_from_epoll(this);
+            io_engine * p_engine = _p_net_container->get_io_engine();
+            if (p_engine) {
+                p_engine->del_obj(this);
             }
         }
     } catch (...) {
@@ -48,14 +53,14 @@ base_net_obj::~base_net_obj()
 void base_net_obj::set_net_container(common_obj_container *p_net_container)
 {
     _p_net_container = p_net_container;
-    common_epoll * p_epoll = _p_net_container->get_epoll();
+    io_engine * p_engine = _p_net_container->get_io_engine();
 
     std::shared_ptr<base_net_obj> p=std::dynamic_pointer_cast<base_net_obj>(shared_from_this());
 
     try {
         // Only add to epoll when we have a valid socket fd
         if (_fd > 0) {
-            p_epoll->add_to_epoll(p.get());
+            p_engine->add_obj(p.get());
         }
         _p_net_container->insert(p);
         add_timer();
@@ -79,15 +84,17 @@ void base_net_obj::set_real_net(bool real_net)
     
     _real_net = real_net;
     if (_real_net) {
-    std::shared_ptr<base_net_obj> p=std::dynamic_pointer_cast<base_net_obj>(shared_from_this());
-        //PDEBUG("base_net_obj:%d, .use_count:%d, _id:%d, _thread_index:%d", p, p.use_count(), p->get_id()._id, p->get_id()._thread_index);
-        PDEBUG(".use_count:%ld, _id:%d, _thread_index:%d", (long)p.use_count(), p->get_id()._id, p->get_id()._thread_index);
-        _p_net_container->push_real_net(p);
-        //PDEBUG("base_net_obj:%d, .use_count:%d, _id:%d, _thread_index:%d", p, p.use_count(), p->get_id()._id, p->get_id()._thread_index);
-        PDEBUG(".use_count:%ld, _id:%d, _thread_index:%d", (long)p.use_count(), p->get_id()._id, p->get_id()._thread_index);
+        PDEBUG("_id:%u, _thread_index:%u", _id_str._id, _id_str._thread_index);
+        request_tick();
     }
 }
 
+void base_net_obj::request_tick()
+{
+    if (_p_net_container && !_in_ready)
+        _p_net_container->mark_ready(this);
+}
+
 common_obj_container * base_net_obj::get_net_container()
 {
     return _p_net_container;
@@ -100,13 +107,30 @@ void base_net_obj::update_event(int event)
         return;
     }
 
-    common_epoll * p_epoll = _p_net_container->get_epoll();
-    if (_epoll_event != event && p_epoll) {
+    if (_edge_triggered)
+        event |= EPOLLET;
+
+    io_engine * p_engine = _p_net_container->get_io_engine();
+    if (_epoll_event != event && p_engine) {
         _epoll_event = event;
-        p_epoll->mod_from_epoll(this);
+        p_engine->mod_obj(this);
     }
 }
 
+void base_net_obj::set_edge_triggered(bool on)
+{
+    _edge_triggered = on;
+    int event = on ? (_epoll_event | EPOLLET) : (_epoll_event & ~EPOLLET);
+    if (!_p_net_container)
+    {
+        // 尚未加入 epoll, add_to_epoll 时带上
+        _epoll_event = event;
+        return;
+    }
+
+    update_event(event);
+}
+
 int base_net_obj::get_event()
 {
     return _epoll_event;
@@ -135,6 +159,12 @@ void base_net_obj::notice_send()
 {
 }
 
+void base_net_obj::request_send()
+{
+    update_event(get_event() | EPOLLOUT);
+    request_tick();
+}
+
 void base_net_obj::destroy()
 {
 }
@@ -153,10 +183,30 @@ void base_net_obj::add_timer(std::shared_ptr<timer_msg> & t_msg)
     }
     else
     {
+        // 还没有容器: 先给一个挂起区间的 id, 加入容器后沿用, 调用方拿到的 id 一直有效
+        static std::atomic<uint32_t> parked_id(0);
+        t_msg->_timer_id = TIMER_ID_PARKED | (parked_id.fetch_add(1, std::memory_order_relaxed) & ~TIMER_ID_PARKED);
         _timer_vec.push_back(t_msg);
     }
 }
 
+bool base_net_obj::cancel_timer(uint32_t timer_id)
+{
+    for (auto it = _timer_vec.begin(); it != _timer_vec.end(); ++it)
+    {
+        if ((*it)->_timer_id == timer_id)
+        {
+            _timer_vec.erase(it);
+            return true;
+        }
+    }
+
+    if (_p_net_container)
+        return _p_net_container->cancel_timer(timer_id);
+
+    return false;
+}
+
 void base_net_obj::add_timer()
 {
     std::vector<std::shared_ptr<timer_msg> >::iterator it;
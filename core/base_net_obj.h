@@ -2,10 +2,12 @@
 #define __BASE_NET_OBJ_H__
 
 #include "common_util.h"
+#include "obj_pool.h"
 #include <string>
 
 class base_data_process;
 class common_obj_container;
+struct io_send_req;
 class base_net_obj: public std::enable_shared_from_this<base_net_obj>
 {
     public:
@@ -13,11 +15,18 @@ class base_net_obj: public std::enable_shared_from_this<base_net_obj>
 
         virtual ~base_net_obj();
 
+        // 连接对象从线程内的 obj_pool 分配, 频繁建连/断连时复用内存
+        MYFRAME_POOLED_NEW
+
         virtual void event_process(int events) = 0;
 
         bool get_real_net();
         void set_real_net(bool real_net);
 
+        // 挂入所属容器的就绪链表, 下一轮 obj_process 会调用 real_net_process
+        void request_tick();
+        bool in_ready_list() const { return _in_ready; }
+
         virtual int real_net_process()=0;
 
         virtual void set_net_container(common_obj_container *p_net_container);
@@ -27,8 +36,21 @@ class base_net_obj: public std::enable_shared_from_this<base_net_obj>
         virtual void update_event(int event);    
         int get_event();
 
+        // 边缘触发(EPOLLET): 开启后 _epoll_event 始终带 EPOLLET, update_event 也会保留它
+        void set_edge_triggered(bool on);
+        bool edge_triggered() const { return _edge_triggered; }
+
         virtual void notice_send();
 
+        // 协议层又有数据可取(如流式响应体 resume), 下一轮事件循环里再取, 不在调用方的栈里发送
+        void request_send();
+
+        // 协议层处理完一个请求后接收缓冲里可能还有已到达的后续请求(如 HTTP 流水线), 请求下一轮接着处理
+        virtual void resume_recv() {}
+
+        // 协议层处理不过来(如流式请求体的业务变慢)时停止监听可读, resume_recv() 恢复
+        virtual void pause_recv() {}
+
         int get_sfd();
 
         void set_id(const ObjId & id_str);
@@ -37,6 +59,7 @@ class base_net_obj: public std::enable_shared_from_this<base_net_obj>
         virtual void handle_msg(std::shared_ptr<normal_msg> & p_msg);
 
         void add_timer(std::shared_ptr<timer_msg> & t_msg);
+        bool cancel_timer(uint32_t timer_id);
         virtual void handle_timeout(std::shared_ptr<timer_msg> & t_msg);
 
         virtual void destroy();
@@ -50,6 +73,23 @@ class base_net_obj: public std::enable_shared_from_this<base_net_obj>
         // Default: when EPOLLOUT is armed.
         virtual bool wants_tick() const { return (_epoll_event & EPOLLOUT) == EPOLLOUT; }
 
+        // 完成式 IO 引擎(io_uring)使用的能力声明与回调, epoll 引擎下不会调用
+        enum
+        {
+            IO_CAP_ACCEPT = 1,  // multishot accept, 回调 on_io_accept
+            IO_CAP_RECV = 2,    // multishot recv, 数据经 on_io_recv 交付, 期间不得直接读 fd
+            IO_CAP_SEND = 4     // 发送可通过 io_engine::submit_send 异步提交
+        };
+        virtual int io_caps() const { return 0; }
+        virtual void on_io_accept(int /*fd*/) {}
+        // len == 0 表示对端关闭
+        virtual void on_io_recv(const char * /*buf*/, size_t /*len*/) {}
+        virtual void on_io_send(std::unique_ptr<io_send_req> & /*req*/, int /*res*/) {}
+
+        // 引擎挂着 multishot recv 时置位
+        void set_io_recv_owned(bool owned) { _io_recv_owned = owned; }
+        bool io_recv_owned() const { return _io_recv_owned; }
+
         net_addr & get_peer_addr();
 
         // Bind a resolved protocol tag to this connection. When lock is true,
@@ -69,12 +109,21 @@ class base_net_obj: public std::enable_shared_from_this<base_net_obj>
         int _fd;	
         ObjId _id_str;
         bool _real_net;
+        bool _edge_triggered{false};
+        bool _io_recv_owned{false};
         std::vector<std::shared_ptr<timer_msg> > _timer_vec;
 
         net_addr _peer_net;
         uint64_t _last_active_ms{0};
         std::string _protocol_tag;
         bool _protocol_locked{false};
+
+    private:
+        // 容器就绪链表的侵入式节点, 只由 common_obj_container 维护
+        friend class common_obj_container;
+        base_net_obj * _ready_prev{nullptr};
+        base_net_obj * _ready_next{nullptr};
+        bool _in_ready{false};
 };
 
 
@@ -6,22 +6,23 @@
 #include "common_util.h"
 #include "factory_base.h"
 #include <algorithm>
+#include <sys/eventfd.h>
 
-base_net_thread::base_net_thread(int channel_num):_channel_num(channel_num), _base_container(NULL), _factory_for_thread(nullptr){
+base_net_thread::base_net_thread():_base_container(NULL), _factory_for_thread(nullptr){
     net_thread_init();
 }
 
-base_net_thread::base_net_thread(IFactory* factory, int channel_num)
-    : _channel_num(channel_num), _base_container(NULL), _factory_for_thread(factory) {
+base_net_thread::base_net_thread(IFactory* factory)
+    : _base_container(NULL), _factory_for_thread(factory) {
     net_thread_init();
 }
 
 base_net_thread::~base_net_thread(){
-    {
-        std::lock_guard<std::mutex> lock(_thread_map_mutex);
-        _base_net_thread_map.erase(get_thread_index());
-    }
+    // 返回后不会再有生产者持有本线程指针
+    _thread_registry.retire(get_thread_index(), this);
     clear_user_data();
+    // channel 连接析构时要从容器的 IO 引擎注销, 必须先于容器释放
+    _channel_msg_vec.clear();
     if (_base_container){
         delete _base_container;
     }
@@ -56,35 +57,28 @@ void base_net_thread::net_thread_init()
         _factory_for_thread->net_thread_init(this);
     }
 
-    for (int i = 0; i < _channel_num; i++) {
-
-        int fd[2];
-        int ret = socketpair(AF_UNIX,SOCK_STREAM,0,fd);
-        if (ret < 0) {
-            return ;
-        }   
+    // MPSC 邮箱支持任意多个生产者, 每个线程一个即可
+    int efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (efd >= 0) {
+        std::shared_ptr<base_connect<channel_data_process> >  p_connect(new channel_connect(efd));
+        channel_data_process * data_process = new channel_data_process(p_connect, efd);
+        p_connect->set_process(data_process);
+        p_connect->set_net_container(_base_container);
 
-        std::shared_ptr<base_connect<channel_data_process> >  channel_connect(new base_connect<channel_data_process>(fd[0]));
-        channel_data_process * data_process = new channel_data_process(channel_connect, fd[1]);
-        channel_connect->set_process(data_process);
-        channel_connect->set_net_container(_base_container);
-
-        _channel_msg_vec.push_back(channel_connect);
+        _channel_msg_vec.push_back(p_connect);
     }
 
-
-    {
-        std::lock_guard<std::mutex> lock(_thread_map_mutex);
-        _base_net_thread_map[get_thread_index()] = this;
-    }
+    _thread_registry.publish(get_thread_index(), this);
 }
 
 
 void base_net_thread::put_msg(uint32_t obj_id, std::shared_ptr<normal_msg> & p_msg)
 {
-    int index = (unsigned long) (&p_msg) % _channel_msg_vec.size();
-    std::shared_ptr<base_connect<channel_data_process> >  channel_connect = _channel_msg_vec[index];
-    channel_data_process * data_process = channel_connect->process();
+    if (_channel_msg_vec.empty()) {
+        return;
+    }
+
+    channel_data_process * data_process = _channel_msg_vec[0]->process();
     if (data_process)
     {
         data_process->put_msg(obj_id, p_msg);
@@ -114,13 +108,7 @@ bool base_net_thread::handle_thread_msg(std::shared_ptr<normal_msg> &)
 
 base_net_thread * base_net_thread::get_base_net_thread_obj(uint32_t thread_index)
 {
-    std::lock_guard<std::mutex> lock(_thread_map_mutex);
-    std::unordered_map<uint32_t, base_net_thread *>::const_iterator it = _base_net_thread_map.find(thread_index);
-    if (it != _base_net_thread_map.end()){
-        return it->second;
-    }
-
-    return NULL;
+    return _thread_registry.peek(thread_index);
 }
 
 void base_net_thread::add_timer(std::shared_ptr<timer_msg> & t_msg)
@@ -128,14 +116,16 @@ void base_net_thread::add_timer(std::shared_ptr<timer_msg> & t_msg)
     _base_container->add_timer(t_msg);
 }
 
+bool base_net_thread::cancel_timer(uint32_t timer_id)
+{
+    return _base_container->cancel_timer(timer_id);
+}
+
 void base_net_thread::put_obj_msg(ObjId & id, std::shared_ptr<normal_msg> & p_msg)
 {
-    std::lock_guard<std::mutex> lock(_thread_map_mutex);
-    auto it = _base_net_thread_map.find(id._thread_index);
-    if (it == _base_net_thread_map.end() || !it->second) {
-        return;
-    }
-    it->second->put_msg(id._id, p_msg);
+    _thread_registry.with(id._thread_index, [&](base_net_thread * th) {
+        th->put_msg(id._id, p_msg);
+    });
 }
 
 void base_net_thread::handle_timeout(std::shared_ptr<timer_msg> & t_msg)
@@ -179,8 +169,7 @@ void base_net_thread::store_user_data(const std::string& key, std::shared_ptr<vo
     _user_data[key] = std::move(entry);
 }
 
-std::unordered_map<uint32_t, base_net_thread *> base_net_thread::_base_net_thread_map;
-std::mutex base_net_thread::_thread_map_mutex;
+thread_registry<base_net_thread> base_net_thread::_thread_registry;
 
 void base_net_thread::add_worker_thread(uint32_t thread_index)
 {
@@ -7,6 +7,7 @@
 #include "base_connect.h"
 #include "channel_data_process.h"
 #include "thread_plugin.h"
+#include "thread_registry.h"
 #ifndef __LISTEN_FWD__
 #define __LISTEN_FWD__
 template <class PROCESS> class listen_connect;
@@ -26,8 +27,8 @@ class base_net_container;
 class base_net_thread:public base_thread
 {
     public:
-        base_net_thread(int channel_num = 1);
-        base_net_thread(class IFactory* factory, int channel_num = 1);
+        base_net_thread();
+        explicit base_net_thread(class IFactory* factory);
         virtual ~base_net_thread();
 
         virtual void *run();
@@ -44,6 +45,8 @@ class base_net_thread:public base_thread
 
         void add_timer(std::shared_ptr<timer_msg> & t_msg);
 
+        bool cancel_timer(uint32_t timer_id);
+
         virtual void handle_timeout(std::shared_ptr<timer_msg> & t_msg);
 
     common_obj_container * get_net_container();
@@ -58,7 +61,6 @@ class base_net_thread:public base_thread
 
         virtual bool handle_thread_msg(std::shared_ptr<normal_msg> & p_msg);
 
-        int _channel_num;
         std::vector< std::shared_ptr<base_connect<channel_data_process> > > _channel_msg_vec;
 
         common_obj_container * _base_container;
@@ -66,8 +68,8 @@ class base_net_thread:public base_thread
         // 仅供 put_obj_msg 内部使用，外部应通过 common_obj_container::get_owner_thread() 获取线程
         static base_net_thread * get_base_net_thread_obj(uint32_t thread_index);
 
-        static std::unordered_map<uint32_t, base_net_thread *> _base_net_thread_map;
-        static std::mutex _thread_map_mutex;
+        // put_obj_msg 按线程索引无锁查找目标线程
+        static thread_registry<base_net_thread> _thread_registry;
 
         std::vector<std::shared_ptr<IThreadPlugin> > _plugins;
     public:
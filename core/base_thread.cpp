@@ -5,7 +5,7 @@
 #endif
 
 
-base_thread::base_thread():_thread_id(0), _run_flag(true)
+base_thread::base_thread():_thread_id(0), _run_flag(true), _cpu(-1)
 {
     std::lock_guard<std::mutex> lck(base_thread::_mutex);
     _thread_index_start++;
@@ -46,6 +46,11 @@ void base_thread::join_thread()
     pthread_join(_thread_id, NULL);
 }
 
+void base_thread::set_cpu_affinity(int cpu)
+{
+    _cpu = cpu;
+}
+
 bool base_thread::stop() 
 {
     _run_flag = false;
@@ -57,6 +62,11 @@ void * base_thread::base_thread_proc(void *arg)
 {
     base_thread *p = (base_thread*)arg;
 #ifdef __linux__
+    if (p->_cpu >= 0) {
+        cpu_set_t set; CPU_ZERO(&set); CPU_SET(p->_cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        return p->run();
+    }
     // Optional CPU affinity: enabled if MYFRAME_THREAD_AFFINITY=1 or MYFRAME_PERF_PRESET=1
     auto want_on = [](){
         const char* env = ::getenv("MYFRAME_THREAD_AFFINITY");
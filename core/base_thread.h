@@ -43,11 +43,15 @@ class base_thread
 
         uint32_t get_thread_index();
 
+        // 指定绑定的 CPU(需在 start 之前调用), 优先于 MYFRAME_THREAD_AFFINITY 的默认分配
+        void set_cpu_affinity(int cpu);
+
     protected:
         uint32_t _thread_index;
 
         pthread_t _thread_id;
         bool _run_flag;
+        int _cpu;
 
         static std::vector<base_thread*>	_thread_vec;
 
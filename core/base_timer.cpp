@@ -1,4 +1,3 @@
-
 #include "base_timer.h"
 #include "common_util.h"
 #include "base_net_thread.h"
@@ -8,13 +7,22 @@ base_timer::base_timer(common_obj_container * net_container)
 {
     _net_container = net_container;
     _timerid = TIMER_ID_BEGIN;
-    _current = 0;
+    _next_tick = GetMilliSecond();
 }
 
 base_timer::~base_timer()
 {
-    _timer_list[_current].clear();
-    _timer_list[1 - _current].clear();
+    for (auto & k : _timer_nodes)
+    {
+        delete k.second;
+    }
+    _timer_nodes.clear();
+
+    for (auto node : _free_nodes)
+    {
+        delete node;
+    }
+    _free_nodes.clear();
 }
 
 uint32_t base_timer::gen_timerid()
@@ -22,90 +30,249 @@ uint32_t base_timer::gen_timerid()
     do
     {
         _timerid++;
-        if (_timerid < TIMER_ID_BEGIN)
+        if (_timerid < TIMER_ID_BEGIN || _timerid >= TIMER_ID_PARKED)
             _timerid = TIMER_ID_BEGIN;
-        
-    }while (_timerid_set.count(_timerid));
 
-    _timerid_set.insert(_timerid);
+    }while (_timer_nodes.count(_timerid));
 
     return _timerid;
 }
 
+base_timer::timer_node * base_timer::alloc_node()
+{
+    if (!_free_nodes.empty())
+    {
+        timer_node * node = _free_nodes.back();
+        _free_nodes.pop_back();
+        return node;
+    }
+
+    return new timer_node();
+}
+
+void base_timer::free_node(timer_node * node)
+{
+    node->_msg.reset();
+    node->_prev = node->_next = NULL;
+    _free_nodes.push_back(node);
+}
+
+base_timer::timer_slot & base_timer::slot_at(uint32_t level, uint32_t idx)
+{
+    if (level == 0)
+        return _root[idx & WHEEL_ROOT_MASK];
+
+    return _levels[level - 1][idx & WHEEL_LEVEL_MASK];
+}
+
+void base_timer::link_node(timer_node * node)
+{
+    uint64_t expires = node->_expires;
+    timer_slot * slot = NULL;
+
+    if (expires < _next_tick)
+    {
+        // 已过期(添加时刻晚于上次推进), 挂到下一个要处理的槽位
+        slot = &_root[_next_tick & WHEEL_ROOT_MASK];
+    }
+    else
+    {
+        uint64_t delta = expires - _next_tick;
+        if (delta > 0xffffffffULL)
+        {
+            // 超出轮子覆盖范围, 先按上限挂入最高层, 级联时会按真实到期时间重新计算
+            delta = 0xffffffffULL;
+            expires = _next_tick + delta;
+        }
+
+        if (delta < WHEEL_ROOT_SIZE)
+        {
+            slot = &_root[expires & WHEEL_ROOT_MASK];
+        }
+        else
+        {
+            for (uint32_t level = 1; level < WHEEL_LEVELS; level++)
+            {
+                uint32_t shift = WHEEL_ROOT_BITS + level * WHEEL_LEVEL_BITS;
+                if (level == WHEEL_LEVELS - 1 || delta < (1ULL << shift))
+                {
+                    slot = &slot_at(level, (uint32_t)(expires >> (shift - WHEEL_LEVEL_BITS)));
+                    break;
+                }
+            }
+        }
+    }
+
+    timer_node * head = &slot->_head;
+    node->_next = head;
+    node->_prev = head->_prev;
+    head->_prev->_next = node;
+    head->_prev = node;
+}
+
+void base_timer::unlink_node(timer_node * node)
+{
+    node->_prev->_next = node->_next;
+    node->_next->_prev = node->_prev;
+    node->_prev = node->_next = NULL;
+}
+
+void base_timer::cascade(uint32_t level)
+{
+    uint32_t shift = WHEEL_ROOT_BITS + (level - 1) * WHEEL_LEVEL_BITS;
+    timer_slot & slot = slot_at(level, (uint32_t)(_next_tick >> shift));
+
+    timer_node * head = &slot._head;
+    timer_node * node = head->_next;
+    head->_prev = head->_next = head;
+
+    while (node != head)
+    {
+        timer_node * next = node->_next;
+        link_node(node);
+        node = next;
+    }
+}
+
 uint32_t base_timer::add_timer(std::shared_ptr<timer_msg> & t_msg)
 {
     if (t_msg->_time_length <= 0 || t_msg->_obj_id <= 0)
     {
-        PDEBUG("add_timer failed: time_length:%u timer_id:%u _timer_type:%u", 
+        PDEBUG("add_timer failed: time_length:%u timer_id:%u _timer_type:%u",
             t_msg->_time_length, t_msg->_timer_id, t_msg->_timer_type);
         return 0;
     }
 
     uint64_t reach_time = GetMilliSecond() + t_msg->_time_length;
-    t_msg->_timer_id = gen_timerid();
+    // 挂起时已经发给调用方的 id 保持不变, 之后仍然可以用它取消
+    if (!(t_msg->_timer_id & TIMER_ID_PARKED) || _timer_nodes.count(t_msg->_timer_id))
+        t_msg->_timer_id = gen_timerid();
 
     //PDEBUG("time_length:%u reach_time:%llu timer_id:%u _timer_type:%u", t_msg->_time_length, reach_time, t_msg->_timer_id, t_msg->_timer_type);
 
-    _timer_list[_current].insert(make_pair(reach_time, t_msg));
+    timer_node * node = alloc_node();
+    node->_msg = t_msg;
+    node->_expires = reach_time;
+    link_node(node);
+
+    _timer_nodes[t_msg->_timer_id] = node;
 
     return t_msg->_timer_id;
 }
 
-void base_timer::check_timer(std::vector<uint32_t> &expect_list)
+bool base_timer::cancel_timer(uint32_t timer_id)
 {
-    uint64_t now = 	GetMilliSecond();
+    auto it = _timer_nodes.find(timer_id);
+    if (it == _timer_nodes.end())
+        return false;
 
-    typedef std::multimap<uint64_t, std::shared_ptr<timer_msg> >::iterator MITER;
-    MITER it;
-    std::pair<MITER, MITER> range;
+    timer_node * node = it->second;
+    _timer_nodes.erase(it);
 
-    std::multimap<uint64_t, std::shared_ptr<timer_msg> > & timer_list = _timer_list[_current];
-    it = timer_list.begin();
+    unlink_node(node);
+    free_node(node);
 
-    std::vector<uint64_t> tmp_vec;
-    std::vector<uint64_t>::iterator ii;
+    return true;
+}
 
-    _current = 1 - _current;
+void base_timer::check_timer(std::vector<uint32_t> &expect_list)
+{
+    uint64_t now = 	GetMilliSecond();
+
+    if (_timer_nodes.empty())
+    {
+        if (now >= _next_tick)
+            _next_tick = now + 1;
+        return;
+    }
 
-    for (it = timer_list.begin(); it != timer_list.end(); it++) 
+    while (_next_tick <= now)
     {
-        try
+        uint32_t idx = (uint32_t)(_next_tick & WHEEL_ROOT_MASK);
+        if (!idx)
         {
-            if (it->first > now)
-                break;
+            for (uint32_t level = 1; level < WHEEL_LEVELS; level++)
+            {
+                cascade(level);
+                uint32_t shift = WHEEL_ROOT_BITS + (level - 1) * WHEEL_LEVEL_BITS;
+                if ((_next_tick >> shift) & WHEEL_LEVEL_MASK)
+                    break;
+            }
+        }
+
+        _next_tick++;
 
-            //PDEBUG("time_length:%u timer_id:%u _timer_type:%u", it->second->_time_length, it->second->_timer_id, it->second->_timer_type);
+        timer_slot & slot = _root[idx];
+        if (slot.empty())
+            continue;
 
-            tmp_vec.push_back(it->first);
+        // 先把到期槽位整体摘下, 回调里新加/取消的定时器不会影响本轮遍历
+        timer_slot expired;
+        timer_node * head = &expired._head;
+        head->_next = slot._head._next;
+        head->_prev = slot._head._prev;
+        head->_next->_prev = head;
+        head->_prev->_next = head;
+        slot._head._prev = slot._head._next = &slot._head;
+
+        while (!expired.empty())
+        {
+            timer_node * node = head->_next;
+            std::shared_ptr<timer_msg> t_msg = node->_msg;
 
-            _net_container->handle_timeout(it->second);
+            _timer_nodes.erase(t_msg->_timer_id);
+            unlink_node(node);
+            free_node(node);
+
+            try
+            {
+                //PDEBUG("time_length:%u timer_id:%u _timer_type:%u", t_msg->_time_length, t_msg->_timer_id, t_msg->_timer_type);
+                _net_container->handle_timeout(t_msg);
+            }
+            catch(CMyCommonException &e)
+            {
+                expect_list.push_back(t_msg->_obj_id);
+            }
+            catch(std::exception &e)
+            {
+                expect_list.push_back(t_msg->_obj_id);
+            }
         }
-        catch(CMyCommonException &e) 
+
+        if (_timer_nodes.empty())
         {
-            expect_list.push_back(it->second->_obj_id);
+            if (now >= _next_tick)
+                _next_tick = now + 1;
+            break;
         }
-        catch(std::exception &e) 
-        {   
-            expect_list.push_back(it->second->_obj_id);
-        } 
     }
+}
 
-    for (ii = tmp_vec.begin(); ii != tmp_vec.end(); ii++)
-    {
+uint32_t base_timer::next_timeout(uint32_t max_ms)
+{
+    if (_timer_nodes.empty() || !max_ms)
+        return max_ms;
 
-        range = timer_list.equal_range(*ii);
-        for (it = range.first; it != range.second; ++it)
-        {
-            _timerid_set.erase(it->second->_timer_id);
-        }
-        timer_list.erase(*ii);
+    uint64_t now = GetMilliSecond();
+    if (_next_tick <= now)
+        return 0;
+
+    for (uint64_t tick = _next_tick; tick < now + max_ms; tick++)
+    {
+        // 回绕点会从上层级联, 保守地在这里醒来
+        if (!(tick & WHEEL_ROOT_MASK) || !_root[tick & WHEEL_ROOT_MASK].empty())
+            return (uint32_t)(tick - now);
     }
 
-    //PDEBUG("_current: size:%u idle: size:%u, _timerid_set:%u", _timer_list[_current].size(), _timer_list[1 - _current].size(), _timerid_set.size());
+    return max_ms;
 }
 
 bool base_timer::is_empty()
 {
-    std::multimap<uint64_t, std::shared_ptr<timer_msg> > & timer_list = _timer_list[_current];
-    return timer_list.begin() == timer_list.end();
+    return _timer_nodes.empty();
+}
+
+size_t base_timer::size()
+{
+    return _timer_nodes.size();
 }
@@ -3,6 +3,9 @@
 
 #include "common_def.h"
 
+// 分层时间轮(hierarchical hashed timing wheel), 精度 1ms
+// level0: 256 个槽(1ms), level1~4: 各 64 个槽, 覆盖 2^32 ms; 更远的到期时间按上限挂入并在级联时重新计算
+// add/cancel 均为 O(1), check_timer 只推进到当前时间并执行到期槽位
 class common_obj_container;
 class base_timer
 {
@@ -10,22 +13,70 @@ class base_timer
 		base_timer(common_obj_container * net_container);
 
 		virtual ~base_timer();
-		
+
 		uint32_t add_timer(std::shared_ptr<timer_msg> & t_msg);
 
+		// 按 timer_id 取消尚未触发的定时器, 不存在或已触发返回 false
+		bool cancel_timer(uint32_t timer_id);
+
 		void check_timer(std::vector<uint32_t> &expect_list);
 
         bool is_empty();
 
+        // 距下一个可能到期的槽位的毫秒数(不超过 max_ms), 供事件循环决定 epoll 等待时间
+        uint32_t next_timeout(uint32_t max_ms);
+
+        size_t size();
+
         uint32_t gen_timerid();
 
 	protected:
-        std::multimap<uint64_t, std::shared_ptr<timer_msg> > _timer_list[2];
-        std::set<uint32_t> _timerid_set;
+        enum
+        {
+            WHEEL_LEVELS = 5,
+            WHEEL_ROOT_BITS = 8,
+            WHEEL_LEVEL_BITS = 6,
+            WHEEL_ROOT_SIZE = 1 << WHEEL_ROOT_BITS,
+            WHEEL_LEVEL_SIZE = 1 << WHEEL_LEVEL_BITS,
+            WHEEL_ROOT_MASK = WHEEL_ROOT_SIZE - 1,
+            WHEEL_LEVEL_MASK = WHEEL_LEVEL_SIZE - 1
+        };
+
+        struct timer_node
+        {
+            std::shared_ptr<timer_msg> _msg;
+            uint64_t _expires;
+            timer_node * _prev;
+            timer_node * _next;
+        };
+
+        // 每个槽位是一个带哨兵的双向链表
+        struct timer_slot
+        {
+            timer_node _head;
+            timer_slot() { _head._expires = 0; _head._prev = &_head; _head._next = &_head; }
+            bool empty() const { return _head._next == &_head; }
+        };
+
+        timer_node * alloc_node();
+        void free_node(timer_node * node);
+
+        void link_node(timer_node * node);
+        static void unlink_node(timer_node * node);
+
+        void cascade(uint32_t level);
+        timer_slot & slot_at(uint32_t level, uint32_t idx);
+
+    protected:
+        timer_slot _root[WHEEL_ROOT_SIZE];
+        timer_slot _levels[WHEEL_LEVELS - 1][WHEEL_LEVEL_SIZE];
+
+        std::unordered_map<uint32_t, timer_node *> _timer_nodes;
+        std::vector<timer_node *> _free_nodes;
 
         common_obj_container * _net_container;
+        uint64_t _next_tick;
         uint32_t _timerid;
-        uint32_t _current;
 };
 #endif
 
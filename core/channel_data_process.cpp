@@ -7,102 +7,146 @@
 #include "common_util.h"
 
 channel_data_process::channel_data_process(std::shared_ptr<base_net_obj> p, int channelid):base_data_process(p),
-    _channelid(channelid),
-    _current(0)
+    _parked(true),
+    _channelid(channelid)
 {
-    _last_time = 0;
 }
 
-size_t channel_data_process::process_recv_buf(const char *buf, size_t len)
+channel_data_process::~channel_data_process()
 {
-    std::deque<normal_obj_msg > processing_queue;
-    size_t k = len / sizeof(CHANNEL_MSG_TAG); //防止在handle_msg 中调用put_msg d导致死锁
+    while (myframe::mpsc_node * node = _queue.pop())
     {
-        std::lock_guard<std::mutex> lck (_mutex);
-        if (_queue[_current].empty())
-        {
-            _current = 1 - _current;
-        }
-        processing_queue.swap(_queue[_current]);
+        delete static_cast<normal_obj_msg *>(node);
     }
-    PDEBUG("buf:%s, len:%zu, que.len:%zu", buf, len, processing_queue.size());
+}
+
+size_t channel_data_process::process_recv_buf(const char *buf, size_t len)
+{
+    drain();
 
-    size_t i = 0;
+    return len;
+}
+
+size_t channel_data_process::drain()
+{
     auto sp = _p_connect.lock();
-    while (!processing_queue.empty())
+    common_obj_container * container = sp ? sp->get_net_container() : NULL;
+
+    std::vector<uint32_t> exp_vec;
+    size_t total = 0;
+
+    for (;;)
     {
-        if (sp)
+        size_t n = 0;
+        while (n < MAX_CHANNEL_BATCH)
         {
-            normal_obj_msg &msg = processing_queue.front();
-            sp->get_net_container()->handle_msg(msg._id, msg.p_msg);
+            myframe::mpsc_node * node = _queue.pop();
+            if (!node)
+                break;
+
+            std::unique_ptr<normal_obj_msg> msg(static_cast<normal_obj_msg *>(node));
+            ++n;
+            if (!container)
+                continue;
+
+            try
+            {
+                container->handle_msg(msg->_id, msg->p_msg);
+            }
+            catch(CMyCommonException &e)
+            {
+                exp_vec.push_back(msg->_id);
+            }
+            catch(std::exception &e)
+            {
+                exp_vec.push_back(msg->_id);
+            }
         }
-        processing_queue.pop_front();
-        ++i;
-    }
+        total += n;
 
-     k =  i * sizeof(CHANNEL_MSG_TAG);
+        if (n == MAX_CHANNEL_BATCH)
+        {
+            // 还有积压: 保持非 parked, 给自己补一次唤醒, 让出本轮给其它连接
+            notify();
+            break;
+        }
 
-     if (!_last_time)
-         add_event_timer();
+        _parked.store(true);
+        if (_queue.empty())
+            break;
 
-     _last_time = GetMilliSecond();
+        // park 之后又来了消息; 如果已被生产者抢先置回 false, 它会负责唤醒
+        if (!_parked.exchange(false))
+            break;
 
-    return k;
-}
+        if (!n)
+        {
+            // 生产者处于 exchange 与链接之间, 交给下一轮
+            notify();
+            break;
+        }
+    }
 
+    PDEBUG("channel drain:%zu", total);
 
-void channel_data_process::put_msg(uint32_t obj_id, std::shared_ptr<normal_msg> & p_msg)
-{
-    std::lock_guard<std::mutex> lck (_mutex);
-    normal_obj_msg nbj_msg;
-    nbj_msg.p_msg = p_msg;
-    nbj_msg._id = obj_id;
-    int idle = 1 - _current;
-    _queue[idle].push_back(nbj_msg);
-
-    //write(_channelid, CHANNEL_MSG_TAG, sizeof(CHANNEL_MSG_TAG));
-    send(_channelid, CHANNEL_MSG_TAG, sizeof(CHANNEL_MSG_TAG), MSG_DONTWAIT);
+    for (auto id : exp_vec)
+    {
+        std::shared_ptr<base_net_obj> net_obj = container->find(id);
+        if (net_obj)
+        {
+            net_obj->destroy();
+            container->erase(id);
+        }
+    }
 
-    return ;
+    return total;
 }
 
-void channel_data_process::add_event_timer(uint64_t time_out)
+void channel_data_process::notify()
 {
-    time_out = time_out > 100 * MAX_CHANNEL_EVENT_TIMEOUT ? 100 * MAX_CHANNEL_EVENT_TIMEOUT:time_out;
-    time_out = time_out < 20 ? 20:time_out;
+    uint64_t one = 1;
+    ssize_t ret = ::write(_channelid, &one, sizeof(one));
+    (void)ret;
+}
 
-    std::shared_ptr<timer_msg> t_msg(new timer_msg);
-    t_msg->_obj_id = OBJ_ID_DOMAIN;
-    t_msg->_timer_type = NONE_CHANNEL_EVENT_TIMER_TYPE;
-    t_msg->_time_length = time_out;
+void channel_data_process::put_msg(uint32_t obj_id, std::shared_ptr<normal_msg> & p_msg)
+{
+    normal_obj_msg * nbj_msg = new normal_obj_msg;
+    nbj_msg->p_msg = p_msg;
+    nbj_msg->_id = obj_id;
+    _queue.push(nbj_msg);
 
-    add_timer(t_msg);
+    if (_parked.load() && _parked.exchange(false))
+    {
+        notify();
+    }
 }
 
-void channel_data_process::handle_timeout(std::shared_ptr<timer_msg> & t_msg)
+void channel_connect::event_process(int event)
 {
-    if (t_msg == nullptr)
-        return;
+    if ((event & EPOLLERR) == EPOLLERR || (event & EPOLLHUP) == EPOLLHUP)
+    {
+        THROW_COMMON_EXCEPT("channel epoll error "<< strError(errno).c_str());
+    }
 
-    int len = 0;
+    if ((event & EPOLLIN) == EPOLLIN)
     {
-        std::lock_guard<std::mutex> lck (_mutex);
-        len = _queue[0].size() + _queue[1].size();
+        uint64_t cnt = 0;
+        ssize_t ret = ::read(_fd, &cnt, sizeof(cnt));
+        if (ret < 0 && errno != EAGAIN)
+        {
+            THROW_COMMON_EXCEPT("channel read error "<< strError(errno).c_str());
+        }
+
+        if (_process)
+            _process->drain();
     }
+}
+
+int channel_connect::real_net_process()
+{
+    if (_process)
+        _process->drain();
 
-    PDEBUG("handle_timeout: timer_id:%u timer_type:%u, len:%d", t_msg->_timer_id, t_msg->_timer_type, len);
-
-    uint64_t now =  GetMilliSecond();
-   if (t_msg->_timer_type == NONE_CHANNEL_EVENT_TIMER_TYPE)
-   {
-       if (llabs(now - _last_time) > t_msg->_time_length && len)
-       {
-           get_base_net()->set_real_net(true);
-           add_event_timer(t_msg->_time_length/2);
-       }
-       else
-       {
-           add_event_timer(t_msg->_time_length * 2);
-       }
-   }
+    return 0;
 }
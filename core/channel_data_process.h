@@ -3,46 +3,64 @@
 
 #include "common_def.h"
 #include "base_data_process.h"
+#include "base_connect.h"
+#include "mpsc_queue.h"
 
-class normal_obj_msg //内部传递的消息
+class normal_obj_msg : public myframe::mpsc_node //内部传递的消息
 {
     public:
         uint32_t _id;
         std::shared_ptr<normal_msg>  p_msg;
 
         virtual ~normal_obj_msg(){
-        }   
+        }
 };
 
 
+// 线程邮箱: 侵入式无锁 MPSC 队列 + 一个 eventfd
+// 消费线程取空队列后进入 parked 状态, 只有把 parked 置回 false 的那个生产者才写 eventfd,
+// 因此一轮唤醒内的多条消息只需要一次 write/read
 class base_net_obj;
 class channel_data_process:public base_data_process
 {
     public:
         channel_data_process(std::shared_ptr<base_net_obj> p, int channelid);
 
-        virtual ~channel_data_process()
-        {
-            for (auto &que : _queue)
-            {
-                que.clear();
-            }
-        }	
+        virtual ~channel_data_process();
 
         virtual size_t process_recv_buf(const char *buf, size_t len);
 
+        // 任意线程可调用
         void put_msg(uint32_t obj_id, std::shared_ptr<normal_msg> & p_msg);
 
-        void add_event_timer(uint64_t time_out = MAX_CHANNEL_EVENT_TIMEOUT);
+        // 仅所属线程调用, 返回本次处理的消息数
+        size_t drain();
 
-        virtual void handle_timeout(std::shared_ptr<timer_msg> & t_msg);
+    protected:
+        void notify();
 
     protected:
-        std::mutex _mutex;
-        std::deque<normal_obj_msg > _queue[2];
-        int _current;
+        myframe::mpsc_queue _queue;
+        std::atomic<bool> _parked;
         int _channelid;
-        uint64_t _last_time;
+};
+
+// eventfd 不是 socket, 不走 base_connect 的 recv/send 路径
+class channel_connect:public base_connect<channel_data_process>
+{
+    public:
+        channel_connect(const int32_t efd):base_connect<channel_data_process>(efd)
+        {
+            // eventfd 每次事件都会整体读空, 不需要边缘触发
+            set_edge_triggered(false);
+        }
+
+        virtual void event_process(int event);
+
+        virtual int real_net_process();
+
+        // eventfd 只走 poll
+        virtual int io_caps() const { return 0; }
 };
 
 #endif
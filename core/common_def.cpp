@@ -2,6 +2,7 @@
 
 #include "common_util.h"
 #include "common_exception.h"
+#include "http_response_head.h"
 
 bool operator<(const ObjId & oj1, const ObjId & oj2)
 {
@@ -92,48 +93,69 @@ void http_res_head_para::to_head_str(std::string * head)
     if (!_response_str.empty())
         _response_str = http_response_code::response.get_response_str(_response_code);
 
-    {
-        head->append(_version);
-        head->append(" ");
+    // HTTP/1.1 的常见状态码直接用预拼好的状态行
+    std::string line_buf;
+    std::string_view line;
+    if (_version == "HTTP/1.1") {
+        line = myframe::http_status_line(_response_code, _response_str, line_buf);
+    } else {
         char tmp_buf[SIZE_LEN_32];
         snprintf(tmp_buf, sizeof(tmp_buf), "%d", _response_code);
-        head->append(tmp_buf);
-        head->append(" ");
-        head->append(_response_str);
-        head->append(CRLF);
+        line_buf.append(_version);
+        line_buf.append(" ");
+        line_buf.append(tmp_buf);
+        line_buf.append(" ");
+        line_buf.append(_response_str);
+        line_buf.append(CRLF);
+        line = line_buf;
     }
 
-    //cookie
-    if (_cookie_list.size() > 0)
+    //cookie, 先拼好再和其它头一起算长度
+    std::string cookies;
+    for (std::map<std::string, set_cookie_item>::iterator itr = _cookie_list.begin(); 
+            itr != _cookie_list.end(); ++itr)
     {
-        for (std::map<std::string, set_cookie_item>::iterator itr = _cookie_list.begin(); 
-                itr != _cookie_list.end(); ++itr)
+        cookies.append("Set-Cookie: ");
+        cookies.append(itr->first);
+        cookies.append("=");
+        cookies.append(itr->second._value);
+        if (itr->second._expire != 0)
         {
-            head->append("Set-Cookie: ");
-            head->append(itr->first);
-            head->append("=");
-            head->append(itr->second._value);
-            if (itr->second._expire != 0)
-            {
-                head->append(";expires=");
-                head->append(SecToHttpTime(itr->second._expire));
-            }
-
-            if (itr->second._path != "")
-            {
-                head->append(";path=");
-                head->append(itr->second._path);
-            }
-
-            if (itr->second._domain != "")
-            {
-                head->append(";domain=");
-                head->append(itr->second._domain);
-            }
-            head->append(CRLF);
+            cookies.append(";expires=");
+            cookies.append(SecToHttpTime(itr->second._expire));
         }
+
+        if (itr->second._path != "")
+        {
+            cookies.append(";path=");
+            cookies.append(itr->second._path);
+        }
+
+        if (itr->second._domain != "")
+        {
+            cookies.append(";domain=");
+            cookies.append(itr->second._domain);
+        }
+        cookies.append(CRLF);
     }
 
+    // 没设置 Date 时补上当前线程缓存的
+    std::string_view date;
+    if (_headers.find("Date") == _headers.end())
+        date = myframe::http_date_header();
+
+    size_t total = head->size() + line.size() + cookies.size() + date.size() + 2;
+    for (std::map<std::string, std::string>::iterator itr = _headers.begin(); 
+            itr != _headers.end(); ++itr)
+    {
+        total += itr->first.size() + 2 + itr->second.size() + 2;
+    }
+    head->reserve(total);
+
+    head->append(line.data(), line.size());
+    head->append(date.data(), date.size());
+    head->append(cookies);
+
     //other para
     for (std::map<std::string, std::string>::iterator itr = _headers.begin(); 
             itr != _headers.end(); ++itr)
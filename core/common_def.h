@@ -2,6 +2,7 @@
 #define __COMMON_DEF_H__
 
 #include "base_def.h"
+#include "http_head_parser.h"
 
 struct ObjId
 {
@@ -151,12 +152,52 @@ struct set_cookie_item
     }
 };
 
+// 接收到的报文头先以解析器视图的形式挂在 _parsed 上, 有人要 map 时才展开到 _headers
+inline void build_http_headers(const myframe::http_head_parser * parsed, bool & built,
+        std::map<std::string, std::string> & headers)
+{
+    if (built || !parsed)
+        return;
+    built = true;
+    for (size_t i = 0; i < parsed->header_count(); i++)
+    {
+        std::string_view n = parsed->header_name(i);
+        std::string_view v = parsed->header_value(i);
+        headers.insert(std::make_pair(std::string(n.data(), n.size()), std::string(v.data(), v.size())));
+    }
+}
+
+inline std::string_view http_header_view(const myframe::http_head_parser * parsed, bool built,
+        const std::map<std::string, std::string> & headers, std::string_view name)
+{
+    if (parsed && !built)
+        return parsed->find(name);
+    for (std::map<std::string, std::string>::const_iterator it = headers.begin(); it != headers.end(); ++it)
+    {
+        if (it->first.size() == name.size() && strncasecmp(it->first.data(), name.data(), name.size()) == 0)
+            return std::string_view(it->second);
+    }
+    return std::string_view();
+}
+
+inline std::string_view http_header_view(const myframe::http_head_parser * parsed, bool built,
+        const std::map<std::string, std::string> & headers, myframe::http_header_id id)
+{
+    if (parsed && !built)
+        return parsed->find(id);
+    if (id < 0 || id >= myframe::HDR_KNOWN_NUM)
+        return std::string_view();
+    return http_header_view(NULL, built, headers, myframe::http_header_index::name(id));
+}
+
 struct http_req_head_para
 {
     http_req_head_para()
     {
         _method = "GET";
         _version = "HTTP/1.1";
+        _parsed = NULL;
+        _headers_built = false;
     }
 
     void init()
@@ -167,6 +208,27 @@ struct http_req_head_para
 
         _headers.clear();
         _cookie_list.clear();
+        _parsed = NULL;
+        _headers_built = false;
+    }
+
+    // 收到的报文头按名字查(不区分大小写, 整词匹配), 不展开 _headers
+    std::string_view header_view(std::string_view name) const
+    {
+        return http_header_view(_parsed, _headers_built, _headers, name);
+    }
+
+    // 常用头部按编号取, 解析时已经记下位置
+    std::string_view header_view(myframe::http_header_id id) const
+    {
+        return http_header_view(_parsed, _headers_built, _headers, id);
+    }
+
+    // 第一次访问时才把解析结果展开成 map
+    std::map<std::string, std::string> & headers()
+    {
+        build_http_headers(_parsed, _headers_built, _headers);
+        return _headers;
     }
 
     std::string * get_header(const char * str)
@@ -176,9 +238,11 @@ struct http_req_head_para
             return ptr;
         }
 
+        headers();
         std::map<std::string, std::string>::iterator it;
         for (it = _headers.begin(); it != _headers.end(); it++) {
-            if (strcasestr(it->first.c_str(), str)) {
+            // 整词匹配, 不再用子串匹配(Content-Length 不会命中 X-Content-Length-Foo)
+            if (strcasecmp(it->first.c_str(), str) == 0) {
                 ptr = &(it->second);
                 break;
             }
@@ -196,6 +260,9 @@ struct http_req_head_para
 
     std::map<std::string, std::string> _headers;    
     std::map<std::string, std::string> _cookie_list;
+
+    const myframe::http_head_parser * _parsed;
+    bool _headers_built;
 };
 
 struct net_addr
@@ -217,6 +284,8 @@ struct http_res_head_para
         _response_code = 200;
         _response_str = "OK";
         _version = "HTTP/1.1";
+        _parsed = NULL;
+        _headers_built = false;
     }
 
     void init()
@@ -227,6 +296,25 @@ struct http_res_head_para
         _cookie_list.clear();
         _headers.clear();
         _chunked.clear();
+        _parsed = NULL;
+        _headers_built = false;
+    }
+
+    std::string_view header_view(std::string_view name) const
+    {
+        return http_header_view(_parsed, _headers_built, _headers, name);
+    }
+
+    // 常用头部按编号取, 解析时已经记下位置
+    std::string_view header_view(myframe::http_header_id id) const
+    {
+        return http_header_view(_parsed, _headers_built, _headers, id);
+    }
+
+    std::map<std::string, std::string> & headers()
+    {
+        build_http_headers(_parsed, _headers_built, _headers);
+        return _headers;
     }
 
     std::string * get_header(const char * str)
@@ -236,9 +324,11 @@ struct http_res_head_para
             return ptr;
         }
 
+        headers();
         std::map<std::string, std::string>::iterator it;
         for (it = _headers.begin(); it != _headers.end(); it++) {
-            if (strcasestr(it->first.c_str(), str)) {
+            // 整词匹配, 不再用子串匹配(Content-Length 不会命中 X-Content-Length-Foo)
+            if (strcasecmp(it->first.c_str(), str) == 0) {
                 ptr = &(it->second);
                 break;
             }
@@ -256,6 +346,9 @@ struct http_res_head_para
     std::map<std::string, set_cookie_item> _cookie_list;
     std::map<std::string, std::string> _headers;
     std::string _chunked;
+
+    const myframe::http_head_parser * _parsed;
+    bool _headers_built;
 }; 
 
 
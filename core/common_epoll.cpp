@@ -50,6 +50,8 @@ void common_epoll::mod_from_epoll(base_net_obj * p_obj)
 {
     int tmpOprate = EPOLL_CTL_MOD;
     struct epoll_event tmpEvent;
+    memset(&tmpEvent, 0, sizeof(epoll_event));
+    // get_event() 已包含 EPOLLET; 边缘触发下 MOD 会重新布防, 已就绪的条件会再报一次
     tmpEvent.events =  p_obj->get_event();  
     tmpEvent.data.ptr = p_obj;
     int ret = epoll_ctl(_epoll_fd, tmpOprate, p_obj->get_sfd(), &tmpEvent);
@@ -64,9 +66,11 @@ void common_epoll::mod_from_epoll(base_net_obj * p_obj)
     }
 }
 
-int common_epoll::epoll_wait(std::map<ObjId, std::shared_ptr<base_net_obj> > &expect_list, std::map<ObjId, std::shared_ptr<base_net_obj> > &remove_list, uint32_t num)
+int common_epoll::epoll_wait(std::map<ObjId, std::shared_ptr<base_net_obj> > &expect_list, std::map<ObjId, std::shared_ptr<base_net_obj> > &remove_list, int wait_ms)
 {
-    int  nfds = ::epoll_wait(_epoll_fd, _epoll_events, _epoll_size, _epoll_wait_time);
+    if (wait_ms < 0 || wait_ms > _epoll_wait_time)
+        wait_ms = _epoll_wait_time;
+    int  nfds = ::epoll_wait(_epoll_fd, _epoll_events, _epoll_size, wait_ms);
     if (nfds == -1)
     {
         std::string err = strError(errno);
@@ -105,13 +109,13 @@ int common_epoll::epoll_wait(std::map<ObjId, std::shared_ptr<base_net_obj> > &ex
                 }
                 catch(CMyCommonException &e)
                 {
-                    fprintf(stderr, "[epoll_wait] CMyCommonException obj_id=%d fd=%d: %s\n",
+                    fprintf(stderr, "[epoll_wait] CMyCommonException obj_id=%u fd=%d: %s\n",
                             p->get_id()._id, p->get_sfd(), e.what());
                     expect_list.insert(std::make_pair(p->get_id(), p_obj));
                 }
                 catch(std::exception &e)
                 {
-                    fprintf(stderr, "[epoll_wait] std::exception obj_id=%d fd=%d: %s\n",
+                    fprintf(stderr, "[epoll_wait] std::exception obj_id=%u fd=%d: %s\n",
                             p->get_id()._id, p->get_sfd(), e.what());
                     expect_list.insert(std::make_pair(p->get_id(), p_obj));
                 }
@@ -4,9 +4,10 @@
 #include "common_def.h"
 #include "common_exception.h"
 #include "common_util.h"
+#include "io_engine.h"
 
 class base_net_obj;
-class common_epoll
+class common_epoll : public io_engine
 {
     public:
         common_epoll()
@@ -17,7 +18,7 @@ class common_epoll
             _epoll_wait_time = DEFAULT_EPOLL_WAITE;
         }
 
-        ~common_epoll()
+        virtual ~common_epoll()
         {
             cleanup();
         }
@@ -26,28 +27,10 @@ class common_epoll
         {
             cleanup();
             // Allow override by environment variables
-            const char* env_size = ::getenv("MYFRAME_EPOLL_SIZE");
-            const char* env_wait = ::getenv("MYFRAME_EPOLL_WAIT_MS");
-            const char* preset   = ::getenv("MYFRAME_PERF_PRESET");
-            _epoll_size = (epoll_size == 0)?DAFAULT_EPOLL_SIZE:epoll_size;
-            if (env_size) {
-                long v = atol(env_size);
-                if (v > 0) _epoll_size = (uint32_t)v;
-            }
-            // Clamp epoll size to sane range
-            if (_epoll_size < 256) _epoll_size = 256;
-            if (_epoll_size > 65536) _epoll_size = 65536;
-            _epoll_wait_time = epoll_wait_time;
-            if (env_wait) {
-                int v = atoi(env_wait); if (v >= 0) _epoll_wait_time = v;
-            } else if (preset && (strcmp(preset, "0") != 0 && strcasecmp(preset, "false") != 0)) {
-                // Recommended low-latency default when preset enabled
-                _epoll_wait_time = 1;
-            }
-            if (_epoll_wait_time < 0) _epoll_wait_time = 0;
-            if (_epoll_wait_time > 1000) _epoll_wait_time = 1000;
+            _epoll_size = config_size(epoll_size);
+            _epoll_wait_time = config_wait_time(epoll_wait_time);
 
-            PDEBUG("[epoll] size=%u wait_ms=%d (preset=%s)", _epoll_size, _epoll_wait_time, preset?preset:"off");
+            PDEBUG("[epoll] size=%u wait_ms=%d", _epoll_size, _epoll_wait_time);
 
             int fd = -1;
 #ifdef EPOLL_CLOEXEC
@@ -78,7 +61,77 @@ class common_epoll
 
         void mod_from_epoll(base_net_obj * p_obj);
 
-        int epoll_wait(std::map<ObjId, std::shared_ptr<base_net_obj> > &expect_list, std::map<ObjId, std::shared_ptr<base_net_obj> > &remove_list, uint32_t num);
+        // wait_ms < 0 时使用配置的等待时间
+        int epoll_wait(std::map<ObjId, std::shared_ptr<base_net_obj> > &expect_list, std::map<ObjId, std::shared_ptr<base_net_obj> > &remove_list, int wait_ms = -1);
+
+        virtual const char * name() const { return "epoll"; }
+
+        virtual void add_obj(base_net_obj * p_obj) { add_to_epoll(p_obj); }
+
+        virtual void del_obj(base_net_obj * p_obj) { del_from_epoll(p_obj); }
+
+        virtual void mod_obj(base_net_obj * p_obj) { mod_from_epoll(p_obj); }
+
+        virtual int wait(std::map<ObjId, std::shared_ptr<base_net_obj> > &expect_list,
+                std::map<ObjId, std::shared_ptr<base_net_obj> > &remove_list, int wait_ms = -1)
+        {
+            return epoll_wait(expect_list, remove_list, wait_ms);
+        }
+
+        virtual int get_wait_time() const { return _epoll_wait_time; }
+
+        // MYFRAME_EPOLL_SIZE / MYFRAME_EPOLL_WAIT_MS / MYFRAME_PERF_PRESET, io_uring 引擎共用同样的取值
+        static uint32_t config_size(uint32_t epoll_size)
+        {
+            uint32_t size = (epoll_size == 0)?DAFAULT_EPOLL_SIZE:epoll_size;
+            if (const char* env_size = ::getenv("MYFRAME_EPOLL_SIZE")) {
+                long v = atol(env_size);
+                if (v > 0) size = (uint32_t)v;
+            }
+            // Clamp epoll size to sane range
+            if (size < 256) size = 256;
+            if (size > 65536) size = 65536;
+            return size;
+        }
+
+        static int config_wait_time(int epoll_wait_time)
+        {
+            const char* env_wait = ::getenv("MYFRAME_EPOLL_WAIT_MS");
+            const char* preset   = ::getenv("MYFRAME_PERF_PRESET");
+            int wait_time = epoll_wait_time;
+            if (env_wait) {
+                int v = atoi(env_wait); if (v >= 0) wait_time = v;
+            } else if (preset && (strcmp(preset, "0") != 0 && strcasecmp(preset, "false") != 0)) {
+                // Recommended low-latency default when preset enabled
+                wait_time = 1;
+            }
+            if (wait_time < 0) wait_time = 0;
+            if (wait_time > 1000) wait_time = 1000;
+            return wait_time;
+        }
+
+        // MYFRAME_EPOLL_ET=1: base_connect 默认以 EPOLLET 注册, 读写循环到 EAGAIN
+        static bool edge_triggered_default()
+        {
+            static const bool on = []() {
+                const char* e = ::getenv("MYFRAME_EPOLL_ET");
+                return e && strcmp(e, "0") != 0 && strcasecmp(e, "false") != 0;
+            }();
+            return on;
+        }
+
+        // 边缘触发下单个连接每次事件最多读/写的字节数(MYFRAME_EPOLL_ET_BUDGET), 避免大流量连接饿死其它连接
+        static size_t edge_io_budget()
+        {
+            static const size_t budget = []() {
+                size_t v = 512 * 1024;
+                if (const char* e = ::getenv("MYFRAME_EPOLL_ET_BUDGET")) { long n = atol(e); if (n > 0) v = (size_t)n; }
+                if (v < SIZE_LEN_32768) v = SIZE_LEN_32768;
+                if (v > 64 * 1024 * 1024) v = 64 * 1024 * 1024;
+                return v;
+            }();
+            return budget;
+        }
 
     private:
         int _epoll_fd;
@@ -9,8 +9,7 @@
 
 common_obj_container::common_obj_container(uint32_t thread_index, uint32_t epoll_size)
 {
-    _p_epoll = new common_epoll();
-    _p_epoll->init(epoll_size);
+    _p_engine = io_engine::create(epoll_size);
 
     _timer = new base_timer(this);
 
@@ -18,17 +17,29 @@ common_obj_container::common_obj_container(uint32_t thread_index, uint32_t epoll
 
     _id_str._id = OBJ_ID_BEGIN;
     _id_str._thread_index = thread_index;
+
+    if (const char* e = ::getenv("MYFRAME_IDLE_SKIP_MS")) { int v = atoi(e); if (v > 0) _idle_skip_ms = (uint32_t)v; }
+    if (!_idle_skip_ms) { const char* preset = ::getenv("MYFRAME_PERF_PRESET"); if (preset && (strcmp(preset, "0") != 0 && strcasecmp(preset, "false") != 0)) _idle_skip_ms = 50; }
+    if (_idle_skip_ms > 5000) _idle_skip_ms = 5000;
+    if (const char* s = ::getenv("MYFRAME_IDLE_SCAN_MAX")) { int v = atoi(s); if (v > 0) _idle_scan_max = (uint32_t)v; }
 }
 
 common_obj_container::~common_obj_container()
 {
-    for (const auto & k :_obj_map)
+    while (_ready_head)
     {
-        k.second->destroy();
+        unmark_ready(_ready_head);
     }
 
-    if (_p_epoll != NULL)
-        delete _p_epoll;
+    _obj_map.for_each([](const std::shared_ptr<base_net_obj> & obj) {
+        obj->destroy();
+    });
+
+    // 先释放连接对象(析构里会从引擎注销), 再释放引擎
+    _obj_map.clear();
+
+    if (_p_engine != NULL)
+        delete _p_engine;
 
     if (_timer) 
         delete _timer;
@@ -38,9 +49,9 @@ common_obj_container::~common_obj_container()
 }
 
 
-common_epoll * common_obj_container::get_epoll()
+io_engine * common_obj_container::get_io_engine()
 {
-        return _p_epoll;
+        return _p_engine;
 }
 
 base_timer * common_obj_container::get_timer()
@@ -48,42 +59,58 @@ base_timer * common_obj_container::get_timer()
         return _timer;
 }
 
-const ObjId & common_obj_container::gen_id_str()
+bool common_obj_container::push_real_net(std::shared_ptr<base_net_obj> & p_obj)
 {
-    do {
-        if (_id_str._id <= OBJ_ID_BEGIN)
-            _id_str._id = OBJ_ID_BEGIN;
+    PDEBUG("base_net_obj:%p, .use_count:%ld, _id:%u _thread_index:%u", (void*)p_obj.get(), (long)p_obj.use_count(), p_obj->get_id()._id, p_obj->get_id()._thread_index);
 
-        _id_str._id++;
-    } while (find(_id_str._id));
+    mark_ready(p_obj.get());
 
-    return _id_str;
+    return true;
 }
 
-
-bool common_obj_container::push_real_net(std::shared_ptr<base_net_obj> & p_obj)
+bool common_obj_container::remove_real_net(std::shared_ptr<base_net_obj> & p_obj)
 {
-    PDEBUG("base_net_obj:%p, .use_count:%ld, _id:%d _thread_index:%d", (void*)p_obj.get(), (long)p_obj.use_count(), p_obj->get_id()._id, p_obj->get_id()._thread_index);
+    PDEBUG("base_net_obj:%p, .use_count:%ld, _id:%u _thread_index:%u", (void*)p_obj.get(), (long)p_obj.use_count(), p_obj->get_id()._id, p_obj->get_id()._thread_index);
 
-    auto it = _obj_net_map.find(p_obj->get_id()._id);
-    if (it == _obj_net_map.end())
-    {
-        _obj_net_map.insert(std::make_pair(p_obj->get_id()._id, p_obj));
-    }
-    //_obj_net_map[p_obj->get_id()._id] = p_obj;
-
-    PDEBUG("base_net_obj:%p, .use_count:%ld, _id:%d _thread_index:%d", (void*)p_obj.get(), (long)p_obj.use_count(), p_obj->get_id()._id, p_obj->get_id()._thread_index);
+    unmark_ready(p_obj.get());
 
     return true;
 }
 
-bool common_obj_container::remove_real_net(std::shared_ptr<base_net_obj> & p_obj)
+void common_obj_container::mark_ready(base_net_obj * p_obj)
 {
-    PDEBUG("base_net_obj:%p, .use_count:%ld, _id:%d _thread_index:%d", (void*)p_obj.get(), (long)p_obj.use_count(), p_obj->get_id()._id, p_obj->get_id()._thread_index);
-    _obj_net_map.erase(p_obj->get_id()._id);
-    PDEBUG("base_net_obj:%p, .use_count:%ld, _id:%d _thread_index:%d", (void*)p_obj.get(), (long)p_obj.use_count(), p_obj->get_id()._id, p_obj->get_id()._thread_index);
+    if (!p_obj || p_obj->_in_ready)
+        return;
+
+    p_obj->_in_ready = true;
+    p_obj->_ready_next = NULL;
+    p_obj->_ready_prev = _ready_tail;
+    if (_ready_tail)
+        _ready_tail->_ready_next = p_obj;
+    else
+        _ready_head = p_obj;
+    _ready_tail = p_obj;
+    _ready_num++;
+}
 
-    return true;
+void common_obj_container::unmark_ready(base_net_obj * p_obj)
+{
+    if (!p_obj || !p_obj->_in_ready)
+        return;
+
+    if (p_obj->_ready_prev)
+        p_obj->_ready_prev->_ready_next = p_obj->_ready_next;
+    else
+        _ready_head = p_obj->_ready_next;
+
+    if (p_obj->_ready_next)
+        p_obj->_ready_next->_ready_prev = p_obj->_ready_prev;
+    else
+        _ready_tail = p_obj->_ready_prev;
+
+    p_obj->_ready_prev = p_obj->_ready_next = NULL;
+    p_obj->_in_ready = false;
+    _ready_num--;
 }
 
 uint32_t common_obj_container::size()
@@ -93,9 +120,10 @@ uint32_t common_obj_container::size()
 
 bool common_obj_container::insert(std::shared_ptr<base_net_obj> &p_obj)
 {
-    p_obj->set_id(gen_id_str());
-
-    _obj_map[p_obj->get_id()._id] = p_obj;
+    ObjId id;
+    id._thread_index = _id_str._thread_index;
+    id._id = _obj_map.insert(p_obj);
+    p_obj->set_id(id);
 
     return true;
 }
@@ -142,6 +170,16 @@ void common_obj_container::add_timer(std::shared_ptr<timer_msg> & t_msg)
     }
 }
 
+bool common_obj_container::cancel_timer(uint32_t timer_id)
+{
+    if (_timer)
+    {
+        return _timer->cancel_timer(timer_id);
+    }
+
+    return false;
+}
+
 common_domain * common_obj_container::get_domain()
 {
     return _domain;
@@ -149,18 +187,16 @@ common_domain * common_obj_container::get_domain()
 
 std::shared_ptr<base_net_obj> common_obj_container::find(uint32_t obj_id)
 {
-    auto it = _obj_map.find(obj_id);
-    if (it == _obj_map.end()){
-        return NULL;
-    }else {
-        return it->second;
-    }
+    return _obj_map.find(obj_id);
 }
 
 void common_obj_container::erase(uint32_t obj_id)
 {
-    _obj_net_map.erase(obj_id);
-    _obj_map.erase(obj_id);
+    std::shared_ptr<base_net_obj> obj = _obj_map.erase(obj_id);
+    if (!obj)
+        return;
+
+    unmark_ready(obj.get());
 
     return;
 }
@@ -189,60 +225,57 @@ void common_obj_container::handle_msg(uint32_t obj_id, std::shared_ptr<normal_ms
 
 void common_obj_container::obj_process()
 {   
-    uint32_t tmp_num = 0;
     uint64_t now = GetMilliSecond();
-    uint32_t idle_skip_ms = 0; if (const char* e = ::getenv("MYFRAME_IDLE_SKIP_MS")) { int v = atoi(e); if (v > 0) idle_skip_ms = (uint32_t)v; }
-    if (!idle_skip_ms) { const char* preset = ::getenv("MYFRAME_PERF_PRESET"); if (preset && (strcmp(preset, "0") != 0 && strcasecmp(preset, "false") != 0)) idle_skip_ms = 50; }
-    if (idle_skip_ms > 5000) idle_skip_ms = 5000;
-    uint32_t idle_scan_max = 0; if (const char* s = ::getenv("MYFRAME_IDLE_SCAN_MAX")) { int v = atoi(s); if (v > 0) idle_scan_max = (uint32_t)v; }
+    uint32_t idle_scan_max = _idle_scan_max;
 
     std::vector<std::shared_ptr<base_net_obj> > exception_vec;
-    std::vector<std::shared_ptr<base_net_obj> > real_net_vec;
 
-    for (const auto & u: _obj_net_map)
+    // 先对就绪链表做快照: tick 过程中对象可能重新挂入或被摘除
+    _ready_snapshot.clear();
+    for (base_net_obj * p = _ready_head; p; p = p->_ready_next)
+    {
+        _ready_snapshot.push_back(p->shared_from_this());
+    }
+
+    for (const auto & obj : _ready_snapshot)
     {
         try
         {
             // Only tick objects that declare interest (e.g., TLS handshake or pending write)
-            bool active = u.second->wants_tick() || (idle_skip_ms && (now - u.second->last_active_ms() < idle_skip_ms));
+            bool active = obj->wants_tick() || (_idle_skip_ms && (now - obj->last_active_ms() < _idle_skip_ms));
             if (!active && idle_scan_max) { active = true; --idle_scan_max; }
-            if (active) {
-                u.second->real_net_process();
+            // 先摘下再 tick, tick 里还有剩余工作(如边缘触发预算用完)可以重新挂入
+            if (!obj->get_real_net()) {
+                PDEBUG("remove_real_net: _id:%u, _thread_index:%u", obj->get_id()._id, obj->get_id()._thread_index);
+                unmark_ready(obj.get());
             }
-            if (!u.second->get_real_net()) {
-                real_net_vec.push_back(u.second);
+            if (active) {
+                obj->real_net_process();
             }
-
-            tmp_num++;
         }
         catch(CMyCommonException &e)
         {
-            PDEBUG("CMyCommonException obj_id=%d: %s", u.second ? u.second->get_id()._id : -1, e.what());
-            fprintf(stderr, "[obj_process] CMyCommonException obj_id=%d: %s\n",
-                    u.second ? u.second->get_id()._id : -1, e.what());
-            exception_vec.push_back(u.second);
+            PDEBUG("CMyCommonException obj_id=%u: %s", obj->get_id()._id, e.what());
+            fprintf(stderr, "[obj_process] CMyCommonException obj_id=%u: %s\n",
+                    obj->get_id()._id, e.what());
+            exception_vec.push_back(obj);
         }
         catch(std::exception &e)
         {
-            PDEBUG("std::exception obj_id=%d: %s", u.second ? u.second->get_id()._id : -1, e.what());
-            fprintf(stderr, "[obj_process] std::exception obj_id=%d: %s\n",
-                    u.second ? u.second->get_id()._id : -1, e.what());
-            exception_vec.push_back(u.second);
+            PDEBUG("std::exception obj_id=%u: %s", obj->get_id()._id, e.what());
+            fprintf(stderr, "[obj_process] std::exception obj_id=%u: %s\n",
+                    obj->get_id()._id, e.what());
+            exception_vec.push_back(obj);
         }
     }
-
-    for (std::vector<std::shared_ptr<base_net_obj> >::iterator tmp_itr = real_net_vec.begin(); 
-            tmp_itr != real_net_vec.end(); tmp_itr++) {
-        PDEBUG("remove_real_net: _id:%d, _thread_index:%d", (*tmp_itr)->get_id()._id, (*tmp_itr)->get_id()._thread_index);            
-        remove_real_net(*tmp_itr);
-    }
+    _ready_snapshot.clear();
 
     auto detach_from_epoll = [](const std::shared_ptr<base_net_obj>& obj) {
         if (!obj) return;
         if (auto* container = obj->get_net_container()) {
-            if (auto* ep = container->get_epoll()) {
+            if (auto* engine = container->get_io_engine()) {
                 try {
-                    ep->del_from_epoll(obj.get());
+                    engine->del_obj(obj.get());
                 } catch (...) {
                     // best effort during teardown
                 }
@@ -259,10 +292,12 @@ void common_obj_container::obj_process()
     std::map<ObjId, std::shared_ptr<base_net_obj> > exp_list;
     std::map<ObjId, std::shared_ptr<base_net_obj> > remove_list;
 
-    _p_epoll->epoll_wait(exp_list, remove_list, tmp_num);
+    // 还有待 tick 的对象就不阻塞; 否则最多睡到下一个定时器槽位, 避免 1ms 的延迟关闭被拖到整个 epoll 周期
+    int wait_ms = _ready_head ? 0 : (int)_timer->next_timeout((uint32_t)_p_engine->get_wait_time());
+    _p_engine->wait(exp_list, remove_list, wait_ms);
     for (std::map<ObjId, std::shared_ptr<base_net_obj> >::iterator itr = exp_list.begin(); itr != exp_list.end(); ++itr)
     {         	
-        PDEBUG("step2: _id:%d, _thread_index:%d", itr->second->get_id()._id, itr->second->get_id()._thread_index);            
+        PDEBUG("step2: _id:%u, _thread_index:%u", itr->second->get_id()._id, itr->second->get_id()._thread_index);            
         detach_from_epoll(itr->second);
         itr->second->destroy();
         erase(itr->first._id);
@@ -270,7 +305,7 @@ void common_obj_container::obj_process()
 
     for (std::map<ObjId, std::shared_ptr<base_net_obj> >::iterator itr = remove_list.begin(); itr != remove_list.end(); ++itr)
     {
-        PDEBUG("remove_real_net: _id:%d, _thread_index:%d", itr->second->get_id()._id, itr->second->get_id()._thread_index);            
+        PDEBUG("remove_real_net: _id:%u, _thread_index:%u", itr->second->get_id()._id, itr->second->get_id()._thread_index);            
         itr->second->set_real_net(false);
         remove_real_net(itr->second);
     }
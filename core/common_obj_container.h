@@ -2,7 +2,8 @@
 #define __COMMON_OBJ_CONTAINER_H__
 
 #include "common_util.h"
-#include "common_epoll.h"
+#include "io_engine.h"
+#include "obj_id_table.h"
 
 class base_timer;
 class common_domain;
@@ -21,6 +22,11 @@ class common_obj_container
         bool push_real_net(std::shared_ptr<base_net_obj> & p_obj);
         bool remove_real_net(std::shared_ptr<base_net_obj> & p_obj);
 
+        // 就绪链表: 只有挂在上面的对象才会在 obj_process 里被 tick, 空闲连接不再参与每轮扫描
+        void mark_ready(base_net_obj * p_obj);
+        void unmark_ready(base_net_obj * p_obj);
+        uint32_t ready_size() const { return _ready_num; }
+
         std::shared_ptr<base_net_obj> find(uint32_t obj_id);
 
         bool insert(std::shared_ptr<base_net_obj> & p_obj);
@@ -30,7 +36,7 @@ class common_obj_container
 
         void obj_process();
 
-        common_epoll *get_epoll();
+        io_engine *get_io_engine();
 
         base_timer * get_timer();
 
@@ -38,6 +44,8 @@ class common_obj_container
 
         void add_timer(std::shared_ptr<timer_msg> & t_msg);
 
+        bool cancel_timer(uint32_t timer_id);
+
         void handle_timeout(std::shared_ptr<timer_msg> & t_msg);
 
         uint32_t get_thread_index();
@@ -45,13 +53,19 @@ class common_obj_container
         uint32_t size();
 
     protected:
-        const ObjId & gen_id_str();
+        // id 即表下标(带代数), 查找不哈希; 关闭连接的槽位在 accept 时复用
+        obj_id_table<base_net_obj> _obj_map;
 
-    protected:
-        std::unordered_map<uint32_t, std::shared_ptr<base_net_obj> > _obj_map;
-        std::unordered_map<uint32_t, std::shared_ptr<base_net_obj> > _obj_net_map;
+        base_net_obj * _ready_head{nullptr};
+        base_net_obj * _ready_tail{nullptr};
+        uint32_t _ready_num{0};
+        std::vector<std::shared_ptr<base_net_obj> > _ready_snapshot;
+
+        // 启动时解析一次: MYFRAME_IDLE_SKIP_MS / MYFRAME_PERF_PRESET / MYFRAME_IDLE_SCAN_MAX
+        uint32_t _idle_skip_ms{0};
+        uint32_t _idle_scan_max{0};
 
-        common_epoll *_p_epoll;
+        io_engine *_p_engine;
         base_timer * _timer;
         common_domain * _domain;
         ObjId _id_str;
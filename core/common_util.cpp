@@ -498,20 +498,37 @@ std::string GetWeekStr(int nWeek)
 
 std::string SecToHttpTime(time_t tmpTime)
 {
-    struct timeval tm1;
-    struct timezone tz1;        
-    gettimeofday(&tm1, &tz1);
-    tmpTime = tmpTime + tz1.tz_minuteswest*60;
+    char sTime[32];
+    size_t len = FormatHttpDate(tmpTime, sTime);
+    return std::string(sTime, len);
+}
+
+size_t FormatHttpDate(time_t tmpTime, char * buf)
+{
     tm tmpTm;
-    localtime_r(&tmpTime, &tmpTm);
-    char sTime[128] = {0};
-    //sprintf(sTime, "%s, %d %s %d %02d:%02d:%02d GMT ", GetWeekStr(tmpTm.tm_wday).c_str(),  tmpTm.tm_mday, 
-    //        GetMonStr(tmpTm.tm_mon + 1).c_str(), 
-    //        tmpTm.tm_year+1900, tmpTm.tm_hour, tmpTm.tm_min,   tmpTm.tm_sec);
-    snprintf(sTime, sizeof(sTime),"%s, %d %s %d %02d:%02d:%02d GMT ", GetWeekStr(tmpTm.tm_wday).c_str(),  tmpTm.tm_mday, 
-            GetMonStr(tmpTm.tm_mon + 1).c_str(), 
-            tmpTm.tm_year+1900, tmpTm.tm_hour, tmpTm.tm_min,   tmpTm.tm_sec);
-    return std::string(sTime);
+    gmtime_r(&tmpTime, &tmpTm);
+    const char * week = WEEKARRAY[tmpTm.tm_wday].sWeek;
+    const char * mon = MONTHARRAY[tmpTm.tm_mon].sMonth;
+    int year = tmpTm.tm_year + 1900;
+
+    char * p = buf;
+    memcpy(p, week, 3); p += 3;
+    *p++ = ','; *p++ = ' ';
+    *p++ = '0' + tmpTm.tm_mday / 10; *p++ = '0' + tmpTm.tm_mday % 10;
+    *p++ = ' ';
+    memcpy(p, mon, 3); p += 3;
+    *p++ = ' ';
+    *p++ = '0' + year / 1000 % 10; *p++ = '0' + year / 100 % 10;
+    *p++ = '0' + year / 10 % 10; *p++ = '0' + year % 10;
+    *p++ = ' ';
+    *p++ = '0' + tmpTm.tm_hour / 10; *p++ = '0' + tmpTm.tm_hour % 10;
+    *p++ = ':';
+    *p++ = '0' + tmpTm.tm_min / 10; *p++ = '0' + tmpTm.tm_min % 10;
+    *p++ = ':';
+    *p++ = '0' + tmpTm.tm_sec / 10; *p++ = '0' + tmpTm.tm_sec % 10;
+    memcpy(p, " GMT", 4); p += 4;
+    *p = '\0';
+    return (size_t)(p - buf);
 }
 
 int parse_domain(const std::string &sDomain, std::vector<std::string> & vIp)
@@ -187,6 +187,9 @@ std::string strError(int errnum);
 
 std::string SecToHttpTime(time_t tmpTime);
 
+// IMF-fixdate(如 "Sun, 06 Nov 1994 08:49:37 GMT"), 写入 buf(至少 30 字节), 返回长度(29)
+size_t FormatHttpDate(time_t tmpTime, char * buf);
+
 struct TMonth
 {       
     int nMonth;
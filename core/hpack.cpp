@@ -1,6 +1,5 @@
 #include "hpack.h"
 #include <cstring>
-#include <map>
 
 namespace hpack {
 
@@ -74,26 +73,83 @@ const std::vector<HeaderField>& static_table() {
     return tbl;
 }
 
-static std::map<std::string,uint32_t> build_static_name_index() {
-    std::map<std::string,uint32_t> m;
-    auto& tbl = static_table();
-    for (uint32_t i = 0; i < tbl.size(); ++i) {
-        if (m.find(tbl[i].name) == m.end()) m[tbl[i].name] = i + 1; // 1-based
-    }
-    return m;
+// Word-at-a-time multiplicative hash, shared by the static index and the encoder's dynamic index
+static inline uint64_t hash_mix(uint64_t h, uint64_t v) {
+    h = (h ^ v) * 0x9e3779b97f4a7c15ull;
+    return h ^ (h >> 29);
+}
+
+static inline uint32_t hash_bytes(uint64_t h, const std::string& s) {
+    const char* p = s.data();
+    size_t n = s.size();
+    for (; n >= 8; p += 8, n -= 8) { uint64_t v; memcpy(&v, p, 8); h = hash_mix(h, v); }
+    uint64_t v = (uint64_t)n << 56;
+    memcpy(&v, p, n);   // n < 8: only the low bytes, the length stays in the top one
+    h = hash_mix(h, v);
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+static inline uint32_t hash_name(const std::string& name) { return hash_bytes(0x8445d61a4e774912ull, name); }
+
+static inline uint32_t hash_pair(uint32_t name_hash, const std::string& value) {
+    return hash_bytes(0xa0761d6478bd642full ^ name_hash, value);
 }
 
+// Open-addressing index over the static table: first index of each name, and every (name, value)
+struct StaticIndex {
+    enum { SLOTS = 256 };
+    uint8_t name_slot[SLOTS];
+    uint8_t pair_slot[SLOTS];
+
+    StaticIndex() {
+        memset(name_slot, 0, sizeof(name_slot));
+        memset(pair_slot, 0, sizeof(pair_slot));
+        const std::vector<HeaderField>& tbl = static_table();
+        for (uint32_t i = 0; i < tbl.size(); ++i) {
+            std::string name = tbl[i].name, value = tbl[i].value;
+            uint32_t nh = hash_name(name);
+            if (!find_name(nh, name)) insert(name_slot, nh, i + 1);
+            insert(pair_slot, hash_pair(nh, value), i + 1);
+        }
+    }
+
+    static void insert(uint8_t* slots, uint32_t h, uint32_t index) {
+        uint32_t i = h & (SLOTS - 1);
+        while (slots[i]) i = (i + 1) & (SLOTS - 1);
+        slots[i] = (uint8_t)index;
+    }
+
+    uint32_t find_name(uint32_t h, const std::string& name) const {
+        const std::vector<HeaderField>& tbl = static_table();
+        for (uint32_t i = h & (SLOTS - 1); name_slot[i]; i = (i + 1) & (SLOTS - 1)) {
+            if (name == tbl[name_slot[i] - 1].name) return name_slot[i];
+        }
+        return 0;
+    }
+
+    uint32_t find_pair(uint32_t h, const std::string& name, const std::string& value) const {
+        const std::vector<HeaderField>& tbl = static_table();
+        for (uint32_t i = h & (SLOTS - 1); pair_slot[i]; i = (i + 1) & (SLOTS - 1)) {
+            const HeaderField& f = tbl[pair_slot[i] - 1];
+            if (name == f.name && value == f.value) return pair_slot[i];
+        }
+        return 0;
+    }
+};
+
+static const StaticIndex& static_index() { static const StaticIndex idx; return idx; }
+
 uint32_t static_index_of_name(const std::string& name) {
-    static std::map<std::string,uint32_t> m = build_static_name_index();
-    auto it = m.find(name);
-    if (it == m.end()) return 0;
-    return it->second;
+    return static_index().find_name(hash_name(name), name);
+}
+
+uint32_t static_index_of_pair(const std::string& name, const std::string& value) {
+    return static_index().find_pair(hash_pair(hash_name(name), value), name, value);
 }
 
 // Huffman coding table (RFC 7541 Appendix B) - code and bit length per symbol (0..256; 256 is EOS)
 struct HuffSym { uint32_t code; uint8_t nbits; };
 
-// Table reduced for brevity? No, we include full per RFC
 static const HuffSym HUF[257] = {
     {0x1ff8,13},{0x7fffd8,23},{0xfffffe2,28},{0xfffffe3,28},{0xfffffe4,28},{0xfffffe5,28},{0xfffffe6,28},{0xfffffe7,28},
     {0xfffffe8,28},{0xffffea,24},{0x3ffffffc,30},{0xfffffe9,28},{0xfffffea,28},{0x3ffffffd,30},{0xfffffeb,28},{0xfffffec,28},
@@ -115,37 +171,106 @@ static const HuffSym HUF[257] = {
     {0x3fffd6,22},{0x7fffda,23},{0x7fffdb,23},{0x7fffdc,23},{0x7fffdd,23},{0x7fffde,23},{0xffffeb,24},{0x7fffdf,23},
     {0xffffec,24},{0xffffed,24},{0x3fffd7,22},{0x7fffe0,23},{0xffffee,24},{0x7fffe1,23},{0x7fffe2,23},{0x7fffe3,23},
     {0x7fffe4,23},{0x1fffdc,21},{0x3fffd8,22},{0x7fffe5,23},{0x3fffd9,22},{0x7fffe6,23},{0x7fffe7,23},{0xffffef,24},
-    {0x3fffda,22},{0x1fffdd,21},{0xfffee,20},{0xfffeF,20},{0x1fffde,21},{0x3fffdb,22},{0x3fffdc,22},{0x7fffe8,23},
-    {0x7fffe9,23},{0x1fffdf,21},{0x3fffe0,22},{0x1fffe0,21},{0x1fffe1,21},{0x3fffe1,22},{0x3fffe2,22},{0x3fffe3,22},
-    {0x3fffe4,22},{0x7fffea,23},{0x7fffeb,23},{0x1fffe2,21},{0x1fffe3,21},{0x3fffe5,22},{0x3fffe6,22},{0x7fffec,23},
-    {0x7fffed,23},{0x7fffee,23},{0x7fffef,23},{0xfffec,20},{0xfffff0,24},{0xfffed,20},{0x1fffe4,21},{0x1fffe5,21},
-    {0x3fffe7,22},{0x3fffe8,22},{0x1fffe6,21},{0x3fffe9,22},{0x1fffe7,21},{0x3fffea,22},{0x3fffeb,22},{0x7ffff0,23},
-    {0x3fffec,22},{0x3fffed,22},{0x7ffff1,23},{0x3fffee,22},{0x7ffff2,23},{0x7ffff3,23},{0x7ffff4,23},{0x7ffff5,23},
-    {0x7ffff6,23},{0x7ffff7,23},{0x7ffff8,23},{0x7ffff9,23},{0x7ffffa,23},{0x7ffffb,23},{0xfffff1,24},{0xfffff2,24},
-    {0xfffff3,24},{0xfffff4,24},{0xfffff5,24},{0xfffff6,24},{0xfffff7,24},{0xfffff8,24},{0xfffff9,24},{0xfffffa,24},
-    {0xfffffb,24},{0xfffffc,24},{0xfffffd,24},{0xfffffe,24},{0xffffff,24},{0x1000000,25} // placeholder; will not be used
+    {0x3fffda,22},{0x1fffdd,21},{0xfffe9,20},{0x3fffdb,22},{0x3fffdc,22},{0x7fffe8,23},{0x7fffe9,23},{0x1fffde,21},
+    {0x7fffea,23},{0x3fffdd,22},{0x3fffde,22},{0xfffff0,24},{0x1fffdf,21},{0x3fffdf,22},{0x7fffeb,23},{0x7fffec,23},
+    {0x1fffe0,21},{0x1fffe1,21},{0x3fffe0,22},{0x1fffe2,21},{0x7fffed,23},{0x3fffe1,22},{0x7fffee,23},{0x7fffef,23},
+    {0xfffea,20},{0x3fffe2,22},{0x3fffe3,22},{0x3fffe4,22},{0x7ffff0,23},{0x3fffe5,22},{0x3fffe6,22},{0x7ffff1,23},
+    {0x3ffffe0,26},{0x3ffffe1,26},{0xfffeb,20},{0x7fff1,19},{0x3fffe7,22},{0x7ffff2,23},{0x3fffe8,22},{0x1ffffec,25},
+    {0x3ffffe2,26},{0x3ffffe3,26},{0x3ffffe4,26},{0x7ffffde,27},{0x7ffffdf,27},{0x3ffffe5,26},{0xfffff1,24},{0x1ffffed,25},
+    {0x7fff2,19},{0x1fffe3,21},{0x3ffffe6,26},{0x7ffffe0,27},{0x7ffffe1,27},{0x3ffffe7,26},{0x7ffffe2,27},{0xfffff2,24},
+    {0x1fffe4,21},{0x1fffe5,21},{0x3ffffe8,26},{0x3ffffe9,26},{0xffffffd,28},{0x7ffffe3,27},{0x7ffffe4,27},{0x7ffffe5,27},
+    {0xfffec,20},{0xfffff3,24},{0xfffed,20},{0x1fffe6,21},{0x3fffe9,22},{0x1fffe7,21},{0x1fffe8,21},{0x7ffff3,23},
+    {0x3fffea,22},{0x3fffeb,22},{0x1ffffee,25},{0x1ffffef,25},{0xfffff4,24},{0xfffff5,24},{0x3ffffea,26},{0x7ffff4,23},
+    {0x3ffffeb,26},{0x7ffffe6,27},{0x3ffffec,26},{0x3ffffed,26},{0x7ffffe7,27},{0x7ffffe8,27},{0x7ffffe9,27},{0x7ffffea,27},
+    {0x7ffffeb,27},{0xffffffe,28},{0x7ffffec,27},{0x7ffffed,27},{0x7ffffee,27},{0x7ffffef,27},{0x7fffff0,27},{0x3ffffee,26},
+    {0x3fffffff,30}
 };
 
-// Build decoding tree
-struct Node { int32_t sym; int32_t left; int32_t right; Node():sym(-1),left(-1),right(-1){} };
-
-static std::vector<Node> build_tree() {
-    std::vector<Node> nodes; nodes.reserve(4096); nodes.emplace_back(); // root at 0
-    for (int s = 0; s <= 255; ++s) {
-        uint32_t code = HUF[s].code; uint8_t n = HUF[s].nbits;
-        int idx = 0;
-        for (int i = n - 1; i >= 0; --i) {
-            int bit = (code >> i) & 1u;
-            int32_t& child = (bit ? nodes[idx].right : nodes[idx].left);
-            if (child == -1) { child = (int32_t)nodes.size(); nodes.emplace_back(); }
-            idx = (int)child;
+void huffman_code(unsigned sym, uint32_t& code, uint8_t& nbits) {
+    if (sym > 256) { code = 0; nbits = 0; return; }
+    code = HUF[sym].code; nbits = HUF[sym].nbits;
+}
+
+// Huffman decoding state machine, 4 input bits per step (same scheme as nghttp2).
+// A state is an internal node of the code tree (256 of them); for every state and nibble the
+// table holds the next state and the symbol completed on the way, if any. Codes are at least
+// 5 bits long, so a nibble completes at most one symbol.
+enum { HUFF_SYM = 1, HUFF_ACCEPT = 2, HUFF_FAIL = 4 };
+
+struct HuffDecode { uint8_t state; uint8_t flags; uint8_t sym; };
+
+struct HuffDecodeTable {
+    HuffDecode t[256][16];
+
+    HuffDecodeTable() {
+        // child >= 0: internal node id; child < 0: leaf for symbol -child - 1
+        int16_t child[256][2];
+        memset(child, 0, sizeof(child));
+        int nodes = 1;
+        for (int s = 0; s <= 256; ++s) {
+            int idx = 0;
+            for (int i = HUF[s].nbits - 1; i > 0; --i) {
+                int bit = (HUF[s].code >> i) & 1;
+                if (!child[idx][bit]) child[idx][bit] = (int16_t)nodes++;
+                idx = child[idx][bit];
+            }
+            child[idx][HUF[s].code & 1] = (int16_t)(-s - 1);
+        }
+
+        // Padding (RFC 7541 5.2) is at most 7 bits, all ones: the nodes reached from the root
+        // by up to seven 1 bits are the only states a string may end in.
+        bool accept[256];
+        memset(accept, 0, sizeof(accept));
+        for (int idx = 0, depth = 0; idx >= 0 && depth <= 7; idx = child[idx][1], ++depth)
+            accept[idx] = true;
+
+        for (int state = 0; state < 256; ++state) {
+            for (int nibble = 0; nibble < 16; ++nibble) {
+                HuffDecode& d = t[state][nibble];
+                d.flags = 0; d.sym = 0;
+                int idx = state;
+                for (int i = 3; i >= 0; --i) {
+                    int next = child[idx][(nibble >> i) & 1];
+                    if (next >= 0) { idx = next; continue; }
+                    // EOS inside a string is a decoding error
+                    if (-next - 1 == 256) { d.flags = HUFF_FAIL; break; }
+                    d.flags |= HUFF_SYM;
+                    d.sym = (uint8_t)(-next - 1);
+                    idx = 0;
+                }
+                d.state = (uint8_t)idx;
+                if (!(d.flags & HUFF_FAIL) && accept[idx]) d.flags |= HUFF_ACCEPT;
+            }
         }
-        nodes[idx].sym = s;
     }
-    return nodes;
-}
+};
+
+static const HuffDecodeTable& huff_table() { static const HuffDecodeTable t; return t; }
 
-static const std::vector<Node>& HTree() { static std::vector<Node> t = build_tree(); return t; }
+static bool huffman_decode(const unsigned char* p, size_t len, std::string& out) {
+    const HuffDecodeTable& T = huff_table();
+    size_t base = out.size();
+    // every code is at least 5 bits
+    out.resize(base + len * 8 / 5);
+    char* dst = &out[0] + base;
+    const char* start = dst;
+    uint8_t state = 0;
+    uint8_t flags = HUFF_ACCEPT;
+    for (const unsigned char* end = p + len; p < end; ++p) {
+        const HuffDecode& hi = T.t[state][*p >> 4];
+        if (hi.flags & HUFF_FAIL) { out.resize(base); return false; }
+        if (hi.flags & HUFF_SYM) *dst++ = (char)hi.sym;
+        const HuffDecode& lo = T.t[hi.state][*p & 0x0f];
+        if (lo.flags & HUFF_FAIL) { out.resize(base); return false; }
+        if (lo.flags & HUFF_SYM) *dst++ = (char)lo.sym;
+        state = lo.state;
+        flags = lo.flags;
+    }
+    out.resize(base + (size_t)(dst - start));
+    // the last code must end on the byte boundary or be followed by an EOS prefix of <= 7 bits
+    if (!(flags & HUFF_ACCEPT)) { out.resize(base); return false; }
+    return true;
+}
 
 bool decode_integer(const unsigned char*& p, const unsigned char* end, uint8_t prefix_bits, uint32_t& out) {
     if (p >= end) return false;
@@ -169,27 +294,108 @@ bool decode_string(const unsigned char*& p, const unsigned char* end, std::strin
         out.append((const char*)p, (size_t)len);
         p += len; return true;
     }
-    // Huffman decode
-    const std::vector<Node>& T = HTree();
-    int idx = 0; uint32_t bits = 0; int nbits = 0; size_t consumed = 0;
-    while (consumed < len) {
-        uint8_t byte = *p++; consumed++;
-        for (int i = 7; i >= 0; --i) {
-            int bit = (byte >> i) & 1;
-            int next = (bit ? T[idx].right : T[idx].left);
-            if (next < 0 || next >= (int)T.size()) return false; // invalid path
-            idx = next;
-            if (T[idx].sym >= 0) {
-                unsigned char sym = (unsigned char)T[idx].sym;
-                out.push_back((char)sym);
-                idx = 0;
-            }
+    bool ok = huffman_decode(p, len, out);
+    p += len;
+    return ok;
+}
+
+void DynamicTable::add(std::string&& name, std::string&& value) {
+    size_t sz = entry_size(name, value);
+    if (sz > _max_size) { evict_to(0); return; }
+    evict_to(_max_size - sz);
+    if (_count == _ring.size()) {
+        // grow: lay the entries out again newest first from slot 0
+        std::vector<Entry> ring(_ring.empty() ? 16 : _ring.size() * 2);
+        for (size_t i = 0; i < _count; ++i) {
+            Entry& e = _ring[(_head + i) & (_ring.size() - 1)];
+            ring[i].name.swap(e.name);
+            ring[i].value.swap(e.value);
         }
+        _ring.swap(ring);
+        _head = 0;
+    }
+    _head = (_head - 1) & (_ring.size() - 1);
+    _ring[_head].name = std::move(name);
+    _ring[_head].value = std::move(value);
+    ++_count;
+    _size += sz;
+    ++_inserted;
+}
+
+void DynamicTable::set_max_size(size_t n) {
+    _max_size = n;
+    evict_to(n);
+}
+
+void DynamicTable::evict_to(size_t limit) {
+    while (_size > limit && _count) {
+        Entry& e = _ring[(_head + _count - 1) & (_ring.size() - 1)];
+        _size -= entry_size(e.name, e.value);
+        std::string().swap(e.name);
+        std::string().swap(e.value);
+        --_count;
+    }
+}
+
+bool Decoder::lookup(uint32_t index, std::string& name, std::string* value) const {
+    const std::vector<HeaderField>& st = static_table();
+    if (index == 0) return false;
+    if (index <= st.size()) {
+        name = st[index - 1].name;
+        if (value) *value = st[index - 1].value;
+        return true;
+    }
+    size_t i = index - st.size() - 1;
+    if (i >= _table.count()) return false;
+    const DynamicTable::Entry& e = _table.at(i);
+    name = e.name;
+    if (value) *value = e.value;
+    return true;
+}
+
+bool Decoder::decode(const unsigned char* p, size_t len, HeaderList& out) {
+    const unsigned char* end = p + len;
+    bool fields_seen = false;
+    while (p < end) {
+        uint8_t b = *p;
+        if ((b & 0xE0) == 0x20) {
+            // Dynamic Table Size Update, only before the first field of a block (RFC 7541 4.2)
+            uint32_t n = 0;
+            if (fields_seen || !decode_integer(p, end, 5, n) || n > _max_table_size) return false;
+            _table.set_max_size(n);
+            continue;
+        }
+        fields_seen = true;
+        out.emplace_back();
+        std::string& name = out.back().first;
+        std::string& value = out.back().second;
+        if (b & 0x80) {
+            // Indexed Header Field
+            uint32_t idx = 0;
+            if (!decode_integer(p, end, 7, idx) || !lookup(idx, name, &value)) return false;
+            continue;
+        }
+        // Literal Header Field: with incremental indexing (6-bit name index),
+        // without indexing or never indexed (4-bit name index); index 0 means a literal name
+        bool indexing = (b & 0x40) != 0;
+        uint32_t nameIndex = 0;
+        if (!decode_integer(p, end, indexing ? 6 : 4, nameIndex)) return false;
+        if (nameIndex) {
+            if (!lookup(nameIndex, name, NULL)) return false;
+        } else if (!decode_string(p, end, name)) {
+            return false;
+        }
+        if (!decode_string(p, end, value)) return false;
+        if (indexing) _table.add(std::string(name), std::string(value));
     }
-    // EOS handling: ignore padding bits (RFC 7541: must be set to ones that form EOS prefix). We do not strictly validate here.
     return true;
 }
 
+void Decoder::set_max_table_size(size_t n) {
+    _max_table_size = n;
+    if (_table.max_size() > n) _table.set_max_size(n);
+}
+
 void encode_integer(std::string& out, uint32_t value, uint8_t prefix_bits, uint8_t prefix_mask) {
     uint8_t cap = (1u << prefix_bits) - 1u;
     if (value < cap) {
@@ -216,38 +422,144 @@ void encode_string_raw(std::string& out, const std::string& s) {
     out += s;
 }
 
+size_t huffman_length(const std::string& s) {
+    size_t bits = 0;
+    for (unsigned char ch : s) bits += HUF[ch].nbits;
+    return (bits + 7) / 8;
+}
+
 void encode_string(std::string& out, const std::string& s, bool huffman) {
     if (!huffman) {
         encode_string_raw(out, s);
         return;
     }
-    // Build bitstream using static Huffman codes
+    // length is known up front, so the bits go straight into out
+    encode_integer(out, (uint32_t)huffman_length(s), 7, 0x80);
     uint64_t acc = 0; int bits = 0;
-    std::string payload;
-    payload.reserve(s.size());
     for (unsigned char ch : s) {
-        uint32_t code = HUF[ch].code; uint8_t n = HUF[ch].nbits;
-        acc = (acc << n) | code; bits += n;
+        acc = (acc << HUF[ch].nbits) | HUF[ch].code; bits += HUF[ch].nbits;
         while (bits >= 8) {
-            int shift = bits - 8;
-            unsigned char byte = (unsigned char)((acc >> shift) & 0xff);
-            payload.push_back((char)byte);
             bits -= 8;
-            acc &= ((1ULL << bits) - 1ULL);
+            out.push_back((char)(unsigned char)(acc >> bits));
         }
+        acc &= (1ULL << bits) - 1ULL;
     }
     // Pad with EOS (all 1s) up to next byte boundary per RFC 7541 5.2
-    if (bits > 0) {
-        unsigned char byte = (unsigned char)((acc << (8 - bits)) | ((1u << (8 - bits)) - 1u));
-        payload.push_back((char)byte);
-        bits = 0; acc = 0;
-    }
-    // Write length with huffman bit set and 7-bit prefix
-    // First byte will be produced by encode_integer with prefix 7 and huffman flag (0x80)
-    std::string lenbuf;
-    encode_integer(lenbuf, (uint32_t)payload.size(), 7, 0x80);
-    out += lenbuf;
-    out += payload;
+    if (bits > 0)
+        out.push_back((char)(unsigned char)((acc << (8 - bits)) | ((1u << (8 - bits)) - 1u)));
+}
+
+// Huffman only when it saves bytes
+static void encode_string_auto(std::string& out, const std::string& s) {
+    encode_string(out, s, huffman_length(s) < s.size());
+}
+
+// Values that differ on almost every message; indexing them would only evict reusable entries
+static bool per_message_field(const std::string& name) {
+    static const char* const names[] = {
+        ":path", "content-length", "content-range", "etag", "last-modified", "age", "location",
+        "if-modified-since", "if-none-match", "if-range", "x-request-id",
+    };
+    for (const char* n : names) {
+        if (name == n) return true;
+    }
+    return false;
+}
+
+// RFC 7541 7.1.3: credentials and short, guessable cookies must not enter any table
+static bool sensitive_field(const std::string& name, const std::string& value) {
+    switch (name.size()) {   // checked for every field, so compare only where the length fits
+    case 6:  return value.size() < 20 && name == "cookie";
+    case 10: return value.size() < 20 && name == "set-cookie";
+    case 13: return name == "authorization";
+    case 19: return name == "proxy-authorization";
+    default: return false;
+    }
+}
+
+Encoder::Encoder(size_t limit)
+    : _table(limit < 4096 ? limit : 4096)
+    , _limit(limit)
+    , _size_update(limit < 4096)          // the peer starts at 4096
+    , _size_update_min(_table.max_size()) {
+    memset(_pair_slot, 0, sizeof(_pair_slot));
+    memset(_name_slot, 0, sizeof(_name_slot));
+    // more slots than the table can ever hold entries (32 bytes each at least)
+    size_t n = 64;
+    while (n <= limit / 32) n *= 2;
+    _pair_next.assign(n, 0);
+    _name_next.assign(n, 0);
+}
+
+void Encoder::set_max_table_size(size_t n) {
+    size_t use = n < _limit ? n : _limit;
+    if (use == _table.max_size()) return;
+    _size_update_min = (_size_update && _size_update_min < use) ? _size_update_min : use;
+    _size_update = true;
+    _table.set_max_size(use);
+}
+
+void Encoder::begin_block(std::string& out) {
+    if (!_size_update) return;
+    if (_size_update_min < _table.max_size()) encode_integer(out, (uint32_t)_size_update_min, 5, 0x20);
+    encode_integer(out, (uint32_t)_table.max_size(), 5, 0x20);
+    _size_update = false;
+}
+
+// Chains run newest to oldest, so the first evicted number ends the walk
+uint32_t Encoder::find_pair(uint32_t h, const std::string& name, const std::string& value) const {
+    uint64_t newest = _table.inserted();
+    size_t mask = _pair_next.size() - 1;
+    for (uint64_t seq = _pair_slot[h & (HASH_SLOTS - 1)]; seq && seq + _table.count() > newest; seq = _pair_next[seq & mask]) {
+        size_t i = (size_t)(newest - seq);
+        const DynamicTable::Entry& e = _table.at(i);
+        if (e.name == name && e.value == value) return (uint32_t)(static_table().size() + 1 + i);
+    }
+    return 0;
+}
+
+uint32_t Encoder::find_name(uint32_t h, const std::string& name) const {
+    uint64_t newest = _table.inserted();
+    size_t mask = _name_next.size() - 1;
+    for (uint64_t seq = _name_slot[h & (HASH_SLOTS - 1)]; seq && seq + _table.count() > newest; seq = _name_next[seq & mask]) {
+        size_t i = (size_t)(newest - seq);
+        if (_table.at(i).name == name) return (uint32_t)(static_table().size() + 1 + i);
+    }
+    return 0;
+}
+
+void Encoder::add(uint32_t pair_hash, uint32_t name_hash, const std::string& name, const std::string& value) {
+    uint64_t before = _table.inserted();
+    _table.add(std::string(name), std::string(value));
+    if (_table.inserted() == before) return;   // larger than the table: emptied it instead
+    uint64_t seq = _table.inserted();
+    uint64_t& pair_head = _pair_slot[pair_hash & (HASH_SLOTS - 1)];
+    uint64_t& name_head = _name_slot[name_hash & (HASH_SLOTS - 1)];
+    _pair_next[seq & (_pair_next.size() - 1)] = pair_head;
+    _name_next[seq & (_name_next.size() - 1)] = name_head;
+    pair_head = seq;
+    name_head = seq;
+}
+
+void Encoder::encode(std::string& out, const std::string& name, const std::string& value, bool sensitive) {
+    const StaticIndex& st = static_index();
+    uint32_t nh = hash_name(name);
+    uint32_t ph = hash_pair(nh, value);
+    bool never = sensitive || sensitive_field(name, value);
+    if (!never) {
+        uint32_t idx = st.find_pair(ph, name, value);
+        if (!idx) idx = find_pair(ph, name, value);
+        if (idx) { encode_integer(out, idx, 7, 0x80); return; }
+    }
+    uint32_t name_idx = st.find_name(nh, name);
+    if (!name_idx) name_idx = find_name(nh, name);
+    bool indexing = !never && !per_message_field(name)
+        && DynamicTable::entry_size(name, value) <= _table.max_size() * 3 / 4;
+    if (indexing) encode_integer(out, name_idx, 6, 0x40);
+    else encode_integer(out, name_idx, 4, never ? 0x10 : 0x00);
+    if (!name_idx) encode_string_auto(out, name);
+    encode_string_auto(out, value);
+    if (indexing) add(ph, nh, name, value);
 }
 
 } // namespace hpack
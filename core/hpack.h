@@ -16,8 +16,13 @@ const std::vector<HeaderField>& static_table();
 bool decode_integer(const unsigned char*& p, const unsigned char* end, uint8_t prefix_bits, uint32_t& out);
 
 // Decode an HPACK string (length + optional huffman), append to out
+// Huffman strings are decoded 4 bits at a time by a table-driven state machine; an EOS symbol,
+// padding longer than 7 bits or padding that is not all ones fails (RFC 7541 5.2)
 bool decode_string(const unsigned char*& p, const unsigned char* end, std::string& out);
 
+// RFC 7541 Appendix B code of sym (0..255, 256 is EOS), for tests and benchmarks
+void huffman_code(unsigned sym, uint32_t& code, uint8_t& nbits);
+
 // Encode an HPACK string; if huffman=true use HPACK static Huffman table
 void encode_string(std::string& out, const std::string& s, bool huffman);
 
@@ -25,7 +30,110 @@ void encode_string(std::string& out, const std::string& s, bool huffman);
 void encode_integer(std::string& out, uint32_t value, uint8_t prefix_bits, uint8_t prefix_mask);
 void encode_string_raw(std::string& out, const std::string& s);
 
-// Optional: lookup static index for name (returns 0 if not found)
+// Huffman-encoded length of s in bytes, without the length prefix
+size_t huffman_length(const std::string& s);
+
+// Static table lookups through a hash built once (return 0 if not found)
 uint32_t static_index_of_name(const std::string& name);
+uint32_t static_index_of_pair(const std::string& name, const std::string& value);
+
+// Decoder dynamic table (RFC 7541 2.3.2, 4): a ring of entries, newest first.
+// Entry i (0-based, 0 = newest) is HPACK index 62 + i; adding past max_size() evicts the oldest.
+class DynamicTable {
+public:
+    struct Entry { std::string name; std::string value; };
+
+    explicit DynamicTable(size_t max_size = 4096) : _head(0), _count(0), _size(0), _max_size(max_size), _inserted(0) {}
+
+    size_t count() const { return _count; }
+    size_t size() const { return _size; }          // sum of name + value + 32 per entry
+    size_t max_size() const { return _max_size; }
+    const Entry& at(size_t i) const { return _ring[(_head + i) & (_ring.size() - 1)]; }
+    // entries ever added; entry i was the (inserted() - i)-th, so a number stays valid while the entry does
+    uint64_t inserted() const { return _inserted; }
+
+    // an entry larger than max_size() empties the table and is not added
+    void add(std::string&& name, std::string&& value);
+    void set_max_size(size_t n);
+
+    static size_t entry_size(const std::string& name, const std::string& value) { return name.size() + value.size() + 32; }
+
+private:
+    void evict_to(size_t limit);
+
+    std::vector<Entry> _ring;   // capacity is a power of two; _head is the newest entry
+    size_t _head;
+    size_t _count;
+    size_t _size;
+    size_t _max_size;
+    uint64_t _inserted;
+};
+
+// Per-connection HPACK decoder: static + dynamic table, size updates and all field representations.
+// One instance per direction of a connection; header blocks must be fed whole and in order.
+class Decoder {
+public:
+    typedef std::vector<std::pair<std::string, std::string>> HeaderList;
+
+    // max_table_size: the SETTINGS_HEADER_TABLE_SIZE we advertised (4096 unless changed)
+    explicit Decoder(size_t max_table_size = 4096) : _table(max_table_size), _max_table_size(max_table_size) {}
+
+    // Decode one complete header block and append its fields to out. false is a COMPRESSION_ERROR:
+    // the connection must be closed since the table may be left half updated.
+    bool decode(const unsigned char* p, size_t len, HeaderList& out);
+
+    // a lower limit takes effect at once; the peer confirms it with a size update
+    void set_max_table_size(size_t n);
+
+    const DynamicTable& table() const { return _table; }
+
+private:
+    // HPACK index (1-based, static then dynamic) to name and, if value is not null, value
+    bool lookup(uint32_t index, std::string& name, std::string* value) const;
+
+    DynamicTable _table;
+    size_t _max_table_size;
+};
+
+// Per-connection HPACK encoder. Its dynamic table mirrors the peer decoder's; hash buckets over
+// (name, value) and over name hold the newest entry's insertion number, chained to older ones, so
+// a match is found without scanning the table.
+// - exact match in the static or dynamic table: Indexed Header Field
+// - sensitive fields (authorization, proxy-authorization, short cookies) are Never Indexed
+// - per-response values (content-length, :path, etag, ...) and fields over 3/4 of the table are
+//   sent without indexing so they do not push reusable entries out
+// - strings are Huffman-coded only when that is shorter
+class Encoder {
+public:
+    // limit: the most table we will use whatever the peer allows
+    explicit Encoder(size_t limit = 4096);
+
+    // peer's SETTINGS_HEADER_TABLE_SIZE; the change is announced at the start of the next block
+    void set_max_table_size(size_t n);
+
+    // call once before the fields of each header block
+    void begin_block(std::string& out);
+
+    // name must be lowercase; sensitive forces Never Indexed
+    void encode(std::string& out, const std::string& name, const std::string& value, bool sensitive = false);
+
+    const DynamicTable& table() const { return _table; }
+
+private:
+    enum { HASH_SLOTS = 128 };
+
+    uint32_t find_pair(uint32_t h, const std::string& name, const std::string& value) const;
+    uint32_t find_name(uint32_t h, const std::string& name) const;
+    void add(uint32_t pair_hash, uint32_t name_hash, const std::string& name, const std::string& value);
+
+    DynamicTable _table;
+    size_t _limit;
+    bool _size_update;          // a size update is owed to the peer
+    size_t _size_update_min;    // smallest size set since the last block (RFC 7541 4.2)
+    uint64_t _pair_slot[HASH_SLOTS];    // newest insertion number per bucket, 0 = none
+    uint64_t _name_slot[HASH_SLOTS];
+    std::vector<uint64_t> _pair_next;   // by insertion number: the next older one in its bucket
+    std::vector<uint64_t> _name_next;
+};
 
 } // namespace hpack
@@ -1,5 +1,6 @@
 #include "client_iface.h"
 #include "http2_frame.h"
+#include "hpack.h"
 #include <string>
 #include <map>
 #include <memory>
@@ -150,43 +151,14 @@ public:
         std::string fh = h2::make_frame_header((uint32_t)block.size(), h2::HEADERS, flags, 1);
         if (!send_all(fh + block)) { SSL_free(ssl); SSL_CTX_free(ctx); ::close(fd); return {}; }
 
-        // --- Minimal HPACK decode helpers (no Huffman) ---
-        auto read_int = [](const unsigned char*& p, const unsigned char* end, int prefix_bits, uint32_t& out)->bool{
-            if (p >= end) return false; uint8_t first = *p++;
-            uint32_t max = (1u<<prefix_bits)-1u; uint32_t val = (first & max);
-            if (val < max) { out = val; return true; }
-            uint32_t m = 0; uint32_t add = 0; do { if (p>=end) return false; add = (uint32_t)(*p & 0x7f); val += (add << m); m += 7; } while((*p++ & 0x80) == 0x80);
-            out = val; return true;
-        };
-        auto read_str = [](const unsigned char*& p, const unsigned char* end, std::string& s)->bool{
-            if (p>=end) return false; uint8_t b = *p++; bool huffman = (b & 0x80) != 0; uint32_t len = (b & 0x7f);
-            if (len == 0x7f) { uint32_t m=0, add=0; len=0x7f; do { if (p>=end) return false; add = (uint32_t)(*p & 0x7f); len += (add << m); m+=7; } while((*p++ & 0x80)==0x80); }
-            if (p+len > end) return false; if (huffman) return false; // not supported
-            s.assign((const char*)p, (const char*)p+len); p += len; return true;
-        };
-        auto static_status_by_index = [](uint32_t idx)->int{
-            switch(idx){
-                case 8: return 200; case 9: return 204; case 10: return 206; case 11: return 304; case 12: return 400; case 13: return 404; case 14: return 500; default: return 0;
-            }
-        };
+        // --- HPACK: one decoder for the connection, fed every response header block in order ---
+        hpack::Decoder hpack_dec;
         auto decode_headers = [&](const std::string& block, HttpResult& out_headers)->bool{
-            const unsigned char* p = (const unsigned char*)block.data();
-            const unsigned char* e = p + block.size();
-            while (p < e) {
-                if (*p & 0x80) { // indexed header field (1xxxxxxx)
-                    uint32_t idx=0; if (!read_int(p,e,7,idx)) return false;
-                    int st = static_status_by_index(idx); if (st>0) { out_headers.status = st; continue; }
-                } else if ((*p & 0x40) == 0x40) { // literal with incremental indexing (01xxxxxx)
-                    uint32_t n=0; std::string name, value; uint8_t first = *p;
-                    if ((first & 0x3f) == 0) { ++p; if (!read_str(p,e,name)) return false; }
-                    else { if (!read_int(p,e,6,n)) return false; if (n==8||n==9||n==10||n==11||n==12||n==13||n==14) name=":status"; else name.clear(); }
-                    if (!read_str(p,e,value)) return false; if (name == ":status") out_headers.status = atoi(value.c_str());
-                } else { // literal without indexing (0000xxxx)
-                    uint32_t n=0; std::string name, value; uint8_t first = *p;
-                    if ((first & 0x0f) == 0) { ++p; if (!read_str(p,e,name)) return false; }
-                    else { if (!read_int(p,e,4,n)) return false; if (n==0) return false; if (n==8||n==9||n==10||n==11||n==12||n==13||n==14) name=":status"; else name.clear(); }
-                    if (!read_str(p,e,value)) return false; if (name == ":status") out_headers.status = atoi(value.c_str());
-                }
+            hpack::Decoder::HeaderList fields;
+            if (!hpack_dec.decode((const unsigned char*)block.data(), block.size(), fields)) return false;
+            for (auto& kv : fields) {
+                if (kv.first == ":status") out_headers.status = atoi(kv.second.c_str());
+                else if (kv.first[0] != ':') out_headers.headers[kv.first] = kv.second;
             }
             return true;
         };
@@ -219,7 +191,7 @@ public:
                     std::string cp; cp.resize(clen); if (clen>0) { if (!recv_n((unsigned char*)&cp[0], clen)) { done=true; break; } }
                     block += cp; end_headers = (cflags & 0x4) != 0;
                 }
-                (void)decode_headers(block, out);
+                if (!decode_headers(block, out)) { done = true; break; } // COMPRESSION_ERROR
                 if (flags_in & 0x1 /*END_STREAM*/) done = true;
             } else if (type == h2::DATA && sid == 1) {
                 // Append response body and maintain HTTP/2 flow control by
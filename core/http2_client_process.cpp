@@ -1,5 +1,6 @@
 #include "http2_client_process.h"
 #include "http2_frame.h"
+#include "hpack.h"
 #include "base_thread.h"
 #include "base_net_obj.h"
 #include <iostream>
@@ -144,28 +145,41 @@ std::string* http2_client_process::get_send_buf() {
     return base_data_process::get_send_buf();
 }
 
+bool http2_client_process::get_send_slice(myframe::send_slice& out) {
+    if (!_sent_all) enqueue_preface_and_request();
+    return base_data_process::get_send_slice(out);
+}
+
 static uint32_t read24u(const unsigned char* p){ return ((uint32_t)p[0]<<16)|((uint32_t)p[1]<<8)|p[2]; }
 static uint32_t read32u(const unsigned char* p){ return ((uint32_t)p[0]<<24)|((uint32_t)p[1]<<16)|((uint32_t)p[2]<<8)|p[3]; }
 
-// Minimal HPACK decode helpers (no Huffman) to extract :status if present
-static bool hp_read_int(const unsigned char*& p, const unsigned char* e, int prefix_bits, uint32_t& out){ if (p>=e) return false; uint8_t first=*p++; uint32_t max=(1u<<prefix_bits)-1u; uint32_t val=(first & max); if (val<max){ out=val; return true;} uint32_t m=0,add=0; do{ if(p>=e) return false; add=(uint32_t)(*p & 0x7f); val += (add<<m); m+=7; }while((*p++ & 0x80)==0x80); out=val; return true; }
-static bool hp_read_str(const unsigned char*& p, const unsigned char* e, std::string& s){ if (p>=e) return false; uint8_t b=*p++; bool h=(b&0x80)!=0; uint32_t len=(b&0x7f); if (len==0x7f){ uint32_t m=0,add=0; len=0x7f; do{ if(p>=e) return false; add=(uint32_t)(*p & 0x7f); len += (add<<m); m+=7; }while((*p++ & 0x80)==0x80);} if ((size_t)(e-p) < len) return false; if (h) return false; s.assign((const char*)p, (const char*)p+len); p += len; return true; }
-
 bool http2_client_process::handle_headers_payload(const unsigned char* p, uint32_t len, uint8_t flags) {
     uint8_t pad_len = 0; const unsigned char* pp = p; const unsigned char* pe = p + len;
     if (flags & 0x08 /*PADDED*/) { if (pp>=pe) return false; pad_len = *pp++; }
     if (flags & 0x20 /*PRIORITY*/) { if ((size_t)(pe-pp) < 5) return false; pp += 5; }
     size_t header_len = (size_t)(pe-pp); if (header_len < pad_len) return false; size_t remain = header_len - pad_len;
-    std::string block; block.assign((const char*)pp, remain);
-    // If not END_HEADERS, expect CONTINUATION frames in parse_frames()
-    // Minimal decode: only extract :status
-    const unsigned char* bp = (const unsigned char*)block.data(); const unsigned char* be = bp + block.size();
-    while (bp < be) {
-        if (*bp & 0x80) { uint32_t idx=0; if (!hp_read_int(bp,be,7,idx)) return false; if (idx>=8 && idx<=14) { static const int map[]={0,0,0,0,0,0,0,200,204,206,304,400,404,500}; int v = map[idx]; if (v) _status = v; } }
-        else if ((*bp & 0x40) == 0x40) { uint32_t n=0; std::string name,value; uint8_t first=*bp; if ((first & 0x3f)==0){ ++bp; if (!hp_read_str(bp,be,name)) return false; } else { if (!hp_read_int(bp,be,6,n)) return false; if (n>=8 && n<=14) name=":status"; }
-            if (!hp_read_str(bp,be,value)) return false; if (name==":status") _status = atoi(value.c_str()); }
-        else { uint32_t n=0; std::string name,value; uint8_t first=*bp; if ((first & 0x0f)==0){ ++bp; if (!hp_read_str(bp,be,name)) return false; } else { if (!hp_read_int(bp,be,4,n)) return false; if (n==0) return false; if (n>=8 && n<=14) name=":status"; }
-            if (!hp_read_str(bp,be,value)) return false; if (name==":status") _status = atoi(value.c_str()); }
+    // CONTINUATION frames append to _hdr_block until END_HEADERS
+    _hdr_block.assign((const char*)pp, remain);
+    return true;
+}
+
+bool http2_client_process::handle_headers_done() {
+    // the whole block goes through the decoder (even trailers) to keep its dynamic table in step
+    hpack::Decoder::HeaderList headers;
+    bool ok = _hpack_dec.decode((const unsigned char*)_hdr_block.data(), _hdr_block.size(), headers);
+    _hdr_block.clear();
+    if (!ok) { PDEBUG("[h2] HPACK decode error"); return false; }
+    for (auto& kv : headers) { if (kv.first == ":status") _status = atoi(kv.second.c_str()); }
+    if (_hdr_end_stream) {
+        _headers_end_stream = true;
+        // Only treat as done for statuses without body or HEAD method
+        std::string m = _method; for (auto& c : m) c = (char)tolower((unsigned char)c);
+        if (_status == 204 || _status == 304 || m == "head") {
+            _response_done = true;
+            notify_done();
+        } else {
+            PDEBUG("[h2] HEADERS had END_STREAM but status=%d method=%s -> waiting for DATA", _status, m.c_str());
+        }
     }
     return true;
 }
@@ -181,24 +195,14 @@ bool http2_client_process::parse_frames() {
         else if (type == HEADERS && sid == 1) {
             PDEBUG("[h2] HEADERS len=%u flags=0x%x sid=%u", len, flags, sid);
             if (!handle_headers_payload(payload, len, flags)) return false;
-            if ((flags & 0x4) == 0) {
-                // need to gather CONTINUATIONs until END_HEADERS
-                size_t cont_off = off + 9 + len; while (n - cont_off >= 9) {
-                    const unsigned char* ch = &_in[cont_off]; uint32_t clen = read24u(ch); uint8_t ctype = ch[3]; uint8_t cflags = ch[4]; uint32_t csid = read32u(ch+5) & 0x7fffffffu; if (n - cont_off < 9 + clen) break; if (ctype != CONTINUATION || csid != 1) break; // ignore unexpected
-                    if (clen) { if (!handle_headers_payload(ch+9, clen, cflags)) return false; }
-                    cont_off += 9 + clen; if (cflags & 0x4) break; }
-            }
-            if (flags & 0x1 /*END_STREAM*/) {
-                _headers_end_stream = true;
-                // Only treat as done for statuses without body or HEAD method
-                std::string m = _method; for (auto& c : m) c = (char)tolower((unsigned char)c);
-                if (_status == 204 || _status == 304 || m == "head") {
-                    _response_done = true;
-                    notify_done();
-                } else {
-                    PDEBUG("[h2] HEADERS had END_STREAM but status=%d method=%s -> waiting for DATA", _status, m.c_str());
-                }
-            }
+            _hdr_end_stream = (flags & 0x1 /*END_STREAM*/) != 0;
+            _hdr_assembling = (flags & 0x4 /*END_HEADERS*/) == 0;
+            if (!_hdr_assembling && !handle_headers_done()) return false;
+        }
+        else if (type == CONTINUATION) {
+            if (!_hdr_assembling || sid != 1) return false;
+            _hdr_block.append((const char*)payload, len);
+            if (flags & 0x4 /*END_HEADERS*/) { _hdr_assembling = false; if (!handle_headers_done()) return false; }
         }
         else if (type == DATA && sid == 1) {
             PDEBUG("[h2] DATA len=%u flags=0x%x sid=%u", len, flags, sid);
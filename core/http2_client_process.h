@@ -1,6 +1,7 @@
 #pragma once
 
 #include "base_data_process.h"
+#include "hpack.h"
 #include <string>
 #include <map>
 #include <vector>
@@ -25,6 +26,7 @@ public:
 
     virtual size_t process_recv_buf(const char* buf, size_t len) override;
     virtual std::string* get_send_buf() override;
+    virtual bool get_send_slice(myframe::send_slice& out) override;
     virtual void handle_timeout(std::shared_ptr<timer_msg>& t_msg) override;
 
     // Convenience helpers for asynchronous callers (examples/tests).
@@ -40,6 +42,7 @@ private:
     // parsing helpers
     bool parse_frames();
     bool handle_headers_payload(const unsigned char* p, uint32_t len, uint8_t flags);
+    bool handle_headers_done(); // END_HEADERS: decode the assembled block
 
     void notify_done();
 
@@ -54,6 +57,12 @@ private:
     bool _response_done{false};
     bool _headers_end_stream{false};
 
+    // response header block (HEADERS + CONTINUATION) and the connection's HPACK decoder
+    hpack::Decoder _hpack_dec;
+    std::string _hdr_block;
+    bool _hdr_assembling{false};
+    bool _hdr_end_stream{false};
+
     // Debug/trace knob
     bool _trace{false};
 
@@ -45,7 +45,8 @@ enum ErrorCode : uint32_t {
     STREAM_CLOSED       = 0x5,
     FRAME_SIZE_ERROR    = 0x6,
     REFUSED_STREAM      = 0x7,
-    CANCEL              = 0x8
+    CANCEL              = 0x8,
+    COMPRESSION_ERROR   = 0x9
 };
 
 inline void write24(std::string& out, uint32_t v) {
@@ -69,13 +70,29 @@ inline uint32_t read32(const unsigned char* p) {
     return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
 }
 
+// 9-byte frame header written over p (used to fill in a header reserved before the payload was known)
+inline void put_frame_header(char* p, uint32_t len, FrameType type, uint8_t flags, uint32_t stream_id) {
+    p[0] = (char)((len >> 16) & 0xff);
+    p[1] = (char)((len >> 8) & 0xff);
+    p[2] = (char)(len & 0xff);
+    p[3] = (char)type;
+    p[4] = (char)flags;
+    stream_id &= 0x7fffffffu;
+    p[5] = (char)((stream_id >> 24) & 0xff);
+    p[6] = (char)((stream_id >> 16) & 0xff);
+    p[7] = (char)((stream_id >> 8) & 0xff);
+    p[8] = (char)(stream_id & 0xff);
+}
+
+inline void append_frame_header(std::string& out, uint32_t len, FrameType type, uint8_t flags, uint32_t stream_id) {
+    size_t at = out.size();
+    out.resize(at + 9);
+    put_frame_header(&out[at], len, type, flags, stream_id);
+}
+
 inline std::string make_frame_header(uint32_t len, FrameType type, uint8_t flags, uint32_t stream_id) {
     std::string out;
-    out.reserve(9);
-    write24(out, len & 0x00ffffffu);
-    out.push_back((char)type);
-    out.push_back((char)flags);
-    write32(out, stream_id & 0x7fffffffu);
+    append_frame_header(out, len, type, flags, stream_id);
     return out;
 }
 
@@ -0,0 +1,137 @@
+#include "http2_frame_writer.h"
+#include "string_pool.h"
+
+namespace h2
+{
+
+void frame_writer::roll()
+{
+    // a full buffer is closed between frames, never inside one
+    if (_cur && _cur->size() >= BUFFER_BYTES)
+    {
+        _full.push_back(_cur);
+        _cur = nullptr;
+    }
+}
+
+void frame_writer::header(uint32_t len, FrameType type, uint8_t flags, uint32_t stream_id)
+{
+    roll();
+    append_frame_header(buffer(), len, type, flags, stream_id);
+    // 0x1 is END_STREAM on DATA and HEADERS
+    if (type == RST_STREAM || ((type == DATA || type == HEADERS) && (flags & 0x1)))
+        close_stream(stream_id);
+}
+
+void frame_writer::frame(FrameType type, uint8_t flags, uint32_t stream_id, const char* payload, size_t len)
+{
+    header((uint32_t)len, type, flags, stream_id);
+    if (len)
+        _cur->append(payload, len);
+}
+
+void frame_writer::append(const std::string& frame)
+{
+    roll();
+    buffer().append(frame);
+    const unsigned char* h = (const unsigned char*)frame.data();
+    if (frame.size() >= 9 && h[3] == RST_STREAM)
+        close_stream(read32(h + 5) & 0x7fffffffu);
+}
+
+std::string& frame_writer::buffer()
+{
+    if (!_cur)
+        _cur = myframe::string_acquire();
+    return *_cur;
+}
+
+void frame_writer::window_update(uint32_t stream_id, uint32_t increment)
+{
+    if (!increment)
+        return;
+    uint32_t* credit = nullptr;
+    if (stream_id == 0)
+    {
+        credit = &_conn_credit;
+    }
+    else
+    {
+        for (size_t i = 0; i < _stream_credit.size(); ++i)
+        {
+            if (_stream_credit[i].first == stream_id) { credit = &_stream_credit[i].second; break; }
+        }
+        if (!credit)
+        {
+            _stream_credit.emplace_back(stream_id, 0);
+            credit = &_stream_credit.back().second;
+        }
+    }
+    // an increment is at most 2^31-1; write out what has built up before it would overflow
+    if (*credit > 0x7fffffffu - increment)
+    {
+        write_window_update(stream_id, *credit);
+        *credit = 0;
+    }
+    *credit += increment;
+}
+
+void frame_writer::close_stream(uint32_t stream_id)
+{
+    for (size_t i = 0; i < _stream_credit.size(); ++i)
+    {
+        if (_stream_credit[i].first == stream_id)
+        {
+            _stream_credit.erase(_stream_credit.begin() + i);
+            return;
+        }
+    }
+}
+
+void frame_writer::write_window_update(uint32_t stream_id, uint32_t increment)
+{
+    header(4, WINDOW_UPDATE, 0, stream_id);
+    write32(*_cur, increment & 0x7fffffffu);
+}
+
+void frame_writer::flush_credit()
+{
+    if (_conn_credit)
+    {
+        write_window_update(0, _conn_credit);
+        _conn_credit = 0;
+    }
+    for (size_t i = 0; i < _stream_credit.size(); ++i)
+        write_window_update(_stream_credit[i].first, _stream_credit[i].second);
+    _stream_credit.clear();
+}
+
+std::string* frame_writer::take()
+{
+    flush_credit();
+    std::string* out = nullptr;
+    if (!_full.empty())
+    {
+        out = _full.front();
+        _full.pop_front();
+    }
+    else if (_cur && !_cur->empty())
+    {
+        out = _cur;
+        _cur = nullptr;
+    }
+    return out;
+}
+
+void frame_writer::clear()
+{
+    for (size_t i = 0; i < _full.size(); ++i)
+        myframe::string_release(_full[i]);
+    _full.clear();
+    myframe::string_release(_cur);
+    _cur = nullptr;
+    _conn_credit = 0;
+    _stream_credit.clear();
+}
+
+} // namespace h2
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "http2_frame.h"
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace h2
+{
+
+// Output side of one HTTP/2 connection.
+// - Frames are appended into pooled buffers (string_acquire); a buffer is closed once it
+//   passes BUFFER_BYTES, so a writev gets a few large segments instead of one per frame
+// - WINDOW_UPDATE credits are summed per stream and written once, when a buffer is taken;
+//   a stream's credit is dropped once END_STREAM or RST_STREAM is queued for it, so no
+//   WINDOW_UPDATE follows the frame that closes the stream
+// - take() hands buffers out in order; the caller owns them (string_release or a send_slice)
+class frame_writer
+{
+    public:
+        static const size_t BUFFER_BYTES = 64 * 1024;
+
+        frame_writer() {}
+        ~frame_writer() { clear(); }
+        frame_writer(const frame_writer&) = delete;
+        frame_writer& operator=(const frame_writer&) = delete;
+
+        // frame header; the caller appends exactly len payload bytes to buffer()
+        void header(uint32_t len, FrameType type, uint8_t flags, uint32_t stream_id);
+        void frame(FrameType type, uint8_t flags, uint32_t stream_id, const char* payload, size_t len);
+        // a complete frame built elsewhere (make_goaway, make_rst_stream, ...)
+        void append(const std::string& frame);
+        // buffer the next frame goes into, for payloads produced in place
+        std::string& buffer();
+
+        // credit given back to the peer; merged with earlier credit for the same stream
+        void window_update(uint32_t stream_id, uint32_t increment);
+        // END_STREAM / RST_STREAM for the stream is queued; header() and append() call this
+        // themselves, callers that set END_STREAM in a header rewritten in place call it directly
+        void close_stream(uint32_t stream_id);
+
+        // next buffer to send (pending WINDOW_UPDATEs are written first), NULL when nothing is queued
+        std::string* take();
+
+        bool empty() const { return _full.empty() && (!_cur || _cur->empty()) && !_conn_credit && _stream_credit.empty(); }
+        // bytes in the buffer currently being filled
+        size_t pending() const { return _cur ? _cur->size() : 0; }
+        void clear();
+
+    private:
+        void roll();
+        void write_window_update(uint32_t stream_id, uint32_t increment);
+        void flush_credit();
+
+        std::deque<std::string*> _full;
+        std::string* _cur{nullptr};
+        uint32_t _conn_credit{0};
+        std::vector<std::pair<uint32_t, uint32_t>> _stream_credit;
+};
+
+} // namespace h2
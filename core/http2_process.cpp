@@ -1,5 +1,8 @@
 #include "http2_process.h"
+#include "base_net_obj.h"
 #include "common_exception.h"
+#include "string_pool.h"
+#include "http_compress.h"
 
 #include <cstring>
 #include "hpack.h"
@@ -8,8 +11,8 @@ using namespace h2;
 void http2_process::on_connected_once() {
     if (_sent_settings) return;
     // Send server SETTINGS (ENABLE_PUSH=0)
-    std::string settings = make_settings_frame(false);
-    put_send_move(std::move(settings));
+    _writer.append(make_settings_frame(false));
+    schedule_send();
     _sent_settings = true;
 }
 
@@ -18,18 +21,29 @@ static const uint8_t FLAG_END_STREAM = 0x1;
 static const uint8_t FLAG_END_HEADERS = 0x4;
 static const uint8_t FLAG_PADDED = 0x8;
 static const uint8_t FLAG_PRIORITY = 0x20;
+// we never advertise SETTINGS_MAX_FRAME_SIZE, so peers must stay within the default
+static const uint32_t MAX_RECV_FRAME_SIZE = 16384;
 
-bool http2_process::parse_frames(size_t& consumed) {
-    consumed = 0;
-    const size_t n = _in.size();
+// Frames are parsed where they lie in the connection's receive buffer; an incomplete
+// trailing frame is left unconsumed and handed back together with the next read.
+size_t http2_process::parse_frames(const unsigned char* data, size_t n) {
     size_t off = 0;
     while (n - off >= 9) {
-        const unsigned char* p = &_in[off];
+        const unsigned char* p = data + off;
         uint32_t len = read24(p);
         uint8_t  type = p[3];
         uint8_t  flags = p[4];
         uint32_t sid = read32(p + 5) & 0x7fffffffu;
+        if (len > MAX_RECV_FRAME_SIZE) {
+            send_goaway(FRAME_SIZE_ERROR, "frame too large");
+            throw CMyCommonException("http2: frame exceeds SETTINGS_MAX_FRAME_SIZE");
+        }
         if (n - off < 9 + len) break; // incomplete frame
+        // a header block must be continued on its own stream before anything else
+        if (_assembling && (type != CONTINUATION || sid != _assembling_sid)) {
+            send_goaway(PROTOCOL_ERROR, "expected CONTINUATION");
+            throw CMyCommonException("http2: frame interleaved with header block");
+        }
 
         const unsigned char* payload = p + 9;
         // Minimal handling for SETTINGS/HEADERS/PING/CONTINUATION
@@ -40,8 +54,7 @@ bool http2_process::parse_frames(size_t& consumed) {
                 // validate pairs (6 bytes each) but ignore content
                 if (len % 6 != 0) {
                     // protocol error → GOAWAY
-                    std::string go = make_goaway(0, FRAME_SIZE_ERROR, "bad settings len");
-                    put_send_move(std::move(go));
+                    send_goaway(FRAME_SIZE_ERROR, "bad settings len");
                     throw CMyCommonException("http2: invalid SETTINGS length");
                 }
                 // parse settings
@@ -60,24 +73,22 @@ bool http2_process::parse_frames(size_t& consumed) {
                         _peer_max_frame_size = val;
                     } else if (id == SETTINGS_HEADER_TABLE_SIZE) {
                         // peer's decoder dynamic table size for our encoder
-                        _enc_tbl_max = val;
-                        enc_dyn_evict();
+                        _hpack_enc.set_max_table_size(val);
                     }
                 }
                 // flow-control related settings may unblock sending
                 pump_all_streams();
+                wake_sources();
                 // reply ACK
-                std::string ack = make_settings_ack();
-                put_send_move(std::move(ack));
+                _writer.frame(SETTINGS, FLAGS_ACK, 0, NULL, 0);
+                schedule_send();
                 _got_client_settings = true;
             }
         } else if (type == PING) {
             // echo with ACK if length==8
             if (len == 8) {
-                std::string hdr = make_frame_header(8, PING, FLAGS_ACK, 0);
-                std::string frame; frame.reserve(9+8);
-                frame += hdr; frame.append((const char*)payload, 8);
-                put_send_move(std::move(frame));
+                _writer.frame(PING, FLAGS_ACK, 0, (const char*)payload, 8);
+                schedule_send();
             }
         } else if (type == PRIORITY) {
             if (sid == 0 || len < 5) throw CMyCommonException("http2: PRIORITY invalid");
@@ -88,17 +99,22 @@ bool http2_process::parse_frames(size_t& consumed) {
             if (len != 4) throw CMyCommonException("http2: WINDOW_UPDATE len");
             uint32_t inc = read32(payload) & 0x7fffffffu; if (inc == 0) throw CMyCommonException("http2: WINDOW_UPDATE zero");
             if (sid == 0) { _conn_send_window += (int32_t)inc; }
-            else { _streams[sid].send_window += (int32_t)inc; }
+            else {
+                // closed streams are gone; their late updates are ignored
+                auto it = _streams.find(sid);
+                if (it != _streams.end()) it->second.send_window += (int32_t)inc;
+            }
             // attempt to send pending data after window increases
             if (sid == 0) pump_all_streams(); else try_send_data(sid);
+            wake_sources();
             #ifdef DEBUG
             PDEBUG("[h2] WINDOW_UPDATE sid=%u inc=%u conn_win=%d", sid, inc, _conn_send_window);
             #endif
         } else if (type == RST_STREAM) {
+            // bytes a paused sink never took were credited to the connection when they arrived
             _streams.erase(sid);
         } else if (type == HEADERS || type == CONTINUATION) {
-            uint32_t sid_valid = sid;
-            if (sid_valid == 0) { throw CMyCommonException("http2: HEADERS with stream_id=0"); }
+            if (sid == 0) { throw CMyCommonException("http2: HEADERS with stream_id=0"); }
             const unsigned char* pld = payload;
             uint32_t remain = len;
             if (type == HEADERS) {
@@ -108,18 +124,38 @@ bool http2_process::parse_frames(size_t& consumed) {
                     if (remain < 5) throw CMyCommonException("http2: PRIORITY short");
                     pld += 5; remain -= 5;
                 }
-                _assembling = true; _assembling_sid = sid_valid; _assembling_block.assign((const char*)pld, remain);
-            } else { // CONTINUATION
-                if (!_assembling || _assembling_sid != sid_valid) throw CMyCommonException("http2: CONTINUATION state");
+            } else if (!_assembling) {
+                send_goaway(PROTOCOL_ERROR, "unexpected CONTINUATION");
+                throw CMyCommonException("http2: CONTINUATION state");
+            }
+            bool end_stream = false;
+            bool done = (flags & FLAG_END_HEADERS) != 0;
+            if (type == HEADERS && done) {
+                // the common case: the whole block is in this frame, decode it in place
+                end_stream = (flags & FLAG_END_STREAM) != 0;
+            } else if (type == HEADERS) {
+                // reassembled in a per-connection arena that keeps its capacity between blocks
+                _assembling = true; _assembling_sid = sid; _assembling_end_stream = (flags & FLAG_END_STREAM) != 0;
+                _assembling_block.assign((const char*)pld, remain);
+            } else {
                 _assembling_block.append((const char*)pld, remain);
+                if (done) {
+                    pld = (const unsigned char*)_assembling_block.data();
+                    remain = (uint32_t)_assembling_block.size();
+                    end_stream = _assembling_end_stream;
+                    _assembling = false; _assembling_sid = 0;
+                }
             }
-            if (flags & FLAG_END_HEADERS) {
-                bool end_stream = (type == HEADERS) && (flags & FLAG_END_STREAM);
-                std::string blk = std::move(_assembling_block);
-                _assembling = false; _assembling_sid = 0; _assembling_block.clear();
-                (void)handle_headers_block(sid_valid, blk, end_stream);
+            if (done) {
+                bool ok = handle_headers_block(sid, pld, remain, end_stream);
+                _assembling_block.clear();
+                if (!ok) {
+                    // HPACK decode failure is a connection error
+                    send_goaway(COMPRESSION_ERROR, "hpack");
+                    throw CMyCommonException("http2: HPACK decode error");
+                }
 #ifdef DEBUG
-                PDEBUG("[h2] HEADERS_DONE stream=%u end_stream=%d size=%u", sid_valid, end_stream ? 1 : 0, (unsigned)blk.size());
+                PDEBUG("[h2] HEADERS_DONE stream=%u end_stream=%d size=%u", sid, end_stream ? 1 : 0, (unsigned)remain);
 #endif
             }
         } else if (type == DATA) {
@@ -127,107 +163,46 @@ bool http2_process::parse_frames(size_t& consumed) {
             // padding if PADDED flag
             const unsigned char* pld = payload; uint32_t remain = len; uint32_t padlen = 0;
             if (flags & FLAG_PADDED) { if (remain < 1) throw CMyCommonException("http2: DATA padded short"); padlen = *pld; ++pld; --remain; if (padlen > remain) throw CMyCommonException("http2: DATA pad too long"); remain -= padlen; }
-            on_data(sid, pld, remain, (flags & FLAG_END_STREAM));
-            // flow control: add windows back for both stream and connection
-            if (remain > 0) {
-                std::string wu1 = make_window_update(0, remain);
-                std::string wu2 = make_window_update(sid, remain);
-                put_send_move(std::move(wu1));
-                put_send_move(std::move(wu2));
-            }
+            bool end_stream = (flags & FLAG_END_STREAM) != 0;
+            uint32_t taken = on_data(sid, pld, remain, end_stream);
+            // flow control: the connection gets the whole frame back at once, so a paused stream
+            // cannot stall the others (what it queues is capped by its own window). The stream gets
+            // padding back at once and body bytes once the sink has taken them; a streaming sink that
+            // falls behind keeps its window closed until resume().
+            // After END_STREAM, or once the stream was reset, only the connection needs credit.
+            _writer.window_update(0, len);
+            schedule_send();
+            if (!end_stream && _streams.count(sid)) send_window_update(sid, (len - remain) + taken);
         }
         off += 9 + len;
     }
-    consumed = off;
-    return false;
+    return off;
 }
 
 size_t http2_process::process_recv_buf(const char* buf, size_t len) {
     // lazy-send server settings on first activity
     on_connected_once();
 
-    if (len > 0) {
-        _in.insert(_in.end(), (const unsigned char*)buf, (const unsigned char*)buf + len);
-    }
-
-    size_t consumed_total = 0;
+    const unsigned char* data = (const unsigned char*)buf;
+    size_t off = 0;
     // Handle connection preface
     if (!_preface_ok) {
-        if (_in.size() < CONNECTION_PREFACE_LEN) return 0;
-        if (std::memcmp(_in.data(), CONNECTION_PREFACE, CONNECTION_PREFACE_LEN) != 0) {
+        if (len < CONNECTION_PREFACE_LEN) return 0;
+        if (std::memcmp(data, CONNECTION_PREFACE, CONNECTION_PREFACE_LEN) != 0) {
             throw CMyCommonException("http2: bad connection preface");
         }
         _preface_ok = true;
-        _in.erase(_in.begin(), _in.begin() + CONNECTION_PREFACE_LEN);
-        consumed_total += CONNECTION_PREFACE_LEN;
+        off = CONNECTION_PREFACE_LEN;
     }
 
-    // Parse frames
-    size_t consumed = 0;
-    bool sent_goaway = parse_frames(consumed);
-    if (consumed) {
-        _in.erase(_in.begin(), _in.begin() + consumed);
-        consumed_total += consumed;
-    }
-    return consumed_total;
+    // whatever is not consumed stays in the connection's receive buffer
+    return off + parse_frames(data + off, len - off);
 }
 
-bool http2_process::handle_headers_block(uint32_t stream_id, const std::string& block, bool end_stream) {
-    using namespace hpack;
-    // decode HPACK block
-    const unsigned char* p = (const unsigned char*)block.data();
-    const unsigned char* end = p + block.size();
-    std::vector<std::pair<std::string,std::string>> headers;
-    while (p < end) {
-        uint8_t b = *p;
-        if (b & 0x80) {
-            // Indexed Header Field Representation - 7-bit prefix
-            uint32_t idx = 0; if (!decode_integer(p, end, 7, idx)) return false;
-            auto& tbl = static_table(); if (idx == 0 || idx > tbl.size()) return false;
-            headers.emplace_back(tbl[idx-1].name, tbl[idx-1].value);
-        } else if ((b & 0x40) == 0x40) {
-            // Literal Header Field with Incremental Indexing - 6-bit name index or 0 then string
-            uint32_t nameIndex = 0; if (!decode_integer(p, end, 6, nameIndex)) return false;
-            std::string name, value;
-            if (nameIndex) {
-                auto& tbl = static_table(); if (nameIndex == 0 || nameIndex > tbl.size()) return false;
-                name = tbl[nameIndex-1].name;
-            } else {
-                if (!decode_string(p, end, name)) return false;
-            }
-            if (!decode_string(p, end, value)) return false;
-            headers.emplace_back(std::move(name), std::move(value));
-        } else if ((b & 0xF0) == 0x00) {
-            // Literal Header Field without Indexing - 4-bit name index or 0 then string
-            uint32_t nameIndex = 0; if (!decode_integer(p, end, 4, nameIndex)) return false;
-            std::string name, value;
-            if (nameIndex) {
-                auto& tbl = static_table(); if (nameIndex == 0 || nameIndex > tbl.size()) return false;
-                name = tbl[nameIndex-1].name;
-            } else {
-                if (!decode_string(p, end, name)) return false;
-            }
-            if (!decode_string(p, end, value)) return false;
-            headers.emplace_back(std::move(name), std::move(value));
-        } else if ((b & 0xF0) == 0x10) {
-            // Literal Header Field Never Indexed - same as without indexing
-            uint32_t nameIndex = 0; if (!decode_integer(p, end, 4, nameIndex)) return false;
-            std::string name, value;
-            if (nameIndex) {
-                auto& tbl = static_table(); if (nameIndex == 0 || nameIndex > tbl.size()) return false;
-                name = tbl[nameIndex-1].name;
-            } else {
-                if (!decode_string(p, end, name)) return false;
-            }
-            if (!decode_string(p, end, value)) return false;
-            headers.emplace_back(std::move(name), std::move(value));
-        } else if ((b & 0xE0) == 0x20) {
-            // Dynamic Table Size Update - 5-bit integer
-            uint32_t dummy = 0; if (!decode_integer(p, end, 5, dummy)) return false;
-        } else {
-            return false;
-        }
-    }
+bool http2_process::handle_headers_block(uint32_t stream_id, const unsigned char* block, size_t len, bool end_stream) {
+    // decode HPACK block against the connection's dynamic table
+    hpack::Decoder::HeaderList headers;
+    if (!_hpack_dec.decode(block, len, headers)) return false;
 
     // Validate pseudo-header ordering and populate per-stream state
     auto itst = _streams.find(stream_id);
@@ -245,14 +220,13 @@ bool http2_process::handle_headers_block(uint32_t stream_id, const std::string&
         if (!is_pseudo) seen_regular = true;
         if (is_pseudo && seen_regular) {
             // Pseudo-header after regular header: RST_STREAM (stream-level error)
-            std::string rst = make_rst_stream(stream_id, PROTOCOL_ERROR);
-            put_send_move(std::move(rst));
+            send_rst_stream(stream_id, PROTOCOL_ERROR);
             _streams.erase(stream_id);
             PDEBUG("[h2] RST_STREAM stream=%u reason=pseudo-after-regular", stream_id);
             return true;
         }
-        if (kv.first == ":method") { if (seen_method) { std::string rst = make_rst_stream(stream_id, PROTOCOL_ERROR); put_send_move(std::move(rst)); _streams.erase(stream_id); PDEBUG("[h2] RST_STREAM stream=%u reason=dup-:method", stream_id); return true; } st.method = kv.second; seen_method = true; }
-        else if (kv.first == ":path") { if (seen_path) { std::string rst = make_rst_stream(stream_id, PROTOCOL_ERROR); put_send_move(std::move(rst)); _streams.erase(stream_id); PDEBUG("[h2] RST_STREAM stream=%u reason=dup-:path", stream_id); return true; } st.path = kv.second; seen_path = true; }
+        if (kv.first == ":method") { if (seen_method) { send_rst_stream(stream_id, PROTOCOL_ERROR); _streams.erase(stream_id); PDEBUG("[h2] RST_STREAM stream=%u reason=dup-:method", stream_id); return true; } st.method = kv.second; seen_method = true; }
+        else if (kv.first == ":path") { if (seen_path) { send_rst_stream(stream_id, PROTOCOL_ERROR); _streams.erase(stream_id); PDEBUG("[h2] RST_STREAM stream=%u reason=dup-:path", stream_id); return true; } st.path = kv.second; seen_path = true; }
         else if (kv.first == ":authority") st.authority = kv.second;
         else if (!is_pseudo) st.headers[kv.first] = kv.second;
 #ifdef DEBUG
@@ -267,8 +241,7 @@ bool http2_process::handle_headers_block(uint32_t stream_id, const std::string&
     for (auto& kvh : st.headers) {
         for (char c : kvh.first) {
             if (c >= 'A' && c <= 'Z') {
-                std::string rst = make_rst_stream(stream_id, PROTOCOL_ERROR);
-                put_send_move(std::move(rst));
+                send_rst_stream(stream_id, PROTOCOL_ERROR);
                 _streams.erase(stream_id);
                 PDEBUG("[h2] RST_STREAM stream=%u reason=uppercase-header '%s'", stream_id, kvh.first.c_str());
                 return true;
@@ -276,8 +249,7 @@ bool http2_process::handle_headers_block(uint32_t stream_id, const std::string&
         }
         for (const char* bad : kBadHdrs) {
             if (kvh.first == bad) {
-                std::string rst = make_rst_stream(stream_id, PROTOCOL_ERROR);
-                put_send_move(std::move(rst));
+                send_rst_stream(stream_id, PROTOCOL_ERROR);
                 _streams.erase(stream_id);
                 PDEBUG("[h2] RST_STREAM stream=%u reason=forbidden-header '%s'", stream_id, kvh.first.c_str());
                 return true;
@@ -290,126 +262,200 @@ bool http2_process::handle_headers_block(uint32_t stream_id, const std::string&
         std::string m = st.method; for (auto& c : m) c = (char)tolower(c);
         if (m == "connect") {
             if (!st.path.empty()) {
-                std::string rst = make_rst_stream(stream_id, PROTOCOL_ERROR);
-                put_send_move(std::move(rst));
+                send_rst_stream(stream_id, PROTOCOL_ERROR);
                 _streams.erase(stream_id);
                 PDEBUG("[h2] RST_STREAM stream=%u reason=CONNECT-has-:path", stream_id);
                 return true;
             }
             if (st.authority.empty()) {
-                std::string rst = make_rst_stream(stream_id, PROTOCOL_ERROR);
-                put_send_move(std::move(rst));
+                send_rst_stream(stream_id, PROTOCOL_ERROR);
                 _streams.erase(stream_id);
                 PDEBUG("[h2] RST_STREAM stream=%u reason=CONNECT-no-:authority", stream_id);
                 return true;
             }
         } else {
             if (st.path.empty()) {
-                std::string rst = make_rst_stream(stream_id, PROTOCOL_ERROR);
-                put_send_move(std::move(rst));
+                send_rst_stream(stream_id, PROTOCOL_ERROR);
                 _streams.erase(stream_id);
                 PDEBUG("[h2] RST_STREAM stream=%u reason=no-:path", stream_id);
                 return true;
             }
         }
     }
-    if (end_stream) finish_stream(stream_id);
+    if (end_stream) {
+        end_of_stream(stream_id);
+    } else if (_app && !st.body_checked) {
+        begin_body_stream(stream_id, st);
+    }
     return true;
 }
 
-void http2_process::send_response(uint32_t stream_id, const myframe::HttpResponse& rsp) {
-    using namespace hpack;
-    // Minimal response: status + content-type + content-length + body
-    std::string body = rsp.body;
-    std::string block;
-    // Encode :status 200
-    // Literal without indexing, name by index if available
-    {
-        uint32_t name_idx = static_index_of_name(":status");
-        encode_integer(block, name_idx ? name_idx : 0, 4, 0x00);
-        if (!name_idx) { encode_string(block, std::string(":status"), false); }
-        encode_string(block, std::to_string(rsp.status), false);
-    }
+void http2_process::send_response(uint32_t stream_id, myframe::HttpResponse& rsp) {
+    // status + content-type + content-length + other headers + body
+    std::string_view body = rsp.body_view();
+    // the header block is encoded straight into the output buffer; its length is filled in afterwards
+    _writer.header(0, HEADERS, FLAG_END_HEADERS, stream_id);
+    std::string& block = _writer.buffer();
+    const size_t block_at = block.size();
+    _hpack_enc.begin_block(block);
+    _hpack_enc.encode(block, ":status", std::to_string(rsp.status));
     // content-type
     {
-        uint32_t name_idx = static_index_of_name("content-type");
-        encode_integer(block, name_idx ? name_idx : 0, 4, 0x00);
-        if (!name_idx) { encode_string(block, std::string("content-type"), false); }
         auto it = rsp.headers.find("Content-Type");
-        encode_string(block, it != rsp.headers.end() ? it->second : std::string("text/plain"), false);
+        _hpack_enc.encode(block, "content-type", it != rsp.headers.end() ? it->second : std::string("text/plain"));
     }
-    // content-length
-    {
-        uint32_t name_idx = static_index_of_name("content-length");
-        encode_integer(block, name_idx ? name_idx : 0, 4, 0x00);
-        if (!name_idx) { encode_string(block, std::string("content-length"), false); }
-        encode_string(block, std::to_string(body.size()), false);
+    // content-length (a streamed body ends with END_STREAM instead)
+    if (!rsp.stream) {
+        _hpack_enc.encode(block, "content-length", std::to_string(body.size()));
     }
     // other headers (optional, non-pseudo)
+    std::string lname;
     for (auto& kv : rsp.headers) {
-        if (kv.first == "Content-Type" || kv.first == "content-type" || kv.first == "content-length") continue;
+        if (kv.first == "Content-Type" || kv.first == "content-type" || kv.first == "Content-Length" || kv.first == "content-length") continue;
         // HTTP/2 requires lowercase header field-names. Values keep original case.
-        std::string lname = kv.first; for (auto& c : lname) c = (char)tolower(c);
-        const std::string& lval = kv.second;
-        // Try dynamic table exact (name,value)
-        uint32_t dyn_idx = enc_dyn_find_pair(lname, lval);
-        if (dyn_idx) {
-            encode_integer(block, dyn_idx, 7, 0x80); // Indexed Header Field
-            continue;
-        }
-        // Otherwise, encode with incremental indexing and add to dynamic table
-        uint32_t name_idx = static_index_of_name(lname);
-        encode_integer(block, name_idx ? name_idx : 0, 4, 0x00);
-        if (!name_idx) { encode_string(block, lname, false); }
-        encode_string(block, lval, false);
-        enc_dyn_add(lname, lval);
+        lname = kv.first; for (auto& c : lname) c = (char)tolower(c);
+        _hpack_enc.encode(block, lname, kv.second);
     }
-    // HEADERS frame with END_HEADERS (use Huffman for strings), no END_STREAM here
-    std::string hdr = make_frame_header((uint32_t)block.size(), HEADERS, FLAG_END_HEADERS, stream_id);
-    std::string frame = hdr + block;
-    put_send_move(std::move(frame));
+    // HEADERS frame with END_HEADERS, no END_STREAM here
+    put_frame_header(&block[block_at - 9], (uint32_t)(block.size() - block_at), HEADERS, FLAG_END_HEADERS, stream_id);
+    schedule_send();
 
     // If no body, send empty DATA with END_STREAM; else enqueue body and try to send within flow control windows
+    if (!rsp.stream && body.empty()) {
+        _writer.header(0, DATA, FLAG_END_STREAM, stream_id);
+        return;
+    }
     StreamState& st = _streams[stream_id];
     // Initialize per-stream send window to the current peer initial window size
     // so we honor SETTINGS_INITIAL_WINDOW_SIZE for newly created response streams.
     st.send_window = (int32_t)_peer_initial_window_size;
-    if (body.empty()) {
-        std::string datahdr = make_frame_header(0, DATA, FLAG_END_STREAM, stream_id);
-        put_send_move(std::move(datahdr));
+    if (rsp.stream) {
+        // DATA is pulled from the source in get_send_buf() as the socket and flow-control windows allow
+        st.source.reset(rsp.stream, [this, stream_id]() { resume_source(stream_id); });
+        st.source_wait = false;
+        if (auto sp = get_base_net()) sp->request_send();
     } else {
-        st.out_body = std::move(body);
+        st.out_body = rsp.shared_body ? std::move(rsp.shared_body) : myframe::make_shared_buffer(std::move(rsp.body));
         st.out_off = 0;
         // Schedule initial send; try to fill available flow-control windows.
         (void)try_send_data(stream_id);
     }
 }
 
-void http2_process::on_data(uint32_t stream_id, const unsigned char* p, uint32_t len, bool end_stream) {
-    if (len) _streams[stream_id].body.append((const char*)p, (size_t)len);
+uint32_t http2_process::on_data(uint32_t stream_id, const unsigned char* p, uint32_t len, bool end_stream) {
+    auto it = _streams.find(stream_id);
+    if (it != _streams.end() && it->second.sink) {
+        StreamState& st = it->second;
+        uint32_t taken = 0;
+        // keep arrival order: while earlier bytes are pending, new ones queue behind them
+        if (len && st.pending.empty() && !st.paused)
+            taken = feed_sink(st, (const char*)p, len);
+        if (taken < len) st.pending.append((const char*)p + taken, len - taken);
+        if (st.pending.size() > (size_t)st.recv_window) {
+            // we never granted more than the initial window beyond what the sink took.
+            // The connection was credited as the bytes arrived; the caller credits this frame.
+            send_rst_stream(stream_id, FLOW_CONTROL_ERROR);
+            _streams.erase(it);
+            PDEBUG("[h2] RST_STREAM stream=%u reason=recv-window-overrun", stream_id);
+            return 0;
+        }
+        if (end_stream) end_of_stream(stream_id);
+        return taken;
+    }
+    // DATA still in flight on a stream we reset or never opened is dropped; the caller credits the connection
+    if (it == _streams.end()) return len;
+    if (len) it->second.body.append((const char*)p, (size_t)len);
     if (end_stream) finish_stream(stream_id);
+    return len;
 }
 
-void http2_process::finish_stream(uint32_t stream_id) {
+void http2_process::end_of_stream(uint32_t stream_id) {
     auto it = _streams.find(stream_id);
     if (it == _streams.end()) { return; }
-    StreamState st = std::move(it->second);
-    _streams.erase(it);
+    // a paused sink still has bytes to take; finish once resume() drains them
+    if (!it->second.pending.empty()) { it->second.end_seen = true; return; }
+    finish_stream(stream_id);
+}
 
-    myframe::HttpRequest req; req.version = "HTTP/2";
+void http2_process::build_request(const StreamState& st, myframe::HttpRequest& req) const {
+    req.version = "HTTP/2";
     req.method = st.method.empty() ? "GET" : st.method;
     req.url = st.path.empty() ? "/" : st.path;
-    req.body = std::move(st.body);
     if (!st.authority.empty()) req.headers["host"] = st.authority;
     for (auto& kv : st.headers) req.headers[kv.first] = kv.second;
+}
+
+void http2_process::begin_body_stream(uint32_t stream_id, StreamState& st) {
+    st.body_checked = true;
+    myframe::HttpRequest req;
+    build_request(st, req);
+    std::shared_ptr<myframe::HttpBodySink> sink;
+    {
+        myframe::detail::HandlerContextScope scope(this);
+        sink = _app->on_body_begin(req);
+    }
+    if (!sink) return;
+    st.req = std::move(req);
+    st.sink.reset(std::move(sink), [this, stream_id]() { resume_stream(stream_id); });
+    PDEBUG("[h2] stream=%u streaming body %s %s", stream_id, st.req.method.c_str(), st.req.url.c_str());
+}
+
+uint32_t http2_process::feed_sink(StreamState& st, const char* data, size_t len) {
+    size_t taken;
+    {
+        myframe::detail::HandlerContextScope scope(this);
+        taken = st.sink.get()->on_body_chunk(data, len);
+    }
+    if (taken > len) taken = len;
+    if (taken < len) st.paused = true;
+    return (uint32_t)taken;
+}
+
+void http2_process::resume_stream(uint32_t stream_id) {
+    auto it = _streams.find(stream_id);
+    if (it == _streams.end() || !it->second.paused) return;
+    StreamState& st = it->second;
+    st.paused = false;
+    uint32_t taken = feed_sink(st, st.pending.data(), st.pending.size());
+    st.pending.erase(0, taken);
+    send_window_update(stream_id, taken);
+    if (st.pending.empty() && st.end_seen) finish_stream(stream_id);
+}
+
+void http2_process::send_window_update(uint32_t stream_id, uint32_t n) {
+    if (!n) return;
+    // stream credit only: the connection was credited when the bytes arrived.
+    // Merged with other credit for the same stream until the output buffer is taken
+    _writer.window_update(stream_id, n);
+    schedule_send();
+}
+
+void http2_process::finish_stream(uint32_t stream_id) {
+    auto it = _streams.find(stream_id);
+    if (it == _streams.end()) { return; }
+    StreamState st = std::move(it->second);
+    _streams.erase(it);
+
+    myframe::HttpRequest req;
+    if (st.sink) {
+        req = std::move(st.req);
+    } else {
+        build_request(st, req);
+        req.body = std::move(st.body);
+    }
 
     myframe::HttpResponse rsp; rsp.status = 200; rsp.reason = "OK";
     if (_app) {
         myframe::detail::HandlerContextScope scope(this);
-        _app->on_http(req, rsp);
+        if (st.sink) st.sink.get()->on_body_end(req, rsp);
+        else _app->on_http(req, rsp);
     }
+    st.sink.reset();
     if (rsp.headers.find("Content-Type") == rsp.headers.end()) rsp.set_content_type("text/plain");
-    if (rsp.body.empty()) rsp.body = "OK";
+    if (rsp.body_view().empty() && !rsp.stream) rsp.body = "OK";
+    // gzip/deflate when the client accepts it (content-encoding/vary are lowercased in send_response)
+    auto ae = req.headers.find("accept-encoding");
+    myframe::http_compress_response(ae != req.headers.end() ? std::string_view(ae->second) : std::string_view(), rsp);
     PDEBUG("[h2] stream=%u %s %s body=%zu", stream_id, req.method.c_str(), req.url.c_str(), req.body.size());
     send_response(stream_id, rsp);
 }
@@ -427,34 +473,131 @@ void http2_process::handle_timeout(std::shared_ptr<timer_msg>& t_msg) {
     if (_app) { _app->handle_timeout(t_msg); }
 }
 
+std::string* http2_process::get_send_buf() {
+    std::string* p = base_data_process::get_send_buf();
+    if (p) return p;
+    // DATA pulled from streaming bodies joins the frames already written, up to one buffer's worth
+    while (_writer.pending() < h2::frame_writer::BUFFER_BYTES && pull_stream_data()) {}
+    p = _writer.take();
+    if (!p) _send_scheduled = false;
+    return p;
+}
+
+void http2_process::schedule_send() {
+    // the connection picks the frames up when it next writes: once per loop iteration, not once per frame
+    if (_send_scheduled) return;
+    _send_scheduled = true;
+    if (auto sp = get_base_net()) sp->request_send();
+}
+
+void http2_process::send_goaway(ErrorCode ec, const char* debug) {
+    // callers throw right after; write now so the GOAWAY goes out before the connection is torn down
+    _writer.append(make_goaway(0, ec, debug));
+    _send_scheduled = true;
+    if (auto sp = get_base_net()) sp->notice_send();
+}
+
+void http2_process::send_rst_stream(uint32_t stream_id, ErrorCode ec) {
+    _writer.append(make_rst_stream(stream_id, ec));
+    schedule_send();
+}
+
+bool http2_process::pull_stream_data() {
+    if (_conn_send_window <= 0) return false;
+    std::vector<uint32_t> ids;
+    for (auto& kv : _streams) {
+        const StreamState& st = kv.second;
+        if (st.source && !st.source_wait && st.send_window > 0) ids.push_back(kv.first);
+    }
+    // one DATA frame per call, rotating over the streams that can make progress
+    size_t n = ids.size();
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t sid = ids[(_send_rr + i) % n];
+        StreamState& st = _streams[sid];
+        uint32_t allowance = (uint32_t)std::min<int32_t>(_conn_send_window, st.send_window);
+        allowance = std::min<uint32_t>(allowance, _peer_max_frame_size);
+
+        // the source appends straight into the output buffer behind a header filled in below
+        _writer.header(0, DATA, 0, sid);
+        std::string& out = _writer.buffer();
+        const size_t at = out.size() - 9;
+        int ret;
+        {
+            myframe::detail::HandlerContextScope scope(this);
+            ret = st.source.get()->pull(out, allowance);
+        }
+        size_t len = out.size() - at - 9;
+        if (len > allowance) {
+            out.resize(at);
+            throw CMyCommonException("http2: body source returned more than requested");
+        }
+        bool done = ret == myframe::HttpBodySource::DONE;
+        if (!done && ret == myframe::HttpBodySource::WAIT) st.source_wait = true;
+        if (!len && !done) {
+            // nothing now; MORE without data counts as WAIT so the send path cannot spin
+            st.source_wait = true;
+            out.resize(at);
+            continue;
+        }
+
+        put_frame_header(&out[at], (uint32_t)len, DATA, done ? FLAG_END_STREAM : 0, sid);
+        if (done) _writer.close_stream(sid);
+        _conn_send_window -= (int32_t)len;
+        st.send_window -= (int32_t)len;
+        _send_rr++;
+        if (done) _streams.erase(sid);
+        return true;
+    }
+    return false;
+}
+
+void http2_process::resume_source(uint32_t stream_id) {
+    auto it = _streams.find(stream_id);
+    if (it == _streams.end() || !it->second.source) return;
+    it->second.source_wait = false;
+    if (auto sp = get_base_net()) sp->request_send();
+}
+
+void http2_process::wake_sources() {
+    if (_conn_send_window <= 0) return;
+    for (auto& kv : _streams) {
+        if (kv.second.source && !kv.second.source_wait && kv.second.send_window > 0) {
+            if (auto sp = get_base_net()) sp->request_send();
+            return;
+        }
+    }
+}
+
 uint32_t http2_process::try_send_data(uint32_t stream_id) {
     auto it = _streams.find(stream_id);
     if (it == _streams.end()) return 0;
     StreamState& st = it->second;
-    if (st.out_off >= st.out_body.size()) return 0;
+    if (!st.out_body || st.out_off >= st.out_body->size()) return 0;
+    const std::string& body = *st.out_body;
     // Send as much as allowed by both connection and stream flow-control windows.
     // Avoid artificial stalling: do not gate on scheduler deficit here; fairness is
     // sufficiently protected by HTTP/2 flow control and event loop backpressure.
     uint32_t total_sent = 0;
-    while (st.out_off < st.out_body.size() && _conn_send_window > 0 && st.send_window > 0) {
-        uint32_t remaining = (uint32_t)(st.out_body.size() - st.out_off);
+    while (st.out_off < body.size() && _conn_send_window > 0 && st.send_window > 0) {
+        uint32_t remaining = (uint32_t)(body.size() - st.out_off);
         uint32_t allowance = (uint32_t)std::min<int32_t>(_conn_send_window, st.send_window);
         allowance = std::min<uint32_t>(allowance, _peer_max_frame_size);
         if (allowance == 0) break;
         uint32_t chunk = std::min<uint32_t>(allowance, remaining);
-        std::string payload = st.out_body.substr(st.out_off, chunk);
+        uint8_t fl = (st.out_off + chunk >= body.size()) ? FLAG_END_STREAM : 0;
+        _writer.header(chunk, DATA, fl, stream_id);
+        _writer.buffer().append(body, st.out_off, chunk);
         st.out_off += chunk;
         _conn_send_window -= (int32_t)chunk;
         st.send_window -= (int32_t)chunk;
-        uint8_t fl = (st.out_off >= st.out_body.size()) ? FLAG_END_STREAM : 0;
-        std::string hdr = make_frame_header(chunk, DATA, fl, stream_id);
-        std::string frame = hdr + payload;
-        put_send_move(std::move(frame));
 #ifdef DEBUG
         PDEBUG("[h2] SEND DATA stream=%u chunk=%u conn_win=%d stream_win=%d end=%d", stream_id, chunk, _conn_send_window, st.send_window, fl ? 1 : 0);
 #endif
         total_sent += chunk;
     }
+    if (total_sent) schedule_send();
+    // END_STREAM is out: the stream is closed on our side, drop its state
+    if (st.out_off >= body.size()) _streams.erase(it);
     return total_sent;
 }
 
@@ -498,34 +641,3 @@ void http2_process::update_quantum(StreamState& st) {
     st.sched_quantum = (uint32_t)q;
 }
 
-void http2_process::enc_dyn_evict() {
-    while (_enc_tbl_size > _enc_tbl_max && !_enc_dyn.empty()) {
-        DynHdr& last = _enc_dyn.back();
-        if (_enc_tbl_size >= last.sz) _enc_tbl_size -= last.sz; else _enc_tbl_size = 0;
-        _enc_dyn.pop_back();
-    }
-}
-
-void http2_process::enc_dyn_add(const std::string& name, const std::string& value) {
-    size_t sz = 32 + name.size() + value.size();
-    if (sz > _enc_tbl_max) {
-        // cannot fit even alone; clear table per RFC 7541 4.2
-        _enc_dyn.clear(); _enc_tbl_size = 0; return;
-    }
-    while (_enc_tbl_size + sz > _enc_tbl_max && !_enc_dyn.empty()) {
-        DynHdr& last = _enc_dyn.back();
-        if (_enc_tbl_size >= last.sz) _enc_tbl_size -= last.sz; else _enc_tbl_size = 0;
-        _enc_dyn.pop_back();
-    }
-    _enc_dyn.insert(_enc_dyn.begin(), DynHdr{name, value, sz});
-    _enc_tbl_size += sz;
-}
-
-uint32_t http2_process::enc_dyn_find_pair(const std::string& name, const std::string& value) const {
-    for (size_t i = 0; i < _enc_dyn.size(); ++i) {
-        if (_enc_dyn[i].name == name && _enc_dyn[i].value == value) {
-            return (uint32_t)(i + 1); // dynamic table index is 1-based, newest at 1
-        }
-    }
-    return 0;
-}
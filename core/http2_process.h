@@ -2,8 +2,11 @@
 
 #include "base_data_process.h"
 #include "http2_frame.h"
+#include "hpack.h"
+#include "http2_frame_writer.h"
 #include <vector>
 #include "app_handler_v2.h"
+#include "http_body_sink.h"
 #include <unordered_map>
 #include <map>
 
@@ -18,28 +21,35 @@ public:
     {}
 
     virtual size_t process_recv_buf(const char* buf, size_t len) override;
-    virtual std::string* get_send_buf() override { return base_data_process::get_send_buf(); }
-    virtual void reset() override { _in.clear(); _preface_ok=false; _sent_settings=false; _got_client_settings=false; }
+    // frames written since the last send, then DATA pulled from streaming response bodies (HttpBodySource),
+    // handed out in buffers of up to frame_writer::BUFFER_BYTES
+    virtual std::string* get_send_buf() override;
+    virtual void reset() override { _preface_ok=false; _assembling=false; _assembling_sid=0; _assembling_block.clear(); _sent_settings=false; _got_client_settings=false; _hpack_dec = hpack::Decoder(); _hpack_enc = hpack::Encoder(); _writer.clear(); _send_scheduled=false; }
     virtual void handle_msg(std::shared_ptr<normal_msg>& msg) override;
     virtual void handle_timeout(std::shared_ptr<timer_msg>& t_msg) override;
 
 private:
     void on_connected_once();
-    bool parse_frames(size_t& consumed);
-    bool handle_headers_block(uint32_t stream_id, const std::string& block, bool end_stream);
-    void send_response(uint32_t stream_id, const myframe::HttpResponse& rsp);
-    void on_data(uint32_t stream_id, const unsigned char* p, uint32_t len, bool end_stream);
+    // returns the bytes of complete frames handled
+    size_t parse_frames(const unsigned char* data, size_t n);
+    bool handle_headers_block(uint32_t stream_id, const unsigned char* block, size_t len, bool end_stream);
+    void send_response(uint32_t stream_id, myframe::HttpResponse& rsp);
+    // returns how many body bytes were consumed now (their flow-control window can be given back)
+    uint32_t on_data(uint32_t stream_id, const unsigned char* p, uint32_t len, bool end_stream);
+    void end_of_stream(uint32_t stream_id);
     void finish_stream(uint32_t stream_id);
 
-    std::string _out;
-    std::vector<unsigned char> _in;
+    // all outgoing frames go through the writer; one request_send() per batch
+    h2::frame_writer _writer;
+    bool _send_scheduled{false};
     myframe::IApplicationHandler* _app;
     bool _preface_ok;
     bool _sent_settings;
     bool _got_client_settings;
 
-    // header assembly across CONTINUATION
+    // header assembly across CONTINUATION (a single HEADERS frame is decoded in place)
     bool _assembling{false};
+    bool _assembling_end_stream{false};
     uint32_t _assembling_sid{0};
     std::string _assembling_block;
 
@@ -54,12 +64,22 @@ private:
         uint8_t weight{16}; // 1-256 (stored as weight-1 on wire)
         int32_t send_window{65535};
         int32_t recv_window{65535};
-        // Outbound response body (pending due to flow control)
-        std::string out_body;
+        // Outbound response body (pending due to flow control); shared, so a cached body is sent without a copy
+        myframe::shared_buffer out_body;
         size_t out_off{0};
         // Scheduler state (deficit round-robin)
         int32_t sched_deficit{0};
         uint32_t sched_quantum{16384}; // base quantum in bytes (scaled by weight)
+        // Streaming request body (IApplicationHandler::on_body_begin)
+        bool body_checked{false};
+        myframe::body_sink_holder sink;
+        myframe::HttpRequest req;  // built when the request headers complete
+        std::string pending;       // DATA the sink has not taken; its window is held back
+        bool paused{false};
+        bool end_seen{false};
+        // Pull-based response body (HttpResponse::stream); DATA is produced only when the socket is writable
+        myframe::body_source_holder source;
+        bool source_wait{false};   // source said WAIT; pulled again after resume()
     };
     std::unordered_map<uint32_t, StreamState> _streams;
 
@@ -74,13 +94,21 @@ private:
     void pump_all_streams();
     void update_quantum(StreamState& st);
 
-    // HPACK dynamic table for encoder (per-connection)
-    struct DynHdr { std::string name; std::string value; size_t sz; };
-    std::vector<DynHdr> _enc_dyn; // newest at front (index 1)
-    size_t _enc_tbl_size{0};
-    size_t _enc_tbl_max{4096}; // default per RFC
-    void enc_dyn_evict();
-    void enc_dyn_add(const std::string& name, const std::string& value);
-    // return 1-based index in dynamic table if exact (name,value) match found; 0 if not
-    uint32_t enc_dyn_find_pair(const std::string& name, const std::string& value) const;
+    void build_request(const StreamState& st, myframe::HttpRequest& req) const;
+    void begin_body_stream(uint32_t stream_id, StreamState& st);
+    uint32_t feed_sink(StreamState& st, const char* data, size_t len);
+    void resume_stream(uint32_t stream_id);
+    void send_window_update(uint32_t stream_id, uint32_t n);
+    void schedule_send();
+    void send_goaway(h2::ErrorCode ec, const char* debug);
+    void send_rst_stream(uint32_t stream_id, h2::ErrorCode ec);
+
+    // appends one DATA frame from a streaming body; false when no stream can make progress
+    bool pull_stream_data();
+    void resume_source(uint32_t stream_id);
+    void wake_sources();
+
+    // HPACK state (per-connection): decoder for request headers, encoder for response headers
+    hpack::Decoder _hpack_dec;
+    hpack::Encoder _hpack_enc;
 };
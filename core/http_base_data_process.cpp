@@ -50,6 +50,7 @@ std::string *http_base_data_process::get_send_head()
 
 
 //处理接收的数据
+//result: 0 继续接收  1: body 收完(分块编码以 last-chunk 为准)  <0: 拒绝这个 body, 连接关闭
 size_t http_base_data_process::process_recv_body(const char *buf, size_t len, int& result)
 {
     PDEBUG("%p", this);
@@ -73,3 +74,9 @@ void http_base_data_process::complete_async_response()
     _async_response_pending = false;
     _base_process->notify_send_ready();
 }
+
+void http_base_data_process::resume_send_body()
+{
+    if (auto sp = get_base_net())
+        sp->request_send();
+}
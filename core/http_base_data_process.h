@@ -36,6 +36,15 @@ class http_base_data_process: public base_data_process
 
         bool async_response_pending() const { return _async_response_pending; }
 
+        // 响应体由业务的 HttpBodySource 拉取产生: 只在连接可写时取, 不提前攒进发送队列
+        virtual bool streaming_response() const { return false; }
+
+        // 响应体是共享缓冲(如响应缓存命中)时交出整段, 以共享切片发送, 不再调 get_send_body
+        virtual bool get_send_body_shared(myframe::shared_buffer & buf) { (void)buf; return false; }
+
+        // HttpBodySource::resume() 的落点: 下一轮事件循环接着取响应体
+        void resume_send_body();
+
         // 便利方法：完成异步响应（清除标志并通知发送）
         virtual void complete_async_response();
 
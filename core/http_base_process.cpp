@@ -4,9 +4,12 @@
 #include "http_base_data_process.h"
 
 
-http_base_process::http_base_process(std::shared_ptr<base_net_obj> p):base_data_process(p)
+http_base_process::http_base_process(std::shared_ptr<base_net_obj> p, myframe::http_head_parser::mode head_mode)
+    : base_data_process(p), _head_parser(head_mode)
 {
     _data_process = NULL;
+    _keep_alive = false;
+    _body_paused = false;
 }
 
 http_base_process::~http_base_process()
@@ -29,6 +32,8 @@ void http_base_process::reset()
 {
     _req_head_para.init();
     _res_head_para.init();
+    _head_parser.reset();
+    _chunked_decoder.reset();
 }
 
 void http_base_process::set_process(http_base_data_process * data_process)
@@ -47,38 +52,93 @@ size_t http_base_process::process_recv_buf(const char *buf, size_t len)
         THROW_COMMON_EXCEPT("http recv status not correct " << _http_status);
     }
 
-
     size_t ret = 0;
-    bool staus_change = false;
-    std::string left_str, recv_head;
-    if (_http_status == RECV_HEAD && strstr(buf, CRLF2))
+    if (_http_status == RECV_HEAD)
     {
-        recv_head.append(buf, len);
-        check_head_finish(recv_head, left_str);
-        staus_change = true;
-    }
+        // 头没收全时不消费, 下次从上次扫到的位置接着找
+        int r = _head_parser.parse(buf, len);
+        if (r == myframe::http_head_parser::ERROR)
+        {
+            THROW_COMMON_EXCEPT("http head parse error");
+        }
+        if (r == myframe::http_head_parser::MORE)
+        {
+            if (len > MAX_HTTP_HEAD_LEN)
+            {
+                THROW_COMMON_EXCEPT("http head too long (" << len << ")");
+            }
+            return 0;
+        }
 
-    //PDEBUG("%s\n", buf);
+        ret = _head_parser.head_len();
+        buf += ret;
+        len -= ret;
+        change_http_status(RECV_BODY);
+        parse_header(_head_parser);
+        _data_process->header_recv_finish();
+    }
 
-    if (_http_status == RECV_BODY) //ݲ
+    if (_http_status == RECV_BODY)
     {
         int result = 0;
-        if (staus_change)
+        ret += process_recv_body(buf, len, result);
+        if (result < 0)
         {
-            ret = len - left_str.length();
-            ret += process_recv_body((char*)left_str.c_str(), left_str.length(), result);
+            // body 已经读了一部分, 找不到下一条报文的起点, 只能关连接
+            THROW_COMMON_EXCEPT("http body rejected (" << result << ")");
         }
-        else
-            ret = process_recv_body(buf, len, result);
-
         if (result == 1)
         {
             recv_finish();
         }
     }
+
+    // 接收缓冲马上会被消费, 还要用的报文头拷到解析器内部
+    if (_head_parser.done())
+        _head_parser.detach();
     return ret;
 }
 
+size_t http_base_process::process_chunked_body(const char *buf, size_t len, int &result)
+{
+    size_t total = 0;
+    result = 0;
+    while (1)
+    {
+        size_t used = 0;
+        std::string_view data;
+        int r = _chunked_decoder.decode(buf + total, len - total, used, data);
+        total += used;
+        if (r == myframe::http_chunked_decoder::ERROR)
+        {
+            THROW_COMMON_EXCEPT("http chunked body parse error");
+        }
+        if (r == myframe::http_chunked_decoder::DONE)
+        {
+            result = 1;
+            break;
+        }
+        if (r == myframe::http_chunked_decoder::MORE)
+            break;
+
+        int data_result = 0;
+        size_t took = _data_process->process_recv_body(data.data(), data.size(), data_result);
+        if (took > data.size())
+            took = data.size();
+        _chunked_decoder.data_consumed(took);
+        total += took;
+        // 结束以 last-chunk 为准, 业务层的 1 不提前结束; 负值是业务层拒绝这个 body
+        if (data_result < 0)
+        {
+            result = data_result;
+            break;
+        }
+        if (took < data.size())
+            break;
+    }
+    return total;
+}
+
 std::string* http_base_process::get_send_buf()
 {
     if (_http_status < SEND_HEAD)
@@ -108,6 +168,42 @@ std::string* http_base_process::get_send_buf()
     return ret_str;
 }
 
+bool http_base_process::get_send_slice(myframe::send_slice & out)
+{
+    // 与 base_data_process::get_send_slice 同样的先后规则, 报文输出换成 next_send_slice
+    if (!_send_pulling && pop_send_list(out))
+        return true;
+
+    if (next_send_slice(out))
+    {
+        _send_pulling = true;
+        return true;
+    }
+
+    _send_pulling = false;
+    return pop_send_list(out);
+}
+
+bool http_base_process::next_send_slice(myframe::send_slice & out)
+{
+    if (_http_status == SEND_BODY)
+    {
+        myframe::shared_buffer buf;
+        if (_data_process->get_send_body_shared(buf))
+        {
+            out = myframe::send_slice(std::move(buf));
+            send_finish();
+            return true;
+        }
+    }
+
+    std::string * p = get_send_buf();
+    if (!p)
+        return false;
+    out = myframe::send_slice(myframe::make_pooled_string(p));
+    return true;
+}
+
 void http_base_process::handle_msg(std::shared_ptr<normal_msg> & p_msg)
 {
     _data_process->handle_msg(p_msg);
@@ -146,33 +242,68 @@ void http_base_process::notify_send_ready()
     change_http_status(SEND_HEAD);
 }
 
-http_base_data_process * http_base_process::get_process()
+void http_base_process::fill_connection_header(std::map<std::string, std::string> & headers)
 {
-    return _data_process;
+    if (!_keep_alive)
+    {
+        headers["Connection"] = "close";
+        return;
+    }
+
+    auto it = headers.find("Connection");
+    if (it == headers.end())
+        headers["Connection"] = "keep-alive";
+    else if (strcasestr(it->second.c_str(), "close"))
+        _keep_alive = false;
 }
 
-void http_base_process::check_head_finish(std::string & recv_head, std::string &left_str)
+bool http_base_process::prepare_stream_headers(std::map<std::string, std::string> & headers)
 {
-    size_t pos =  recv_head.find(CRLF2);
-    if (pos != std::string::npos)
+    if (headers.find("Content-Length") != headers.end())
+        return false;
+    if (_req_head_para._version != "HTTP/1.1")
     {
-        left_str = recv_head.substr(pos + 4);
-        recv_head.erase(pos + 4);				
-        //_http_status = RECV_BODY;
-        change_http_status(RECV_BODY);
-        parse_header(recv_head);
-
-        _data_process->header_recv_finish();
+        // 没有长度也没有分块, 以关闭连接标记 body 结束
+        _keep_alive = false;
+        return false;
     }
-    else
-    {
-        if (recv_head.length() > MAX_HTTP_HEAD_LEN) //httpͷҪ10k
-        {
-            THROW_COMMON_EXCEPT("http head too long (" << recv_head.length() << ")");
-        }
-    }			
+    headers["Transfer-Encoding"] = "chunked";
+    return true;
 }
 
+bool http_base_process::has_request_body() const
+{
+    if (_req_head_para.header_view(myframe::HDR_TRANSFER_ENCODING).data())
+        return true;
+    std::string_view cl = _req_head_para.header_view(myframe::HDR_CONTENT_LENGTH);
+    for (size_t i = 0; i < cl.size(); i++)
+    {
+        if (cl[i] >= '1' && cl[i] <= '9')
+            return true;
+    }
+    return false;
+}
 
+void http_base_process::pause_body()
+{
+    if (_body_paused)
+        return;
+    _body_paused = true;
+    if (auto sp = _p_connect.lock())
+        sp->pause_recv();
+}
 
+void http_base_process::resume_body()
+{
+    if (!_body_paused)
+        return;
+    _body_paused = false;
+    // 接收缓冲里剩下的数据在下一轮事件循环里交付, 不在业务的调用栈里重入
+    if (auto sp = _p_connect.lock())
+        sp->resume_recv();
+}
 
+http_base_data_process * http_base_process::get_process()
+{
+    return _data_process;
+}
@@ -7,13 +7,16 @@
 #include "base_data_process.h"
 #include "common_exception.h"
 #include "common_def.h"
+#include "http_head_parser.h"
+#include "http_chunked_decoder.h"
 
 
 class http_base_data_process;
 class http_base_process: public base_data_process
 {
     public:
-        http_base_process(std::shared_ptr<base_net_obj> p);
+        http_base_process(std::shared_ptr<base_net_obj> p,
+                myframe::http_head_parser::mode head_mode = myframe::http_head_parser::REQUEST);
 
         virtual ~http_base_process();
 
@@ -23,6 +26,9 @@ class http_base_process: public base_data_process
 
         virtual std::string* get_send_buf();
 
+        // ״̬֮ȡͶ; ݲ˹ body(绺)ʱԹƬ
+        virtual bool get_send_slice(myframe::send_slice & out);
+
         virtual void handle_msg(std::shared_ptr<normal_msg> & p_msg);
 
         virtual void handle_timeout(std::shared_ptr<timer_msg> & t_msg);
@@ -45,24 +51,51 @@ class http_base_process: public base_data_process
 
         virtual void reset();
 
+        // ǰǷ񱣳(˰ͷ keep-alive þ)
+        bool keep_alive() const { return _keep_alive; }
+
+        //  keep_alive() ȫӦ Connection ͷ; ҵʽҪ close ʱηر
+        void fill_connection_header(std::map<std::string, std::string> & headers);
+
+        // ȡʽӦͷ: ҵû Content-Length ʱ chunked; HTTP/1.1 µĿͻ˲ chunked,
+        // ԭͲڷر. Ƿ chunked ,  fill_connection_header ֮ǰ
+        bool prepare_stream_headers(std::map<std::string, std::string> & headers);
+
+        // Ƿ body(Content-Length  0  Transfer-Encoding)
+        bool has_request_body() const;
+
+        // ʽ: ҵղʱͣ, ָŴջʣµ
+        void pause_body();
+        void resume_body();
+        bool body_paused() const { return _body_paused; }
+
     protected:		
 		virtual size_t process_recv_body(const char *buf, size_t len, int &result) = 0;	
 		
-        virtual void parse_header(std::string & recv_head) = 0;
+        // head ͼָջ, process_recv_buf ǰת浽ڲ, reset ֮ǰһֱ
+        virtual void parse_header(const myframe::http_head_parser & head) = 0;
+
+        // ֿ body: ݶֱӴӽջ彻 _data_process, ҵʱʣµڽջ
+        size_t process_chunked_body(const char *buf, size_t len, int &result);
 
-        virtual void parse_first_line(const std::string & line) = 0;
+        // ״̬ȡһӦ: ͷ body
+        bool next_send_slice(myframe::send_slice & out);
 
         virtual void recv_finish() = 0;
         virtual void send_finish() = 0;
 
-        void check_head_finish(std::string & recv_head, std::string &left_str);
-
         HTTP_STATUS _http_status;
         http_base_data_process *_data_process;
         
         http_req_head_para _req_head_para;
         http_res_head_para _res_head_para;
 
+        myframe::http_head_parser _head_parser;
+        myframe::http_chunked_decoder _chunked_decoder;
+
+        bool _keep_alive;
+        bool _body_paused;
+
 };
 
 
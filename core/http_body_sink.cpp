@@ -0,0 +1,246 @@
+#include "http_body_sink.h"
+#include "common_exception.h"
+#include "common_util.h"
+#include "string_pool.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace myframe {
+
+namespace {
+
+struct spill_conf
+{
+    size_t threshold;
+    std::string dir;
+};
+
+spill_conf & spill_ref()
+{
+    static spill_conf conf = []{
+        spill_conf c;
+        const size_t max_bytes = (size_t)1 << 30;
+        long v = 1 << 20;
+        const char * e = ::getenv("MYFRAME_HTTP_SPILL_BYTES");
+        if (e && *e)
+            v = atol(e);
+        if (v < 0) v = 0;
+        c.threshold = (size_t)v > max_bytes ? max_bytes : (size_t)v;
+        const char * d = ::getenv("MYFRAME_HTTP_SPILL_DIR");
+        c.dir = (d && *d) ? d : "/tmp";
+        return c;
+    }();
+    return conf;
+}
+
+} // namespace
+
+size_t HttpSpillBodySink::spill_threshold()
+{
+    return spill_ref().threshold;
+}
+
+const std::string & HttpSpillBodySink::spill_dir()
+{
+    return spill_ref().dir;
+}
+
+void HttpSpillBodySink::set_spill(size_t threshold, const std::string & dir)
+{
+    const size_t max_bytes = (size_t)1 << 30;
+    spill_ref().threshold = threshold > max_bytes ? max_bytes : threshold;
+    if (!dir.empty())
+        spill_ref().dir = dir;
+}
+
+HttpSpillBodySink::HttpSpillBodySink(size_t memory_limit)
+    : _limit(memory_limit ? memory_limit : spill_threshold()), _size(0), _fd(-1)
+{
+}
+
+HttpSpillBodySink::~HttpSpillBodySink()
+{
+    if (_fd >= 0)
+        ::close(_fd);
+}
+
+size_t HttpSpillBodySink::on_body_chunk(const char * data, size_t len)
+{
+    if (_fd < 0 && _mem.size() + len > _limit)
+        spill();
+
+    if (_fd >= 0)
+        write_file(data, len);
+    else
+        _mem.append(data, len);
+    _size += len;
+    return len;
+}
+
+void HttpSpillBodySink::spill()
+{
+    const std::string & dir = spill_dir();
+    int fd = -1;
+#ifdef O_TMPFILE
+    fd = ::open(dir.c_str(), O_TMPFILE | O_RDWR | O_EXCL | O_CLOEXEC, 0600);
+#endif
+    if (fd < 0)
+    {
+        // 文件系统不支持 O_TMPFILE 时建一个再删掉名字
+        std::string path = dir + "/myframe_body_XXXXXX";
+        fd = ::mkostemp(&path[0], O_CLOEXEC);
+        if (fd >= 0)
+            ::unlink(path.c_str());
+    }
+    if (fd < 0)
+    {
+        THROW_COMMON_EXCEPT("http body spill open " << dir << " failed: " << strError(errno));
+    }
+    _fd = fd;
+
+    std::string mem;
+    mem.swap(_mem);
+    write_file(mem.data(), mem.size());
+}
+
+void HttpSpillBodySink::write_file(const char * data, size_t len)
+{
+    while (len)
+    {
+        ssize_t n = ::write(_fd, data, len);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            THROW_COMMON_EXCEPT("http body spill write failed: " << strError(errno));
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+}
+
+ssize_t HttpSpillBodySink::read(uint64_t off, char * buf, size_t len) const
+{
+    if (off >= _size)
+        return 0;
+    if (len > _size - off)
+        len = (size_t)(_size - off);
+    if (_fd < 0)
+    {
+        _mem.copy(buf, len, (size_t)off);
+        return (ssize_t)len;
+    }
+
+    size_t got = 0;
+    while (got < len)
+    {
+        ssize_t n = ::pread(_fd, buf + got, len - got, (off_t)(off + got));
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (!n)
+            break;
+        got += (size_t)n;
+    }
+    return (ssize_t)got;
+}
+
+std::string * body_source_pump::pull(bool & done)
+{
+    done = false;
+    if (!_src)
+    {
+        done = true;
+        return NULL;
+    }
+
+    std::string * out = string_acquire();
+    int ret = _src.get()->pull(*out, PULL_BYTES);
+    if (ret == HttpBodySource::DONE)
+        done = true;
+
+    if (_chunked)
+    {
+        if (!out->empty())
+        {
+            char line[24];
+            int n = snprintf(line, sizeof(line), "%zx\r\n", out->size());
+            out->insert(0, line, (size_t)n);
+            out->append("\r\n", 2);
+        }
+        if (done)
+            out->append("0\r\n\r\n", 5);
+    }
+
+    if (done)
+        _src.reset();
+
+    if (out->empty())
+    {
+        // MORE 却没给数据也按 WAIT 处理, 否则发送路径会空转
+        string_release(out);
+        return NULL;
+    }
+    return out;
+}
+
+HttpPushBodySource::HttpPushBodySource(size_t limit)
+    : _limit(limit ? limit : body_source_pump::PULL_BYTES * 8), _off(0), _ended(false)
+{
+}
+
+size_t HttpPushBodySource::write(const char * data, size_t len)
+{
+    if (_ended || !len)
+        return 0;
+    size_t room = _limit > buffered() ? _limit - buffered() : 0;
+    if (len > room)
+        len = room;
+    if (!len)
+        return 0;
+    if (_off && _off == _buf.size())
+    {
+        _buf.clear();
+        _off = 0;
+    }
+    _buf.append(data, len);
+    resume();
+    return len;
+}
+
+void HttpPushBodySource::end()
+{
+    if (_ended)
+        return;
+    _ended = true;
+    resume();
+}
+
+int HttpPushBodySource::pull(std::string & out, size_t max)
+{
+    size_t n = buffered() < max ? buffered() : max;
+    out.append(_buf, _off, n);
+    _off += n;
+    if (_off == _buf.size())
+    {
+        _buf.clear();
+        _off = 0;
+    }
+    else if (_off > _buf.size() / 2)
+    {
+        _buf.erase(0, _off);
+        _off = 0;
+    }
+    if (!buffered())
+        return _ended ? DONE : WAIT;
+    return MORE;
+}
+
+} // namespace myframe
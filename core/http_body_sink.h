@@ -0,0 +1,152 @@
+#ifndef __HTTP_BODY_SINK_H__
+#define __HTTP_BODY_SINK_H__
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <string>
+
+#include "app_handler_v2.h"
+
+namespace myframe {
+
+// 框架这一侧持有 HttpBodySink/HttpBodySource: 持有期间绑定恢复入口, 释放时解绑
+// 业务多留的 shared_ptr 之后再调 resume() 不会碰到已经销毁的连接/流
+template <typename T>
+class body_stream_holder
+{
+    public:
+        body_stream_holder() {}
+
+        ~body_stream_holder() { reset(); }
+
+        body_stream_holder(body_stream_holder && other) noexcept : _ptr(std::move(other._ptr)) {}
+
+        body_stream_holder & operator=(body_stream_holder && other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                _ptr = std::move(other._ptr);
+            }
+            return *this;
+        }
+
+        body_stream_holder(const body_stream_holder &) = delete;
+        body_stream_holder & operator=(const body_stream_holder &) = delete;
+
+        void reset(std::shared_ptr<T> p = nullptr, std::function<void()> resume = nullptr)
+        {
+            if (_ptr)
+                _ptr->bind_resume(nullptr);
+            _ptr = std::move(p);
+            if (_ptr)
+                _ptr->bind_resume(std::move(resume));
+        }
+
+        T * get() const { return _ptr.get(); }
+
+        explicit operator bool() const { return _ptr != nullptr; }
+
+    private:
+        std::shared_ptr<T> _ptr;
+};
+
+typedef body_stream_holder<HttpBodySink> body_sink_holder;
+typedef body_stream_holder<HttpBodySource> body_source_holder;
+
+// HTTP/1 响应体的拉取: 每次向 source 要一段, 没有 Content-Length 时按 chunked 编码加上分块头
+class body_source_pump
+{
+    public:
+        // 每次最多向 source 要的字节数
+        static const size_t PULL_BYTES = 32 * 1024;
+
+        body_source_pump() : _chunked(false) {}
+
+        void reset(std::shared_ptr<HttpBodySource> src = nullptr, bool chunked = false,
+                std::function<void()> resume = nullptr)
+        {
+            _src.reset(std::move(src), std::move(resume));
+            _chunked = chunked;
+        }
+
+        explicit operator bool() const { return (bool)_src; }
+
+        // 返回下一段要发送的数据; 返回 NULL 且 done 为 false 表示 source 暂时没有数据, 等它 resume()
+        // done 为 true 时 body 已经结束(返回的是最后一段), source 随即释放
+        std::string * pull(bool & done);
+
+    private:
+        body_source_holder _src;
+        bool _chunked;
+};
+
+// stream_write 式的推送 source: 业务往里写, 连接可写时框架取走; 缓冲有上限, 写满时少收
+class HttpPushBodySource : public HttpBodySource
+{
+    public:
+        // limit 为 0 时用 body_source_pump::PULL_BYTES 的 8 倍
+        explicit HttpPushBodySource(size_t limit = 0);
+
+        // 返回收下的字节数, 缓冲满或已 end() 时少于 len
+        size_t write(const char * data, size_t len);
+
+        void end();
+
+        size_t buffered() const { return _buf.size() - _off; }
+
+        virtual int pull(std::string & out, size_t max) override;
+
+    private:
+        size_t _limit;
+        std::string _buf;
+        size_t _off;
+        bool _ended;
+};
+
+// 超过内存上限就转存到临时文件的 sink, 业务继承后实现 on_body_end, 在里面用 size()/read()/fd() 取 body
+// - 临时文件创建后即删除名字(O_TMPFILE 或 mkstemp + unlink), sink 析构时关闭, 进程退出也不会留下文件
+// - 写文件失败抛异常, 连接按常规错误路径关闭
+class HttpSpillBodySink : public HttpBodySink
+{
+    public:
+        // memory_limit 为 0 时用 spill_threshold()
+        explicit HttpSpillBodySink(size_t memory_limit = 0);
+
+        virtual ~HttpSpillBodySink();
+
+        virtual size_t on_body_chunk(const char * data, size_t len) override;
+
+        uint64_t size() const { return _size; }
+
+        bool spilled() const { return _fd >= 0; }
+
+        // 未转存时的 body; 转存后为空
+        const std::string & memory() const { return _mem; }
+
+        // 转存后的临时文件(可 pread/sendfile), 未转存为 -1
+        int fd() const { return _fd; }
+
+        // 读 body 的 [off, off + len), 返回读到的字节数, 出错 -1
+        ssize_t read(uint64_t off, char * buf, size_t len) const;
+
+        // 转存阈值: MYFRAME_HTTP_SPILL_BYTES(默认 1MB, 上限 1GB)
+        static size_t spill_threshold();
+        // 临时文件目录: MYFRAME_HTTP_SPILL_DIR(默认 /tmp)
+        static const std::string & spill_dir();
+        // 覆盖环境变量, 需在服务启动前调用
+        static void set_spill(size_t threshold, const std::string & dir);
+
+    private:
+        void spill();
+        void write_file(const char * data, size_t len);
+
+        size_t _limit;
+        uint64_t _size;
+        std::string _mem;
+        int _fd;
+};
+
+} // namespace myframe
+
+#endif
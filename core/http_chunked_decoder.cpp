@@ -0,0 +1,167 @@
+#include "http_chunked_decoder.h"
+#include "base_def.h"
+#include <string.h>
+#include <strings.h>
+
+namespace myframe {
+
+namespace {
+
+inline bool is_ows(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+inline int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
+http_chunked_decoder::http_chunked_decoder()
+{
+    reset();
+}
+
+void http_chunked_decoder::reset()
+{
+    _state = ST_SIZE;
+    _remain = 0;
+    _body_len = 0;
+    _trailer_len = 0;
+}
+
+long http_chunked_decoder::line_len(const char * buf, size_t len)
+{
+    size_t scan = len < (size_t)MAX_LINE_LEN ? len : (size_t)MAX_LINE_LEN;
+    const char * nl = (const char *)memchr(buf, '\n', scan);
+    if (nl)
+        return nl - buf + 1;
+    return len < (size_t)MAX_LINE_LEN ? 0 : -1;
+}
+
+bool http_chunked_decoder::parse_size(const char * line, size_t len)
+{
+    // chunk-size [ BWS ";" chunk-ext ] CRLF
+    size_t i = 0;
+    uint64_t size = 0;
+    while (i < len)
+    {
+        int v = hex_value(line[i]);
+        if (v < 0)
+            break;
+        if (size >> 59)
+            return false;
+        size = (size << 4) | (uint64_t)v;
+        i++;
+    }
+    if (!i)
+        return false;
+    while (i < len && is_ows(line[i]))
+        i++;
+    if (i < len && line[i] != ';' && line[i] != '\r' && line[i] != '\n')
+        return false;
+    _remain = size;
+    return true;
+}
+
+int http_chunked_decoder::decode(const char * buf, size_t len, size_t & used, std::string_view & data)
+{
+    used = 0;
+    data = std::string_view();
+    while (1)
+    {
+        const char * p = buf + used;
+        size_t left = len - used;
+        switch (_state)
+        {
+            case ST_SIZE:
+            {
+                long n = line_len(p, left);
+                if (n < 0)
+                    return ERROR;
+                if (!n)
+                    return MORE;
+                if (!parse_size(p, (size_t)n))
+                    return ERROR;
+                used += n;
+                _state = _remain ? ST_DATA : ST_TRAILER;
+                break;
+            }
+            case ST_DATA:
+            {
+                if (!_remain)
+                {
+                    _state = ST_DATA_CRLF;
+                    break;
+                }
+                if (!left)
+                    return MORE;
+                size_t n = left < _remain ? left : (size_t)_remain;
+                data = std::string_view(p, n);
+                return DATA;
+            }
+            case ST_DATA_CRLF:
+            {
+                if (!left)
+                    return MORE;
+                if (p[0] == '\n')
+                {
+                    used += 1;
+                }
+                else if (p[0] == '\r')
+                {
+                    if (left < 2)
+                        return MORE;
+                    if (p[1] != '\n')
+                        return ERROR;
+                    used += 2;
+                }
+                else
+                {
+                    return ERROR;
+                }
+                _state = ST_SIZE;
+                break;
+            }
+            case ST_TRAILER:
+            {
+                // 尾部头部不交给业务, 只跳过; 空行结束
+                long n = line_len(p, left);
+                if (n < 0)
+                    return ERROR;
+                if (!n)
+                    return MORE;
+                used += n;
+                _trailer_len += n;
+                if (n == 1 || (n == 2 && p[0] == '\r'))
+                {
+                    _state = ST_DONE;
+                    return DONE;
+                }
+                if (_trailer_len > MAX_HTTP_HEAD_LEN)
+                    return ERROR;
+                break;
+            }
+            case ST_DONE:
+                return DONE;
+        }
+    }
+}
+
+bool http_chunked_decoder::is_chunked(std::string_view te)
+{
+    // 取最后一个逗号后的编码名
+    size_t comma = te.rfind(',');
+    size_t b = comma == std::string_view::npos ? 0 : comma + 1;
+    size_t e = te.size();
+    while (b < e && is_ows(te[b])) b++;
+    while (e > b && is_ows(te[e - 1])) e--;
+    return e - b == 7 && strncasecmp(te.data() + b, "chunked", 7) == 0;
+}
+
+} // namespace myframe
@@ -0,0 +1,67 @@
+#ifndef __HTTP_CHUNKED_DECODER_H__
+#define __HTTP_CHUNKED_DECODER_H__
+
+#include <stdint.h>
+#include <string_view>
+
+namespace myframe {
+
+// Transfer-Encoding: chunked 增量解码器, 服务端(上传)和客户端(上游响应)共用
+// - 可重入: 状态保存在成员里, 每次从上次停下的地方接着解码, 不缓存已到达的字节
+// - 分块大小行/扩展/尾部头部只有整行到齐才消费; 数据部分以视图形式直接指向调用方缓冲, 不拷贝
+// - 调用方按返回值推进: decode 先消费 used 字节的分帧, 返回 DATA 时 data 紧跟其后,
+//   调用方处理完 n 字节后调 data_consumed(n) 并把缓冲再推进 n(可以少于 data.size(), 剩下的下次再给)
+class http_chunked_decoder
+{
+    public:
+        enum result { ERROR = -1, MORE = 0, DATA = 1, DONE = 2 };
+
+        // 分块大小行(含扩展)和单个尾部行的长度上限
+        enum { MAX_LINE_LEN = 4096 };
+
+        http_chunked_decoder();
+
+        void reset();
+
+        int decode(const char * buf, size_t len, size_t & used, std::string_view & data);
+
+        void data_consumed(size_t n)
+        {
+            if (n > _remain)
+                n = (size_t)_remain;
+            _remain -= n;
+            _body_len += n;
+        }
+
+        bool done() const { return _state == ST_DONE; }
+
+        // 已经交出的数据字节数(解码后)
+        uint64_t body_len() const { return _body_len; }
+
+        // Transfer-Encoding 最后一个编码是 chunked 时按分块解码(RFC 7230 3.3.3)
+        static bool is_chunked(std::string_view transfer_encoding);
+
+    private:
+        enum state
+        {
+            ST_SIZE = 0,
+            ST_DATA,
+            ST_DATA_CRLF,
+            ST_TRAILER,
+            ST_DONE
+        };
+
+        // 从 buf 取一整行, 返回含换行的长度, 0 表示还没到齐, -1 表示超长
+        static long line_len(const char * buf, size_t len);
+
+        bool parse_size(const char * line, size_t len);
+
+        state _state;
+        uint64_t _remain;
+        uint64_t _body_len;
+        size_t _trailer_len;
+};
+
+} // namespace myframe
+
+#endif
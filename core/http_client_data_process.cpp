@@ -76,10 +76,10 @@ void http_client_data_process::msg_recv_finish() {
     PDEBUG("Response Body Length: %zu", _resp_body.length());
 #ifdef HAVE_ZLIB
     // Check content-encoding header or gzip magic, try to auto-decompress
-    std::string* enc = hp.get_header("Content-Encoding");
+    std::string_view enc = hp.header_view(myframe::HDR_CONTENT_ENCODING);
     bool is_gzip = false;
-    if (enc) {
-        std::string v = *enc; for (auto& c : v) c = (char)tolower((unsigned char)c);
+    if (!enc.empty()) {
+        std::string v(enc); for (auto& c : v) c = (char)tolower((unsigned char)c);
         if (v.find("gzip") != std::string::npos) is_gzip = true;
     }
     if (!is_gzip && _resp_body.size() >= 2 && (uint8_t)_resp_body[0] == 0x1f && (uint8_t)_resp_body[1] == 0x8b) {
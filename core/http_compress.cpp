@@ -0,0 +1,501 @@
+#include "http_compress.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+#include <vector>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace myframe {
+
+namespace {
+
+struct compress_conf
+{
+    int level;
+    size_t min_bytes;
+};
+
+long env_long(const char * name, long def, long max)
+{
+    long v = def;
+    const char * e = ::getenv(name);
+    if (e && *e)
+        v = atol(e);
+    if (v < 0) v = 0;
+    if (v > max) v = max;
+    return v;
+}
+
+const long MAX_CACHE_BYTES = 1L << 30;
+
+compress_conf & compress_ref()
+{
+    static compress_conf conf = []{
+        compress_conf c;
+        c.level = (int)env_long("MYFRAME_HTTP_COMPRESS_LEVEL", 1, 9);
+        c.min_bytes = (size_t)env_long("MYFRAME_HTTP_COMPRESS_MIN", 1024, 0x7fffffff);
+        return c;
+    }();
+    return conf;
+}
+
+bool iequals(std::string_view a, std::string_view b)
+{
+    return a.size() == b.size() && strncasecmp(a.data(), b.data(), a.size()) == 0;
+}
+
+std::string_view trim(std::string_view s)
+{
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+        s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t'))
+        s.remove_suffix(1);
+    return s;
+}
+
+// Vary 里没有 Accept-Encoding 时补上
+void add_vary(std::map<std::string, std::string> & headers)
+{
+    std::string & vary = headers["Vary"];
+    std::string_view list = vary;
+    while (!list.empty())
+    {
+        size_t comma = list.find(',');
+        if (iequals(trim(list.substr(0, comma)), "Accept-Encoding") || trim(list.substr(0, comma)) == "*")
+            return;
+        list.remove_prefix(comma == std::string_view::npos ? list.size() : comma + 1);
+    }
+    if (!vary.empty())
+        vary += ", ";
+    vary += "Accept-Encoding";
+}
+
+#ifdef HAVE_ZLIB
+
+// 线程内复用的 z_stream, 用完 deflateReset 放回
+struct pooled_zstream
+{
+    z_stream z;
+    int encoding;
+    int level;
+};
+
+struct zstream_pool
+{
+    std::vector<pooled_zstream *> free;
+
+    ~zstream_pool()
+    {
+        for (size_t i = 0; i < free.size(); i++)
+        {
+            deflateEnd(&free[i]->z);
+            delete free[i];
+        }
+    }
+};
+
+const size_t ZSTREAM_POOL_MAX = 16;
+
+zstream_pool & local_zstream_pool()
+{
+    thread_local zstream_pool pool;
+    return pool;
+}
+
+pooled_zstream * zstream_acquire(int encoding, int level)
+{
+    std::vector<pooled_zstream *> & free = local_zstream_pool().free;
+    for (size_t i = free.size(); i > 0; i--)
+    {
+        pooled_zstream * p = free[i - 1];
+        if (p->encoding != encoding)
+            continue;
+        free.erase(free.begin() + (i - 1));
+        if (p->level != level && deflateParams(&p->z, level, Z_DEFAULT_STRATEGY) == Z_OK)
+            p->level = level;
+        return p;
+    }
+
+    pooled_zstream * p = new pooled_zstream;
+    memset(&p->z, 0, sizeof(p->z));
+    int bits = encoding == HTTP_ENCODING_GZIP ? 16 + MAX_WBITS : MAX_WBITS;
+    if (deflateInit2(&p->z, level, Z_DEFLATED, bits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        delete p;
+        return NULL;
+    }
+    p->encoding = encoding;
+    p->level = level;
+    return p;
+}
+
+void zstream_release(pooled_zstream * p)
+{
+    if (!p)
+        return;
+    std::vector<pooled_zstream *> & free = local_zstream_pool().free;
+    if (free.size() < ZSTREAM_POOL_MAX && deflateReset(&p->z) == Z_OK)
+    {
+        free.push_back(p);
+        return;
+    }
+    deflateEnd(&p->z);
+    delete p;
+}
+
+// 压缩 data 追加到 out, 输出缓冲写满就继续, 直到这次的输入和 flush 都做完
+void deflate_append(z_stream * z, const char * data, size_t len, int flush, std::string & out)
+{
+    unsigned char buf[16384];
+    z->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    z->avail_in = (uInt)len;
+    do
+    {
+        z->next_out = buf;
+        z->avail_out = sizeof(buf);
+        deflate(z, flush);
+        out.append(reinterpret_cast<const char *>(buf), sizeof(buf) - z->avail_out);
+    } while (z->avail_out == 0);
+}
+
+#endif
+
+} // namespace
+
+int http_pick_encoding(std::string_view accept_encoding)
+{
+#ifdef HAVE_ZLIB
+    // 每种编码的 q 值, -1 表示没提到
+    double gzip = -1, deflate = -1, star = -1;
+    std::string_view list = accept_encoding;
+    while (!list.empty())
+    {
+        size_t comma = list.find(',');
+        std::string_view item = list.substr(0, comma);
+        list.remove_prefix(comma == std::string_view::npos ? list.size() : comma + 1);
+
+        size_t semi = item.find(';');
+        std::string_view name = trim(item.substr(0, semi));
+        double q = 1;
+        if (semi != std::string_view::npos)
+        {
+            std::string_view param = trim(item.substr(semi + 1));
+            if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=')
+                q = atof(std::string(param.substr(2)).c_str());
+        }
+
+        if (iequals(name, "gzip") || iequals(name, "x-gzip"))
+            gzip = q;
+        else if (iequals(name, "deflate"))
+            deflate = q;
+        else if (name == "*")
+            star = q;
+    }
+    if (gzip < 0) gzip = star;
+    if (deflate < 0) deflate = star;
+
+    if (gzip > 0 && gzip >= deflate)
+        return HTTP_ENCODING_GZIP;
+    if (deflate > 0)
+        return HTTP_ENCODING_DEFLATE;
+#else
+    (void)accept_encoding;
+#endif
+    return HTTP_ENCODING_IDENTITY;
+}
+
+bool http_compressible_type(std::string_view content_type)
+{
+    std::string_view type = trim(content_type.substr(0, content_type.find(';')));
+    if (type.size() > 5 && strncasecmp(type.data(), "text/", 5) == 0)
+        return true;
+
+    static const char * const TYPES[] = {
+        "application/json", "application/javascript", "application/x-javascript", "application/xml",
+        "application/xhtml+xml", "application/rss+xml", "application/atom+xml", "application/ld+json",
+        "application/x-ndjson", "image/svg+xml",
+    };
+    for (size_t i = 0; i < sizeof(TYPES) / sizeof(TYPES[0]); i++)
+        if (iequals(type, TYPES[i]))
+            return true;
+
+    // application/problem+json, application/soap+xml 之类
+    if (type.size() > 5)
+    {
+        std::string_view suffix = type.substr(type.size() - 5);
+        if (iequals(suffix, "+json") || iequals(type.substr(type.size() - 4), "+xml"))
+            return true;
+    }
+    return false;
+}
+
+bool http_compress_body(int encoding, const char * data, size_t len, std::string & out)
+{
+#ifdef HAVE_ZLIB
+    int level = http_compress_level();
+    if (encoding == HTTP_ENCODING_IDENTITY || !level || len > UINT_MAX / 2)
+        return false;
+    pooled_zstream * p = zstream_acquire(encoding, level);
+    if (!p)
+        return false;
+
+    // 上界一次给够, 一次 deflate 做完
+    out.resize(deflateBound(&p->z, (uLong)len));
+    p->z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    p->z.avail_in = (uInt)len;
+    p->z.next_out = reinterpret_cast<Bytef *>(&out[0]);
+    p->z.avail_out = (uInt)out.size();
+    int ret = deflate(&p->z, Z_FINISH);
+    out.resize(out.size() - p->z.avail_out);
+    zstream_release(p);
+    return ret == Z_STREAM_END;
+#else
+    (void)encoding; (void)data; (void)len; (void)out;
+    return false;
+#endif
+}
+
+bool http_compress_response(std::string_view accept_encoding, HttpResponse & res)
+{
+    if (!http_compress_level())
+        return false;
+    if (res.status < 200 || res.status == 204 || res.status == 304)
+        return false;
+    // 业务给的共享缓冲区原样发送
+    if (res.shared_body)
+        return false;
+    if (!res.stream && res.body.size() < http_compress_min())
+        return false;
+    if (res.headers.find("Content-Encoding") != res.headers.end())
+        return false;
+    // 业务给拉取式响应体设了 Content-Length 时原样发送
+    if (res.stream && res.headers.find("Content-Length") != res.headers.end())
+        return false;
+    auto ct = res.headers.find("Content-Type");
+    if (ct == res.headers.end() || !http_compressible_type(ct->second))
+        return false;
+
+    // 压不压都告诉中间缓存按 Accept-Encoding 区分
+    add_vary(res.headers);
+    int encoding = http_pick_encoding(accept_encoding);
+    if (encoding == HTTP_ENCODING_IDENTITY)
+        return false;
+    const char * name = encoding == HTTP_ENCODING_GZIP ? "gzip" : "deflate";
+
+    if (res.stream)
+    {
+        res.stream = std::make_shared<HttpCompressSource>(std::move(res.stream), encoding);
+        res.headers["Content-Encoding"] = name;
+        return true;
+    }
+
+    http_compress_cache & cache = http_compress_cache::instance();
+    bool use_cache = !res.compress_key.empty() && cache.capacity();
+    if (use_cache)
+    {
+        // 命中时把缓存的缓冲区直接交给发送, 不拷进 body
+        shared_buffer hit = cache.get(res.compress_key, encoding, res.compress_version, res.body.size());
+        if (hit)
+        {
+            res.shared_body = hit;
+            res.body.clear();
+            res.headers.erase("Content-Length");
+            res.headers["Content-Encoding"] = name;
+            return true;
+        }
+    }
+
+    std::string out;
+    if (!http_compress_body(encoding, res.body.data(), res.body.size(), out) || out.size() >= res.body.size())
+        return false;
+
+    if (use_cache)
+    {
+        shared_buffer data = make_shared_buffer(std::move(out));
+        cache.put(res.compress_key, encoding, res.compress_version, res.body.size(), data);
+        res.shared_body = data;
+        res.body.clear();
+    }
+    else
+    {
+        res.body.swap(out);
+    }
+    res.headers.erase("Content-Length");
+    res.headers["Content-Encoding"] = name;
+    return true;
+}
+
+void http_compress_set(int level, size_t min_bytes, size_t cache_bytes)
+{
+    if (level < 0) level = 0;
+    if (level > 9) level = 9;
+    compress_ref().level = level;
+    compress_ref().min_bytes = min_bytes;
+    http_compress_cache::instance().set_capacity(cache_bytes);
+}
+
+int http_compress_level()
+{
+    return compress_ref().level;
+}
+
+size_t http_compress_min()
+{
+    return compress_ref().min_bytes;
+}
+
+HttpCompressSource::HttpCompressSource(std::shared_ptr<HttpBodySource> inner, int encoding)
+    : _inner(std::move(inner)), _encoding(encoding), _zs(NULL), _out_off(0), _unflushed(false), _finished(false)
+{
+#ifdef HAVE_ZLIB
+    _zs = zstream_acquire(encoding, http_compress_level() ? http_compress_level() : Z_DEFAULT_COMPRESSION);
+#endif
+    // 业务对内部 source 调 resume() 时唤醒外层
+    _inner->bind_resume([this]() { resume(); });
+}
+
+HttpCompressSource::~HttpCompressSource()
+{
+    _inner->bind_resume(nullptr);
+#ifdef HAVE_ZLIB
+    zstream_release(static_cast<pooled_zstream *>(_zs));
+#endif
+}
+
+int HttpCompressSource::pull(std::string & out, size_t max)
+{
+    // 上次压缩出来没交完的先交
+    if (_out_off < _out.size())
+        return hand_out(out, max, MORE);
+    if (_finished)
+        return DONE;
+#ifdef HAVE_ZLIB
+    if (!_zs)
+        return _inner->pull(out, max);
+    z_stream * z = &static_cast<pooled_zstream *>(_zs)->z;
+    for (;;)
+    {
+        _in.clear();
+        int ret = _inner->pull(_in, max);
+        // 和框架的约定一样: MORE 却没有数据当作 WAIT
+        if (ret == MORE && _in.empty())
+            ret = WAIT;
+        if (!_in.empty())
+            _unflushed = true;
+
+        int flush = Z_NO_FLUSH;
+        if (ret == DONE)
+            flush = Z_FINISH;
+        else if (ret == WAIT && _unflushed)
+            flush = Z_SYNC_FLUSH;
+        if (!_in.empty() || flush != Z_NO_FLUSH)
+            deflate_append(z, _in.data(), _in.size(), flush, _out);
+        if (flush == Z_SYNC_FLUSH)
+            _unflushed = false;
+        if (ret == DONE)
+            _finished = true;
+
+        // 没交完时返回 MORE, 下次先交剩下的再拉内部 source(它 WAIT 过就再回 WAIT)
+        if (!_out.empty() || ret != MORE)
+            return hand_out(out, max, ret);
+        // deflate 可能先攒着不出数据; 交出空的 MORE 会被当成 WAIT, 所以接着拉
+    }
+#else
+    (void)_encoding;
+    return _inner->pull(out, max);
+#endif
+}
+
+int HttpCompressSource::hand_out(std::string & out, size_t max, int ret)
+{
+    size_t n = _out.size() - _out_off;
+    if (n > max)
+        n = max;
+    out.append(_out, _out_off, n);
+    _out_off += n;
+    if (_out_off < _out.size())
+        return MORE;
+    _out.clear();
+    _out_off = 0;
+    return _finished ? DONE : ret;
+}
+
+http_compress_cache & http_compress_cache::instance()
+{
+    static http_compress_cache cache;
+    return cache;
+}
+
+http_compress_cache::http_compress_cache()
+    : _bytes(0), _capacity((size_t)env_long("MYFRAME_HTTP_COMPRESS_CACHE_BYTES", 16L << 20, MAX_CACHE_BYTES))
+{
+}
+
+shared_buffer http_compress_cache::get(const std::string & key, int encoding, uint64_t version, size_t len)
+{
+    std::string id = key;
+    id.push_back('\0');
+    id.push_back((char)('0' + encoding));
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _index.find(id);
+    if (it == _index.end())
+        return shared_buffer();
+    if (it->second->version != version || it->second->len != len)
+        return shared_buffer();
+    _lru.splice(_lru.begin(), _lru, it->second);
+    return it->second->data;
+}
+
+void http_compress_cache::put(const std::string & key, int encoding, uint64_t version, size_t len,
+        const shared_buffer & data)
+{
+    std::string id = key;
+    id.push_back('\0');
+    id.push_back((char)('0' + encoding));
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!data || data->size() > _capacity)
+        return;
+    auto it = _index.find(id);
+    if (it != _index.end())
+    {
+        _bytes -= it->second->data->size();
+        _lru.erase(it->second);
+        _index.erase(it);
+    }
+    _lru.push_front(entry());
+    entry & e = _lru.front();
+    e.id = id;
+    e.version = version;
+    e.len = len;
+    e.data = data;
+    _index[id] = _lru.begin();
+    _bytes += data->size();
+    evict();
+}
+
+void http_compress_cache::set_capacity(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _capacity = bytes > (size_t)MAX_CACHE_BYTES ? (size_t)MAX_CACHE_BYTES : bytes;
+    evict();
+}
+
+void http_compress_cache::evict()
+{
+    while (_bytes > _capacity && !_lru.empty())
+    {
+        entry & e = _lru.back();
+        _bytes -= e.data->size();
+        _index.erase(e.id);
+        _lru.pop_back();
+    }
+}
+
+} // namespace myframe
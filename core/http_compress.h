@@ -0,0 +1,113 @@
+#ifndef __HTTP_COMPRESS_H__
+#define __HTTP_COMPRESS_H__
+
+#include "app_handler_v2.h"
+#include "send_slice.h"
+
+#include <stdint.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace myframe {
+
+// 响应压缩(gzip/deflate), 按请求的 Accept-Encoding 协商; 编译时没有 zlib(HAVE_ZLIB)则一律不压缩
+// - 级别: MYFRAME_HTTP_COMPRESS_LEVEL(默认 1, 0 关闭, 上限 9)
+// - 下限: MYFRAME_HTTP_COMPRESS_MIN(默认 1024 字节, 更小的 body 不压缩; 拉取式响应体大小未知, 总是压缩)
+// - 只压缩 text/*, JSON, JavaScript, XML, SVG 等文本类 Content-Type
+// - z_stream 按线程复用(deflateReset), 不为每个响应 deflateInit
+enum
+{
+    HTTP_ENCODING_IDENTITY = 0,
+    HTTP_ENCODING_GZIP = 1,
+    HTTP_ENCODING_DEFLATE = 2
+};
+
+// 从 Accept-Encoding 选编码, 同等条件下优先 gzip; q=0 的不选
+int http_pick_encoding(std::string_view accept_encoding);
+
+// Content-Type 是否在允许压缩的列表里
+bool http_compressible_type(std::string_view content_type);
+
+// 一次压缩整段 data, 结果写入 out; 没有 zlib 或失败返回 false
+bool http_compress_body(int encoding, const char * data, size_t len, std::string & out);
+
+// 按 accept_encoding 压缩 res(body 或 stream), 设好 Content-Encoding 和 Vary; 压缩了返回 true
+// res.compress_key 非空时压缩结果进缓存并放进 res.shared_body; 同一 key 同样长度和 compress_version 的 body
+// 再来直接发缓存的缓冲区, 不再压缩也不拷贝; 已经带 shared_body 的响应不压缩
+bool http_compress_response(std::string_view accept_encoding, HttpResponse & res);
+
+// 覆盖环境变量: level 0 关闭; cache_bytes 0 关闭压缩结果缓存
+void http_compress_set(int level, size_t min_bytes, size_t cache_bytes);
+
+int http_compress_level();
+size_t http_compress_min();
+
+// 流式压缩: 包一个 HttpBodySource, 每段拉到的数据压缩后交出
+// 内部 source 返回 WAIT 时做一次 Z_SYNC_FLUSH, 已拉到的数据(长轮询的事件)立即送到客户端
+// 每次交出不超过 max(deflate 一次吐出的可能更多), 多的留到下次 pull
+class HttpCompressSource : public HttpBodySource {
+public:
+    HttpCompressSource(std::shared_ptr<HttpBodySource> inner, int encoding);
+    ~HttpCompressSource();
+
+    int pull(std::string & out, size_t max) override;
+
+private:
+    // 从 _out 交出至多 max 字节; 交完时返回 ret(_finished 时 DONE), 没交完返回 MORE
+    int hand_out(std::string & out, size_t max, int ret);
+
+    std::shared_ptr<HttpBodySource> _inner;
+    int _encoding;
+    void * _zs;          // 线程池里借来的 z_stream
+    std::string _in;
+    std::string _out;    // 压缩好还没交出的数据, 从 _out_off 开始
+    size_t _out_off;
+    bool _unflushed;     // 上次 flush 之后有新输入
+    bool _finished;
+};
+
+// 压缩结果缓存(进程内共享, LRU, 按字节数限容)
+// 按 (key, 编码) 存, 同时记下原 body 的长度和业务给的版本号, 任一个变了就当未命中重新压缩
+// 容量: MYFRAME_HTTP_COMPRESS_CACHE_BYTES(默认 16MB, 0 关闭, 上限 1GB)
+class http_compress_cache
+{
+    public:
+        static http_compress_cache & instance();
+
+        shared_buffer get(const std::string & key, int encoding, uint64_t version, size_t len);
+
+        void put(const std::string & key, int encoding, uint64_t version, size_t len, const shared_buffer & data);
+
+        void set_capacity(size_t bytes);
+
+        size_t capacity() const { return _capacity; }
+
+        size_t bytes() const { return _bytes; }
+
+    private:
+        http_compress_cache();
+
+        struct entry
+        {
+            std::string id;
+            uint64_t version;
+            size_t len;
+            shared_buffer data;
+        };
+
+        void evict();
+
+        std::mutex _mutex;
+        std::list<entry> _lru;          // 前面是最近用过的
+        std::unordered_map<std::string, std::list<entry>::iterator> _index;
+        size_t _bytes;
+        size_t _capacity;
+};
+
+} // namespace myframe
+
+#endif
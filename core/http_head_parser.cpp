@@ -0,0 +1,166 @@
+#include "http_head_parser.h"
+#include <string.h>
+#include <strings.h>
+
+namespace myframe {
+
+namespace {
+
+inline bool is_ows(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+} // namespace
+
+http_head_parser::http_head_parser(mode m)
+    : _mode(m)
+{
+    reset();
+}
+
+void http_head_parser::reset()
+{
+    _base = NULL;
+    _pos = 0;
+    _line_start = 0;
+    _head_len = 0;
+    _first_done = false;
+    memset(_first, 0, sizeof(_first));
+    _headers.clear();
+    memset(_known, 0xff, sizeof(_known));
+}
+
+int http_head_parser::parse(const char * buf, size_t len)
+{
+    if (_head_len)
+        return DONE;
+
+    _base = buf;
+    while (_pos < len)
+    {
+        const char * nl = (const char *)memchr(buf + _pos, '\n', len - _pos);
+        if (!nl)
+        {
+            _pos = len;
+            return MORE;
+        }
+
+        size_t begin = _line_start;
+        size_t end = nl - buf;
+        _pos = _line_start = end + 1;
+        if (end > begin && buf[end - 1] == '\r')
+            end--;
+
+        if (!_first_done)
+        {
+            // 首行前的空行忽略(RFC 7230 3.5)
+            if (end == begin)
+                continue;
+            if (!parse_first_line(buf, begin, end))
+                return ERROR;
+            _first_done = true;
+        }
+        else if (end == begin)
+        {
+            _head_len = _pos;
+            return DONE;
+        }
+        else
+        {
+            parse_header_line(buf, begin, end);
+        }
+    }
+    return MORE;
+}
+
+bool http_head_parser::parse_first_line(const char * buf, size_t begin, size_t end)
+{
+    const char * p = buf + begin;
+    const char * sp1 = (const char *)memchr(p, ' ', end - begin);
+    if (!sp1 || sp1 == p)
+        return false;
+    size_t off1 = sp1 - buf + 1;
+    const char * sp2 = (const char *)memchr(buf + off1, ' ', end - off1);
+
+    _first[0].off = begin;
+    _first[0].len = sp1 - p;
+    if (_mode == RESPONSE)
+    {
+        // 状态描述可以含空格, 也可以省略
+        size_t code_end = sp2 ? (size_t)(sp2 - buf) : end;
+        if (code_end == off1)
+            return false;
+        _first[1].off = off1;
+        _first[1].len = code_end - off1;
+        _first[2].off = sp2 ? code_end + 1 : end;
+        _first[2].len = end - _first[2].off;
+        return true;
+    }
+
+    // 请求行严格是 "method SP target SP version"
+    if (!sp2 || (size_t)(sp2 - buf) == off1 || (size_t)(sp2 - buf) + 1 >= end)
+        return false;
+    size_t off2 = sp2 - buf + 1;
+    if (memchr(buf + off2, ' ', end - off2))
+        return false;
+    _first[1].off = off1;
+    _first[1].len = off2 - 1 - off1;
+    _first[2].off = off2;
+    _first[2].len = end - off2;
+    return true;
+}
+
+void http_head_parser::parse_header_line(const char * buf, size_t begin, size_t end)
+{
+    const char * colon = (const char *)memchr(buf + begin, ':', end - begin);
+    // 没有冒号的行和以前一样忽略
+    if (!colon)
+        return;
+
+    size_t name_end = colon - buf;
+    size_t v = name_end + 1;
+    while (v < end && is_ows(buf[v]))
+        v++;
+    size_t v_end = end;
+    while (v_end > v && is_ows(buf[v_end - 1]))
+        v_end--;
+
+    header_ref h;
+    h.name.off = begin;
+    h.name.len = name_end - begin;
+    h.value.off = v;
+    h.value.len = v_end - v;
+
+    // 记下常用头部第一次出现的位置, 重复的头部和以前一样以第一个为准
+    http_header_id id = http_header_index::lookup(std::string_view(buf + begin, h.name.len));
+    if (id != HDR_UNKNOWN && _known[id] < 0 && _headers.size() < 0x7fff)
+        _known[id] = (int16_t)_headers.size();
+    _headers.push_back(h);
+}
+
+std::string_view http_head_parser::find(std::string_view name) const
+{
+    http_header_id id = http_header_index::lookup(name);
+    if (id != HDR_UNKNOWN)
+        return find(id);
+
+    for (size_t i = 0; i < _headers.size(); i++)
+    {
+        const header_ref & h = _headers[i];
+        if (h.name.len == name.size() && strncasecmp(_base + h.name.off, name.data(), name.size()) == 0)
+            return view(h.value);
+    }
+    return std::string_view();
+}
+
+void http_head_parser::detach()
+{
+    if (!_base || _base == _owned.data())
+        return;
+    size_t n = _head_len ? _head_len : _pos;
+    _owned.assign(_base, n);
+    _base = _owned.data();
+}
+
+} // namespace myframe
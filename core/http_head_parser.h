@@ -0,0 +1,102 @@
+#ifndef __HTTP_HEAD_PARSER_H__
+#define __HTTP_HEAD_PARSER_H__
+
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "http_header_index.h"
+
+namespace myframe {
+
+// HTTP/1.x 报文头增量解析器
+// - 可重入: 记住上次扫描到的位置, 数据没收全时下次只扫新到的字节, 每个字节只看一次
+// - 首行三段和各个头部只记偏移, 通过 string_view 访问, 解析过程不分配内存
+// - 每次 parse 传入的缓冲都要从报文头第一个字节开始(接收缓冲在头收全前不消费, 起点不变)
+// - 视图指向最近一次 parse 的缓冲; 缓冲要被消费/搬移前调 detach() 把报文头拷到自己名下
+class http_head_parser
+{
+    public:
+        enum mode { REQUEST = 0, RESPONSE = 1 };
+        enum result { ERROR = -1, MORE = 0, DONE = 1 };
+
+        explicit http_head_parser(mode m = REQUEST);
+
+        // 视图可能指向自己的缓冲, 不能拷贝
+        http_head_parser(const http_head_parser &) = delete;
+        http_head_parser & operator=(const http_head_parser &) = delete;
+
+        // 开始解析下一个报文; 保留内部容器的容量
+        void reset();
+
+        int parse(const char * buf, size_t len);
+
+        bool done() const { return _head_len != 0; }
+
+        // 含结尾空行的报文头长度, 未解析完为 0
+        size_t head_len() const { return _head_len; }
+
+        // 已经扫描过的字节数
+        size_t scanned() const { return _pos; }
+
+        // 请求: method / path / version; 响应: version / code / reason
+        std::string_view first(size_t i) const
+        {
+            return i < 3 ? view(_first[i]) : std::string_view();
+        }
+
+        size_t header_count() const { return _headers.size(); }
+        std::string_view header_name(size_t i) const { return view(_headers[i].name); }
+        std::string_view header_value(size_t i) const { return view(_headers[i].value); }
+
+        // 按名字查找第一个同名头部(不区分大小写, 整词匹配), 没有返回空视图(data() 为 NULL)
+        // 常用头部走解析时记下的下标, 其余的在头部数组里顺序找
+        std::string_view find(std::string_view name) const;
+
+        std::string_view find(http_header_id id) const
+        {
+            if (id < 0 || id >= HDR_KNOWN_NUM || _known[id] < 0)
+                return std::string_view();
+            return view(_headers[_known[id]].value);
+        }
+
+        // 把报文头拷进内部缓冲, 之后视图不再依赖接收缓冲
+        void detach();
+
+    private:
+        struct span
+        {
+            uint32_t off;
+            uint32_t len;
+        };
+
+        struct header_ref
+        {
+            span name;
+            span value;
+        };
+
+        std::string_view view(span s) const
+        {
+            return std::string_view(_base + s.off, s.len);
+        }
+
+        bool parse_first_line(const char * buf, size_t begin, size_t end);
+        void parse_header_line(const char * buf, size_t begin, size_t end);
+
+        mode _mode;
+        const char * _base;
+        size_t _pos;
+        size_t _line_start;
+        size_t _head_len;
+        bool _first_done;
+        span _first[3];
+        std::vector<header_ref> _headers;
+        int16_t _known[HDR_KNOWN_NUM];
+        std::string _owned;
+};
+
+} // namespace myframe
+
+#endif
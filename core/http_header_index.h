@@ -0,0 +1,158 @@
+#ifndef __HTTP_HEADER_INDEX_H__
+#define __HTTP_HEADER_INDEX_H__
+
+#include <stdint.h>
+#include <string_view>
+
+namespace myframe {
+
+// 常用头部名的编号; 解析时查一次表记下每个常用头部第一次出现的位置, 之后按编号 O(1) 取值
+enum http_header_id
+{
+    HDR_UNKNOWN = -1,
+    HDR_ACCEPT = 0,
+    HDR_ACCEPT_ENCODING,
+    HDR_ACCEPT_LANGUAGE,
+    HDR_AUTHORIZATION,
+    HDR_CACHE_CONTROL,
+    HDR_CONNECTION,
+    HDR_CONTENT_ENCODING,
+    HDR_CONTENT_LENGTH,
+    HDR_CONTENT_TYPE,
+    HDR_COOKIE,
+    HDR_DATE,
+    HDR_EXPECT,
+    HDR_HOST,
+    HDR_IF_MODIFIED_SINCE,
+    HDR_IF_NONE_MATCH,
+    HDR_KEEP_ALIVE,
+    HDR_LOCATION,
+    HDR_ORIGIN,
+    HDR_RANGE,
+    HDR_REFERER,
+    HDR_SEC_WEBSOCKET_KEY,
+    HDR_SEC_WEBSOCKET_VERSION,
+    HDR_SERVER,
+    HDR_SET_COOKIE,
+    HDR_TE,
+    HDR_TRAILER,
+    HDR_TRANSFER_ENCODING,
+    HDR_UPGRADE,
+    HDR_USER_AGENT,
+    HDR_X_FORWARDED_FOR,
+    HDR_X_REAL_IP,
+    HDR_X_REQUEST_ID,
+    HDR_KNOWN_NUM
+};
+
+// 编译期生成的完美哈希: 长度 + 首/中/尾字符(小写)算槽位, 表里没有冲突(static_assert 保证),
+// 查找是一次哈希、一次长度比较加一次不区分大小写的比较
+class http_header_index
+{
+    public:
+        enum { TABLE_SIZE = 64 };
+
+        static constexpr std::string_view name(http_header_id id)
+        {
+            return NAMES[id];
+        }
+
+        static http_header_id lookup(std::string_view n)
+        {
+            if (n.empty())
+                return HDR_UNKNOWN;
+            int8_t id = table().slot[hash(n)];
+            if (id < 0)
+                return HDR_UNKNOWN;
+            std::string_view k = NAMES[id];
+            if (k.size() != n.size())
+                return HDR_UNKNOWN;
+            for (size_t i = 0; i < k.size(); i++)
+            {
+                if (lower(n[i]) != lower(k[i]))
+                    return HDR_UNKNOWN;
+            }
+            return (http_header_id)id;
+        }
+
+    private:
+        struct slot_table
+        {
+            int8_t slot[TABLE_SIZE];
+            bool perfect;
+        };
+
+        static constexpr char lower(char c)
+        {
+            return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+        }
+
+        static constexpr size_t hash(std::string_view n)
+        {
+            return (n.size() * 11 + (unsigned char)lower(n[0]) * 26
+                    + (unsigned char)lower(n[n.size() - 1]) * 24
+                    + (unsigned char)lower(n[n.size() / 2])) & (TABLE_SIZE - 1);
+        }
+
+        static constexpr slot_table build()
+        {
+            slot_table t = {};
+            t.perfect = true;
+            for (int i = 0; i < TABLE_SIZE; i++)
+                t.slot[i] = -1;
+            for (int i = 0; i < HDR_KNOWN_NUM; i++)
+            {
+                size_t h = hash(NAMES[i]);
+                if (t.slot[h] >= 0)
+                    t.perfect = false;
+                t.slot[h] = (int8_t)i;
+            }
+            return t;
+        }
+
+        static const slot_table & table()
+        {
+            static constexpr slot_table t = build();
+            static_assert(t.perfect, "http_header_index hash collision, adjust hash()");
+            return t;
+        }
+
+        static constexpr std::string_view NAMES[HDR_KNOWN_NUM] = {
+            "Accept",
+            "Accept-Encoding",
+            "Accept-Language",
+            "Authorization",
+            "Cache-Control",
+            "Connection",
+            "Content-Encoding",
+            "Content-Length",
+            "Content-Type",
+            "Cookie",
+            "Date",
+            "Expect",
+            "Host",
+            "If-Modified-Since",
+            "If-None-Match",
+            "Keep-Alive",
+            "Location",
+            "Origin",
+            "Range",
+            "Referer",
+            "Sec-WebSocket-Key",
+            "Sec-WebSocket-Version",
+            "Server",
+            "Set-Cookie",
+            "TE",
+            "Trailer",
+            "Transfer-Encoding",
+            "Upgrade",
+            "User-Agent",
+            "X-Forwarded-For",
+            "X-Real-IP",
+            "X-Request-Id",
+        };
+};
+
+} // namespace myframe
+
+#endif
@@ -8,11 +8,10 @@
 #include "http_base_data_process.h"
 #include "common_util.h"
 
-http_req_process::http_req_process(std::shared_ptr<base_net_obj> p):http_base_process(p)
+http_req_process::http_req_process(std::shared_ptr<base_net_obj> p)
+    : http_base_process(p, myframe::http_head_parser::RESPONSE)
 {
     http_base_process::change_http_status(SEND_HEAD);
-    _cur_chunked_len = -1;
-    _cur_chunked_rec_len = -1;
     _recv_body_length = 0;
     _recv_type = CONTENT_LENGTH_TYPE;
 }
@@ -28,10 +27,7 @@ void http_req_process::reset()
     _req_head_para.init();
     _res_head_para.init();
 
-    _cur_chunked_len = -1;
-    _cur_chunked_rec_len = -1;
     _recv_body_length = 0;
-    _chunked_body.clear();
 }
 
 
@@ -43,52 +39,23 @@ void http_req_process::peer_close()
     }
 }
 
-void http_req_process::parse_first_line(const std::string & line)
+void http_req_process::parse_header(const myframe::http_head_parser & head)
 {
     // HTTP response: "HTTP/1.1 200 OK" or "HTTP/1.1 404 Not Found"
-    // Status text may contain spaces, so we only split the first 2 spaces
-    std::vector<std::string> tmp_vec;
-    SplitString(line.c_str(), " ", &tmp_vec, SPLIT_MODE_ALL);
-    if (tmp_vec.size() < 3) {
-        THROW_COMMON_EXCEPT("http first line");
-    }
-    _res_head_para._response_code = strtoull(tmp_vec[1].c_str(), 0, 10);
-    _res_head_para._version = tmp_vec[0];
-    // Join remaining parts as status text (e.g. "Not Found")
-    _res_head_para._response_str = tmp_vec[2];
-    for (size_t i = 3; i < tmp_vec.size(); ++i) {
-        _res_head_para._response_str += " " + tmp_vec[i];
-    }
-}
-
-void http_req_process::parse_header(std::string & recv_head)
-{
-    PDEBUG("recv_head:%s", recv_head.c_str());
-    std::string &head_str = recv_head;
-    std::vector<std::string> strList;
-    SplitString(head_str.c_str(), CRLF, &strList, SPLIT_MODE_ALL);
-    for (uint32_t i = 0; i < strList.size(); i++) {
-        if (!i) {
-            parse_first_line(strList[i]);
-        }else {
-            std::vector<std::string> tmp_vec;
-            SplitString(strList[i].c_str(), ":", &tmp_vec, SPLIT_MODE_ONE);
-            if (2 == tmp_vec.size()) {
-                //THROW_COMMON_EXCEPT("http headers parms error");
-                _res_head_para._headers.insert(make_pair(tmp_vec[0], tmp_vec[1]));
-                PDEBUG("%s: %s", tmp_vec[0].c_str(), tmp_vec[1].c_str());
-            }
-        }
-    }
+    // the parser keeps the whole status text (may contain spaces) as the third token
+    std::string code(head.first(1).data(), head.first(1).size());
+    _res_head_para._response_code = strtoull(code.c_str(), 0, 10);
+    _res_head_para._version.assign(head.first(0).data(), head.first(0).size());
+    _res_head_para._response_str.assign(head.first(2).data(), head.first(2).size());
+    _res_head_para._parsed = &head;
+    _res_head_para._headers_built = false;
 
     //parse chunked
-    std::string * tmp_str= _res_head_para.get_header("Transfer-Encoding");
-    if (tmp_str)
-    {	
-        _res_head_para._chunked = *tmp_str;
-        StringTrim(_res_head_para._chunked);	
+    std::string_view te = head.find(myframe::HDR_TRANSFER_ENCODING);
+    if (te.data())
+    {
+        _res_head_para._chunked.assign(te.data(), te.size());
     }
-
 }
 
 size_t http_req_process::process_recv_body(const char *buf, size_t len, int &result)
@@ -96,22 +63,22 @@ size_t http_req_process::process_recv_body(const char *buf, size_t len, int &res
     result = 0;
     size_t ret  = 0;
     uint64_t content_length = 0;
-    std::string *tmp_str = _res_head_para.get_header("Content-Length");
-    if (tmp_str)
+    std::string_view tmp_str = _res_head_para.header_view(myframe::HDR_CONTENT_LENGTH);
+    if (!tmp_str.empty())
     {
-        content_length = strtoull(tmp_str->c_str(), 0, 10);
+        content_length = strtoull(std::string(tmp_str).c_str(), 0, 10);
     }
-    if (_res_head_para._chunked == "chunked")
+    if (myframe::http_chunked_decoder::is_chunked(_res_head_para._chunked))
     {
         _recv_type = CHUNK_TYPE;
-        ret = get_chuncked(buf, len, result);				
+        ret = process_chunked_body(buf, len, result);
     }
     else if (content_length)
     {
         _recv_type = CONTENT_LENGTH_TYPE;
         ret = _data_process->process_recv_body(buf, len, result);
         _recv_body_length += ret;
-        if (_recv_body_length == content_length)
+        if (_recv_body_length == content_length && result >= 0)
         {
             result = 1;
         }
@@ -126,77 +93,12 @@ size_t http_req_process::process_recv_body(const char *buf, size_t len, int &res
     return ret;
 }
 
-size_t http_req_process::get_chuncked(const char *buf, size_t len, int &result)
-{
-    size_t ret = len;
-    size_t p_len = 0;
-    result = 0;
-    if (len == 0)
-        return 0;
-
-    _chunked_body.append(buf, len);
-    while (1)
-    {
-        if (_cur_chunked_len == -1)
-        {   
-            std::string sTmp;
-            int nRet= GetStringByLabel(_chunked_body, "", "\r\n", sTmp, 0, 1);            
-            if (nRet != -1)
-            {
-                _cur_chunked_len=strtoul(sTmp.c_str(), 0, 16);
-                _cur_chunked_rec_len = nRet;
-                if(_cur_chunked_len == 0)
-                {         
-                    result = 1; //������
-                    break;
-                }
-
-                if (_cur_chunked_len + 2 + _cur_chunked_rec_len  > (int)_chunked_body.length())
-                {
-                    break;
-                }
-                else
-                {
-                    p_len = _data_process->process_recv_body((char*)_chunked_body.substr(_cur_chunked_rec_len, _cur_chunked_len).c_str(), _cur_chunked_len, result);
-                    p_len = _cur_chunked_len - p_len;
-
-                    _chunked_body = _chunked_body.substr(_cur_chunked_rec_len+2+_cur_chunked_len);
-                    _cur_chunked_len = -1;
-                    if (0 == _chunked_body.length())
-                        break;
-                }
-            }
-            else
-            {
-                break;
-            }
-        }
-        else //�Ѿ���ȡ���ȵ���û�л�ȡ����
-        {          
-            if (_cur_chunked_len+2+_cur_chunked_rec_len > (int)_chunked_body.length())
-            {
-                break;
-            }
-            else
-            {
-                p_len = _data_process->process_recv_body((char*)_chunked_body.substr(_cur_chunked_rec_len, _cur_chunked_len).c_str(), _cur_chunked_len, result); 
-                p_len = _cur_chunked_len - p_len;
-                _chunked_body = _chunked_body.substr(_cur_chunked_len+_cur_chunked_rec_len+2);
-                _cur_chunked_len = -1;
-                if ( 0 == _chunked_body.length())
-                    break;
-            }
-        }
-    }
-    return ret - p_len;
-}
-
 void http_req_process::recv_finish()
 {
     // Check if server sent Connection: close before reset() clears headers
     bool should_close = false;
-    std::string* conn_hdr = _res_head_para.get_header("Connection");
-    if (conn_hdr && strcasecmp(conn_hdr->c_str(), "close") == 0) {
+    std::string_view conn_hdr = _res_head_para.header_view(myframe::HDR_CONNECTION);
+    if (conn_hdr.size() == 5 && strncasecmp(conn_hdr.data(), "close", 5) == 0) {
         should_close = true;
     }
 
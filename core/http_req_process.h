@@ -26,21 +26,14 @@ class http_req_process:public http_base_process
     protected:
         virtual size_t process_recv_body(const char *buf, size_t len, int &result);
 
-        size_t get_chuncked(const char *buf, size_t len, int &result);
-
         void recv_finish();
 
         void send_finish();
         
-        virtual void parse_first_line(const std::string & line);
-
-        virtual void parse_header(std::string & recv_head);
+        virtual void parse_header(const myframe::http_head_parser & head);
 
     protected:
 
-		int64_t _cur_chunked_len;
-		int64_t _cur_chunked_rec_len;
-        std::string _chunked_body;
 		size_t _recv_body_length;
 
 		HTTP_RECV_TYPE _recv_type;
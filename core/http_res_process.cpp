@@ -8,6 +8,74 @@
 #include "http_base_process.h"
 #include "http_base_data_process.h"
 #include "common_util.h"
+#include "string_pool.h"
+
+namespace {
+
+struct keepalive_conf
+{
+    uint32_t timeout_ms;
+    uint32_t max_requests;
+};
+
+long env_long(const char * name, long def, long max)
+{
+    long v = def;
+    const char * e = ::getenv(name);
+    if (e && *e)
+        v = atol(e);
+    if (v < 0) v = 0;
+    if (v > max) v = max;
+    return v;
+}
+
+keepalive_conf & keepalive_ref()
+{
+    static keepalive_conf conf = []{
+        keepalive_conf c;
+        c.timeout_ms = (uint32_t)env_long("MYFRAME_HTTP_KEEPALIVE_MS", 60000, 3600000);
+        c.max_requests = (uint32_t)env_long("MYFRAME_HTTP_KEEPALIVE_MAX", 1000, 0x7fffffff);
+        return c;
+    }();
+    return conf;
+}
+
+// 逗号分隔的头部值里是否有某个 token(不区分大小写), 如 Connection: keep-alive, Upgrade
+bool has_token(std::string_view list, std::string_view tok)
+{
+    size_t pos = 0;
+    while (pos < list.size())
+    {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string_view::npos)
+            comma = list.size();
+        size_t b = pos, e = comma;
+        while (b < e && (list[b] == ' ' || list[b] == '\t')) b++;
+        while (e > b && (list[e - 1] == ' ' || list[e - 1] == '\t')) e--;
+        if (e - b == tok.size() && strncasecmp(list.data() + b, tok.data(), tok.size()) == 0)
+            return true;
+        pos = comma + 1;
+    }
+    return false;
+}
+
+} // namespace
+
+uint32_t http_res_process::keepalive_timeout_ms()
+{
+    return keepalive_ref().timeout_ms;
+}
+
+uint32_t http_res_process::keepalive_max_requests()
+{
+    return keepalive_ref().max_requests;
+}
+
+void http_res_process::set_keepalive(uint32_t timeout_ms, uint32_t max_requests)
+{
+    keepalive_ref().timeout_ms = timeout_ms > 3600000 ? 3600000 : timeout_ms;
+    keepalive_ref().max_requests = max_requests > 0x7fffffff ? 0x7fffffff : max_requests;
+}
 
 
 http_res_process::http_res_process(std::shared_ptr<base_net_obj>  p):http_base_process(p)
@@ -15,6 +83,10 @@ http_res_process::http_res_process(std::shared_ptr<base_net_obj>  p):http_base_p
     change_http_status(RECV_HEAD);
     _recv_body_length = 0;
     _recv_boundary_status = BOUNDARY_RECV_HEAD;
+    _recv_chunked = false;
+    _requests = 0;
+    _idle_timer_id = 0;
+    _in_recv_batch = false;
 }
 
 http_res_process::~http_res_process()
@@ -30,125 +102,128 @@ void http_res_process::reset()
     _boundary_para.init();
     _recv_body_length = 0;
     _recv_boundary_status = BOUNDARY_RECV_HEAD;
+    _recv_chunked = false;
 }
 
 
 size_t http_res_process::process_recv_body(const char *buf, size_t len, int &result)
 {
-
     int ret = 0;
-    if (strcasecmp(_req_head_para._method.c_str(), "GET") == 0 || strcasecmp(_req_head_para._method.c_str(), "HEAD") == 0)
+    // 分块上传优先于 Content-Length(RFC 7230 3.3.3), 解码后的数据不再按 boundary 拆分
+    if (_recv_chunked)
     {
-        result = 1;
-        ret = len;
+        return process_chunked_body(buf, len, result);
     }
-    else
+    // GET/HEAD 一般不带 Content-Length, 走"没有 body"的分支; 后面的字节属于下一个流水线请求
+    if (_boundary_para._boundary_str.length() == 0)
     {
-        if (_boundary_para._boundary_str.length() == 0)
+        std::string_view tmp_str = _req_head_para.header_view(myframe::HDR_CONTENT_LENGTH);
+        if (!tmp_str.data())
         {
-            std::string *tmp_str = _req_head_para.get_header("Content-Length");
-            if (!tmp_str)
+            // No Content-Length header: finish immediately to avoid hanging.
+            // Do not consume current bytes here; they may belong to next request.
+            result = 1;
+            ret = 0;
+        }
+        else
+        {
+            uint64_t content_length = strtoull(std::string(tmp_str).c_str(), 0, 10);
+            if (_recv_body_length >= content_length)
             {
-                // No Content-Length header: finish immediately to avoid hanging.
-                // Do not consume current bytes here; they may belong to next request.
+                // Content-Length: 0 or body already complete.
+                // Leave current bytes for next request in keep-alive/pipeline.
                 result = 1;
                 ret = 0;
             }
             else
             {
-                uint64_t content_length = strtoull(tmp_str->c_str(), 0, 10);
-                if (_recv_body_length >= content_length)
-                {
-                    // Content-Length: 0 or body already complete.
-                    // Leave current bytes for next request in keep-alive/pipeline.
-                    result = 1;
-                    ret = 0;
-                }
-                else
-                {
-                    size_t remain = static_cast<size_t>(content_length - _recv_body_length);
-                    size_t take = len < remain ? len : remain;
-                    ret = _data_process->process_recv_body(buf, take, result);
-                    _recv_body_length += ret;
-                }
-
-                if (_recv_body_length >= content_length)
-                {
-                    result = 1;
-                }
-            }				
-        }
-        else //parse boundary
-        {
-            ret = get_boundary(buf, len, result);
-        }
+                size_t remain = static_cast<size_t>(content_length - _recv_body_length);
+                size_t take = len < remain ? len : remain;
+                ret = _data_process->process_recv_body(buf, take, result);
+                _recv_body_length += ret;
+            }
+
+            if (_recv_body_length >= content_length && result >= 0)
+            {
+                result = 1;
+            }
+        }				
+    }
+    else //parse boundary
+    {
+        ret = get_boundary(buf, len, result);
     }
     return ret;
 }
 
 
-void http_res_process::parse_first_line(const std::string & line)
+void http_res_process::parse_header(const myframe::http_head_parser & head)
 {
-    std::vector<std::string> tmp_vec;
-    SplitString(line.c_str(), " ", &tmp_vec, SPLIT_MODE_ALL);
-    if (tmp_vec.size() != 3) {
-        THROW_COMMON_EXCEPT("http first line");
-    }
-    _req_head_para._method = tmp_vec[0];
-    _req_head_para._version = tmp_vec[2];
-    _req_head_para._url_path = tmp_vec[1];
-}
+    // 请求行三段例子和适配层直接读, 照旧填值; 头部只挂视图, 用到 map 时再展开
+    _req_head_para._method.assign(head.first(0).data(), head.first(0).size());
+    _req_head_para._url_path.assign(head.first(1).data(), head.first(1).size());
+    _req_head_para._version.assign(head.first(2).data(), head.first(2).size());
+    _req_head_para._parsed = &head;
+    _req_head_para._headers_built = false;
 
-void http_res_process::parse_header(std::string & recv_head)
-{
-    std::string &head_str = recv_head;
-    std::vector<std::string> strList;
-    SplitString(head_str.c_str(), CRLF, &strList, SPLIT_MODE_ALL);
-    for (uint32_t i = 0; i < strList.size(); i++) {
-        if (!i) {
-            parse_first_line(strList[i]);
-        }else {
-            std::vector<std::string> tmp_vec;
-            SplitString(strList[i].c_str(), ":", &tmp_vec, SPLIT_MODE_ONE);
-            if (2 == tmp_vec.size()) {
-                _req_head_para._headers.insert(make_pair(tmp_vec[0], tmp_vec[1]));
-                PDEBUG("%s: %s", tmp_vec[0].c_str(), tmp_vec[1].c_str());
-            }
+    // HTTP/1.1 默认长连接, 除非带 close; HTTP/1.0 要显式带 keep-alive
+    std::string_view conn = head.find(myframe::HDR_CONNECTION);
+    bool client_keep;
+    if (_req_head_para._version == "HTTP/1.1")
+        client_keep = !has_token(conn, "close");
+    else
+        client_keep = has_token(conn, "keep-alive");
+    _requests++;
+    uint32_t max_requests = keepalive_max_requests();
+    _keep_alive = client_keep && keepalive_timeout_ms() && (!max_requests || _requests < max_requests);
+
+    std::string_view cookie = head.find(myframe::HDR_COOKIE);
+    if (!cookie.empty())
+    {
+        // name=value; name2=value2
+        size_t pos = 0;
+        while (pos < cookie.size())
+        {
+            size_t semi = cookie.find(';', pos);
+            if (semi == std::string_view::npos)
+                semi = cookie.size();
+            std::string_view item = cookie.substr(pos, semi - pos);
+            pos = semi + 1;
+
+            size_t eq = item.find('=');
+            if (eq == std::string_view::npos)
+                continue;
+            std::string name(item.data(), eq);
+            std::string value(item.data() + eq + 1, item.size() - eq - 1);
+            StringTrim(name);
+            StringTrim(value);
+            _req_head_para._cookie_list.insert(make_pair(name, value));
         }
     }
 
-    std::string * cookie_str = _req_head_para.get_header("Cookie");
-    if (cookie_str)
+    std::string_view te = head.find(myframe::HDR_TRANSFER_ENCODING);
+    if (te.data())
     {
-        std::vector<std::string> cookie_vec;
-        SplitString(cookie_str->c_str(), ";", &cookie_vec, SPLIT_MODE_ALL);
-        size_t c_num = cookie_vec.size();
-        for (size_t ii = 0; ii < c_num; ii++)
+        if (!myframe::http_chunked_decoder::is_chunked(te))
         {
-            std::vector<std::string> c_tmp_vec;
-            SplitString(cookie_vec[ii].c_str(), "=", &c_tmp_vec, SPLIT_MODE_ONE);
-            if (c_tmp_vec.size() == 2)
-            {
-                StringTrim(c_tmp_vec[0]);
-                StringTrim(c_tmp_vec[1]);
-                _req_head_para._cookie_list.insert(make_pair(c_tmp_vec[0], c_tmp_vec[1]));
-            }
+            THROW_COMMON_EXCEPT("unsupported transfer-encoding " << std::string(te));
         }
+        _recv_chunked = true;
     }
 
-    std::string *tmp_str = NULL;
-    if (_req_head_para._method == "POST" || _req_head_para._method == "PUT")
+    if (!_recv_chunked && (_req_head_para._method == "POST" || _req_head_para._method == "PUT"))
     {
         //parse content_type
-        tmp_str = _req_head_para.get_header("Content-Type");
-        if (tmp_str)
+        std::string_view content_type = head.find(myframe::HDR_CONTENT_TYPE);
+        if (!content_type.empty())
         {
-            if (strcasestr(tmp_str->c_str(), "multipart/form-data") != NULL)
+            std::string tmp_str(content_type.data(), content_type.size());
+            if (strcasestr(tmp_str.c_str(), "multipart/form-data") != NULL)
             {
-                GetCaseStringByLabel(*tmp_str, "boundary=", "", _boundary_para._boundary_str);
+                GetCaseStringByLabel(tmp_str, "boundary=", "", _boundary_para._boundary_str);
             }
         }
-    }         
+    }
 }
 
 void http_res_process::recv_finish()
@@ -159,33 +234,142 @@ void http_res_process::recv_finish()
         PDEBUG("http_res_process waiting async response");
         return;
     }
-    notify_send_ready();
+    // 流水线批处理中: 响应由 process_recv_buf 统一取出, 不在这里逐个触发发送
+    change_http_status(SEND_HEAD, !_in_recv_batch);
 }
 
 void http_res_process::send_finish()
 {
     // Check Connection header before reset() clears it
-    bool should_close = false;
-    std::string* conn_hdr = _res_head_para.get_header("Connection");
-    if (conn_hdr && strcasecmp(conn_hdr->c_str(), "close") == 0) {
+    bool should_close = !_keep_alive;
+    std::string_view conn_hdr = _res_head_para.header_view(myframe::HDR_CONNECTION);
+    if (conn_hdr.size() == 5 && strncasecmp(conn_hdr.data(), "close", 5) == 0) {
         should_close = true;
     }
 
     reset();
 
     if (should_close) {
+        _keep_alive = false;
         request_close_now();
+        return;
+    }
+
+    arm_idle_timer(keepalive_timeout_ms());
+    // 异步响应发完后, 接收缓冲里可能已经有后续请求
+    if (!_in_recv_batch) {
+        if (auto sp = _p_connect.lock())
+            sp->resume_recv();
+    }
+}
+
+size_t http_res_process::process_recv_buf(const char *buf, size_t len)
+{
+    // 上一个响应还没发完(异步响应或发送中)、流式 body 暂停或连接将要关闭时, 数据先留在接收缓冲
+    http_base_data_process * data_process = get_process();
+    if (_http_status > RECV_BODY || _closing || _body_paused || (data_process && data_process->async_response_pending()))
+    {
+        // 水平触发下接收缓冲满了 EPOLLIN 会一直触发, 和 body 暂停一样先去掉, send_finish 里恢复
+        if (!_closing && !_body_paused)
+        {
+            if (auto sp = _p_connect.lock())
+                sp->pause_recv();
+        }
+        return 0;
+    }
+
+    size_t total = 0;
+    _in_recv_batch = true;
+    try
+    {
+        while (total < len)
+        {
+            size_t ret = http_base_process::process_recv_buf(buf + total, len - total);
+            total += ret;
+            if (_http_status <= RECV_BODY || (data_process && data_process->async_response_pending()))
+                break;
+
+            flush_response();
+            // 响应没取完(业务分段产生), 或本次响应后关闭连接
+            if (_http_status != RECV_HEAD || !_keep_alive || _closing)
+                break;
+        }
+    }
+    catch (...)
+    {
+        _in_recv_batch = false;
+        throw;
+    }
+    _in_recv_batch = false;
+
+    if (!_send_list.empty())
+    {
+        if (auto sp = _p_connect.lock())
+            sp->notice_send();
+    }
+    return total;
+}
+
+void http_res_process::flush_response()
+{
+    while (_http_status == SEND_HEAD || _http_status == SEND_BODY)
+    {
+        myframe::send_slice slice;
+        if (next_send_slice(slice))
+            _send_list.push_back(std::move(slice));
+        else if (_http_status == SEND_HEAD || _http_status == SEND_BODY)
+            break;
+        // 拉取式响应体留给连接在可写时取
+        if (_http_status == SEND_BODY && _data_process->streaming_response())
+            break;
     }
 }
 
+void http_res_process::arm_idle_timer(uint32_t delay_ms)
+{
+    if (_idle_timer_id || !delay_ms)
+        return;
+    auto sp = _p_connect.lock();
+    if (!sp)
+        return;
+    std::shared_ptr<timer_msg> t_msg(new timer_msg);
+    t_msg->_obj_id = sp->get_id()._id;
+    t_msg->_timer_type = HTTP_KEEPALIVE_TIMER_TYPE;
+    t_msg->_time_length = delay_ms;
+    add_timer(t_msg);
+    _idle_timer_id = t_msg->_timer_id;
+}
+
+void http_res_process::handle_timeout(std::shared_ptr<timer_msg> & t_msg)
+{
+    if (t_msg->_timer_type != HTTP_KEEPALIVE_TIMER_TYPE)
+    {
+        http_base_process::handle_timeout(t_msg);
+        return;
+    }
+    if (t_msg->_timer_id != _idle_timer_id)
+        return;
+    _idle_timer_id = 0;
+
+    // 请求处理中(含异步响应)不算空闲, 发完响应会重新计时
+    auto sp = _p_connect.lock();
+    if (!sp || _closing || _http_status != RECV_HEAD)
+        return;
+    uint32_t timeout = keepalive_timeout_ms();
+    uint64_t idle = GetMilliSecond() - sp->last_active_ms();
+    if (!timeout || idle >= timeout)
+        close_now();
+    arm_idle_timer(timeout - (uint32_t)idle);
+}
+
 
 size_t http_res_process::get_boundary(const char *buf, size_t len, int &result)
 {	
     uint64_t content_length = 0;
-    std::string *tmp_str = _req_head_para.get_header("Content-Length");
-    if (tmp_str) 
+    std::string_view tmp_str = _req_head_para.header_view(myframe::HDR_CONTENT_LENGTH);
+    if (!tmp_str.empty())
     {
-        content_length = strtoull(tmp_str->c_str(), 0, 10);
+        content_length = strtoull(std::string(tmp_str).c_str(), 0, 10);
     }
 
     if (!content_length)
@@ -18,18 +18,34 @@ class http_res_process:public http_base_process
 
 		virtual void reset();     
 
+        // 一次读到的多个流水线请求在这里逐个处理, 响应按顺序攒进发送队列后统一发出
+        virtual size_t process_recv_buf(const char *buf, size_t len);
+
+        // 流式请求体暂停期间不读
+        virtual bool want_recv() const { return !_body_paused; }
+
+        virtual void handle_timeout(std::shared_ptr<timer_msg> & t_msg);
+
+        // 长连接空闲超时: MYFRAME_HTTP_KEEPALIVE_MS(默认 60000, 0 关闭长连接, 上限 3600000)
+        static uint32_t keepalive_timeout_ms();
+        // 每个连接最多处理的请求数: MYFRAME_HTTP_KEEPALIVE_MAX(默认 1000, 0 不限)
+        static uint32_t keepalive_max_requests();
+        // 覆盖环境变量, 需在服务启动前调用
+        static void set_keepalive(uint32_t timeout_ms, uint32_t max_requests);
+
     protected:
 		virtual size_t process_recv_body(const char *buf, size_t len, int &result);
         
-        virtual void parse_first_line(const std::string & line);
-
-        virtual void parse_header(std::string & recv_head);
+        virtual void parse_header(const myframe::http_head_parser & head);
 
         virtual void recv_finish();
 
         virtual void send_finish();
 
 		size_t get_boundary(const char *buf, size_t len, int &result);
+
+        void flush_response();
+        void arm_idle_timer(uint32_t delay_ms);
       
     protected:
 		enum BOUNDARY_STATUS
@@ -42,6 +58,11 @@ class http_res_process:public http_base_process
 		boundary_para _boundary_para;		
 		BOUNDARY_STATUS _recv_boundary_status;
 		uint32_t _recv_body_length;
+
+        bool _recv_chunked;
+        uint32_t _requests;
+        uint32_t _idle_timer_id;
+        bool _in_recv_batch;
 };
 
 
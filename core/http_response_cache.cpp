@@ -0,0 +1,615 @@
+#include "http_response_cache.h"
+#include "http_base_process.h"
+#include "http_base_data_process.h"
+#include "http_compress.h"
+#include "http_response_head.h"
+#include "base_net_thread.h"
+#include "common_util.h"
+#include "string_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace myframe {
+
+namespace {
+
+const long MAX_CACHE_BYTES = 1L << 30;
+const size_t MAX_VARIANTS = 8;
+// 刷新请求没有结果(如连接已关)时多久后允许别的请求再刷新
+const uint64_t REFRESH_TIMEOUT_MS = 1000;
+// 每条缓存除数据外的大致开销
+const size_t ENTRY_OVERHEAD = 128;
+
+long env_long(const char * name, long def, long max)
+{
+    long v = def;
+    const char * e = ::getenv(name);
+    if (e && *e)
+        v = atol(e);
+    if (v < 0) v = 0;
+    if (v > max) v = max;
+    return v;
+}
+
+struct cache_conf
+{
+    std::atomic<size_t> local_bytes;
+    std::atomic<size_t> shared_bytes;
+
+    cache_conf()
+        : local_bytes((size_t)env_long("MYFRAME_HTTP_CACHE_BYTES", 32L << 20, MAX_CACHE_BYTES)),
+          shared_bytes((size_t)env_long("MYFRAME_HTTP_CACHE_SHARED_BYTES", 0, MAX_CACHE_BYTES))
+    {
+    }
+};
+
+cache_conf & conf()
+{
+    static cache_conf c;
+    return c;
+}
+
+// 各线程的缓存, 汇总统计用; 线程退出时计数并入 retired
+struct cache_registry
+{
+    std::mutex mutex;
+    std::vector<http_response_cache *> locals;
+    http_cache_stats retired;
+
+    cache_registry() : retired() {}
+};
+
+cache_registry & registry()
+{
+    static cache_registry r;
+    return r;
+}
+
+size_t entry_bytes(const http_cached_ptr & e)
+{
+    return e->tail->size() + ENTRY_OVERHEAD;
+}
+
+bool same_variant(const http_cached_response & a, const http_cached_response & b)
+{
+    return a.vary == b.vary && a.vary_values == b.vary_values;
+}
+
+bool name_is(const std::string & name, const char * want, size_t len)
+{
+    return name.size() == len && strncasecmp(name.data(), want, len) == 0;
+}
+
+struct refresh_msg : public normal_msg
+{
+    refresh_msg() : normal_msg(HTTP_CACHE_REFRESH_MSG_OP), id(0), tier(NULL) {}
+
+    std::string key;
+    uint64_t id;
+    http_response_cache * tier;
+    HttpRequest req;
+    std::string accept_encoding;
+};
+
+void put_both(const std::string & key, const http_cached_ptr & entry)
+{
+    http_response_cache::local().put(key, entry);
+    http_response_cache & shared = http_response_cache::shared();
+    if (shared.enabled())
+        shared.put(key, entry);
+}
+
+} // namespace
+
+namespace detail {
+
+bool cache_vary_names(std::string_view vary, std::vector<std::string> & names)
+{
+    size_t pos = 0;
+    while (pos < vary.size())
+    {
+        size_t comma = vary.find(',', pos);
+        if (comma == std::string_view::npos)
+            comma = vary.size();
+        size_t b = pos, e = comma;
+        while (b < e && (vary[b] == ' ' || vary[b] == '\t')) b++;
+        while (e > b && (vary[e - 1] == ' ' || vary[e - 1] == '\t')) e--;
+        if (e - b == 1 && vary[b] == '*')
+            return false;
+        if (e > b)
+            names.emplace_back(vary.data() + b, e - b);
+        pos = comma + 1;
+    }
+    return true;
+}
+
+bool cache_allowed(const HttpResponse & res)
+{
+    if (!res.cache_ttl_ms || res.stream || res.status < 200)
+        return false;
+    for (auto it = res.headers.begin(); it != res.headers.end(); ++it)
+    {
+        if (name_is(it->first, "Set-Cookie", 10) || name_is(it->first, "Connection", 10)
+            || name_is(it->first, "Transfer-Encoding", 17))
+            return false;
+    }
+    return true;
+}
+
+http_cached_ptr cache_serialize(const HttpResponse & res, std::vector<std::string> && vary,
+        std::vector<std::string> && values, uint64_t now)
+{
+    std::string_view body = res.body_view();
+    char cl[24];
+    size_t cl_len = 0;
+    if (res.headers.find("Content-Length") == res.headers.end())
+        cl_len = (size_t)snprintf(cl, sizeof(cl), "%zu", body.size());
+
+    size_t total = 2 + body.size();
+    if (cl_len)
+        total += 16 + cl_len + 2;
+    for (auto it = res.headers.begin(); it != res.headers.end(); ++it)
+        total += it->first.size() + 2 + it->second.size() + 2;
+
+    std::string tail;
+    tail.reserve(total);
+    if (cl_len)
+    {
+        tail.append("Content-Length: ", 16);
+        tail.append(cl, cl_len);
+        tail.append("\r\n", 2);
+    }
+    for (auto it = res.headers.begin(); it != res.headers.end(); ++it)
+    {
+        // Date 每次命中重新给
+        if (name_is(it->first, "Date", 4))
+            continue;
+        tail.append(it->first);
+        tail.append(": ", 2);
+        tail.append(it->second);
+        tail.append("\r\n", 2);
+    }
+    tail.append("\r\n", 2);
+    tail.append(body.data(), body.size());
+
+    std::shared_ptr<http_cached_response> e = std::make_shared<http_cached_response>();
+    e->status = res.status;
+    e->reason = res.reason;
+    e->tail = make_shared_buffer(std::move(tail));
+    e->vary = std::move(vary);
+    e->vary_values = std::move(values);
+    e->fresh_until = now + res.cache_ttl_ms;
+    e->stale_until = e->fresh_until + res.cache_stale_ms;
+    return e;
+}
+
+} // namespace detail
+
+void http_cache_key(std::string_view method, std::string_view host, std::string_view url, std::string & key)
+{
+    key.clear();
+    key.reserve(method.size() + host.size() + 2 + url.size());
+    key.append(method.data(), method.size());
+    key.push_back(' ');
+    key.append(host.data(), host.size());
+    key.push_back(' ');
+    key.append(url.data(), url.size());
+}
+
+http_cache_stats http_response_cache_stats()
+{
+    http_cache_stats s;
+    cache_registry & r = registry();
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        s = r.retired;
+        for (size_t i = 0; i < r.locals.size(); i++)
+        {
+            http_response_cache & c = *r.locals[i];
+            s.hits += c.hits;
+            s.stale_hits += c.stale_hits;
+            s.misses += c.misses;
+            s.coalesced += c.coalesced;
+            s.stores += c.stores;
+            s.evictions += c.evictions;
+            s.bytes += c.bytes();
+        }
+    }
+    http_response_cache & shared = http_response_cache::shared();
+    s.stores += shared.stores;
+    s.evictions += shared.evictions;
+    s.bytes += shared.bytes();
+    return s;
+}
+
+void http_response_cache_set(size_t local_bytes, size_t shared_bytes)
+{
+    if (local_bytes > (size_t)MAX_CACHE_BYTES) local_bytes = (size_t)MAX_CACHE_BYTES;
+    if (shared_bytes > (size_t)MAX_CACHE_BYTES) shared_bytes = (size_t)MAX_CACHE_BYTES;
+    conf().local_bytes = local_bytes;
+    conf().shared_bytes = shared_bytes;
+    if (!shared_bytes)
+        http_response_cache::shared().clear();
+}
+
+// ---------------------------------------------------------------------------
+
+http_response_cache & http_response_cache::local()
+{
+    thread_local http_response_cache cache(false);
+    return cache;
+}
+
+http_response_cache & http_response_cache::shared()
+{
+    static http_response_cache cache(true);
+    return cache;
+}
+
+http_response_cache::http_response_cache(bool shared)
+    : hits(0), stale_hits(0), misses(0), coalesced(0), stores(0), evictions(0),
+      _shared(shared), _bytes(0), _next_id(0)
+{
+    if (_shared)
+        return;
+    cache_registry & r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.locals.push_back(this);
+}
+
+http_response_cache::~http_response_cache()
+{
+    if (_shared)
+        return;
+    cache_registry & r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.retired.hits += hits;
+    r.retired.stale_hits += stale_hits;
+    r.retired.misses += misses;
+    r.retired.coalesced += coalesced;
+    r.retired.stores += stores;
+    r.retired.evictions += evictions;
+    for (size_t i = 0; i < r.locals.size(); i++)
+    {
+        if (r.locals[i] == this)
+        {
+            r.locals.erase(r.locals.begin() + i);
+            break;
+        }
+    }
+}
+
+size_t http_response_cache::capacity() const
+{
+    size_t local_bytes = conf().local_bytes;
+    if (!_shared)
+        return local_bytes;
+    return local_bytes ? (size_t)conf().shared_bytes : 0;
+}
+
+bool http_response_cache::enabled() const
+{
+    return capacity() != 0;
+}
+
+void http_response_cache::put(const std::string & key, const http_cached_ptr & entry)
+{
+    size_t cap = capacity();
+    if (!entry || entry_bytes(entry) + key.size() > cap)
+        return;
+    size_t add = entry_bytes(entry);
+
+    tier_lock lock(*this);
+    auto it = _index.find(key);
+    if (it == _index.end())
+    {
+        _lru.push_front(slot());
+        slot & s = _lru.front();
+        s.key = key;
+        s.bytes = key.size();
+        _bytes += s.bytes;
+        it = _index.emplace(key, _lru.begin()).first;
+    }
+    else
+    {
+        _lru.splice(_lru.begin(), _lru, it->second);
+    }
+
+    slot & s = *it->second;
+    for (size_t i = 0; i < s.variants.size(); i++)
+    {
+        // 同一版本(含从共享层拿来的同一条)替换掉
+        if (s.variants[i] == entry || same_variant(*s.variants[i], *entry))
+        {
+            size_t old = entry_bytes(s.variants[i]);
+            s.bytes -= old;
+            _bytes -= old;
+            s.variants.erase(s.variants.begin() + i);
+            break;
+        }
+    }
+    if (s.variants.size() >= MAX_VARIANTS)
+    {
+        size_t old = entry_bytes(s.variants.front());
+        s.bytes -= old;
+        _bytes -= old;
+        s.variants.erase(s.variants.begin());
+        evictions++;
+    }
+    s.variants.push_back(entry);
+    s.bytes += add;
+    _bytes += add;
+    stores++;
+    evict(cap);
+}
+
+void http_response_cache::evict(size_t cap)
+{
+    // 刚放进去的在最前面, 单条不超过容量, 不会被挤掉
+    while (_bytes > cap && !_lru.empty())
+    {
+        slot & s = _lru.back();
+        _bytes -= s.bytes;
+        evictions += s.variants.size();
+        _index.erase(s.key);
+        _lru.pop_back();
+    }
+}
+
+void http_response_cache::clear()
+{
+    tier_lock lock(*this);
+    _index.clear();
+    _lru.clear();
+    _bytes = 0;
+}
+
+uint64_t http_response_cache::begin_fill(const std::string & key, const ObjId * waiter, bool refresh, uint64_t now)
+{
+    tier_lock lock(*this);
+    auto it = _flights.find(key);
+    if (it == _flights.end())
+    {
+        flight & f = _flights[key];
+        f.id = ++_next_id;
+        f.start = now;
+        f.refresh = refresh;
+        return f.id;
+    }
+
+    flight & f = it->second;
+    if (f.refresh && (!refresh || now - f.start >= REFRESH_TIMEOUT_MS))
+    {
+        // 刷新的结果在另一轮事件循环里才出来, 可能随连接关闭丢掉; 未命中的请求不等它
+        f.id = ++_next_id;
+        f.start = now;
+        f.refresh = refresh;
+        return f.id;
+    }
+    if (!refresh && !f.refresh && waiter)
+        f.waiters.push_back(*waiter);
+    return 0;
+}
+
+void http_response_cache::end_fill(const std::string & key, uint64_t id)
+{
+    std::vector<ObjId> waiters;
+    {
+        tier_lock lock(*this);
+        auto it = _flights.find(key);
+        if (it == _flights.end() || it->second.id != id)
+            return;
+        waiters.swap(it->second.waiters);
+        _flights.erase(it);
+    }
+    for (size_t i = 0; i < waiters.size(); i++)
+    {
+        std::shared_ptr<normal_msg> msg(new normal_msg(HTTP_CACHE_FILL_MSG_OP));
+        base_net_thread::put_obj_msg(waiters[i], msg);
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+int http_cache_session::lookup(http_base_process * process, http_base_data_process * data, bool wait)
+{
+    abandon();
+    _key.clear();
+    _head.reset();
+    _body.reset();
+    _refresh_id = 0;
+
+    http_response_cache & local = http_response_cache::local();
+    if (!local.enabled())
+        return PASS;
+    http_req_head_para & rh = process->get_req_head_para();
+    if (rh._method != "GET" || process->has_request_body())
+        return PASS;
+
+    local.misses++;
+    http_response_cache & shared = http_response_cache::shared();
+    bool use_shared = shared.enabled();
+    // 什么都没存过时不用组键
+    if (!local.bytes() && !use_shared)
+        return PASS;
+
+    http_cache_key(rh._method, rh.header_view(HDR_HOST), rh._url_path, _key);
+    auto get = [&rh](std::string_view name) { return rh.header_view(name); };
+    uint64_t now = GetMilliSecond();
+    http_cached_ptr entry;
+    int state = local.find(_key, get, now, entry);
+    if (state == http_response_cache::MISS && use_shared)
+    {
+        http_cached_ptr hint = std::move(entry);
+        state = shared.find(_key, get, now, entry);
+        if (state != http_response_cache::MISS)
+            local.put(_key, entry);
+        else if (!entry)
+            entry = std::move(hint);
+    }
+
+    http_response_cache & tier = use_shared ? shared : local;
+    if (state != http_response_cache::MISS)
+    {
+        local.misses--;
+        if (state == http_response_cache::FRESH)
+        {
+            local.hits++;
+        }
+        else
+        {
+            local.stale_hits++;
+            _refresh_id = tier.begin_fill(_key, NULL, true, now);
+            if (_refresh_id)
+                _fill_tier = &tier;
+        }
+        serve(process, entry);
+        return SERVED;
+    }
+
+    // 已知可缓存的键才排队, 从没缓存过的照常各自处理
+    if (!wait || !use_shared || !entry)
+        return PASS;
+    std::shared_ptr<base_net_obj> conn = data->get_base_net();
+    if (!conn)
+        return PASS;
+    ObjId self = conn->get_id();
+    _fill_id = shared.begin_fill(_key, &self, false, now);
+    if (_fill_id)
+    {
+        _fill_tier = &shared;
+        return PASS;
+    }
+    local.misses--;
+    local.coalesced++;
+    data->set_async_response_pending(true);
+    return PARKED;
+}
+
+void http_cache_session::refresh(http_base_data_process * data, HttpRequest && req, std::string_view accept_encoding)
+{
+    if (!_refresh_id)
+        return;
+    std::shared_ptr<refresh_msg> msg = std::make_shared<refresh_msg>();
+    msg->key = _key;
+    msg->id = _refresh_id;
+    msg->tier = _fill_tier;
+    msg->req = std::move(req);
+    msg->accept_encoding.assign(accept_encoding.data(), accept_encoding.size());
+    _refresh_id = 0;
+
+    std::shared_ptr<base_net_obj> conn = data->get_base_net();
+    if (!conn)
+    {
+        msg->tier->end_fill(msg->key, msg->id);
+        return;
+    }
+    // 发给自己, 旧响应先发出去, 下一轮事件循环再调 on_http
+    ObjId self = conn->get_id();
+    std::shared_ptr<normal_msg> p = msg;
+    base_net_thread::put_obj_msg(self, p);
+}
+
+bool http_cache_session::store(http_base_process * process, HttpResponse & res)
+{
+    bool stored = false;
+    http_response_cache & local = http_response_cache::local();
+    if (res.cache_ttl_ms && local.enabled())
+    {
+        http_req_head_para & rh = process->get_req_head_para();
+        if (rh._method == "GET" && !process->has_request_body())
+        {
+            if (_key.empty())
+                http_cache_key(rh._method, rh.header_view(HDR_HOST), rh._url_path, _key);
+            http_cached_ptr entry = http_cache_make_entry(res,
+                    [&rh](std::string_view name) { return rh.header_view(name); }, GetMilliSecond());
+            if (entry)
+            {
+                put_both(_key, entry);
+                serve(process, entry);
+                stored = true;
+            }
+        }
+    }
+    abandon();
+    return stored;
+}
+
+void http_cache_session::abandon()
+{
+    if (_fill_id && _fill_tier)
+        _fill_tier->end_fill(_key, _fill_id);
+    _fill_id = 0;
+}
+
+void http_cache_session::serve(http_base_process * process, const http_cached_ptr & entry)
+{
+    std::string scratch;
+    std::string_view line = http_status_line(entry->status, entry->reason, scratch);
+    std::string_view date = http_date_header();
+    std::string_view conn = process->keep_alive() ? std::string_view("Connection: keep-alive\r\n", 24)
+                                                  : std::string_view("Connection: close\r\n", 19);
+
+    std::string * head = string_acquire();
+    head->reserve(line.size() + date.size() + conn.size());
+    head->append(line.data(), line.size());
+    head->append(date.data(), date.size());
+    head->append(conn.data(), conn.size());
+    _head = make_pooled_string(head);
+    _body = entry->tail;
+}
+
+std::string * http_cache_session::take_head()
+{
+    return _head.release();
+}
+
+bool http_cache_session::take_body(shared_buffer & buf)
+{
+    if (!_body)
+        return false;
+    buf = std::move(_body);
+    _body.reset();
+    return true;
+}
+
+bool http_cache_session::handle_refresh(std::shared_ptr<normal_msg> & msg, IApplicationHandler * handler,
+        base_data_process * data)
+{
+    if (!msg || msg->_msg_op != HTTP_CACHE_REFRESH_MSG_OP)
+        return false;
+    std::shared_ptr<refresh_msg> m = std::dynamic_pointer_cast<refresh_msg>(msg);
+    if (!m)
+        return true;
+
+    HttpResponse res;
+    bool ok = handler != NULL;
+    if (ok)
+    {
+        try
+        {
+            detail::HandlerContextScope scope(data);
+            handler->on_http(m->req, res);
+        }
+        catch (const std::exception & e)
+        {
+            PDEBUG("cache refresh %s failed: %s", m->key.c_str(), e.what());
+            ok = false;
+        }
+    }
+    if (ok)
+    {
+        http_compress_response(m->accept_encoding, res);
+        const std::map<std::string, std::string> & headers = m->req.headers;
+        http_cached_ptr entry = http_cache_make_entry(res,
+                [&headers](std::string_view name) { return http_header_view(NULL, true, headers, name); },
+                GetMilliSecond());
+        if (entry)
+            put_both(m->key, entry);
+    }
+    m->tier->end_fill(m->key, m->id);
+    return true;
+}
+
+} // namespace myframe
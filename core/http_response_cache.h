@@ -0,0 +1,269 @@
+#ifndef __HTTP_RESPONSE_CACHE_H__
+#define __HTTP_RESPONSE_CACHE_H__
+
+#include "app_handler_v2.h"
+#include "send_slice.h"
+
+#include <stdint.h>
+#include <strings.h>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class http_base_process;
+class http_base_data_process;
+
+namespace myframe {
+
+// HTTP/1 响应缓存(可选), 挡在 Level 1 的 on_http 前面
+// - 业务在 on_http 里调 res.set_cache(ttl_ms, stale_ms) 的响应才缓存; 只查/存不带 body 的 GET,
+//   流式响应、1xx、带 Set-Cookie / Connection 或 Vary: * 的不缓存
+// - 键: 方法 + Host + URL; 同一键下按响应 Vary 列出的请求头取值区分版本(压缩过的响应带 Vary: Accept-Encoding)
+// - 存序列化好的响应(Date/Connection 以外的头 + 空行 + body), 命中时以 shared_buffer 挂到发送队列, 不复制
+// - 过期后 stale_ms 内先返回旧响应, 同一连接在下一轮事件循环里再调 on_http 刷新(stale-while-revalidate)
+// - 每个工作线程一份, 不加锁; 打开共享层后本线程没有的再查进程内共享的一份, 存入时两层都放
+// - 共享层打开时, 已知可缓存的键过期后几个线程同时未命中只调一次 on_http,
+//   其余请求挂起(异步响应), 结果存入后被唤醒直接取(singleflight)
+// - 容量: MYFRAME_HTTP_CACHE_BYTES(每线程, 默认 32MB, 0 关闭整个缓存),
+//   MYFRAME_HTTP_CACHE_SHARED_BYTES(默认 0 不开共享层), 上限都是 1GB
+// - HTTP/2 和 Level 2 不经过这里
+
+// 挂起的请求被唤醒 / 刷新过期响应的消息编号('H''C''F''1' / 'H''C''R''1')
+constexpr int HTTP_CACHE_FILL_MSG_OP = 0x48434631;
+constexpr int HTTP_CACHE_REFRESH_MSG_OP = 0x48435231;
+
+// 命中统计: 所有工作线程(含已退出的)和共享层相加
+struct http_cache_stats
+{
+    uint64_t hits;          // 新鲜命中
+    uint64_t stale_hits;    // 过期但在 stale 窗口内, 返回了旧响应
+    uint64_t misses;        // 调了 on_http 的可缓存请求(GET)
+    uint64_t coalesced;     // 挂起等别的线程结果的请求
+    uint64_t stores;
+    uint64_t evictions;
+    uint64_t bytes;         // 当前占用
+};
+
+http_cache_stats http_response_cache_stats();
+
+// 覆盖环境变量: local_bytes 0 关闭整个缓存; shared_bytes 0 关闭共享层
+void http_response_cache_set(size_t local_bytes, size_t shared_bytes);
+
+// 缓存的一条响应, 生成后不再修改, 两层之间共用同一份
+struct http_cached_response
+{
+    int status;
+    std::string reason;
+    shared_buffer tail;                      // Date/Connection 以外的头 + 空行 + body
+    std::vector<std::string> vary;           // 响应 Vary 列出的请求头
+    std::vector<std::string> vary_values;    // 存入时请求里这些头的值
+    uint64_t fresh_until;                    // GetMilliSecond() 毫秒
+    uint64_t stale_until;
+};
+
+typedef std::shared_ptr<const http_cached_response> http_cached_ptr;
+
+// 业务要求缓存且能缓存时, 把 res 序列化成一条缓存; get(name) 取请求头的值(算 Vary)
+template <typename GetHeader>
+http_cached_ptr http_cache_make_entry(const HttpResponse & res, GetHeader get, uint64_t now);
+
+// 方法 + Host + URL 组成的键(Host 带端口, 同一进程里的几个 server 不会串)
+void http_cache_key(std::string_view method, std::string_view host, std::string_view url, std::string & key);
+
+class http_response_cache
+{
+    public:
+        enum { MISS = 0, FRESH = 1, STALE = 2 };
+
+        static http_response_cache & local();    // 当前线程
+        static http_response_cache & shared();   // 进程内共享层
+
+        ~http_response_cache();
+
+        bool enabled() const;
+
+        // get(name) 取请求头的值
+        // 超出 stale 窗口的条目留到被淘汰, 作为"已知可缓存"的标记: 返回 MISS, out 仍指向它
+        template <typename GetHeader>
+        int find(const std::string & key, GetHeader get, uint64_t now, http_cached_ptr & out);
+
+        void put(const std::string & key, const http_cached_ptr & entry);
+
+        // singleflight, 在共享层(关闭时在本线程)登记谁在取这个键
+        // - 没人在取: 登记为取数方, 返回编号(> 0)
+        // - refresh 为 false 且正有人为未命中在取: waiter 登记为等待方, 返回 0
+        // - 正在刷新(旧响应还能用)时: 刷新超过 1 秒没结果或这次是未命中, 接过来返回新编号; 否则返回 0
+        uint64_t begin_fill(const std::string & key, const ObjId * waiter, bool refresh, uint64_t now);
+
+        // 取数结束(存没存都要调), 给等待方发 HTTP_CACHE_FILL_MSG_OP
+        void end_fill(const std::string & key, uint64_t id);
+
+        void clear();
+
+        size_t bytes() const { return _bytes; }
+
+        // 计数, 工作线程里单写, 汇总时读
+        std::atomic<uint64_t> hits;
+        std::atomic<uint64_t> stale_hits;
+        std::atomic<uint64_t> misses;
+        std::atomic<uint64_t> coalesced;
+        std::atomic<uint64_t> stores;
+        std::atomic<uint64_t> evictions;
+
+    private:
+        explicit http_response_cache(bool shared);
+
+        struct slot
+        {
+            std::string key;
+            std::vector<http_cached_ptr> variants;
+            size_t bytes;
+        };
+
+        struct flight
+        {
+            uint64_t id;
+            uint64_t start;
+            bool refresh;
+            std::vector<ObjId> waiters;
+        };
+
+        // 共享层才真正加锁
+        struct tier_lock
+        {
+            explicit tier_lock(http_response_cache & c) : m(c._shared ? &c._mutex : NULL) { if (m) m->lock(); }
+            ~tier_lock() { if (m) m->unlock(); }
+            std::mutex * m;
+        };
+
+        size_t capacity() const;
+        void evict(size_t cap);
+
+        bool _shared;
+        std::mutex _mutex;
+        std::list<slot> _lru;          // 前面是最近用过的
+        std::unordered_map<std::string, std::list<slot>::iterator> _index;
+        std::unordered_map<std::string, flight> _flights;
+        std::atomic<size_t> _bytes;
+        uint64_t _next_id;
+};
+
+// 一个连接上的缓存处理状态, 由 Level 1 的 HTTP/1 数据处理层持有
+// msg_recv_finish: lookup() 命中就不调 on_http; 否则调完(压缩后)交给 store(), 异常时 abandon()
+// get_send_head / get_send_body_shared: 先问 take_head() / take_body()
+class http_cache_session
+{
+    public:
+        enum { PASS = 0, SERVED = 1, PARKED = 2 };
+
+        http_cache_session() : _fill_id(0), _refresh_id(0), _fill_tier(NULL) {}
+        ~http_cache_session() { abandon(); }
+
+        // SERVED: 响应已备好; PARKED: 已挂起等别的线程的结果; PASS: 照常调 on_http
+        // wait 为 false 时不挂起也不登记 singleflight(被唤醒后再查一次用)
+        int lookup(http_base_process * process, http_base_data_process * data, bool wait = true);
+
+        // 过期命中时登记到了刷新, 调用方组好请求交给 refresh(), 下一轮事件循环里调 on_http
+        bool need_refresh() const { return _refresh_id != 0; }
+        void refresh(http_base_data_process * data, HttpRequest && req, std::string_view accept_encoding);
+
+        // on_http 之后(已压缩)调; 业务要求缓存时存入并备好从缓存发出, 返回 true(res 不再使用)
+        bool store(http_base_process * process, HttpResponse & res);
+
+        // 异常等没走到 store 时结束 singleflight
+        void abandon();
+
+        std::string * take_head();
+        bool take_body(shared_buffer & buf);
+
+        // 处理刷新消息: 调 on_http, 能缓存就存入; 不是刷新消息返回 false
+        static bool handle_refresh(std::shared_ptr<normal_msg> & msg, IApplicationHandler * handler,
+                base_data_process * data);
+
+    private:
+        void serve(http_base_process * process, const http_cached_ptr & entry);
+
+        std::string _key;
+        uint64_t _fill_id;
+        uint64_t _refresh_id;
+        http_response_cache * _fill_tier;
+        pooled_string_ptr _head;
+        shared_buffer _body;
+};
+
+// ---------------------------------------------------------------------------
+
+namespace detail {
+
+// 把 Vary 的取值拆成头名追加到 names; 出现 * 时返回 false(不可缓存)
+bool cache_vary_names(std::string_view vary, std::vector<std::string> & names);
+
+http_cached_ptr cache_serialize(const HttpResponse & res, std::vector<std::string> && vary,
+        std::vector<std::string> && values, uint64_t now);
+
+bool cache_allowed(const HttpResponse & res);
+
+} // namespace detail
+
+template <typename GetHeader>
+http_cached_ptr http_cache_make_entry(const HttpResponse & res, GetHeader get, uint64_t now)
+{
+    if (!detail::cache_allowed(res))
+        return http_cached_ptr();
+
+    std::vector<std::string> vary, values;
+    for (auto it = res.headers.begin(); it != res.headers.end(); ++it)
+    {
+        if (it->first.size() == 4 && strncasecmp(it->first.data(), "Vary", 4) == 0
+            && !detail::cache_vary_names(it->second, vary))
+            return http_cached_ptr();
+    }
+    values.reserve(vary.size());
+    for (size_t i = 0; i < vary.size(); i++)
+    {
+        std::string_view v = get(std::string_view(vary[i]));
+        values.emplace_back(v.data(), v.size());
+    }
+    return detail::cache_serialize(res, std::move(vary), std::move(values), now);
+}
+
+template <typename GetHeader>
+int http_response_cache::find(const std::string & key, GetHeader get, uint64_t now, http_cached_ptr & out)
+{
+    out.reset();
+    tier_lock lock(*this);
+    auto it = _index.find(key);
+    if (it == _index.end())
+        return MISS;
+
+    std::vector<http_cached_ptr> & variants = it->second->variants;
+    for (size_t i = 0; i < variants.size(); i++)
+    {
+        const http_cached_response & e = *variants[i];
+        size_t j = 0;
+        for (; j < e.vary.size(); j++)
+        {
+            if (get(std::string_view(e.vary[j])) != std::string_view(e.vary_values[j]))
+                break;
+        }
+        if (j < e.vary.size())
+            continue;
+        _lru.splice(_lru.begin(), _lru, it->second);
+        out = variants[i];
+        if (now < e.fresh_until)
+            return FRESH;
+        return now < e.stale_until ? STALE : MISS;
+    }
+    // 键已知可缓存, 只是没有这个版本
+    out = variants.front();
+    return MISS;
+}
+
+} // namespace myframe
+
+#endif
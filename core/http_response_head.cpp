@@ -0,0 +1,157 @@
+#include "http_response_head.h"
+#include "common_util.h"
+#include "string_pool.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+namespace myframe {
+
+namespace {
+
+const int STATUS_MIN = 100;
+const int STATUS_MAX = 599;
+
+struct reason_entry
+{
+    int status;
+    const char * reason;
+};
+
+const reason_entry REASONS[] =
+{
+    {100, "Continue"}, {101, "Switching Protocols"},
+    {200, "OK"}, {201, "Created"}, {202, "Accepted"}, {204, "No Content"}, {206, "Partial Content"},
+    {301, "Moved Permanently"}, {302, "Found"}, {303, "See Other"}, {304, "Not Modified"},
+    {307, "Temporary Redirect"}, {308, "Permanent Redirect"},
+    {400, "Bad Request"}, {401, "Unauthorized"}, {403, "Forbidden"}, {404, "Not Found"},
+    {405, "Method Not Allowed"}, {408, "Request Timeout"}, {409, "Conflict"}, {411, "Length Required"},
+    {413, "Content Too Large"}, {414, "URI Too Long"}, {415, "Unsupported Media Type"},
+    {429, "Too Many Requests"},
+    {500, "Internal Server Error"}, {501, "Not Implemented"}, {502, "Bad Gateway"},
+    {503, "Service Unavailable"}, {504, "Gateway Timeout"},
+};
+
+// 下标为 status - STATUS_MIN, 没有标准短语的状态码为空
+struct status_table
+{
+    std::string_view reasons[STATUS_MAX - STATUS_MIN + 1];
+    std::string lines[STATUS_MAX - STATUS_MIN + 1];
+
+    status_table()
+    {
+        for (size_t i = 0; i < sizeof(REASONS) / sizeof(REASONS[0]); ++i)
+        {
+            int idx = REASONS[i].status - STATUS_MIN;
+            reasons[idx] = REASONS[i].reason;
+            char buf[64];
+            int n = snprintf(buf, sizeof(buf), "HTTP/1.1 %d %s\r\n", REASONS[i].status, REASONS[i].reason);
+            lines[idx].assign(buf, (size_t)n);
+        }
+    }
+};
+
+const status_table & table()
+{
+    static const status_table t;
+    return t;
+}
+
+const std::string CONTENT_LENGTH = "Content-Length";
+const std::string DATE = "Date";
+
+} // namespace
+
+std::string_view http_reason_phrase(int status)
+{
+    if (status < STATUS_MIN || status > STATUS_MAX)
+        return std::string_view();
+    return table().reasons[status - STATUS_MIN];
+}
+
+std::string_view http_status_line(int status, const std::string & reason, std::string & scratch)
+{
+    if (status >= STATUS_MIN && status <= STATUS_MAX)
+    {
+        const std::string & line = table().lines[status - STATUS_MIN];
+        if (!line.empty() && (reason.empty() || table().reasons[status - STATUS_MIN] == reason))
+            return line;
+    }
+
+    char code[16];
+    int n = snprintf(code, sizeof(code), "%d", status);
+    scratch.assign("HTTP/1.1 ", 9);
+    scratch.append(code, (size_t)n);
+    scratch.push_back(' ');
+    scratch.append(reason);
+    scratch.append("\r\n", 2);
+    return scratch;
+}
+
+std::string_view http_date_header()
+{
+    struct date_cache
+    {
+        time_t sec;
+        size_t len;
+        char buf[48];
+    };
+    thread_local date_cache cache = {(time_t)-1, 0, {0}};
+
+    time_t now = ::time(NULL);
+    if (now != cache.sec)
+    {
+        cache.sec = now;
+        memcpy(cache.buf, "Date: ", 6);
+        size_t n = FormatHttpDate(now, cache.buf + 6);
+        memcpy(cache.buf + 6 + n, "\r\n", 2);
+        cache.len = 6 + n + 2;
+    }
+    return std::string_view(cache.buf, cache.len);
+}
+
+std::string * http_response_head(int status, const std::string & reason,
+        const std::map<std::string, std::string> & headers, int64_t content_length)
+{
+    std::string scratch;
+    std::string_view line = http_status_line(status, reason, scratch);
+
+    char cl[24];
+    size_t cl_len = 0;
+    if (content_length >= 0 && headers.find(CONTENT_LENGTH) == headers.end())
+        cl_len = (size_t)snprintf(cl, sizeof(cl), "%lld", (long long)content_length);
+
+    std::string_view date;
+    if (headers.find(DATE) == headers.end())
+        date = http_date_header();
+
+    size_t total = line.size() + date.size() + 2;
+    if (cl_len)
+        total += CONTENT_LENGTH.size() + 2 + cl_len + 2;
+    for (auto it = headers.begin(); it != headers.end(); ++it)
+        total += it->first.size() + 2 + it->second.size() + 2;
+
+    std::string * out = string_acquire();
+    out->reserve(total);
+    out->append(line.data(), line.size());
+    out->append(date.data(), date.size());
+    if (cl_len)
+    {
+        out->append(CONTENT_LENGTH);
+        out->append(": ", 2);
+        out->append(cl, cl_len);
+        out->append("\r\n", 2);
+    }
+    for (auto it = headers.begin(); it != headers.end(); ++it)
+    {
+        out->append(it->first);
+        out->append(": ", 2);
+        out->append(it->second);
+        out->append("\r\n", 2);
+    }
+    out->append("\r\n", 2);
+    return out;
+}
+
+} // namespace myframe
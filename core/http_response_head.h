@@ -0,0 +1,32 @@
+#ifndef __HTTP_RESPONSE_HEAD_H__
+#define __HTTP_RESPONSE_HEAD_H__
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace myframe {
+
+// HTTP/1.1 响应头序列化
+// - 常见状态码的状态行预先拼好, reason 为空或与标准短语相同时直接拷贝
+// - Date 头按线程缓存, 秒数变化时才重新格式化
+// - 先算出总长度, 一次 reserve 后顺序写入池化缓冲
+
+// 状态码的标准短语, 不认识的返回空
+std::string_view http_reason_phrase(int status);
+
+// "HTTP/1.1 <status> <reason>\r\n"; 非标准的 reason 拼在 scratch 里返回它的视图
+std::string_view http_status_line(int status, const std::string & reason, std::string & scratch);
+
+// "Date: <IMF-fixdate>\r\n", 当前线程的缓存
+std::string_view http_date_header();
+
+// 完整响应头(含结尾空行), 返回 string_acquire() 取到的缓冲
+// content_length >= 0 且 headers 里没有 Content-Length 时补上; headers 里没有 Date 时补上缓存的 Date
+std::string * http_response_head(int status, const std::string & reason,
+        const std::map<std::string, std::string> & headers, int64_t content_length = -1);
+
+} // namespace myframe
+
+#endif
@@ -0,0 +1,293 @@
+#include "http_router.h"
+#include "protocol_context.h"
+
+#include <string.h>
+
+namespace myframe {
+
+struct http_route_tree::node
+{
+    std::string prefix;                             // 静态节点的这一段字符, 参数/通配节点为空
+    std::string indices;                            // children 各自的首字符, 和 children 一一对应
+    std::vector<std::unique_ptr<node>> children;    // 静态子节点, 首字符互不相同
+    std::unique_ptr<node> param;
+    std::unique_ptr<node> wild;
+    int routes[ROUTE_METHOD_MAX];
+
+    node()
+    {
+        for (int i = 0; i < ROUTE_METHOD_MAX; i++)
+            routes[i] = -1;
+    }
+};
+
+http_route_tree::http_route_tree() : _root(new node)
+{
+}
+
+http_route_tree::~http_route_tree()
+{
+}
+
+int http_route_tree::method_id(std::string_view method)
+{
+    switch (method.size())
+    {
+        case 1:
+            if (method == "*") return ROUTE_ANY;
+            break;
+        case 3:
+            if (method == "GET") return ROUTE_GET;
+            if (method == "PUT") return ROUTE_PUT;
+            if (method == "ANY") return ROUTE_ANY;
+            break;
+        case 4:
+            if (method == "HEAD") return ROUTE_HEAD;
+            if (method == "POST") return ROUTE_POST;
+            break;
+        case 5:
+            if (method == "PATCH") return ROUTE_PATCH;
+            break;
+        case 6:
+            if (method == "DELETE") return ROUTE_DELETE;
+            break;
+        case 7:
+            if (method == "OPTIONS") return ROUTE_OPTIONS;
+            break;
+    }
+    return -1;
+}
+
+const char * http_route_tree::method_name(int id)
+{
+    static const char * const NAMES[ROUTE_METHOD_MAX] =
+        {"GET", "HEAD", "POST", "PUT", "DELETE", "PATCH", "OPTIONS", "*"};
+    if (id < 0 || id >= ROUTE_METHOD_MAX)
+        return "";
+    return NAMES[id];
+}
+
+void http_route_tree::add(int method, std::string_view pattern, int route, std::vector<std::string> & names)
+{
+    if (method < 0 || method >= ROUTE_METHOD_MAX)
+        THROW_COMMON_EXCEPT("invalid route method id " << method);
+    if (pattern.empty() || pattern[0] != '/')
+        THROW_COMMON_EXCEPT("route pattern must start with '/': " << pattern);
+
+    names.clear();
+    node * n = _root.get();
+    std::string_view rest = pattern;
+    while (!rest.empty())
+    {
+        if (rest[0] != ':' && rest[0] != '*')
+        {
+            size_t end = rest.find_first_of(":*");
+            if (end == std::string_view::npos)
+                end = rest.size();
+            n = insert_static(n, rest.substr(0, end));
+            rest.remove_prefix(end);
+            continue;
+        }
+
+        bool wild = rest[0] == '*';
+        if (rest.data()[-1] != '/')
+            THROW_COMMON_EXCEPT("route parameter must start a segment: " << pattern);
+        size_t end = wild ? rest.size() : rest.find('/');
+        if (end == std::string_view::npos)
+            end = rest.size();
+        if (end == 1)
+            THROW_COMMON_EXCEPT("route parameter without a name: " << pattern);
+        if (names.size() >= MAX_PARAMS)
+            THROW_COMMON_EXCEPT("too many route parameters: " << pattern);
+
+        names.emplace_back(rest.substr(1, end - 1));
+        std::unique_ptr<node> & slot = wild ? n->wild : n->param;
+        if (!slot)
+            slot.reset(new node);
+        n = slot.get();
+        rest.remove_prefix(end);
+    }
+
+    if (n->routes[method] >= 0)
+        THROW_COMMON_EXCEPT("duplicate route " << method_name(method) << " " << pattern);
+    n->routes[method] = route;
+}
+
+http_route_tree::node * http_route_tree::insert_static(node * n, std::string_view s)
+{
+    while (!s.empty())
+    {
+        size_t i = n->indices.find(s[0]);
+        if (i == std::string::npos)
+        {
+            node * c = new node;
+            c->prefix.assign(s.data(), s.size());
+            n->indices.push_back(s[0]);
+            n->children.emplace_back(c);
+            return c;
+        }
+
+        node * c = n->children[i].get();
+        size_t l = 0;
+        while (l < c->prefix.size() && l < s.size() && c->prefix[l] == s[l])
+            l++;
+
+        if (l < c->prefix.size())
+        {
+            // 只有前 l 个字符相同: 拆出公共部分作为中间节点, 原节点挂在它下面
+            std::unique_ptr<node> mid(new node);
+            mid->prefix.assign(c->prefix, 0, l);
+            c->prefix.erase(0, l);
+            mid->indices.push_back(c->prefix[0]);
+            mid->children.push_back(std::move(n->children[i]));
+            n->children[i] = std::move(mid);
+            c = n->children[i].get();
+        }
+        n = c;
+        s.remove_prefix(l);
+    }
+    return n;
+}
+
+int http_route_tree::pick(const node * n, int method, unsigned & allowed)
+{
+    if (method >= 0 && n->routes[method] >= 0)
+        return n->routes[method];
+    if (method == ROUTE_HEAD && n->routes[ROUTE_GET] >= 0)
+        return n->routes[ROUTE_GET];
+    if (n->routes[ROUTE_ANY] >= 0)
+        return n->routes[ROUTE_ANY];
+
+    for (int i = 0; i < ROUTE_ANY; i++)
+        if (n->routes[i] >= 0)
+            allowed |= 1u << i;
+    return -1;
+}
+
+bool http_route_tree::match(const node * n, std::string_view path, int method, captures & caps,
+        unsigned & allowed, int & route)
+{
+    if (path.empty())
+    {
+        route = pick(n, method, allowed);
+        if (route >= 0)
+            return true;
+    }
+    else
+    {
+        size_t i = n->indices.find(path[0]);
+        if (i != std::string::npos)
+        {
+            const node * c = n->children[i].get();
+            if (path.size() >= c->prefix.size() && memcmp(path.data(), c->prefix.data(), c->prefix.size()) == 0
+                    && match(c, path.substr(c->prefix.size()), method, caps, allowed, route))
+                return true;
+        }
+
+        if (n->param && caps.count < MAX_PARAMS)
+        {
+            size_t end = path.find('/');
+            if (end == std::string_view::npos)
+                end = path.size();
+            if (end > 0)
+            {
+                caps.values[caps.count++] = path.substr(0, end);
+                if (match(n->param.get(), path.substr(end), method, caps, allowed, route))
+                    return true;
+                caps.count--;
+            }
+        }
+    }
+
+    if (n->wild && caps.count < MAX_PARAMS)
+    {
+        route = pick(n->wild.get(), method, allowed);
+        if (route >= 0)
+        {
+            caps.values[caps.count++] = path;
+            return true;
+        }
+    }
+    return false;
+}
+
+int http_route_tree::find(int method, std::string_view path, captures & caps, unsigned & allowed) const
+{
+    int route = -1;
+    caps.count = 0;
+    if (!match(_root.get(), path, method, caps, allowed, route))
+        return -1;
+    return route;
+}
+
+void parse_query_string(std::string_view query, std::vector<std::pair<std::string_view, std::string_view>> & out)
+{
+    out.clear();
+    while (!query.empty())
+    {
+        size_t amp = query.find('&');
+        std::string_view item = query.substr(0, amp);
+        query.remove_prefix(amp == std::string_view::npos ? query.size() : amp + 1);
+        if (item.empty())
+            continue;
+
+        size_t eq = item.find('=');
+        if (eq == std::string_view::npos)
+            out.emplace_back(item, std::string_view());
+        else
+            out.emplace_back(item.substr(0, eq), item.substr(eq + 1));
+    }
+}
+
+std::string_view find_query_param(std::string_view query, std::string_view name)
+{
+    while (!query.empty())
+    {
+        size_t amp = query.find('&');
+        std::string_view item = query.substr(0, amp);
+        query.remove_prefix(amp == std::string_view::npos ? query.size() : amp + 1);
+        if (item.size() < name.size() || item.compare(0, name.size(), name) != 0)
+            continue;
+        if (item.size() == name.size())
+            return item.substr(item.size());
+        if (item[name.size()] == '=')
+            return item.substr(name.size() + 1);
+    }
+    return std::string_view();
+}
+
+void http_route_not_found(HttpResponse & res, unsigned allowed)
+{
+    if (!allowed)
+    {
+        res.status = 404;
+        res.reason = "Not Found";
+        res.set_text("Not Found");
+        return;
+    }
+
+    std::string allow;
+    for (int i = 0; i < http_route_tree::ROUTE_ANY; i++)
+    {
+        if (!(allowed & (1u << i)))
+            continue;
+        if (!allow.empty())
+            allow += ", ";
+        allow += http_route_tree::method_name(i);
+        // GET 也接受 HEAD
+        if (i == http_route_tree::ROUTE_GET && !(allowed & (1u << http_route_tree::ROUTE_HEAD)))
+            allow += ", HEAD";
+    }
+    res.status = 405;
+    res.reason = "Method Not Allowed";
+    res.set_header("Allow", allow);
+    res.set_text("Method Not Allowed");
+}
+
+bool HttpContextRouter::dispatch(HttpContext & ctx) const
+{
+    const HttpRequest & req = ctx.request();
+    return dispatch_to(req.method, req.url, ctx.response(), ctx);
+}
+
+} // namespace myframe
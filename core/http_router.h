@@ -0,0 +1,213 @@
+#ifndef __HTTP_ROUTER_H__
+#define __HTTP_ROUTER_H__
+
+#include "app_handler_v2.h"
+#include "common_exception.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace myframe {
+
+class HttpContext;
+
+// 压缩前缀树(radix tree)路由表: 按 方法 + 路径 找到路由编号
+// - 模式: 静态 "/api/users", 参数 "/users/:id"(匹配到下一个 '/' 为止, 不能为空),
+//   通配 "/static/*path"(匹配剩下的全部, 可以为空, 只能放在最后); 参数和通配都要占满一段
+// - 同一位置静态优先, 其次参数, 最后通配; 走不通时回溯
+// - 查找只比较字符, 不分配内存; 捕获的参数值是指向请求路径的视图
+class http_route_tree
+{
+    public:
+        enum
+        {
+            ROUTE_GET = 0,
+            ROUTE_HEAD,
+            ROUTE_POST,
+            ROUTE_PUT,
+            ROUTE_DELETE,
+            ROUTE_PATCH,
+            ROUTE_OPTIONS,
+            ROUTE_ANY,
+            ROUTE_METHOD_MAX
+        };
+
+        // 一条路由最多的参数(含通配)个数
+        enum { MAX_PARAMS = 16 };
+
+        struct captures
+        {
+            std::string_view values[MAX_PARAMS];
+            size_t count = 0;
+        };
+
+        http_route_tree();
+        ~http_route_tree();
+
+        // 方法名转编号("*"/"ANY" 为 ROUTE_ANY), 不认识的返回 -1
+        static int method_id(std::string_view method);
+
+        static const char * method_name(int id);
+
+        // 加一条路由, names 按出现顺序返回参数名; 模式不合法或 方法+模式 重复时抛异常
+        void add(int method, std::string_view pattern, int route, std::vector<std::string> & names);
+
+        // 返回路由编号并填好 caps; 找不到返回 -1, allowed 是路径匹配上的各方法位(1 << ROUTE_xxx, 0 即路径不存在)
+        // method 为 -1(不认识的方法)时只匹配 ROUTE_ANY; HEAD 没有单独注册时用 GET 的
+        int find(int method, std::string_view path, captures & caps, unsigned & allowed) const;
+
+    private:
+        struct node;
+
+        static node * insert_static(node * n, std::string_view s);
+        static int pick(const node * n, int method, unsigned & allowed);
+        static bool match(const node * n, std::string_view path, int method, captures & caps,
+                unsigned & allowed, int & route);
+
+        std::unique_ptr<node> _root;
+};
+
+// query 串("a=1&b=&c")切成 (名, 值) 视图, 不做 % 解码; 没有 '=' 的值为空
+void parse_query_string(std::string_view query, std::vector<std::pair<std::string_view, std::string_view>> & out);
+
+// 在 query 串上原地找第一个名为 name 的参数, 规则同 parse_query_string; 没有时为空
+std::string_view find_query_param(std::string_view query, std::string_view name);
+
+// 一次路由匹配的结果, 视图都指向请求的 url, 只在 handler 调用期间有效
+class HttpRouteParams {
+public:
+    typedef std::vector<std::pair<std::string_view, std::string_view>> QueryList;
+
+    HttpRouteParams() : _names(nullptr), _query_parsed(false) {}
+
+    // 路径参数: "/users/:id" 的 param("id"), 通配 "*path" 的 param("path"); 没有时为空
+    std::string_view param(std::string_view name) const {
+        for (size_t i = 0; i < _caps.count; i++)
+            if ((*_names)[i] == name) return _caps.values[i];
+        return std::string_view();
+    }
+
+    size_t param_count() const { return _caps.count; }
+    std::string_view param_name(size_t i) const { return (*_names)[i]; }
+    std::string_view param_value(size_t i) const { return _caps.values[i]; }
+
+    // '?' 之前的部分
+    std::string_view path() const { return _path; }
+
+    // query 参数(未解码), 每次在 query 串上原地扫一遍, 不分配内存
+    std::string_view query(std::string_view name) const {
+        return find_query_param(_query, name);
+    }
+
+    // 全部 query 参数, 要遍历时才切成列表
+    const QueryList& query_params() const {
+        if (!_query_parsed) {
+            parse_query_string(_query, _query_list);
+            _query_parsed = true;
+        }
+        return _query_list;
+    }
+
+private:
+    template <typename... Args> friend class HttpRouterBase;
+
+    const std::vector<std::string>* _names;
+    http_route_tree::captures _caps;
+    std::string_view _path;
+    std::string_view _query;
+    mutable bool _query_parsed;
+    mutable QueryList _query_list;
+};
+
+// 没有匹配的路由时的默认响应: allowed 为 0 给 404, 否则 405 并带 Allow
+void http_route_not_found(HttpResponse& res, unsigned allowed);
+
+// 路由表: 注册时建树, 之后只读, 多个工作线程可以共用一个实例
+// Args 是 handler 除 HttpRouteParams 以外的参数, Level 1/Level 2 各有一个具体类型
+template <typename... Args>
+class HttpRouterBase {
+public:
+    typedef std::function<void(Args..., const HttpRouteParams&)> Handler;
+
+    // method 为 "GET"/"POST"/... 或 "*"(任意方法); 模式写法见 http_route_tree
+    void add(std::string_view method, std::string_view pattern, Handler handler) {
+        int id = http_route_tree::method_id(method);
+        if (id < 0)
+            THROW_COMMON_EXCEPT("unsupported route method: " << method);
+        Route r;
+        r.handler = std::move(handler);
+        _tree.add(id, pattern, (int)_routes.size(), r.names);
+        _routes.push_back(std::move(r));
+    }
+
+    void get(std::string_view pattern, Handler h) { add("GET", pattern, std::move(h)); }
+    void post(std::string_view pattern, Handler h) { add("POST", pattern, std::move(h)); }
+    void put(std::string_view pattern, Handler h) { add("PUT", pattern, std::move(h)); }
+    void del(std::string_view pattern, Handler h) { add("DELETE", pattern, std::move(h)); }
+    void patch(std::string_view pattern, Handler h) { add("PATCH", pattern, std::move(h)); }
+    void any(std::string_view pattern, Handler h) { add("*", pattern, std::move(h)); }
+
+    // url 可以带 query; 找到返回 handler 并填好 params, 找不到返回 nullptr(allowed 含义见 http_route_tree::find)
+    const Handler* find(std::string_view method, std::string_view url, HttpRouteParams& params,
+                        unsigned& allowed) const {
+        size_t q = url.find('?');
+        params._path = url.substr(0, q);
+        params._query = q == std::string_view::npos ? std::string_view() : url.substr(q + 1);
+        params._query_parsed = false;
+        params._query_list.clear();
+        params._caps.count = 0;
+        allowed = 0;
+
+        int route = _tree.find(http_route_tree::method_id(method), params._path, params._caps, allowed);
+        if (route < 0) return nullptr;
+        params._names = &_routes[route].names;
+        return &_routes[route].handler;
+    }
+
+    size_t size() const { return _routes.size(); }
+
+protected:
+    bool dispatch_to(std::string_view method, std::string_view url, HttpResponse& res, Args... args) const {
+        HttpRouteParams params;
+        unsigned allowed;
+        const Handler* h = find(method, url, params, allowed);
+        if (!h) {
+            http_route_not_found(res, allowed);
+            return false;
+        }
+        (*h)(args..., params);
+        return true;
+    }
+
+private:
+    struct Route {
+        Handler handler;
+        std::vector<std::string> names;
+    };
+
+    http_route_tree _tree;
+    std::vector<Route> _routes;
+};
+
+// Level 1: 在 IApplicationHandler::on_http 里调 dispatch
+class HttpRouter : public HttpRouterBase<const HttpRequest&, HttpResponse&> {
+public:
+    // 找到路由就调用 handler 返回 true; 否则在 res 里填好 404/405 返回 false
+    bool dispatch(const HttpRequest& req, HttpResponse& res) const {
+        return dispatch_to(req.method, req.url, res, req, res);
+    }
+};
+
+// Level 2: 在 IProtocolHandler::on_http_request 里调 dispatch
+class HttpContextRouter : public HttpRouterBase<HttpContext&> {
+public:
+    bool dispatch(HttpContext& ctx) const;
+};
+
+} // namespace myframe
+
+#endif
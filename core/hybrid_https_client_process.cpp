@@ -4,6 +4,7 @@
 #include "http2_frame.h"
 #include "base_thread.h"
 #include "out_connect.h"
+#include "common_exception.h"
 #include <algorithm>
 #include <cctype>
 #include <iostream>
@@ -61,6 +62,14 @@ std::string* hybrid_https_client_process::get_send_buf() {
     return base_data_process::get_send_buf();
 }
 
+bool hybrid_https_client_process::get_send_slice(myframe::send_slice& out) {
+    // H2 模式把内层的片段原样转出, 共享缓冲区不会被复制
+    if (_mode == H2) {
+        return _inner ? _inner->get_send_slice(out) : false;
+    }
+    return base_data_process::get_send_slice(out);
+}
+
 static void to_lower(std::string& s){ for (auto& c : s) c = (char)std::tolower((unsigned char)c); }
 
 void hybrid_https_client_process::enqueue_http1_request() {
@@ -125,21 +134,20 @@ size_t hybrid_https_client_process::process_http1_recv(const char* buf, size_t l
     }
     // body
     if (_h1_chunked) {
-        // Minimal chunked decode
+        // 一次解完缓冲里已到达的分块, 最后只搬移一次没解完的尾巴
+        size_t off = 0;
         for(;;){
-            // need at least a line
-            size_t nl = _h1_buf.find("\r\n");
-            if (nl == std::string::npos) break;
-            std::string sz = _h1_buf.substr(0,nl);
-            size_t chunk = (size_t)strtoul(sz.c_str(), 0, 16);
-            if (_h1_buf.size() < nl+2+chunk+2) break; // wait
-            if (chunk == 0) {
-            // done (do not stop all threads; owner decides lifecycle)
-            break;
-            }
-            _h1_body.append(_h1_buf.data()+nl+2, chunk);
-            _h1_buf.erase(0, nl+2+chunk+2);
+            size_t used = 0;
+            std::string_view data;
+            int r = _h1_chunked_decoder.decode(_h1_buf.data() + off, _h1_buf.size() - off, used, data);
+            off += used;
+            if (r == myframe::http_chunked_decoder::ERROR) THROW_COMMON_EXCEPT("http chunked body parse error");
+            if (r != myframe::http_chunked_decoder::DATA) break; // MORE: wait; DONE: owner decides lifecycle
+            _h1_body.append(data.data(), data.size());
+            _h1_chunked_decoder.data_consumed(data.size());
+            off += data.size();
         }
+        _h1_buf.erase(0, off);
     } else if (_h1_content_length > 0) {
         size_t need = _h1_content_length - _h1_body.size();
         size_t take = std::min(need, _h1_buf.size());
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "base_data_process.h"
+#include "http_chunked_decoder.h"
 #include <map>
 #include <string>
 
@@ -19,6 +20,7 @@ public:
 
     virtual size_t process_recv_buf(const char* buf, size_t len) override;
     virtual std::string* get_send_buf() override;
+    virtual bool get_send_slice(myframe::send_slice& out) override;
     virtual void handle_timeout(std::shared_ptr<timer_msg>& t_msg) override;
 
 private:
@@ -42,6 +44,7 @@ private:
     int _h1_status{0};
     size_t _h1_content_length{0};
     bool _h1_chunked{false};
+    myframe::http_chunked_decoder _h1_chunked_decoder;
     std::string _h1_buf;
     std::string _h1_body;
 };
@@ -0,0 +1,61 @@
+#include "io_engine.h"
+#include "common_epoll.h"
+#include "io_uring_engine.h"
+
+namespace {
+
+bool want_uring()
+{
+    const char* e = ::getenv("MYFRAME_IO_ENGINE");
+    return e && (strcasecmp(e, "uring") == 0 || strcasecmp(e, "io_uring") == 0);
+}
+
+} // namespace
+
+io_engine * io_engine::create(uint32_t epoll_size)
+{
+#ifdef MYFRAME_HAVE_IO_URING
+    if (want_uring())
+    {
+        io_uring_engine * engine = new io_uring_engine();
+        try
+        {
+            engine->init(epoll_size);
+            return engine;
+        }
+        catch (std::exception &e)
+        {
+            delete engine;
+            // 每个进程只提示一次
+            static bool logged = false;
+            if (!logged)
+            {
+                logged = true;
+                fprintf(stderr, "[io_engine] io_uring unavailable (%s), fallback to epoll\n", e.what());
+            }
+        }
+    }
+#else
+    if (want_uring())
+    {
+        static bool logged = false;
+        if (!logged)
+        {
+            logged = true;
+            fprintf(stderr, "[io_engine] built without io_uring, fallback to epoll\n");
+        }
+    }
+#endif
+
+    common_epoll * engine = new common_epoll();
+    try
+    {
+        engine->init(epoll_size);
+    }
+    catch (...)
+    {
+        delete engine;
+        throw;
+    }
+    return engine;
+}
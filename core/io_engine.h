@@ -0,0 +1,51 @@
+#ifndef __IO_ENGINE_H__
+#define __IO_ENGINE_H__
+
+#include "common_def.h"
+#include "send_slice.h"
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+class base_net_obj;
+
+// 异步发送请求: 引擎在完成前持有缓冲区, 完成后连同结果交还给连接
+struct io_send_req
+{
+    enum { MAX_IOV = 64 };
+
+    std::vector<myframe::send_slice> bufs;
+    struct iovec iov[MAX_IOV];
+    struct msghdr msg;
+    size_t bytes{0};
+};
+
+// 容器下层的 IO 引擎: 默认 epoll(就绪通知), 可在运行时切换为 io_uring(完成通知)
+// 选择: MYFRAME_IO_ENGINE=epoll|uring, io_uring 不可用时自动退回 epoll
+class io_engine
+{
+    public:
+        virtual ~io_engine() {}
+
+        virtual const char * name() const = 0;
+
+        virtual void add_obj(base_net_obj * p_obj) = 0;
+
+        virtual void del_obj(base_net_obj * p_obj) = 0;
+
+        // 对象的 get_event()/io_caps() 变化后调用
+        virtual void mod_obj(base_net_obj * p_obj) = 0;
+
+        // wait_ms < 0 时使用配置的等待时间; 事件处理中抛异常的对象放入 expect_list
+        virtual int wait(std::map<ObjId, std::shared_ptr<base_net_obj> > &expect_list,
+                std::map<ObjId, std::shared_ptr<base_net_obj> > &remove_list, int wait_ms = -1) = 0;
+
+        virtual int get_wait_time() const = 0;
+
+        // 是否支持 submit_send; 成功提交后由引擎回调 base_net_obj::on_io_send
+        virtual bool async_send() const { return false; }
+        virtual bool submit_send(base_net_obj *, std::unique_ptr<io_send_req> &) { return false; }
+
+        static io_engine * create(uint32_t epoll_size);
+};
+
+#endif
@@ -0,0 +1,753 @@
+#include "io_uring_engine.h"
+
+#ifdef MYFRAME_HAVE_IO_URING
+
+#include "base_net_obj.h"
+#include "common_epoll.h"
+#include "common_exception.h"
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+namespace {
+
+int sys_io_uring_setup(uint32_t entries, struct io_uring_params * p)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+int sys_io_uring_enter(int fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags, void * arg, size_t argsz)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+int sys_io_uring_register(int fd, uint32_t opcode, void * arg, uint32_t nr_args)
+{
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+uint32_t round_pow2(uint32_t v)
+{
+    uint32_t n = 1;
+    while (n < v)
+        n <<= 1;
+    return n;
+}
+
+// 与 epoll_wait 相同的异常处理: 抛异常的对象放入 expect_list, 仍是 real_net 的放入 remove_list
+template <class F>
+void dispatch(base_net_obj * p, F fn,
+        std::map<ObjId, std::shared_ptr<base_net_obj> > &expect_list,
+        std::map<ObjId, std::shared_ptr<base_net_obj> > &remove_list)
+{
+    if (expect_list.count(p->get_id()))
+        return;
+
+    std::shared_ptr<base_net_obj> p_obj = p->shared_from_this();
+    try
+    {
+        fn();
+        if (p->get_real_net()) {
+            remove_list.insert(std::make_pair(p->get_id(), p_obj));
+        }
+    }
+    catch(CMyCommonException &e)
+    {
+        fprintf(stderr, "[io_uring] CMyCommonException obj_id=%u fd=%d: %s\n",
+                p->get_id()._id, p->get_sfd(), e.what());
+        expect_list.insert(std::make_pair(p->get_id(), p_obj));
+    }
+    catch(std::exception &e)
+    {
+        fprintf(stderr, "[io_uring] std::exception obj_id=%u fd=%d: %s\n",
+                p->get_id()._id, p->get_sfd(), e.what());
+        expect_list.insert(std::make_pair(p->get_id(), p_obj));
+    }
+}
+
+} // namespace
+
+io_uring_engine::io_uring_engine()
+{
+    _ring_fd = -1;
+    _entries = 0;
+    _wait_time = DEFAULT_EPOLL_WAITE;
+
+    _sq_ptr = NULL;
+    _sq_size = 0;
+    _cq_ptr = NULL;
+    _cq_size = 0;
+    _sqes = NULL;
+    _sqes_size = 0;
+    _sq_khead = _sq_ktail = NULL;
+    _sq_mask = _sq_entries = 0;
+    _sq_tail = _sq_submitted = 0;
+    _cq_khead = _cq_ktail = NULL;
+    _cq_mask = 0;
+    _cqes = NULL;
+
+    _buf_ring = NULL;
+    _buf_ring_size = 0;
+    _buf_base = NULL;
+    _buf_count = 0;
+    _buf_size = 0;
+    _buf_tail = 0;
+
+    _multishot_recv = false;
+    _multishot_accept = true;
+    _live_ops = NULL;
+}
+
+io_uring_engine::~io_uring_engine()
+{
+    // 先关 ring, 内核会取消所有在途请求; 之后只释放用户态记录
+    if (_ring_fd >= 0)
+    {
+        ::close(_ring_fd);
+        _ring_fd = -1;
+    }
+
+    std::unordered_set<obj_state *> states;
+    for (auto & k : _states)
+        states.insert(k.second);
+    for (auto st : _dirty)
+        states.insert(st);
+    while (_live_ops)
+    {
+        io_op * op = _live_ops;
+        states.insert(op->_state);
+        _live_ops = op->_next;
+        delete op;
+    }
+    for (auto st : states)
+        delete st;
+    _states.clear();
+    _dirty.clear();
+
+    for (auto op : _free_ops)
+        delete op;
+    _free_ops.clear();
+
+    if (_buf_ring)
+        munmap(_buf_ring, _buf_ring_size);
+    free(_buf_base);
+
+    if (_sqes)
+        munmap(_sqes, _sqes_size);
+    if (_cq_ptr && _cq_ptr != _sq_ptr)
+        munmap(_cq_ptr, _cq_size);
+    if (_sq_ptr)
+        munmap(_sq_ptr, _sq_size);
+}
+
+void io_uring_engine::init(uint32_t entries)
+{
+    _entries = round_pow2(entries < 64 ? 64 : (entries > 4096 ? 4096 : entries));
+    if (const char* e = ::getenv("MYFRAME_URING_ENTRIES")) {
+        long v = atol(e);
+        if (v >= 64 && v <= 32768) _entries = round_pow2((uint32_t)v);
+    }
+    _wait_time = common_epoll::config_wait_time(DEFAULT_EPOLL_WAITE);
+
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = _entries * 4;
+    int fd = sys_io_uring_setup(_entries, &p);
+    if (fd < 0 && errno == EINVAL)
+    {
+        memset(&p, 0, sizeof(p));
+        fd = sys_io_uring_setup(_entries, &p);
+    }
+    if (fd < 0)
+    {
+        THROW_COMMON_EXCEPT("io_uring_setup fail " << strError(errno).c_str());
+    }
+    _ring_fd = fd;
+
+    // 需要 IORING_ENTER_EXT_ARG 做带超时的等待(5.11+)
+    if (!(p.features & IORING_FEAT_EXT_ARG) || !(p.features & IORING_FEAT_NODROP))
+    {
+        THROW_COMMON_EXCEPT("io_uring features 0x" << std::hex << p.features << " lack EXT_ARG/NODROP");
+    }
+
+    _sq_size = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+    _cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single)
+    {
+        if (_cq_size > _sq_size)
+            _sq_size = _cq_size;
+        _cq_size = _sq_size;
+    }
+
+    _sq_ptr = mmap(NULL, _sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (_sq_ptr == MAP_FAILED)
+    {
+        _sq_ptr = NULL;
+        THROW_COMMON_EXCEPT("io_uring mmap sq fail " << strError(errno).c_str());
+    }
+
+    if (single)
+    {
+        _cq_ptr = _sq_ptr;
+    }
+    else
+    {
+        _cq_ptr = mmap(NULL, _cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (_cq_ptr == MAP_FAILED)
+        {
+            _cq_ptr = NULL;
+            THROW_COMMON_EXCEPT("io_uring mmap cq fail " << strError(errno).c_str());
+        }
+    }
+
+    _sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    void * sqes = mmap(NULL, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        THROW_COMMON_EXCEPT("io_uring mmap sqes fail " << strError(errno).c_str());
+    }
+    _sqes = (struct io_uring_sqe *)sqes;
+
+    char * sq = (char *)_sq_ptr;
+    _sq_khead = (uint32_t *)(sq + p.sq_off.head);
+    _sq_ktail = (uint32_t *)(sq + p.sq_off.tail);
+    _sq_mask = *(uint32_t *)(sq + p.sq_off.ring_mask);
+    _sq_entries = *(uint32_t *)(sq + p.sq_off.ring_entries);
+    uint32_t * sq_array = (uint32_t *)(sq + p.sq_off.array);
+    for (uint32_t i = 0; i < _sq_entries; i++)
+        sq_array[i] = i;
+    _sq_tail = _sq_submitted = *_sq_ktail;
+
+    char * cq = (char *)_cq_ptr;
+    _cq_khead = (uint32_t *)(cq + p.cq_off.head);
+    _cq_ktail = (uint32_t *)(cq + p.cq_off.tail);
+    _cq_mask = *(uint32_t *)(cq + p.cq_off.ring_mask);
+    _cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    init_buf_ring();
+
+    PDEBUG("[io_uring] entries=%u cq=%u wait_ms=%d recv_multishot=%d bufs=%u x %u",
+            _sq_entries, p.cq_entries, _wait_time, _multishot_recv ? 1 : 0, _buf_count, _buf_size);
+}
+
+void io_uring_engine::init_buf_ring()
+{
+    // MYFRAME_URING_BUFS / MYFRAME_URING_BUF_SIZE: 每个线程一组 provided buffer, 供 multishot recv 选用
+    uint32_t count = 256;
+    uint32_t size = 16384;
+    if (const char* e = ::getenv("MYFRAME_URING_BUFS")) { long v = atol(e); if (v > 0) count = (uint32_t)v; }
+    if (const char* e = ::getenv("MYFRAME_URING_BUF_SIZE")) { long v = atol(e); if (v > 0) size = (uint32_t)v; }
+    if (count < 16) count = 16;
+    if (count > 32768) count = 32768;
+    count = round_pow2(count);
+    if (size < 1024) size = 1024;
+    if (size > 1024 * 1024) size = 1024 * 1024;
+
+    _buf_ring_size = count * sizeof(struct io_uring_buf);
+    void * ring = mmap(NULL, _buf_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED)
+    {
+        PDEBUG("[io_uring] buf ring mmap fail %s", strError(errno).c_str());
+        return;
+    }
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)ring;
+    reg.ring_entries = count;
+    reg.bgid = 0;
+    if (sys_io_uring_register(_ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+    {
+        // 5.19 之前没有 buffer ring, 连接退回 poll + recv
+        PDEBUG("[io_uring] register pbuf ring fail %s", strError(errno).c_str());
+        munmap(ring, _buf_ring_size);
+        return;
+    }
+
+    _buf_base = (char *)malloc((size_t)count * size);
+    if (!_buf_base)
+    {
+        THROW_COMMON_EXCEPT("io_uring buffer alloc fail");
+    }
+
+    _buf_ring = (struct io_uring_buf_ring *)ring;
+    _buf_count = count;
+    _buf_size = size;
+    _buf_tail = 0;
+    for (uint32_t i = 0; i < count; i++)
+        recycle_buf((uint16_t)i);
+
+    _multishot_recv = true;
+}
+
+void io_uring_engine::recycle_buf(uint16_t bid)
+{
+    // 不用 _buf_ring->bufs: C++ 下 __DECLARE_FLEX_ARRAY 的空结构体占 1 字节, 数组会整体后移
+    struct io_uring_buf * buf = (struct io_uring_buf *)(void *)_buf_ring + (_buf_tail & (_buf_count - 1));
+    buf->addr = (uint64_t)(uintptr_t)(_buf_base + (size_t)bid * _buf_size);
+    buf->len = _buf_size;
+    buf->bid = bid;
+    _buf_tail++;
+    __atomic_store_n(&_buf_ring->tail, _buf_tail, __ATOMIC_RELEASE);
+}
+
+io_uring_engine::io_op * io_uring_engine::alloc_op(op_type type, obj_state * st)
+{
+    io_op * op = NULL;
+    if (!_free_ops.empty())
+    {
+        op = _free_ops.back();
+        _free_ops.pop_back();
+    }
+    else
+    {
+        op = new io_op();
+    }
+
+    op->_type = type;
+    op->_state = st;
+    op->_prev = NULL;
+    op->_next = _live_ops;
+    if (_live_ops)
+        _live_ops->_prev = op;
+    _live_ops = op;
+
+    return op;
+}
+
+void io_uring_engine::free_op(io_op * op)
+{
+    if (op->_prev)
+        op->_prev->_next = op->_next;
+    else
+        _live_ops = op->_next;
+    if (op->_next)
+        op->_next->_prev = op->_prev;
+
+    op->_req.reset();
+    op->_state = NULL;
+    op->_prev = op->_next = NULL;
+    _free_ops.push_back(op);
+}
+
+struct io_uring_sqe * io_uring_engine::get_sqe()
+{
+    uint32_t head = __atomic_load_n(_sq_khead, __ATOMIC_ACQUIRE);
+    if (_sq_tail - head >= _sq_entries)
+    {
+        // SQ 满了先提交一批
+        submit(0, 0);
+        head = __atomic_load_n(_sq_khead, __ATOMIC_ACQUIRE);
+        if (_sq_tail - head >= _sq_entries)
+        {
+            THROW_COMMON_EXCEPT("io_uring sq full");
+        }
+    }
+
+    struct io_uring_sqe * sqe = &_sqes[_sq_tail & _sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    _sq_tail++;
+
+    return sqe;
+}
+
+int io_uring_engine::submit(uint32_t min_complete, int wait_ms)
+{
+    uint32_t to_submit = _sq_tail - _sq_submitted;
+    if (!to_submit && !min_complete)
+        return 0;
+
+    __atomic_store_n(_sq_ktail, _sq_tail, __ATOMIC_RELEASE);
+
+    uint32_t flags = 0;
+    void * arg = NULL;
+    size_t argsz = 0;
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg ext;
+    if (min_complete)
+    {
+        ts.tv_sec = wait_ms / 1000;
+        ts.tv_nsec = (long long)(wait_ms % 1000) * 1000000;
+        memset(&ext, 0, sizeof(ext));
+        ext.sigmask_sz = _NSIG / 8;
+        ext.ts = (uint64_t)(uintptr_t)&ts;
+        flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        arg = &ext;
+        argsz = sizeof(ext);
+    }
+
+    int ret = sys_io_uring_enter(_ring_fd, to_submit, min_complete, flags, arg, argsz);
+    if (ret < 0)
+    {
+        int err = errno;
+        if (err == ETIME || err == EINTR || err == EBUSY || err == EAGAIN)
+            return 0;
+        THROW_COMMON_EXCEPT("io_uring_enter fail " << strError(err).c_str());
+    }
+
+    _sq_submitted += (uint32_t)ret;
+    return ret;
+}
+
+void io_uring_engine::cancel_op(io_op * op)
+{
+    struct io_uring_sqe * sqe = get_sqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = (uint64_t)(uintptr_t)op;
+    sqe->user_data = 0;
+}
+
+void io_uring_engine::mark_dirty(obj_state * st)
+{
+    if (!st->_dirty)
+    {
+        st->_dirty = true;
+        _dirty.push_back(st);
+    }
+}
+
+void io_uring_engine::maybe_free(obj_state * st)
+{
+    if (!st->_obj && !st->_poll_op && !st->_recv_op && !st->_accept_op && !st->_send_op && !st->_dirty)
+    {
+        delete st;
+    }
+}
+
+void io_uring_engine::sync_state(obj_state * st)
+{
+    base_net_obj * obj = st->_obj;
+    int caps = obj->io_caps();
+    uint32_t mask = (uint32_t)(obj->get_event() & ~EPOLLET);
+
+    bool want_accept = (caps & base_net_obj::IO_CAP_ACCEPT) && _multishot_accept;
+    if (want_accept && !st->_accept_op)
+    {
+        io_op * op = alloc_op(OP_ACCEPT, st);
+        struct io_uring_sqe * sqe = get_sqe();
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = st->_fd;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->user_data = (uint64_t)(uintptr_t)op;
+        st->_accept_op = op;
+    }
+    else if (!want_accept && st->_accept_op && !st->_accept_cancel)
+    {
+        cancel_op(st->_accept_op);
+        st->_accept_cancel = true;
+    }
+
+    bool want_recv = (caps & base_net_obj::IO_CAP_RECV) && _multishot_recv;
+    if (want_recv && !st->_recv_op)
+    {
+        io_op * op = alloc_op(OP_RECV, st);
+        struct io_uring_sqe * sqe = get_sqe();
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = st->_fd;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = 0;
+        sqe->user_data = (uint64_t)(uintptr_t)op;
+        st->_recv_op = op;
+        // 从这里开始读取只能来自完成事件, 否则数据会乱序
+        obj->set_io_recv_owned(true);
+    }
+    else if (!want_recv && st->_recv_op && !st->_recv_cancel)
+    {
+        cancel_op(st->_recv_op);
+        st->_recv_cancel = true;
+    }
+
+    // 读由 accept/recv 完成事件负责时, poll 只关心写
+    if (st->_accept_op || st->_recv_op)
+        mask &= ~(uint32_t)EPOLLIN;
+
+    bool want_poll = (mask & (EPOLLIN | EPOLLOUT)) != 0;
+    if (st->_poll_op)
+    {
+        if ((!want_poll || st->_poll_mask != mask) && !st->_poll_cancel)
+        {
+            // 取消完成后会重新 sync, 用新的掩码布防
+            cancel_op(st->_poll_op);
+            st->_poll_cancel = true;
+        }
+    }
+    else if (want_poll)
+    {
+        io_op * op = alloc_op(OP_POLL, st);
+        struct io_uring_sqe * sqe = get_sqe();
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = st->_fd;
+        sqe->poll32_events = mask;
+        sqe->user_data = (uint64_t)(uintptr_t)op;
+        st->_poll_op = op;
+        st->_poll_mask = mask;
+    }
+}
+
+void io_uring_engine::add_obj(base_net_obj * p_obj)
+{
+    auto it = _states.find(p_obj);
+    if (it != _states.end())
+    {
+        mark_dirty(it->second);
+        return;
+    }
+
+    obj_state * st = new obj_state();
+    st->_obj = p_obj;
+    st->_fd = p_obj->get_sfd();
+    st->_poll_op = st->_recv_op = st->_accept_op = st->_send_op = NULL;
+    st->_poll_mask = 0;
+    st->_poll_cancel = st->_recv_cancel = st->_accept_cancel = false;
+    st->_dirty = false;
+    _states[p_obj] = st;
+    PDEBUG("add to io_uring _ring_fd[%d] _get_sock [%d]", _ring_fd, st->_fd);
+
+    mark_dirty(st);
+}
+
+void io_uring_engine::del_obj(base_net_obj * p_obj)
+{
+    auto it = _states.find(p_obj);
+    if (it == _states.end())
+        return;
+
+    obj_state * st = it->second;
+    _states.erase(it);
+    st->_obj = NULL;
+    PDEBUG("delete from io_uring _ring_fd[%d] _get_sock [%d]", _ring_fd, st->_fd);
+
+    if (st->_poll_op && !st->_poll_cancel)
+    {
+        cancel_op(st->_poll_op);
+        st->_poll_cancel = true;
+    }
+    if (st->_recv_op && !st->_recv_cancel)
+    {
+        cancel_op(st->_recv_op);
+        st->_recv_cancel = true;
+    }
+    if (st->_accept_op && !st->_accept_cancel)
+    {
+        cancel_op(st->_accept_op);
+        st->_accept_cancel = true;
+    }
+    // 在途的发送不取消, 让已经交给内核的数据发完(关闭前的最后一个响应)
+
+    // 调用方接下来会 close(fd): 排队中的 SQE 必须在 fd 号被复用前交给内核
+    if (_sq_tail != _sq_submitted)
+        submit(0, 0);
+
+    maybe_free(st);
+}
+
+void io_uring_engine::mod_obj(base_net_obj * p_obj)
+{
+    auto it = _states.find(p_obj);
+    if (it == _states.end())
+    {
+        add_obj(p_obj);
+        return;
+    }
+
+    mark_dirty(it->second);
+}
+
+bool io_uring_engine::submit_send(base_net_obj * p_obj, std::unique_ptr<io_send_req> & req)
+{
+    auto it = _states.find(p_obj);
+    if (it == _states.end() || it->second->_send_op || !req || req->bufs.empty())
+        return false;
+
+    obj_state * st = it->second;
+    size_t n = req->bufs.size() < (size_t)io_send_req::MAX_IOV ? req->bufs.size() : (size_t)io_send_req::MAX_IOV;
+    for (size_t i = 0; i < n; i++)
+    {
+        req->iov[i].iov_base = (void *)req->bufs[i].data();
+        req->iov[i].iov_len = req->bufs[i].size();
+    }
+    memset(&req->msg, 0, sizeof(req->msg));
+    req->msg.msg_iov = req->iov;
+    req->msg.msg_iovlen = n;
+
+    struct io_uring_sqe * sqe = get_sqe();
+    io_op * op = alloc_op(OP_SEND, st);
+    op->_req = std::move(req);
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = st->_fd;
+    sqe->addr = (uint64_t)(uintptr_t)&op->_req->msg;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = (uint64_t)(uintptr_t)op;
+    st->_send_op = op;
+
+    return true;
+}
+
+void io_uring_engine::handle_cqe(const struct io_uring_cqe & cqe,
+        std::map<ObjId, std::shared_ptr<base_net_obj> > &expect_list,
+        std::map<ObjId, std::shared_ptr<base_net_obj> > &remove_list)
+{
+    io_op * op = (io_op *)(uintptr_t)cqe.user_data;
+    if (!op)
+        return; // 取消请求本身的完成事件
+
+    obj_state * st = op->_state;
+    bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+    int res = cqe.res;
+
+    switch (op->_type)
+    {
+        case OP_POLL:
+            {
+                st->_poll_op = NULL;
+                st->_poll_cancel = false;
+                free_op(op);
+                if (st->_obj && res > 0)
+                {
+                    base_net_obj * obj = st->_obj;
+                    dispatch(obj, [&]() { obj->event_process(res); }, expect_list, remove_list);
+                }
+                else if (st->_obj && res < 0 && res != -ECANCELED)
+                {
+                    base_net_obj * obj = st->_obj;
+                    dispatch(obj, [&]() { THROW_COMMON_EXCEPT("poll error " << strError(-res).c_str()); },
+                            expect_list, remove_list);
+                }
+            }
+            break;
+        case OP_RECV:
+            {
+                bool has_buf = (cqe.flags & IORING_CQE_F_BUFFER) != 0;
+                uint16_t bid = has_buf ? (uint16_t)(cqe.flags >> IORING_CQE_BUFFER_SHIFT) : 0;
+                if (st->_obj)
+                {
+                    base_net_obj * obj = st->_obj;
+                    if (res > 0 && has_buf)
+                    {
+                        const char * data = _buf_base + (size_t)bid * _buf_size;
+                        dispatch(obj, [&]() { obj->on_io_recv(data, (size_t)res); }, expect_list, remove_list);
+                    }
+                    else if (res == 0)
+                    {
+                        dispatch(obj, [&]() { obj->on_io_recv(NULL, 0); }, expect_list, remove_list);
+                    }
+                    else if (res == -EINVAL)
+                    {
+                        // 内核不支持 multishot recv, 之后一律走 poll + recv
+                        PDEBUG("[io_uring] multishot recv unsupported, fallback to poll");
+                        _multishot_recv = false;
+                    }
+                    else if (res < 0 && res != -ENOBUFS && res != -ECANCELED)
+                    {
+                        dispatch(obj, [&]() { THROW_COMMON_EXCEPT("this socket occur fatal error " << strError(-res).c_str()); },
+                                expect_list, remove_list);
+                    }
+                }
+                if (has_buf)
+                    recycle_buf(bid);
+
+                if (!more)
+                {
+                    st->_recv_op = NULL;
+                    st->_recv_cancel = false;
+                    free_op(op);
+                    if (st->_obj)
+                        st->_obj->set_io_recv_owned(false);
+                }
+            }
+            break;
+        case OP_ACCEPT:
+            {
+                if (res >= 0)
+                {
+                    if (st->_obj)
+                    {
+                        base_net_obj * obj = st->_obj;
+                        dispatch(obj, [&]() { obj->on_io_accept(res); }, expect_list, remove_list);
+                    }
+                    else
+                    {
+                        ::close(res);
+                    }
+                }
+                else if (res == -EINVAL)
+                {
+                    PDEBUG("[io_uring] multishot accept unsupported, fallback to poll");
+                    _multishot_accept = false;
+                }
+                else if (res != -ECANCELED)
+                {
+                    PDEBUG("accept fail:%s", strError(-res).c_str());
+                }
+
+                if (!more)
+                {
+                    st->_accept_op = NULL;
+                    st->_accept_cancel = false;
+                    free_op(op);
+                }
+            }
+            break;
+        case OP_SEND:
+            {
+                std::unique_ptr<io_send_req> req = std::move(op->_req);
+                st->_send_op = NULL;
+                free_op(op);
+                if (st->_obj)
+                {
+                    base_net_obj * obj = st->_obj;
+                    dispatch(obj, [&]() { obj->on_io_send(req, res); }, expect_list, remove_list);
+                }
+            }
+            break;
+    }
+
+    if (st->_obj)
+        mark_dirty(st);
+    else
+        maybe_free(st);
+}
+
+int io_uring_engine::wait(std::map<ObjId, std::shared_ptr<base_net_obj> > &expect_list,
+        std::map<ObjId, std::shared_ptr<base_net_obj> > &remove_list, int wait_ms)
+{
+    if (wait_ms < 0 || wait_ms > _wait_time)
+        wait_ms = _wait_time;
+
+    // 按最新的 io_caps()/get_event() 布防, 连同本轮的发送一次提交
+    for (size_t i = 0; i < _dirty.size(); i++)
+    {
+        obj_state * st = _dirty[i];
+        st->_dirty = false;
+        if (st->_obj)
+            sync_state(st);
+        else
+            maybe_free(st);
+    }
+    _dirty.clear();
+
+    uint32_t head = *_cq_khead;
+    uint32_t tail = __atomic_load_n(_cq_ktail, __ATOMIC_ACQUIRE);
+    submit((head != tail || !wait_ms) ? 0 : 1, wait_ms);
+
+    tail = __atomic_load_n(_cq_ktail, __ATOMIC_ACQUIRE);
+    int n = 0;
+    while (head != tail)
+    {
+        struct io_uring_cqe cqe = _cqes[head & _cq_mask];
+        head++;
+        __atomic_store_n(_cq_khead, head, __ATOMIC_RELEASE);
+
+        handle_cqe(cqe, expect_list, remove_list);
+        n++;
+    }
+
+    return n;
+}
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef __IO_URING_ENGINE_H__
+#define __IO_URING_ENGINE_H__
+
+#include "io_engine.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define MYFRAME_HAVE_IO_URING 1
+#endif
+#endif
+
+#ifdef MYFRAME_HAVE_IO_URING
+
+#include <linux/io_uring.h>
+
+// io_uring 引擎(直接走系统调用, 不依赖 liburing)
+// - 监听 socket: multishot accept
+// - 普通连接: multishot recv + provided buffer ring, 数据经 on_io_recv 交付
+// - 发送: sendmsg SQE, 本轮产生的所有 SQE 在下一次 wait 时一次 io_uring_enter 提交
+// - 其余对象(eventfd、TLS、协议探测阶段等): one-shot poll, 每次事件后重新布防, 语义等同水平触发
+// 内核不支持 multishot recv/accept 时自动退回 poll 方式
+class io_uring_engine : public io_engine
+{
+    public:
+        io_uring_engine();
+
+        virtual ~io_uring_engine();
+
+        // 失败抛 CMyCommonException, 由 io_engine::create 退回 epoll
+        void init(uint32_t entries);
+
+        virtual const char * name() const { return "io_uring"; }
+
+        virtual void add_obj(base_net_obj * p_obj);
+
+        virtual void del_obj(base_net_obj * p_obj);
+
+        virtual void mod_obj(base_net_obj * p_obj);
+
+        virtual int wait(std::map<ObjId, std::shared_ptr<base_net_obj> > &expect_list,
+                std::map<ObjId, std::shared_ptr<base_net_obj> > &remove_list, int wait_ms = -1);
+
+        virtual int get_wait_time() const { return _wait_time; }
+
+        virtual bool async_send() const { return true; }
+
+        virtual bool submit_send(base_net_obj * p_obj, std::unique_ptr<io_send_req> & req);
+
+    protected:
+        enum op_type
+        {
+            OP_POLL,
+            OP_RECV,
+            OP_ACCEPT,
+            OP_SEND
+        };
+
+        struct obj_state;
+
+        struct io_op
+        {
+            op_type _type;
+            obj_state * _state;
+            std::unique_ptr<io_send_req> _req;
+            io_op * _prev;
+            io_op * _next;
+        };
+
+        // 每个注册对象一份; 对象注销后(_obj 为空)等所有在途操作完成再释放
+        struct obj_state
+        {
+            base_net_obj * _obj;
+            int _fd;
+            io_op * _poll_op;
+            io_op * _recv_op;
+            io_op * _accept_op;
+            io_op * _send_op;
+            uint32_t _poll_mask;
+            bool _poll_cancel;
+            bool _recv_cancel;
+            bool _accept_cancel;
+            bool _dirty;
+        };
+
+        io_op * alloc_op(op_type type, obj_state * st);
+        void free_op(io_op * op);
+
+        struct io_uring_sqe * get_sqe();
+        int submit(uint32_t min_complete, int wait_ms);
+        void cancel_op(io_op * op);
+
+        void mark_dirty(obj_state * st);
+        void sync_state(obj_state * st);
+        void maybe_free(obj_state * st);
+
+        void init_buf_ring();
+        void recycle_buf(uint16_t bid);
+
+        void handle_cqe(const struct io_uring_cqe & cqe,
+                std::map<ObjId, std::shared_ptr<base_net_obj> > &expect_list,
+                std::map<ObjId, std::shared_ptr<base_net_obj> > &remove_list);
+
+    protected:
+        int _ring_fd;
+        uint32_t _entries;
+        int _wait_time;
+
+        // SQ/CQ 映射
+        void * _sq_ptr;
+        size_t _sq_size;
+        void * _cq_ptr;
+        size_t _cq_size;
+        struct io_uring_sqe * _sqes;
+        size_t _sqes_size;
+        uint32_t * _sq_khead;
+        uint32_t * _sq_ktail;
+        uint32_t _sq_mask;
+        uint32_t _sq_entries;
+        uint32_t _sq_tail;
+        uint32_t _sq_submitted;
+        uint32_t * _cq_khead;
+        uint32_t * _cq_ktail;
+        uint32_t _cq_mask;
+        struct io_uring_cqe * _cqes;
+
+        // provided buffer ring(bgid 0)
+        struct io_uring_buf_ring * _buf_ring;
+        size_t _buf_ring_size;
+        char * _buf_base;
+        uint32_t _buf_count;
+        uint32_t _buf_size;
+        uint16_t _buf_tail;
+
+        bool _multishot_recv;
+        bool _multishot_accept;
+
+        std::unordered_map<base_net_obj *, obj_state *> _states;
+        std::vector<obj_state *> _dirty;
+        std::vector<io_op *> _free_ops;
+        io_op * _live_ops;
+};
+
+#endif
+
+#endif
@@ -13,7 +13,8 @@ template<class PROCESS>
 class listen_connect:public base_net_obj
 {
     public:
-        listen_connect(const std::string &ip, unsigned short port)
+        // reuse_port: 开启 SO_REUSEPORT, 多个线程各自 bind 同一地址, 由内核分摊新连接
+        listen_connect(const std::string &ip, unsigned short port, bool reuse_port = false)
         {
             _process.reset();
 
@@ -45,10 +46,20 @@ class listen_connect:public base_net_obj
             }
             setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, (void*)(&(reuse_addr)), sizeof(reuse_addr));
             int one = 1; setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (void*)(&one), sizeof(one));
+            if (reuse_port)
+            {
+                if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, (void*)(&one), sizeof(one)) < 0)
+                {
+                    PDEBUG("[listen_factory] SO_REUSEPORT fail: %s", strError(errno).c_str());
+                    ::close(fd);
+                    THROW_COMMON_EXCEPT("setsockopt SO_REUSEPORT error " << strError(errno).c_str());
+                }
+            }
 
             if (::bind(fd, (struct sockaddr *) &address, sizeof(address)) < 0) 
             {
                 PDEBUG("[listen_factory] bind(%s:%u) fail: %s", ip.empty()?"0.0.0.0":ip.c_str(), port, strError(errno).c_str());
+                ::close(fd);
                 THROW_COMMON_EXCEPT("bind error "  << strError(errno).c_str() << " " << ip << ":" << port);
             }
 
@@ -60,6 +71,7 @@ class listen_connect:public base_net_obj
             if (ret == -1)
             {
                 PDEBUG("[listen_factory] listen(fd=%d, backlog=%d) fail: %s", fd, backlog, strError(errno).c_str());
+                ::close(fd);
                 THROW_COMMON_EXCEPT("listen error "  << strError(errno).c_str());
             }
 
@@ -113,6 +125,21 @@ class listen_connect:public base_net_obj
             return 0;
         }
 
+        // io_uring 引擎: multishot accept 直接交付新连接
+        virtual int io_caps() const
+        {
+            return IO_CAP_ACCEPT;
+        }
+
+        virtual void on_io_accept(int fd)
+        {
+            PDEBUG("[accept] new fd=%d", fd);
+            if (_process)
+                _process->process(fd);
+            else
+                ::close(fd);
+        }
+
         void set_process(PROCESS *p)
         {
             _process.reset(p);
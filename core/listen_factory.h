@@ -8,6 +8,7 @@
 #include "multi_protocol_factory.h"
 #include "base_net_thread.h"
 #include "factory_base.h"
+#include <linux/filter.h>
 
 // ListenFactory：实现 IFactory，可直接用于 server.set_business_factory()
 class ListenFactory : public IFactory {
@@ -58,14 +59,19 @@ public:
     }
 
     IFactory* inner_factory() const { return _biz_factory.get(); }
+    const std::string& ip() const { return _ip; }
+    unsigned short port() const { return _port; }
 
     // Initialize listen socket, attach to container/epoll, and return fd
+    // reuse_port=true 用于每个 worker 各自监听(SO_REUSEPORT)，此时监听 socket 只属于一个线程，
+    // 使用水平触发：单次 accept 达到上限后剩余连接下一轮 epoll 仍会上报
     static int init_listen(base_net_thread* owner_thread,
                            const std::string& ip, unsigned short port,
                            std::shared_ptr< listen_connect<listen_process> >& out_conn,
-                           listen_process*& out_proc)
+                           listen_process*& out_proc,
+                           bool reuse_port = false)
     {
-        out_conn.reset(new listen_connect<listen_process>(ip, port));
+        out_conn.reset(new listen_connect<listen_process>(ip, port, reuse_port));
         int fd = out_conn ? out_conn->get_sfd() : -1;
         if (fd < 0) {
             PDEBUG("[listen_factory] invalid listen fd for %s:%u", ip.c_str(), port);
@@ -77,12 +83,43 @@ public:
         out_conn->set_process(out_proc);
         // 注册到 epoll
         out_conn->set_net_container(owner_thread->get_net_container());
-        // 改为边沿触发，避免饥饿
-        out_conn->update_event(EPOLLIN | EPOLLERR | EPOLLHUP | EPOLLET);
+        if (reuse_port) {
+            out_proc->set_local_accept(true);
+            out_conn->update_event(EPOLLIN | EPOLLERR | EPOLLHUP);
+        } else {
+            // 改为边沿触发，避免饥饿
+            out_conn->update_event(EPOLLIN | EPOLLERR | EPOLLHUP | EPOLLET);
+        }
         PDEBUG("[listen] added listen_fd=%d to epoll", fd);
         return fd;
     }
 
+    // SO_ATTACH_REUSEPORT_CBPF：按收包 CPU 选择 reuseport 组内的 socket (cpu % group_size)，
+    // 配合 worker k 绑定到 CPU k，连接会落在处理其软中断的那个 CPU 上。
+    // 只需挂到组内任意一个 socket；内核不支持时返回 false，退化为默认的四元组 hash
+    static bool attach_cpu_steering(int listen_fd, uint32_t group_size)
+    {
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+        if (listen_fd < 0 || group_size == 0) return false;
+        struct sock_filter code[] = {
+            { BPF_LD  | BPF_W | BPF_ABS, 0, 0, (uint32_t)(SKF_AD_OFF + SKF_AD_CPU) },
+            { BPF_ALU | BPF_MOD | BPF_K, 0, 0, group_size },
+            { BPF_RET | BPF_A, 0, 0, 0 },
+        };
+        struct sock_fprog prog;
+        prog.len = sizeof(code) / sizeof(code[0]);
+        prog.filter = code;
+        if (setsockopt(listen_fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) < 0) {
+            PDEBUG("[listen_factory] SO_ATTACH_REUSEPORT_CBPF fail: %s", strError(errno).c_str());
+            return false;
+        }
+        return true;
+#else
+        (void)listen_fd; (void)group_size;
+        return false;
+#endif
+    }
+
 private:
     std::string _ip; unsigned short _port{0};
     int _listen_fd{-1};
@@ -20,6 +20,15 @@ class listen_process
 
         void process(int fd)
         {
+            // SO_REUSEPORT 模式：本线程就是 worker，直接交给本线程的工厂，不经过 put_obj_msg
+            if (_local_accept && _listen_thread) {
+                auto msg = std::make_shared<content_msg>();
+                msg->fd = fd;
+                auto ng = std::static_pointer_cast<normal_msg>(msg);
+                ng->_msg_op = NORMAL_MSG_CONNECT;
+                _listen_thread->handle_msg(ng);
+                return;
+            }
             // 优先使用监听线程维护的线程池进行分发
             if (_biz_factory && _listen_thread && _listen_thread->worker_count() > 0) {
                 auto msg = std::make_shared<content_msg>();
@@ -80,12 +89,16 @@ class listen_process
         // 下发业务工厂（用于 accept 后的轮询分发）
         void set_business_factory(IFactory* f) { _biz_factory = f; }
 
+        // 本线程 accept 的连接留在本线程处理
+        void set_local_accept(bool on) { _local_accept = on; }
+
     protected:	
         std::weak_ptr<base_net_obj> _p_connect;
         base_net_thread * _listen_thread;
         std::vector<uint32_t> _worker_thd_vec;
         std::atomic<size_t> _next{0};
         IFactory* _biz_factory{nullptr};
+        bool _local_accept{false};
 };
 
 #endif
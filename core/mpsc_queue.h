@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace myframe {
+
+// 侵入式无锁 MPSC 队列 (Vyukov)
+// push 可在任意线程并发调用(一次 exchange + 一次 store), pop/empty 只能由唯一的消费线程调用
+struct mpsc_node
+{
+    std::atomic<mpsc_node*> _mpsc_next{nullptr};
+};
+
+class mpsc_queue
+{
+    public:
+        mpsc_queue() : _head(&_stub), _tail(&_stub) {}
+
+        mpsc_queue(const mpsc_queue&) = delete;
+        mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+        void push(mpsc_node* node)
+        {
+            node->_mpsc_next.store(nullptr, std::memory_order_relaxed);
+            mpsc_node* prev = _head.exchange(node, std::memory_order_seq_cst);
+            prev->_mpsc_next.store(node, std::memory_order_release);
+        }
+
+        // 返回 nullptr 表示为空, 或某个生产者正处于 exchange 与链接之间(稍后可再取到)
+        mpsc_node* pop()
+        {
+            mpsc_node* tail = _tail;
+            mpsc_node* next = tail->_mpsc_next.load(std::memory_order_acquire);
+            if (tail == &_stub) {
+                if (!next)
+                    return nullptr;
+                _tail = next;
+                tail = next;
+                next = next->_mpsc_next.load(std::memory_order_acquire);
+            }
+
+            if (next) {
+                _tail = next;
+                return tail;
+            }
+
+            if (tail != _head.load(std::memory_order_acquire))
+                return nullptr;
+
+            push(&_stub);
+            next = tail->_mpsc_next.load(std::memory_order_acquire);
+            if (next) {
+                _tail = next;
+                return tail;
+            }
+
+            return nullptr;
+        }
+
+        bool empty() const
+        {
+            return _tail == &_stub && _head.load(std::memory_order_seq_cst) == &_stub;
+        }
+
+    private:
+        alignas(64) std::atomic<mpsc_node*> _head;
+        alignas(64) mpsc_node* _tail;
+        mpsc_node _stub;
+};
+
+} // namespace myframe
@@ -36,7 +36,8 @@ void MultiProtocolFactory::handle_thread_msg(std::shared_ptr<normal_msg>& msg)
     int fd = cm->fd;
     PDEBUG("[factory] creating connection for fd=%d", fd);
 
-    std::shared_ptr< base_connect<base_data_process> > conn(new base_connect<base_data_process>(fd));
+    std::shared_ptr< base_connect<base_data_process> > conn =
+        myframe::make_pooled_shared< base_connect<base_data_process> >(fd);
     std::unique_ptr<protocol_detect_process> detector(new protocol_detect_process(conn, _app_handler));
 
     if (_mode == Mode::Auto) {
@@ -0,0 +1,131 @@
+#ifndef __OBJ_ID_TABLE_H__
+#define __OBJ_ID_TABLE_H__
+
+#include "common_exception.h"
+#include <memory>
+#include <vector>
+
+// 按 id 直接下标的对象表, 取代 unordered_map<uint32_t, shared_ptr>
+// id = (代数 << SLOT_BITS) | 槽位, 查找只是一次数组访问加代数比较, 不做哈希也不会 rehash
+// 空闲槽位先进先出复用, 同一个槽位要复用 GEN_MAX 次之后 id 才会重复, 发给已关闭连接的旧消息不会投错
+// 代数从 1 开始, id 一定大于 OBJ_ID_BEGIN, 不会和 OBJ_ID_THREAD/OBJ_ID_DOMAIN 冲突
+template <class T>
+class obj_id_table
+{
+    public:
+        enum { SLOT_BITS = 20, MAX_SLOTS = 1 << SLOT_BITS, GEN_MAX = (1 << (32 - SLOT_BITS)) - 1 };
+
+        obj_id_table() : _free_head(NIL), _free_tail(NIL), _size(0) {}
+
+        // 放入对象并返回分配的 id
+        uint32_t insert(const std::shared_ptr<T> & obj)
+        {
+            uint32_t idx = _free_head;
+            if (idx != NIL)
+            {
+                _free_head = _slots[idx].next_free;
+                if (_free_head == NIL)
+                    _free_tail = NIL;
+            }
+            else
+            {
+                if (_slots.size() >= (size_t)MAX_SLOTS)
+                {
+                    THROW_COMMON_EXCEPT("obj_id_table full, slots: " << _slots.size());
+                }
+                idx = (uint32_t)_slots.size();
+                _slots.push_back(slot());
+            }
+
+            slot & s = _slots[idx];
+            s.obj = obj;
+            s.next_free = NIL;
+            _size++;
+            return (s.gen << SLOT_BITS) | idx;
+        }
+
+        T * get(uint32_t id) const
+        {
+            uint32_t idx = id & (MAX_SLOTS - 1);
+            if (idx >= _slots.size())
+                return NULL;
+            const slot & s = _slots[idx];
+            if (s.gen != (id >> SLOT_BITS) || !s.obj)
+                return NULL;
+            return s.obj.get();
+        }
+
+        std::shared_ptr<T> find(uint32_t id) const
+        {
+            uint32_t idx = id & (MAX_SLOTS - 1);
+            if (idx >= _slots.size())
+                return std::shared_ptr<T>();
+            const slot & s = _slots[idx];
+            if (s.gen != (id >> SLOT_BITS))
+                return std::shared_ptr<T>();
+            return s.obj;
+        }
+
+        // 移出对象(由调用方决定何时释放), 槽位换代后挂到空闲表尾
+        std::shared_ptr<T> erase(uint32_t id)
+        {
+            std::shared_ptr<T> obj;
+            uint32_t idx = id & (MAX_SLOTS - 1);
+            if (idx >= _slots.size())
+                return obj;
+            slot & s = _slots[idx];
+            if (s.gen != (id >> SLOT_BITS) || !s.obj)
+                return obj;
+
+            obj.swap(s.obj);
+            s.gen = s.gen >= (uint32_t)GEN_MAX ? 1 : s.gen + 1;
+            s.next_free = NIL;
+            if (_free_tail != NIL)
+                _slots[_free_tail].next_free = idx;
+            else
+                _free_head = idx;
+            _free_tail = idx;
+            _size--;
+            return obj;
+        }
+
+        template <class F>
+        void for_each(F f) const
+        {
+            // 回调里可能 erase/insert, 按下标遍历并持有一份引用
+            for (size_t i = 0; i < _slots.size(); i++)
+            {
+                std::shared_ptr<T> obj = _slots[i].obj;
+                if (obj)
+                    f(obj);
+            }
+        }
+
+        void clear()
+        {
+            // 先整体摘下再析构, 对象析构时再访问本表看到的是空表
+            std::vector<slot> tmp;
+            tmp.swap(_slots);
+            _free_head = _free_tail = NIL;
+            _size = 0;
+        }
+
+        uint32_t size() const { return _size; }
+
+    private:
+        enum : uint32_t { NIL = 0xFFFFFFFFu };
+
+        struct slot
+        {
+            std::shared_ptr<T> obj;
+            uint32_t gen{1};
+            uint32_t next_free{NIL};
+        };
+
+        std::vector<slot> _slots;
+        uint32_t _free_head;
+        uint32_t _free_tail;
+        uint32_t _size;
+};
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef __OBJ_POOL_H__
+#define __OBJ_POOL_H__
+
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace myframe {
+
+// 连接对象/协议处理对象的线程内空闲块池
+// - 按 64 字节分级, 4KB 以上直接走 malloc
+// - 每个块单独 malloc, 任何线程释放都可以放进自己的空闲表, 线程退出时统一 free
+// - 短连接风暴(如发布后大量重连)时 accept 直接复用刚关闭连接的内存
+class obj_pool
+{
+    public:
+        enum { ALIGN = 64, MAX_SIZE = 4096, CLASS_NUM = MAX_SIZE / ALIGN };
+
+        static void * alloc(size_t n)
+        {
+            if (n && n <= MAX_SIZE)
+            {
+                if (!exited())
+                {
+                    std::vector<void *> & free_list = holder().lists[(n - 1) / ALIGN];
+                    if (!free_list.empty())
+                    {
+                        void * p = free_list.back();
+                        free_list.pop_back();
+                        return p;
+                    }
+                }
+                // 按级别上限分配, 块回收后可以给同级别的任意大小复用
+                n = ((n - 1) / ALIGN + 1) * ALIGN;
+            }
+            void * p = ::malloc(n ? n : 1);
+            if (!p)
+                throw std::bad_alloc();
+            return p;
+        }
+
+        static void free(void * p, size_t n)
+        {
+            if (!p)
+                return;
+            if (n && n <= MAX_SIZE && !exited())
+            {
+                std::vector<void *> & free_list = holder().lists[(n - 1) / ALIGN];
+                if (free_list.size() < capacity())
+                {
+                    free_list.push_back(p);
+                    return;
+                }
+            }
+            ::free(p);
+        }
+
+        // 每个大小级别最多缓存的空闲块数: MYFRAME_OBJPOOL_CAP(0 关闭, 默认 256, 上限 65536)
+        static size_t capacity() { return cap_ref(); }
+
+        // 覆盖环境变量; 已缓存的块不受影响
+        static void set_capacity(size_t cap) { cap_ref() = cap > 65536 ? 65536 : cap; }
+
+        // 当前线程缓存的空闲块数(基准测试用)
+        static size_t cached()
+        {
+            size_t n = 0;
+            for (auto & l : holder().lists)
+                n += l.size();
+            return n;
+        }
+
+    private:
+        static size_t & cap_ref()
+        {
+            static size_t cap = []{
+                long v = 256;
+                const char * e = std::getenv("MYFRAME_OBJPOOL_CAP");
+                if (e && *e)
+                    v = std::atol(e);
+                else
+                {
+                    const char * preset = std::getenv("MYFRAME_PERF_PRESET");
+                    if (preset && (strcmp(preset, "0") != 0 && strcasecmp(preset, "false") != 0))
+                        v = 1024;
+                }
+                if (v < 0) v = 0;
+                if (v > 65536) v = 65536;
+                return (size_t)v;
+            }();
+            return cap;
+        }
+
+        struct pool_holder
+        {
+            std::vector<void *> lists[CLASS_NUM];
+            ~pool_holder()
+            {
+                exited() = true;
+                for (auto & l : lists)
+                    for (auto p : l)
+                        ::free(p);
+            }
+        };
+
+        // 线程退出时池已析构, 之后(如全局对象析构)释放的对象直接 free
+        static bool & exited()
+        {
+            thread_local bool flag = false;
+            return flag;
+        }
+
+        static pool_holder & holder()
+        {
+            thread_local pool_holder h;
+            return h;
+        }
+};
+
+// 给 std::allocate_shared 用: 对象和 shared_ptr 控制块合成一块从 obj_pool 分配
+template <class T>
+struct pool_allocator
+{
+    typedef T value_type;
+
+    pool_allocator() noexcept {}
+    template <class U> pool_allocator(const pool_allocator<U> &) noexcept {}
+
+    T * allocate(size_t n) { return static_cast<T *>(obj_pool::alloc(n * sizeof(T))); }
+    void deallocate(T * p, size_t n) noexcept { obj_pool::free(p, n * sizeof(T)); }
+
+    template <class U> bool operator==(const pool_allocator<U> &) const noexcept { return true; }
+    template <class U> bool operator!=(const pool_allocator<U> &) const noexcept { return false; }
+};
+
+template <class T, class... Args>
+inline std::shared_ptr<T> make_pooled_shared(Args &&... args)
+{
+    return std::allocate_shared<T>(pool_allocator<T>(), std::forward<Args>(args)...);
+}
+
+} // namespace myframe
+
+// 类内 operator new/delete: 派生类对象(虚析构)按实际大小回收到 obj_pool
+#define MYFRAME_POOLED_NEW \
+    static void * operator new(size_t n) { return myframe::obj_pool::alloc(n); } \
+    static void operator delete(void * p, size_t n) { myframe::obj_pool::free(p, n); }
+
+#endif
@@ -115,6 +115,10 @@ class out_connect:public base_connect<PROCESS>
                     PDEBUG("connect ok %s:%d", _ip.c_str(), _port);
                     _status = CONNECT_OK;
                     connect_ok_process();
+                    // 边缘触发下与连接完成一起到达的 EPOLLIN 不会再报, 下一轮补一次读写
+                    if (this->edge_triggered()) {
+                        this->request_tick();
+                    }
                 } else {
                     THROW_COMMON_EXCEPT(std::string("connect failed after epoll: ") + strError(err));
                 }
@@ -143,6 +147,12 @@ class out_connect:public base_connect<PROCESS>
             }
         }
 
+        // 连接建立前由 poll 等待可写
+        virtual int io_caps() const
+        {
+            return _status == CONNECT_OK ? base_connect<PROCESS>::io_caps() : 0;
+        }
+
         virtual void connect_ok_process()
         {
             PDEBUG("CONNECT OK");
@@ -3,6 +3,9 @@
 #include "../http_base_process.h"
 #include "../common_def.h"
 #include "../string_pool.h"
+#include "../http_response_head.h"
+#include "../http_compress.h"
+#include "../http_response_cache.h"
 
 namespace myframe {
 
@@ -43,6 +46,7 @@ HttpApplicationDataProcess::HttpApplicationDataProcess(
     IApplicationHandler* handler)
     : http_base_data_process(process)
     , _handler(handler)
+    , _content_length(-1)
     , _body_sent(false)
 {
     PDEBUG("[HttpApplicationDataProcess] Created");
@@ -52,22 +56,65 @@ HttpApplicationDataProcess::~HttpApplicationDataProcess() {
     PDEBUG("[HttpApplicationDataProcess] Destroyed");
 }
 
-void HttpApplicationDataProcess::msg_recv_finish() {
-    PDEBUG("[HttpApplicationDataProcess] msg_recv_finish called");
-
-    // 构造 HttpRequest
-    HttpRequest req;
-
-    // 获取请求头信息
+void HttpApplicationDataProcess::build_request(HttpRequest& req) {
     auto& req_head = _base_process->get_req_head_para();
     req.method = req_head._method;
     req.url = req_head._url_path;
     req.version = req_head._version;
-    req.headers = req_head._headers;
+    req.headers = req_head.headers();
+}
+
+void HttpApplicationDataProcess::header_recv_finish() {
+    // 带 body 的请求先问业务要不要流式接收
+    if (!_handler || !_base_process->has_request_body()) {
+        return;
+    }
+    HttpRequest req;
+    build_request(req);
+    std::shared_ptr<HttpBodySink> sink;
+    {
+        detail::HandlerContextScope scope(this);
+        sink = _handler->on_body_begin(req);
+    }
+    if (!sink) {
+        return;
+    }
+    _stream_req = std::move(req);
+    http_base_process* process = _base_process;
+    _sink.reset(std::move(sink), [process]() { process->resume_body(); });
+    PDEBUG("[HttpApplicationDataProcess] streaming body %s %s",
+           _stream_req.method.c_str(), _stream_req.url.c_str());
+}
+
+void HttpApplicationDataProcess::msg_recv_finish() {
+    PDEBUG("[HttpApplicationDataProcess] msg_recv_finish called");
+
+    // 响应缓存命中(或挂起等别的线程的结果)时不调 handler
+    if (!_sink && _cache.lookup(_base_process, this) != http_cache_session::PASS) {
+        if (_cache.need_refresh()) {
+            HttpRequest req;
+            build_request(req);
+            _cache.refresh(this, std::move(req),
+                           _base_process->get_req_head_para().header_view(HDR_ACCEPT_ENCODING));
+        }
+        return;
+    }
+    respond();
+}
 
-    // 获取请求体（move 后 swap 释放内存）
-    req.body = std::move(_recv_body);
-    std::string().swap(_recv_body);
+void HttpApplicationDataProcess::respond() {
+    // 构造 HttpRequest
+    HttpRequest req;
+    if (_sink) {
+        req = std::move(_stream_req);
+    } else {
+        // 获取请求头信息
+        build_request(req);
+
+        // 获取请求体（move 后 swap 释放内存）
+        req.body = std::move(_recv_body);
+        std::string().swap(_recv_body);
+    }
 
     PDEBUG("[HttpApplicationDataProcess] Request: %s %s",
            req.method.c_str(), req.url.c_str());
@@ -78,13 +125,26 @@ void HttpApplicationDataProcess::msg_recv_finish() {
     try {
         // 调用用户处理器
         detail::HandlerContextScope scope(this);
-        _handler->on_http(req, res);
+        if (_sink) {
+            _sink.get()->on_body_end(req, res);
+        } else {
+            _handler->on_http(req, res);
+        }
+        _sink.reset();
+
+        // 客户端接受时压缩(gzip/deflate)
+        http_compress_response(_base_process->get_req_head_para().header_view(HDR_ACCEPT_ENCODING), res);
+        // 业务要求缓存的响应存进缓存, 这次也从缓存发出
+        if (_cache.store(_base_process, res)) {
+            return;
+        }
 
         PDEBUG("[HttpApplicationDataProcess] Response: %d %s (body size=%zu)",
-               res.status, res.reason.c_str(), res.body.size());
+               res.status, res.reason.c_str(), res.body_view().size());
 
         // 保存响应体
         _response_body = res.body;
+        _response_shared = std::move(res.shared_body);
         _body_sent = false;
 
         // 设置响应头参数
@@ -93,26 +153,30 @@ void HttpApplicationDataProcess::msg_recv_finish() {
         res_head._response_str = res.reason;
         res_head._headers = res.headers;
 
-        // 自动设置 Content-Length
-        if (res_head._headers.find("Content-Length") == res_head._headers.end()) {
-            char buf[32];
-            snprintf(buf, sizeof(buf), "%zu", _response_body.size());
-            res_head._headers["Content-Length"] = buf;
+        // Content-Length 由 get_send_head 写头时补上(业务已设置的不覆盖)
+        _content_length = (int64_t)(_response_shared ? _response_shared->size() : _response_body.size());
+        if (res.stream) {
+            // 拉取式响应体: 连接可写时在 get_send_body 里取
+            bool chunked = _base_process->prepare_stream_headers(res_head._headers);
+            _pump.reset(std::move(res.stream), chunked, [this]() { resume_send_body(); });
+            _content_length = -1;
         }
 
-        // 默认设置 Connection: close（简单实现）
-        if (res_head._headers.find("Connection") == res_head._headers.end()) {
-            res_head._headers["Connection"] = "close";
-        }
+        // 默认保持连接; 客户端/配置不允许时为 close
+        _base_process->fill_connection_header(res_head._headers);
 
-        // 触发发送流程
-        _base_process->change_http_status(SEND_HEAD);
+        // 发送由 http_res_process::recv_finish 统一触发, 流水线请求的响应合并发出
 
     } catch (const std::exception& e) {
         PDEBUG("[HttpApplicationDataProcess] Exception: %s", e.what());
 
+        _cache.abandon();
+        _sink.reset();
+        _pump.reset();
+
         // 发生异常，返回500错误
         _response_body = "Internal Server Error";
+        _response_shared.reset();
         _body_sent = false;
 
         auto& res_head = _base_process->get_res_head_para();
@@ -120,40 +184,23 @@ void HttpApplicationDataProcess::msg_recv_finish() {
         res_head._response_str = "Internal Server Error";
         res_head._headers.clear();
         res_head._headers["Content-Type"] = "text/plain";
-        res_head._headers["Content-Length"] = "21"; // "Internal Server Error" length
-        res_head._headers["Connection"] = "close";
-
-        _base_process->change_http_status(SEND_HEAD);
+        _content_length = (int64_t)_response_body.size();
+        _base_process->fill_connection_header(res_head._headers);
     }
 }
 
 std::string* HttpApplicationDataProcess::get_send_head() {
     PDEBUG("[HttpApplicationDataProcess] get_send_head called");
 
-    auto& res_head = _base_process->get_res_head_para();
-
-    // 从字符串池分配
-    std::string* send_head = myframe::string_acquire();
-
-    // 状态行: HTTP/1.1 200 OK\r\n
-    *send_head += "HTTP/1.1 ";
-    char status_buf[16];
-    snprintf(status_buf, sizeof(status_buf), "%d", res_head._response_code);
-    *send_head += status_buf;
-    *send_head += " ";
-    *send_head += res_head._response_str;
-    *send_head += "\r\n";
-
-    // 头部字段
-    for (const auto& kv : res_head._headers) {
-        *send_head += kv.first;
-        *send_head += ": ";
-        *send_head += kv.second;
-        *send_head += "\r\n";
+    if (std::string* head = _cache.take_head()) {
+        return head;
     }
 
-    // 空行
-    *send_head += "\r\n";
+    auto& res_head = _base_process->get_res_head_para();
+
+    // 预拼的状态行 + 线程缓存的 Date, 一次算好长度写进池化缓冲
+    std::string* send_head = myframe::http_response_head(res_head._response_code, res_head._response_str,
+                                                         res_head._headers, _content_length);
 
     PDEBUG("[HttpApplicationDataProcess] Response header size=%zu", send_head->size());
 
@@ -162,14 +209,43 @@ std::string* HttpApplicationDataProcess::get_send_head() {
 
 size_t HttpApplicationDataProcess::process_recv_body(const char* buf, size_t len, int& result) {
     PDEBUG("[HttpApplicationDataProcess] process_recv_body len=%zu", len);
-    _recv_body.append(buf, len);
     result = 0;
+    if (_sink) {
+        if (!len) {
+            return 0;
+        }
+        size_t took;
+        {
+            detail::HandlerContextScope scope(this);
+            took = _sink.get()->on_body_chunk(buf, len);
+        }
+        if (took > len) {
+            took = len;
+        }
+        // 没收下的留在接收缓冲, sink 调 resume() 后再交付
+        if (took < len) {
+            _base_process->pause_body();
+        }
+        return took;
+    }
+    _recv_body.append(buf, len);
     return len;
 }
 
 std::string* HttpApplicationDataProcess::get_send_body(int& result) {
     PDEBUG("[HttpApplicationDataProcess] get_send_body called, body_sent=%d", _body_sent);
 
+    if (_pump) {
+        bool done;
+        std::string* p;
+        {
+            detail::HandlerContextScope scope(this);
+            p = _pump.pull(done);
+        }
+        result = done ? 1 : 0;
+        return p;
+    }
+
     if (_body_sent) {
         result = 1;  // 结束发送
         return nullptr;
@@ -192,4 +268,44 @@ std::string* HttpApplicationDataProcess::get_send_body(int& result) {
     return send_body;
 }
 
+bool HttpApplicationDataProcess::get_send_body_shared(myframe::shared_buffer& buf) {
+    if (_cache.take_body(buf)) {
+        return true;
+    }
+    if (!_response_shared) {
+        return false;
+    }
+    buf = std::move(_response_shared);
+    _body_sent = true;
+    return true;
+}
+
+void HttpApplicationDataProcess::handle_msg(std::shared_ptr<normal_msg>& msg) {
+    if (msg && msg->_msg_op == HTTP_CACHE_FILL_MSG_OP) {
+        // 别的线程取完了, 再查一次; 还是没有就自己调 handler
+        if (!async_response_pending()) {
+            return;
+        }
+        if (_cache.lookup(_base_process, this, false) == http_cache_session::PASS) {
+            respond();
+        }
+        complete_async_response();
+        return;
+    }
+    if (http_cache_session::handle_refresh(msg, _handler, this)) {
+        return;
+    }
+    if (_handler) {
+        detail::HandlerContextScope scope(this);
+        _handler->handle_thread_msg(msg);
+    }
+}
+
+void HttpApplicationDataProcess::handle_timeout(std::shared_ptr<timer_msg>& t_msg) {
+    if (_handler) {
+        detail::HandlerContextScope scope(this);
+        _handler->handle_timeout(t_msg);
+    }
+}
+
 } // namespace myframe
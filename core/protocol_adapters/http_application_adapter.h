@@ -6,6 +6,8 @@
 #include "../app_handler_v2.h"
 #include "../http_res_process.h"
 #include "../http_base_data_process.h"
+#include "../http_body_sink.h"
+#include "../http_response_cache.h"
 #include <memory>
 
 namespace myframe {
@@ -49,15 +51,31 @@ public:
     virtual ~HttpApplicationDataProcess();
 
     // http_base_data_process 接口实现
+    virtual void header_recv_finish() override;
     virtual void msg_recv_finish() override;
     virtual size_t process_recv_body(const char* buf, size_t len, int& result) override;
     virtual std::string* get_send_head() override;
     virtual std::string* get_send_body(int& result) override;
+    virtual bool get_send_body_shared(myframe::shared_buffer& buf) override;
+    virtual bool streaming_response() const override { return (bool)_pump; }
+
+    // 定时器/线程消息转给 handler(流式请求体在这里调 HttpBodySink::resume)
+    virtual void handle_msg(std::shared_ptr<normal_msg>& msg) override;
+    virtual void handle_timeout(std::shared_ptr<timer_msg>& t_msg) override;
 
 private:
+    void build_request(HttpRequest& req);
+    void respond();
+
     IApplicationHandler* _handler;
     std::string _recv_body;      // 保存请求体内容
+    body_sink_holder _sink;      // 业务选择流式接收时的 sink
+    HttpRequest _stream_req;     // 流式接收时头部收完组好的请求
     std::string _response_body;  // 保存响应体内容
+    shared_buffer _response_shared; // 响应体是共享缓冲区时(如压缩缓存命中)按引用发出
+    body_source_pump _pump;      // 业务给了 HttpBodySource 时的拉取式响应体
+    int64_t _content_length;     // 写头时补的 Content-Length, 流式响应为 -1
+    http_cache_session _cache;   // 响应缓存的命中/存入状态
     bool _body_sent;
 };
 
@@ -2,6 +2,7 @@
 #include "http_context_adapter.h"
 #include "../base_net_obj.h"
 #include "../string_pool.h"
+#include "../http_compress.h"
 #include "../common_obj_container.h"
 #include "../base_net_thread.h"
 #include <algorithm>
@@ -16,7 +17,7 @@ namespace myframe {
 // ============================================================================
 
 HttpContextImpl::HttpContextImpl(http_base_process* process, std::shared_ptr<base_net_obj> conn)
-    : _process(process), _conn(conn), _streaming_enabled(false) {
+    : _process(process), _conn(conn) {
     // ��ʼ��������Ϣ
     if (conn) {
         // ע��base_net_obj ��ǰ���ṩ IP/�˿ڷ��ʽӿ�
@@ -83,23 +84,20 @@ void HttpContextImpl::complete_async_response() {
 }
 
 void HttpContextImpl::enable_streaming() {
-    _streaming_enabled = true;
+    // 响应体改为拉取: stream_write 写进缓冲, 连接可写时取走
+    _stream = std::make_shared<HttpPushBodySource>();
+    _response.stream = _stream;
 }
 
 size_t HttpContextImpl::stream_write(const void* data, size_t len) {
-    if (!_streaming_enabled || !_conn) return 0;
-
-    // ����ʽģʽ�£�ֱ��д������
-    if (data && len > 0) {
-        auto buf = string_acquire();
-        if (buf) {
-            buf->assign(static_cast<const char*>(data), len);
-            // TODO: ʵ���첽����
-            // _conn->async_send(buf);
-            string_release(buf);
-        }
+    if (!_stream || !data) return 0;
+    return _stream->write(static_cast<const char*>(data), len);
+}
+
+void HttpContextImpl::stream_end() {
+    if (_stream) {
+        _stream->end();
     }
-    return len;
 }
 
 void HttpContextImpl::upgrade_to_websocket() {
@@ -207,12 +205,23 @@ std::string* HttpContextDataProcess::get_send_head() {
     
     // ������Ӧͷ
     http_res_head_para& res = _base_process->get_res_head_para();
-    std::string* head = new std::string();
+    std::string* head = myframe::string_acquire();
     res.to_head_str(head);
     return head;
 }
 
 std::string* HttpContextDataProcess::get_send_body(int& result) {
+    if (_pump) {
+        bool done;
+        std::string* p;
+        {
+            detail::HandlerContextScope scope(this);
+            p = _pump.pull(done);
+        }
+        result = done ? 1 : 0;
+        return p;
+    }
+
     result = 1;
     if (_send_body.empty()) {
         return NULL;
@@ -223,6 +232,14 @@ std::string* HttpContextDataProcess::get_send_body(int& result) {
     return body;
 }
 
+bool HttpContextDataProcess::get_send_body_shared(myframe::shared_buffer& buf) {
+    if (!_send_shared) {
+        return false;
+    }
+    buf = std::move(_send_shared);
+    return true;
+}
+
 void HttpContextDataProcess::msg_recv_finish() {
     if (!_handler || !_context) return;
 
@@ -234,7 +251,7 @@ void HttpContextDataProcess::msg_recv_finish() {
         ctx_req.method = req_head._method;
         ctx_req.url = req_head._url_path;
         ctx_req.version = req_head._version;
-        ctx_req.headers = req_head._headers;
+        ctx_req.headers = req_head.headers();
         ctx_req.body = _recv_body;  // ����������
 
         // ���ô�����
@@ -244,20 +261,10 @@ void HttpContextDataProcess::msg_recv_finish() {
         // ������Ӧ���䵽 res_head
         auto& res_head = _base_process->get_res_head_para();
         
-        const auto& ctx_res = _context->response();
-        res_head._response_code = ctx_res.status;
-        res_head._response_str = ctx_res.reason;
-        res_head._headers = ctx_res.headers;
+        auto& ctx_res = _context->mutable_response();
 
         // ������Ӧ�嵽 _send_body
-        _send_body = ctx_res.body;
-        
-        // �Զ����� Content-Length
-        if (!_send_body.empty()) {
-            res_head._headers["Content-Length"] = std::to_string(_send_body.size());
-        } else {
-            res_head._headers["Content-Length"] = "0";
-        }
+        prepare_body(ctx_res, res_head);
 
         // ȷ���� Connection ͷ
         if (res_head._headers.find("Connection") == res_head._headers.end()) {
@@ -284,26 +291,38 @@ void HttpContextDataProcess::msg_recv_finish() {
     }
 }
 
+void HttpContextDataProcess::prepare_body(HttpResponse& res, http_res_head_para& res_head) {
+    // 客户端接受时压缩(gzip/deflate), 会改 body 和头部, 所以在拷到 res_head 之前做
+    http_compress_response(_base_process->get_req_head_para().header_view(HDR_ACCEPT_ENCODING), res);
+
+    res_head._response_code = res.status;
+    res_head._response_str = res.reason;
+    res_head._headers = res.headers;
+
+    if (res.stream) {
+        // enable_streaming 的响应: 不带 Content-Length, 连接可写时拉取
+        _send_body.clear();
+        _send_shared.reset();
+        bool chunked = _base_process->prepare_stream_headers(res_head._headers);
+        _pump.reset(std::move(res.stream), chunked, [this]() { resume_send_body(); });
+        return;
+    }
+
+    _send_body = res.body;
+    _send_shared = res.shared_body;
+    res_head._headers["Content-Length"] = std::to_string(res.body_view().size());
+}
+
 void HttpContextDataProcess::complete_async_response() {
     // 同步异步回调中设置的响应数据到发送缓冲区
     if (_context) {
         auto& res_head = _base_process->get_res_head_para();
 
         // 更新响应状态和头
-        const auto& ctx_res = _context->response();
-        res_head._response_code = ctx_res.status;
-        res_head._response_str = ctx_res.reason;
-        res_head._headers = ctx_res.headers;
+        auto& ctx_res = _context->mutable_response();
 
         // 同步响应体
-        _send_body = ctx_res.body;
-
-        // 自动设置 Content-Length
-        if (!_send_body.empty()) {
-            res_head._headers["Content-Length"] = std::to_string(_send_body.size());
-        } else {
-            res_head._headers["Content-Length"] = "0";
-        }
+        prepare_body(ctx_res, res_head);
 
         PDEBUG("[HttpContextDataProcess] Async response completed: status=%d, body_size=%zu",
                res_head._response_code, _send_body.size());
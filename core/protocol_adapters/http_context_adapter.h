@@ -6,6 +6,7 @@
 #include "../protocol_context.h"
 #include "../http_res_process.h"
 #include "../http_base_data_process.h"
+#include "../http_body_sink.h"
 #include <memory>
 #include <map>
 #include <thread>
@@ -33,7 +34,9 @@ public:
     void async_response(std::function<void()> fn) override;
     void complete_async_response() override;
     void enable_streaming() override;
+    // 缓冲满(HttpPushBodySource 上限)时少收, 返回收下的字节数, 剩下的稍后(如定时器里)再写
     size_t stream_write(const void* data, size_t len) override;
+    void stream_end() override;
     void upgrade_to_websocket() override;
 
     void close() override;
@@ -64,7 +67,7 @@ private:
     HttpResponse _response;
     std::map<std::string, void*> _user_data;
     ConnectionInfo _conn_info;
-    bool _streaming_enabled;
+    std::shared_ptr<HttpPushBodySource> _stream;
 };
 
 // ============================================================================
@@ -106,15 +109,22 @@ public:
     size_t process_recv_body(const char* buf, size_t len, int& result) override;
     std::string* get_send_head() override;
     std::string* get_send_body(int& result) override;
+    bool get_send_body_shared(myframe::shared_buffer& buf) override;
     void msg_recv_finish() override;
     void complete_async_response() override;
     void handle_timeout(std::shared_ptr<::timer_msg>& t_msg) override;
     void handle_msg(std::shared_ptr<::normal_msg>& msg) override;
+    bool streaming_response() const override { return (bool)_pump; }
 
 private:
+    // 按响应填 Content-Length, 或接管 enable_streaming 的 source 改为拉取发送
+    void prepare_body(HttpResponse& res, http_res_head_para& res_head);
+
     IProtocolHandler* _handler;
     std::shared_ptr<HttpContextImpl> _context;
     std::string _recv_body;   // �洢������
+    body_source_pump _pump;
+    shared_buffer _send_shared; // 响应体是共享缓冲区时(如压缩缓存命中)按引用发出
     std::string _send_body;   // �洢��Ӧ��
 };
 
@@ -53,6 +53,9 @@ public:
     // ��ʽд������
     virtual size_t stream_write(const void* data, size_t len) = 0;
 
+    // 流式响应结束, 缓冲里剩下的数据发完后结束响应; 之后 stream_write 不再接收
+    virtual void stream_end() = 0;
+
     // Э���������� HTTP ������ WebSocket��
     virtual void upgrade_to_websocket() = 0;
 
@@ -46,6 +46,7 @@ size_t protocol_detect_process::process_recv_buf(const char* buf, size_t buf_len
         IProtocolProbe* probe = _probes[i].get();
         if (probe->match(buf, buf_len)) {
             _protocol_detected = true;
+            if (_timer_id) { cancel_timer(_timer_id); _timer_id = 0; }
 
             base_connect<base_data_process>* holder = dynamic_cast< base_connect<base_data_process>* >(get_base_net().get());
             if (holder) {
@@ -68,10 +69,9 @@ size_t protocol_detect_process::process_recv_buf(const char* buf, size_t buf_len
 
                 holder->set_process(next.release());
 
-                // 让新流程预处理这批数据，但按探测缓冲长度告知上层擦除
+                // 交给新流程处理, 按它实际消费的长度告知上层; 报文头没收全时剩下的留在接收缓冲
                 if (holder->process()) {
-                    (void)holder->process()->process_recv_buf(buf, buf_len);
-                    return buf_len;
+                    return holder->process()->process_recv_buf(buf, buf_len);
                 }
             }
             return 0;
@@ -28,7 +28,8 @@ ProtocolDetector::~ProtocolDetector() {
 bool ProtocolDetector::handoff_to_protocol(const UnifiedProtocolFactory::ProtocolEntry& proto,
                                            base_connect<base_data_process>* holder,
                                            const char* data,
-                                           size_t len)
+                                           size_t len,
+                                           size_t* consumed)
 {
     std::unique_ptr<::base_data_process> next = proto.create(get_base_net());
     if (!next) {
@@ -36,6 +37,12 @@ bool ProtocolDetector::handoff_to_protocol(const UnifiedProtocolFactory::Protoco
         return false;
     }
 
+    // 探测已完成, 撤销探测超时定时器(NONE_DATA 类型, 触发会直接关闭连接)
+    if (_timer_id) {
+        cancel_timer(_timer_id);
+        _timer_id = 0;
+    }
+
     auto net = get_base_net();
     if (net) {
         net->set_protocol_tag(proto.name, proto.terminal);
@@ -47,8 +54,7 @@ bool ProtocolDetector::handoff_to_protocol(const UnifiedProtocolFactory::Protoco
     holder->set_process(raw);
     // 'this' 已被释放 —— 只能操作局部变量和 raw 指针
     if (len > 0) {
-        size_t consumed = raw->process_recv_buf(data, len);
-        (void)consumed;
+        *consumed = raw->process_recv_buf(data, len);
     }
     // 不要写 _detected = true; （use-after-free！）
     return true;
@@ -81,50 +87,29 @@ size_t ProtocolDetector::process_recv_buf(const char* buf, size_t len) {
         return len;
     }
 
-    // Try detection on incoming data directly before buffering.
-    // This avoids rejecting large payloads (e.g. HTTP POST with body > 4KB)
-    // that can be identified from the first few bytes.
-    if (_buffer.empty()) {
-        for (const auto& proto : _protocols) {
-            if (proto.detect(buf, len)) {
-                bool ok = handoff_to_protocol(proto, holder, buf, len);
-                if (!ok) {
-                    notify_peer_close();
-                }
-                // handoff 成功后 'this' 已被 delete，不能访问成员
+    // 不消费就一直留在接收缓冲里, 每次都对从第一个字节开始的完整数据做探测;
+    // 交接后新协议看到的也是同一段缓冲, 它没吃完的部分(如没收全的报文头)下次接着处理
+    for (const auto& proto : _protocols) {
+        if (proto.detect(buf, len)) {
+            size_t consumed = 0;
+            bool ok = handoff_to_protocol(proto, holder, buf, len, &consumed);
+            if (!ok) {
+                notify_peer_close();
                 return len;
             }
+            // handoff 成功后 'this' 已被 delete，不能访问成员
+            return consumed;
         }
     }
 
-    // Buffer the data for multi-packet detection
-    size_t remaining = (MAX_DETECT_BUFFER_SIZE > _buffer.size())
-                           ? (MAX_DETECT_BUFFER_SIZE - _buffer.size())
-                           : 0;
-    if (remaining == 0 || len > remaining) {
-        PDEBUG("[ProtocolDetector] Buffer overflow attempt (current=%zu, incoming=%zu, cap=%zu). Closing.",
-               _buffer.size(), static_cast<size_t>(len), static_cast<size_t>(MAX_DETECT_BUFFER_SIZE));
+    if (len > MAX_DETECT_BUFFER_SIZE) {
+        PDEBUG("[ProtocolDetector] No protocol matched within %zu bytes (cap=%zu). Closing.",
+               static_cast<size_t>(len), static_cast<size_t>(MAX_DETECT_BUFFER_SIZE));
         notify_peer_close();
         return len;
     }
 
-    _buffer.append(buf, len);
-
-    for (const auto& proto : _protocols) {
-        if (proto.detect(_buffer.data(), _buffer.size())) {
-            std::string buffered;
-            buffered.swap(_buffer);
-            bool ok = handoff_to_protocol(proto, holder,
-                                          buffered.data(), buffered.size());
-            if (!ok) {
-                notify_peer_close();
-            }
-            // handoff 成功后 'this' 已被 delete，不能访问成员
-            return len;
-        }
-    }
-
-    return len;
+    return 0;
 }
 
 std::string* ProtocolDetector::get_send_buf() { return nullptr; }
@@ -143,7 +128,6 @@ void ProtocolDetector::peer_close() {
 
 void ProtocolDetector::reset() {
     _detected = false;
-    _buffer.clear();
     _start_ms = 0;
     _timer_id = 0;
     if (auto net = get_base_net()) {
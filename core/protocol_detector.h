@@ -40,12 +40,12 @@ private:
     bool handoff_to_protocol(const UnifiedProtocolFactory::ProtocolEntry& proto,
                              base_connect<base_data_process>* holder,
                              const char* data,
-                             size_t len);
+                             size_t len,
+                             size_t* consumed);
 
     std::vector<UnifiedProtocolFactory::ProtocolEntry> _protocols;
     bool _over_tls;
     bool _detected;
-    std::string _buffer;
     uint64_t _start_ms;
     uint32_t _timer_id;
 
@@ -0,0 +1,167 @@
+#ifndef __RECV_BUFFER_H__
+#define __RECV_BUFFER_H__
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace myframe {
+
+// 接收缓冲: 一块连续内存 + 读写游标
+// - recv/readv 直接写进 write_ptr(), 不再经栈上临时缓冲中转
+// - consume() 只移动读游标; 尾部空间不够时才把未消费的数据搬到开头, 摊还 O(1)
+// - 读空后 shrink() 把内存块还给线程内的块池, 空闲连接不占接收内存
+class recv_buffer
+{
+    public:
+        enum { BLOCK_SIZE = 32768, POOL_MAX = 64 };
+
+        recv_buffer() : _data(NULL), _cap(0), _rpos(0), _wpos(0) {}
+
+        ~recv_buffer() { release(); }
+
+        recv_buffer(const recv_buffer &) = delete;
+        recv_buffer & operator=(const recv_buffer &) = delete;
+
+        const char * data() const { return _data + _rpos; }
+        size_t size() const { return _wpos - _rpos; }
+        size_t length() const { return _wpos - _rpos; }
+        bool empty() const { return _wpos == _rpos; }
+        size_t capacity() const { return _cap; }
+
+        char * write_ptr() { return _data + _wpos; }
+        size_t writable() const { return _cap - _wpos; }
+
+        // 保证 write_ptr() 后至少 n 字节可写
+        void reserve(size_t n)
+        {
+            if (_cap - _wpos >= n)
+                return;
+
+            size_t used = size();
+            if (!_data)
+            {
+                alloc(n);
+                return;
+            }
+
+            if (_cap - used >= n)
+            {
+                // 空间够, 只是被已消费的前缀占着
+                memmove(_data, _data + _rpos, used);
+            }
+            else
+            {
+                size_t cap = _cap * 2;
+                if (cap < used + n)
+                    cap = used + n;
+                char * p = (char *)malloc(cap);
+                if (!p)
+                    throw std::bad_alloc();
+                memcpy(p, _data + _rpos, used);
+                free_block(_data, _cap);
+                _data = p;
+                _cap = cap;
+            }
+            _rpos = 0;
+            _wpos = used;
+        }
+
+        // 直接写入 write_ptr() 后提交 n 字节
+        void commit(size_t n) { _wpos += n; }
+
+        void append(const char * buf, size_t n)
+        {
+            if (!n)
+                return;
+            reserve(n);
+            memcpy(_data + _wpos, buf, n);
+            _wpos += n;
+        }
+
+        void consume(size_t n)
+        {
+            if (n >= size())
+                _rpos = _wpos = 0;
+            else
+                _rpos += n;
+        }
+
+        void clear() { _rpos = _wpos = 0; }
+
+        // 读空时归还内存
+        void shrink()
+        {
+            if (empty())
+                release();
+        }
+
+        void release()
+        {
+            if (_data)
+                free_block(_data, _cap);
+            _data = NULL;
+            _cap = _rpos = _wpos = 0;
+        }
+
+    private:
+        void alloc(size_t n)
+        {
+            if (n <= BLOCK_SIZE)
+            {
+                std::vector<char *> & pool = block_pool();
+                if (!pool.empty())
+                {
+                    _data = pool.back();
+                    pool.pop_back();
+                }
+                else
+                {
+                    _data = (char *)malloc(BLOCK_SIZE);
+                }
+                _cap = BLOCK_SIZE;
+            }
+            else
+            {
+                _data = (char *)malloc(n);
+                _cap = n;
+            }
+            if (!_data)
+            {
+                _cap = 0;
+                throw std::bad_alloc();
+            }
+            _rpos = _wpos = 0;
+        }
+
+        static void free_block(char * p, size_t cap)
+        {
+            std::vector<char *> & pool = block_pool();
+            if (cap == BLOCK_SIZE && pool.size() < POOL_MAX)
+                pool.push_back(p);
+            else
+                free(p);
+        }
+
+        // 连接固定在一个线程上, 块池按线程划分不需要加锁
+        static std::vector<char *> & block_pool()
+        {
+            struct pool_holder
+            {
+                std::vector<char *> blocks;
+                ~pool_holder() { for (auto p : blocks) free(p); }
+            };
+            thread_local pool_holder holder;
+            return holder.blocks;
+        }
+
+        char * _data;
+        size_t _cap;
+        size_t _rpos;
+        size_t _wpos;
+};
+
+} // namespace myframe
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef __SEND_SLICE_H__
+#define __SEND_SLICE_H__
+
+#include "string_pool.h"
+#include <memory>
+#include <string>
+
+namespace myframe {
+
+// 共享的不可变发送数据: 同一份内容(如缓存的响应体)可以同时挂在多个连接上, 只增加引用计数
+typedef std::shared_ptr<const std::string> shared_buffer;
+
+inline shared_buffer make_shared_buffer(std::string && data)
+{
+    return std::make_shared<const std::string>(std::move(data));
+}
+
+inline shared_buffer make_shared_buffer(const char * data, size_t len)
+{
+    return std::make_shared<const std::string>(data, len);
+}
+
+// 发送队列里的一段数据, 只能移动
+// - 独占: 持有一个池化的 std::string(旧的 put_send_buf/get_send_buf 路径)
+// - 共享: 引用 shared_buffer 的 [off, off + len) 区间
+// 部分写出只前移起始指针, 不搬动数据
+class send_slice
+{
+    public:
+        send_slice() : _data(NULL), _len(0) {}
+
+        explicit send_slice(pooled_string_ptr own)
+            : _own(std::move(own)), _data(NULL), _len(0)
+        {
+            if (_own)
+            {
+                _data = _own->data();
+                _len = _own->size();
+            }
+        }
+
+        explicit send_slice(shared_buffer buf, size_t off = 0, size_t len = std::string::npos)
+            : _shared(std::move(buf)), _data(NULL), _len(0)
+        {
+            if (_shared && off < _shared->size())
+            {
+                size_t max = _shared->size() - off;
+                _data = _shared->data() + off;
+                _len = len < max ? len : max;
+            }
+        }
+
+        send_slice(send_slice && other) noexcept
+            : _own(std::move(other._own)), _shared(std::move(other._shared)),
+              _data(other._data), _len(other._len)
+        {
+            other._data = NULL;
+            other._len = 0;
+        }
+
+        send_slice & operator=(send_slice && other) noexcept
+        {
+            if (this != &other)
+            {
+                _own = std::move(other._own);
+                _shared = std::move(other._shared);
+                _data = other._data;
+                _len = other._len;
+                other._data = NULL;
+                other._len = 0;
+            }
+            return *this;
+        }
+
+        send_slice(const send_slice &) = delete;
+        send_slice & operator=(const send_slice &) = delete;
+
+        const char * data() const { return _data; }
+        size_t size() const { return _len; }
+        bool empty() const { return _len == 0; }
+        bool shared() const { return (bool)_shared; }
+
+        // 丢弃已发送的前 n 字节
+        void advance(size_t n)
+        {
+            if (n >= _len)
+            {
+                _data += _len;
+                _len = 0;
+            }
+            else
+            {
+                _data += n;
+                _len -= n;
+            }
+        }
+
+        // 交出剩余数据的独占 std::string(给只认 std::string* 的旧接口); 共享数据会复制一份
+        std::string * release_string()
+        {
+            std::string * s = NULL;
+            if (_own && _data == _own->data() && _len == _own->size())
+            {
+                s = _own.release();
+            }
+            else
+            {
+                s = string_acquire();
+                s->assign(_data ? _data : "", _len);
+            }
+            reset();
+            return s;
+        }
+
+        void reset()
+        {
+            _own.reset();
+            _shared.reset();
+            _data = NULL;
+            _len = 0;
+        }
+
+    private:
+        pooled_string_ptr _own;
+        shared_buffer _shared;
+        const char * _data;
+        size_t _len;
+};
+
+} // namespace myframe
+
+#endif
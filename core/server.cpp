@@ -6,10 +6,22 @@
 #include "factory_base.h"
 #include "multi_protocol_factory.h"
 #include "unified_protocol_factory.h"
+#include "http_res_process.h"
+#include "http_compress.h"
+#include "http_response_cache.h"
 #include <signal.h>
+#include <unistd.h>
+
+static bool env_on(const char* name) {
+    const char* v = ::getenv(name);
+    return v && (strcmp(v, "0") != 0 && strcasecmp(v, "false") != 0);
+}
 
 server::server(int thread_num)
-    : _threads(thread_num > 0 ? thread_num : 1), _port(0), _listen(nullptr) {}
+    : _threads(thread_num > 0 ? thread_num : 1), _port(0), _listen(nullptr),
+      _reuseport(env_on("MYFRAME_REUSEPORT")), _reuseport_cbpf(env_on("MYFRAME_REUSEPORT_CBPF")) {
+    if (_reuseport_cbpf) _reuseport = true;
+}
 
 server::~server() {
     stop();
@@ -30,29 +42,92 @@ void server::set_business_factory(std::shared_ptr<IFactory> factory) {
     _factory = factory;
 }
 
+void server::set_reuseport(bool on, bool cpu_steering) {
+    _reuseport = on || cpu_steering;
+    _reuseport_cbpf = cpu_steering;
+}
+
+void server::set_http_keepalive(uint32_t idle_ms, uint32_t max_requests) {
+    http_res_process::set_keepalive(idle_ms, max_requests);
+}
+
+void server::set_http_compress(int level, size_t min_bytes, size_t cache_bytes) {
+    myframe::http_compress_set(level, min_bytes, cache_bytes);
+}
+
+void server::set_http_cache(size_t local_bytes, size_t shared_bytes) {
+    myframe::http_response_cache_set(local_bytes, shared_bytes);
+}
+
+IFactory* server::make_worker_factory() {
+    IFactory* factory_for_thread = _factory.get();
+
+    // 如果传入的是 ListenFactory，则提取其内部的业务工厂
+    if (auto lsn = dynamic_cast<ListenFactory*>(factory_for_thread)) {
+        factory_for_thread = lsn->inner_factory();
+    }
+    // 为每个worker克隆工厂实例，避免跨线程共享容器指针
+    if (auto mpf = dynamic_cast<MultiProtocolFactory*>(factory_for_thread)) {
+        std::shared_ptr<MultiProtocolFactory> per_thread(new MultiProtocolFactory(mpf->handler(), mpf->mode()));
+        _worker_factories.push_back(per_thread);
+        factory_for_thread = per_thread.get();
+    } else if (auto upf = dynamic_cast<myframe::UnifiedProtocolFactory*>(factory_for_thread)) {
+        std::shared_ptr<myframe::UnifiedProtocolFactory> per_thread = upf->clone_for_thread();
+        _unified_worker_factories.push_back(per_thread);
+        factory_for_thread = per_thread.get();
+    }
+    return factory_for_thread;
+}
+
+void server::start_reuseport() {
+    std::string ip = _ip;
+    unsigned short port = _port;
+    if (auto lsn = dynamic_cast<ListenFactory*>(_factory.get())) {
+        if (!port) { ip = lsn->ip(); port = lsn->port(); }
+    }
+
+    // CBPF 按收包 CPU 号 % 组大小选 socket, worker k 绑在 CPU k 上; 两者只有 worker 数等于 CPU 数时才对得上
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    bool steer = _reuseport_cbpf;
+    if (steer && ncpu != (long)_threads) {
+        fprintf(stderr, "[server] CPU steering needs one worker per CPU (%d workers, %ld CPUs), using kernel hash\n",
+                _threads, ncpu);
+        steer = false;
+    }
+    int first_fd = -1;
+    for (int i = 0; i < _threads; ++i) {
+        base_net_thread* w = new base_net_thread(make_worker_factory());
+        for (size_t pi = 0; pi < _plugins.size(); ++pi) { w->add_plugin(_plugins[pi]); }
+        if (steer) w->set_cpu_affinity(i);
+
+        // 监听对象由 worker 的容器持有；组内 socket 顺序即 CBPF 返回的下标
+        std::shared_ptr< listen_connect<listen_process> > conn;
+        listen_process* proc = nullptr;
+        int fd = ListenFactory::init_listen(w, ip, port, conn, proc, true);
+        if (first_fd < 0) first_fd = fd;
+        _workers.push_back(w);
+    }
+
+    if (steer && !ListenFactory::attach_cpu_steering(first_fd, (uint32_t)_threads)) {
+        fprintf(stderr, "[server] SO_ATTACH_REUSEPORT_CBPF unavailable, using kernel hash\n");
+    }
+
+    for (auto* w : _workers) {
+        w->start();
+    }
+}
+
 void server::start() {
     // 防止任何写关闭触发的 SIGPIPE 终止进程
     signal(SIGPIPE, SIG_IGN);
+    if (_reuseport) {
+        start_reuseport();
+        return;
+    }
     // 创建并启动 worker 线程（每个worker尽量拥有独立的业务工厂实例）
     int worker_count = _threads > 1 ? _threads - 1 : 0;
     for (int i = 0; i < worker_count; ++i) {
-        IFactory* factory_for_thread = _factory.get();
-
-        // 如果传入的是 ListenFactory，则提取其内部的业务工厂
-        if (auto lsn = dynamic_cast<ListenFactory*>(factory_for_thread)) {
-            factory_for_thread = lsn->inner_factory();
-        }
-        // 为每个worker克隆工厂实例，避免跨线程共享容器指针
-        if (auto mpf = dynamic_cast<MultiProtocolFactory*>(factory_for_thread)) {
-            std::shared_ptr<MultiProtocolFactory> per_thread(new MultiProtocolFactory(mpf->handler(), mpf->mode()));
-            _worker_factories.push_back(per_thread);
-            factory_for_thread = per_thread.get();
-        } else if (auto upf = dynamic_cast<myframe::UnifiedProtocolFactory*>(factory_for_thread)) {
-            std::shared_ptr<myframe::UnifiedProtocolFactory> per_thread = upf->clone_for_thread();
-            _unified_worker_factories.push_back(per_thread);
-            factory_for_thread = per_thread.get();
-        }
-        base_net_thread* w = new base_net_thread(factory_for_thread);
+        base_net_thread* w = new base_net_thread(make_worker_factory());
         for (size_t pi = 0; pi < _plugins.size(); ++pi) { w->add_plugin(_plugins[pi]); }
         w->start();
         _workers.push_back(w);
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <cstdint>
 
 // Forward declarations
 class base_net_thread;
@@ -39,11 +40,34 @@ public:
     // 获取线程数量
     size_t size() const;
 
+    // SO_REUSEPORT 模式：所有线程都是 worker，各自持有监听 socket 并在本线程 accept，
+    // 没有独立的 listen 线程（listen_thread() 返回 nullptr）。
+    // cpu_steering 额外挂载 SO_ATTACH_REUSEPORT_CBPF，并把第 k 个 worker 绑到 CPU k；
+    // 只在 worker 数等于在线 CPU 数时生效，否则打印提示并退回内核哈希。
+    // 默认值取自环境变量 MYFRAME_REUSEPORT / MYFRAME_REUSEPORT_CBPF，需在 start() 前调用
+    void set_reuseport(bool on, bool cpu_steering = false);
+
+    // HTTP/1.x 长连接: 空闲 idle_ms 毫秒后关闭(0 关闭长连接), 每个连接最多 max_requests 个请求(0 不限)
+    // 进程内所有 HTTP 服务共用, 默认值取自 MYFRAME_HTTP_KEEPALIVE_MS / MYFRAME_HTTP_KEEPALIVE_MAX, 需在 start() 前调用
+    void set_http_keepalive(uint32_t idle_ms, uint32_t max_requests);
+
+    // HTTP 响应压缩: level 1-9(0 关闭), 小于 min_bytes 的 body 不压缩, 压缩结果缓存上限 cache_bytes(0 关闭)
+    // 进程内共用, 默认值取自 MYFRAME_HTTP_COMPRESS_LEVEL / _MIN / _CACHE_BYTES, 需在 start() 前调用
+    void set_http_compress(int level, size_t min_bytes, size_t cache_bytes);
+
+    // HTTP/1 响应缓存(业务用 HttpResponse::set_cache 选择缓存): 每个工作线程 local_bytes(0 关闭),
+    // 进程内共享层 shared_bytes(0 不开); 默认值取自 MYFRAME_HTTP_CACHE_BYTES / _SHARED_BYTES
+    // 命中计数见 myframe::http_response_cache_stats()
+    void set_http_cache(size_t local_bytes, size_t shared_bytes);
+
     // Expose worker thread instances without transferring ownership
     const std::vector<base_net_thread*>& worker_threads() const;
     base_net_thread* listen_thread() const;
     
 private:
+    IFactory* make_worker_factory();
+    void start_reuseport();
+
     int _threads;
     std::string _ip;
     unsigned short _port;
@@ -54,6 +78,8 @@ private:
     std::vector<std::shared_ptr<myframe::UnifiedProtocolFactory>> _unified_worker_factories;
     std::vector<base_net_thread*> _workers;
     base_net_thread* _listen;
+    bool _reuseport;
+    bool _reuseport_cbpf;
     
     std::vector<std::shared_ptr<IThreadPlugin>> _plugins;
 };
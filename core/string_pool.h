@@ -2,6 +2,8 @@
 #include <string>
 #include <vector>
 #include <cstdlib>
+#include <cstring>
+#include <strings.h>
 #include <memory>
 
 namespace myframe {
@@ -21,8 +23,19 @@ inline size_t pool_capacity() {
     return cap;
 }
 
+// acquire/release 必须共用同一个线程内的池, 线程退出时释放缓存的字符串
+struct string_pool_holder {
+    std::vector<std::string*> strs;
+    ~string_pool_holder() { for (auto* s : strs) delete s; }
+};
+
+inline std::vector<std::string*>& string_pool_local() {
+    thread_local string_pool_holder holder;
+    return holder.strs;
+}
+
 inline std::string* string_acquire() {
-    thread_local std::vector<std::string*> pool;
+    std::vector<std::string*>& pool = string_pool_local();
     if (!pool.empty()) {
         std::string* s = pool.back(); pool.pop_back(); s->clear(); return s;
     }
@@ -31,7 +44,7 @@ inline std::string* string_acquire() {
 
 inline void string_release(std::string* s) {
     if (!s) return;
-    thread_local std::vector<std::string*> pool;
+    std::vector<std::string*>& pool = string_pool_local();
     if (pool.size() < pool_capacity()) { s->clear(); pool.push_back(s); }
     else { delete s; }
 }
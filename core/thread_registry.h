@@ -0,0 +1,100 @@
+#ifndef __THREAD_REGISTRY_H__
+#define __THREAD_REGISTRY_H__
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// 线程索引 -> 线程对象的注册表, 供跨线程投递消息时查找目标线程
+// - 线程索引是从 1 递增的小整数, 小于 CAPACITY 的直接落在固定数组里, 查找不加锁
+// - 每个槽位独占一条 cache line, 读者计数只在投递到同一个目标线程的生产者之间共享
+// - 注销时先摘下指针再等读者计数归零, 返回后不会再有线程拿着旧指针, 调用方可以安全析构
+// - 超出 CAPACITY 的索引(反复创建销毁线程的进程)退回加锁的 map
+template <class T>
+class thread_registry
+{
+    public:
+        enum { CAPACITY = 1024 };
+
+        thread_registry() {}
+
+        thread_registry(const thread_registry &) = delete;
+        thread_registry & operator=(const thread_registry &) = delete;
+
+        void publish(uint32_t index, T * obj)
+        {
+            if (index < (uint32_t)CAPACITY)
+            {
+                _slots[index].obj.store(obj, std::memory_order_seq_cst);
+                return;
+            }
+            std::lock_guard<std::mutex> lock(_overflow_mutex);
+            _overflow[index] = obj;
+        }
+
+        // 只摘下仍指向 obj 的槽位, 并等正在使用它的读者离开
+        void retire(uint32_t index, T * obj)
+        {
+            if (index < (uint32_t)CAPACITY)
+            {
+                slot & s = _slots[index];
+                T * expect = obj;
+                s.obj.compare_exchange_strong(expect, (T *)NULL, std::memory_order_seq_cst);
+                while (s.readers.load(std::memory_order_seq_cst))
+                    std::this_thread::yield();
+                return;
+            }
+            std::lock_guard<std::mutex> lock(_overflow_mutex);
+            auto it = _overflow.find(index);
+            if (it != _overflow.end() && it->second == obj)
+                _overflow.erase(it);
+        }
+
+        // 在回调期间 obj 保证不会被注销; 找不到返回 false
+        template <class F>
+        bool with(uint32_t index, F f)
+        {
+            if (index < (uint32_t)CAPACITY)
+            {
+                slot & s = _slots[index];
+                // 先登记读者再读指针, 与 retire 的"先摘指针再看读者"配对(都用 seq_cst)
+                s.readers.fetch_add(1, std::memory_order_seq_cst);
+                T * obj = s.obj.load(std::memory_order_seq_cst);
+                if (obj)
+                    f(obj);
+                s.readers.fetch_sub(1, std::memory_order_release);
+                return obj != NULL;
+            }
+            std::lock_guard<std::mutex> lock(_overflow_mutex);
+            auto it = _overflow.find(index);
+            if (it == _overflow.end() || !it->second)
+                return false;
+            f(it->second);
+            return true;
+        }
+
+        // 不做保护的查找, 调用方自己保证目标线程存活(如查询自身)
+        T * peek(uint32_t index)
+        {
+            if (index < (uint32_t)CAPACITY)
+                return _slots[index].obj.load(std::memory_order_acquire);
+            std::lock_guard<std::mutex> lock(_overflow_mutex);
+            auto it = _overflow.find(index);
+            return it == _overflow.end() ? NULL : it->second;
+        }
+
+    private:
+        struct alignas(64) slot
+        {
+            std::atomic<T *> obj{NULL};
+            std::atomic<uint32_t> readers{0};
+        };
+
+        slot _slots[CAPACITY];
+
+        std::mutex _overflow_mutex;
+        std::unordered_map<uint32_t, T *> _overflow;
+};
+
+#endif
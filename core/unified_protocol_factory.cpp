@@ -262,8 +262,9 @@ void UnifiedProtocolFactory::handle_thread_msg(std::shared_ptr<::normal_msg>& ms
    int fd = cm->fd;
 
     // 创建连接对象
-    std::shared_ptr<base_connect<base_data_process>> conn(
-        new base_connect<base_data_process>(fd));
+    // 连接对象和 shared_ptr 控制块一起从线程内的 obj_pool 分配
+    std::shared_ptr<base_connect<base_data_process>> conn =
+        myframe::make_pooled_shared<base_connect<base_data_process>>(fd);
 
     auto attach_direct = [&](const ProtocolEntry& entry,
                              const char* reason) -> bool {
@@ -0,0 +1,118 @@
+// 短连接建连基准：单 listen 线程分发 vs SO_REUSEPORT 每 worker 自行 accept
+// 每个客户端线程循环: connect -> 发送一个 HTTP 请求 -> 读到对端关闭 -> close
+// 用法: ./bench_accept_churn [workers] [client_threads] [seconds] [base_port]
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "server.h"
+#include "unified_protocol_factory.h"
+#include "app_handler_v2.h"
+
+using namespace myframe;
+
+namespace {
+
+class TinyHandler : public IApplicationHandler {
+public:
+    void on_http(const HttpRequest& req, HttpResponse& res) override {
+        (void)req;
+        res.set_text("ok");
+    }
+};
+
+bool one_request(unsigned short port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return false;
+    }
+
+    static const char req[] = "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+    if (send(fd, req, sizeof(req) - 1, MSG_NOSIGNAL) != (ssize_t)(sizeof(req) - 1)) {
+        close(fd);
+        return false;
+    }
+
+    char buf[4096];
+    bool got = false;
+    for (;;) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n > 0) { got = true; continue; }
+        break;
+    }
+    close(fd);
+    return got;
+}
+
+double run_mode(const char* name, bool reuseport, int workers, int clients, int seconds, unsigned short port)
+{
+    TinyHandler handler;
+    auto factory = std::make_shared<UnifiedProtocolFactory>();
+    factory->register_http_handler(&handler);
+
+    // 两种模式的 worker 数相同；旧模式额外多一个 listen 线程
+    server srv(reuseport ? workers : workers + 1);
+    srv.set_reuseport(reuseport, false);
+    srv.bind("127.0.0.1", port);
+    srv.set_business_factory(factory);
+    srv.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> ok(0), fail(0);
+    std::vector<std::thread> ths;
+    for (int i = 0; i < clients; i++) {
+        ths.emplace_back([&]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (one_request(port)) ok.fetch_add(1, std::memory_order_relaxed);
+                else fail.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stop.store(true);
+    for (auto& t : ths) t.join();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    double rate = ok.load() / sec;
+    printf("%-12s %10.0f conn/sec  (ok=%llu fail=%llu)\n", name, rate,
+           (unsigned long long)ok.load(), (unsigned long long)fail.load());
+    return rate;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int workers = argc > 1 ? atoi(argv[1]) : 2;
+    int clients = argc > 2 ? atoi(argv[2]) : 4;
+    int seconds = argc > 3 ? atoi(argv[3]) : 3;
+    unsigned short port = argc > 4 ? (unsigned short)atoi(argv[4]) : 19380;
+    if (workers <= 0) workers = 1;
+    if (clients <= 0) clients = 1;
+    if (seconds <= 0) seconds = 1;
+
+    printf("workers: %d, client threads: %d, %ds per mode\n", workers, clients, seconds);
+    run_mode("listen+rr", false, workers, clients, seconds, port);
+    run_mode("reuseport", true, workers, clients, seconds, (unsigned short)(port + 1));
+    return 0;
+}
@@ -0,0 +1,254 @@
+// 大响应体下载基准: clients 个连接同时各下载 body_mb 的 GET, 看耗时和进程峰值内存(VmHWM)
+// stream:   响应体由 HttpResponse::set_generator 拉取产生, 连接可写时才取下一段, chunked 发出
+// longpoll: 每 10ms 由定时器产生一小段, 其余时间 source 返回 WAIT, 看这段时间进程用了多少 CPU(不应空转)
+// buffered: 整个 body 先放进 HttpResponse::body 再发(峰值内存随并发 x body 增长, 放在最后跑)
+// 用法: ./bench_body_source [workers] [clients] [body_mb] [port]
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "server.h"
+#include "unified_protocol_factory.h"
+#include "app_handler_v2.h"
+#include "http_chunked_decoder.h"
+#include "common_def.h"
+
+using namespace myframe;
+
+namespace {
+
+const uint32_t TICK_MS = 10;
+const int LONGPOLL_EVENTS = 100;
+
+uint64_t g_body_bytes = 1 << 20;
+
+// 定时器到点给 source 一条事件再 resume
+class EventSource : public HttpBodySource {
+public:
+    int pull(std::string& out, size_t max) override {
+        (void)max;
+        if (_ready) {
+            out.append("data: tick\n\n");
+            _ready = false;
+            _sent++;
+        }
+        return _sent >= LONGPOLL_EVENTS ? DONE : WAIT;
+    }
+    void fire() { _ready = true; resume(); }
+    bool finished() const { return _sent >= LONGPOLL_EVENTS; }
+private:
+    bool _ready = false;
+    int _sent = 0;
+};
+
+class DownloadHandler : public IApplicationHandler {
+public:
+    void on_http(const HttpRequest& req, HttpResponse& res) override {
+        res.set_content_type("application/octet-stream");
+        if (req.url == "/buffered") {
+            res.body.assign((size_t)g_body_bytes, 'x');
+            return;
+        }
+        if (req.url == "/longpoll") {
+            auto src = std::make_shared<EventSource>();
+            res.set_stream(src);
+            arm(src);
+            return;
+        }
+        uint64_t left = g_body_bytes;
+        res.set_generator([left](std::string& out, size_t max) mutable {
+            size_t n = left < max ? (size_t)left : max;
+            out.append(n, 'x');
+            left -= n;
+            return left ? HttpBodySource::MORE : HttpBodySource::DONE;
+        });
+    }
+
+    void handle_timeout(std::shared_ptr<timer_msg>& t_msg) override {
+        auto& m = waiting();
+        auto it = m.find(t_msg->_timer_id);
+        if (it == m.end()) return;
+        std::shared_ptr<EventSource> src = it->second.lock();
+        m.erase(it);
+        if (!src) return;
+        src->fire();
+        if (!src->finished()) arm(src);
+    }
+
+private:
+    void arm(const std::shared_ptr<EventSource>& src) {
+        uint32_t id = schedule_timeout(TICK_MS);
+        if (id) waiting()[id] = src;
+    }
+
+    // 定时器和 source 都在连接所在线程, 按线程各记各的
+    static std::map<uint32_t, std::weak_ptr<EventSource>>& waiting() {
+        thread_local std::map<uint32_t, std::weak_ptr<EventSource>> m;
+        return m;
+    }
+};
+
+int connect_to(unsigned short port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// GET 一次, 返回解出来的 body 字节数(chunked 或 Content-Length), 出错返回 -1
+int64_t download(unsigned short port, const char* path)
+{
+    int fd = connect_to(port);
+    if (fd < 0) return -1;
+    char head[256];
+    int n = snprintf(head, sizeof(head), "GET %s HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n", path);
+    if (send(fd, head, (size_t)n, MSG_NOSIGNAL) != n) {
+        close(fd);
+        return -1;
+    }
+
+    std::vector<char> buf(256 * 1024);
+    std::string pending;
+    bool in_body = false, chunked = false, done = false;
+    int64_t body = 0;
+    http_chunked_decoder dec;
+    ssize_t r;
+    while (!done && (r = recv(fd, buf.data(), buf.size(), 0)) > 0) {
+        const char* p = buf.data();
+        size_t len = (size_t)r;
+        if (!in_body) {
+            pending.append(p, len);
+            size_t pos = pending.find("\r\n\r\n");
+            if (pos == std::string::npos) continue;
+            chunked = pending.find("Transfer-Encoding: chunked") < pos;
+            in_body = true;
+            pending.erase(0, pos + 4);
+        } else {
+            pending.append(p, len);
+        }
+        if (!chunked) {
+            body += (int64_t)pending.size();
+            pending.clear();
+            continue;
+        }
+        size_t off = 0;
+        while (off < pending.size()) {
+            size_t used = 0;
+            std::string_view data;
+            int ret = dec.decode(pending.data() + off, pending.size() - off, used, data);
+            off += used;
+            if (ret == http_chunked_decoder::DONE) {
+                done = true;
+                break;
+            }
+            if (ret != http_chunked_decoder::DATA) break;
+            body += (int64_t)data.size();
+            dec.data_consumed(data.size());
+            off += data.size();
+        }
+        pending.erase(0, off);
+    }
+    close(fd);
+    return in_body ? body : -1;
+}
+
+long vm_hwm_kb()
+{
+    FILE* f = fopen("/proc/self/status", "r");
+    if (!f) return -1;
+    char line[256];
+    long kb = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "VmHWM:", 6) == 0) {
+            kb = atol(line + 6);
+            break;
+        }
+    }
+    fclose(f);
+    return kb;
+}
+
+double cpu_ms()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000.0 + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000.0;
+}
+
+void run_mode(const char* name, const char* path, int clients, int64_t expect, unsigned short port)
+{
+    std::atomic<int> ok(0);
+    std::atomic<int64_t> bytes(0);
+    double cpu0 = cpu_ms();
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> ths;
+    for (int i = 0; i < clients; i++) {
+        ths.emplace_back([&]() {
+            int64_t got = download(port, path);
+            if (got > 0) bytes.fetch_add(got);
+            if (got == expect) ok.fetch_add(1);
+        });
+    }
+    for (auto& t : ths) t.join();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    double mb = (double)bytes.load() / (1024.0 * 1024.0);
+    printf("%-9s %8.2f s  %8.1f MB/s  ok=%d/%d  cpu %8.1f ms  VmHWM %ld MB\n", name, sec, mb / sec, ok.load(), clients,
+           cpu_ms() - cpu0, vm_hwm_kb() / 1024);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int workers = argc > 1 ? atoi(argv[1]) : 2;
+    int clients = argc > 2 ? atoi(argv[2]) : 4;
+    int body_mb = argc > 3 ? atoi(argv[3]) : 128;
+    unsigned short port = argc > 4 ? (unsigned short)atoi(argv[4]) : 19582;
+    if (workers <= 0) workers = 1;
+    if (clients <= 0) clients = 1;
+    if (body_mb <= 0) body_mb = 1;
+    g_body_bytes = (uint64_t)body_mb << 20;
+
+    DownloadHandler handler;
+    auto factory = std::make_shared<UnifiedProtocolFactory>();
+    factory->register_http_handler(&handler);
+
+    server srv(workers);
+    srv.bind("127.0.0.1", port);
+    srv.set_business_factory(factory);
+    srv.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    printf("workers: %d, clients: %d, body: %d MB each, VmHWM at start %ld MB\n", workers, clients, body_mb,
+           vm_hwm_kb() / 1024);
+    run_mode("stream", "/stream", clients, (int64_t)g_body_bytes, port);
+    run_mode("longpoll", "/longpoll", clients, (int64_t)LONGPOLL_EVENTS * 12, port);
+    run_mode("buffered", "/buffered", clients, (int64_t)g_body_bytes, port);
+
+    srv.stop();
+    srv.join();
+    return 0;
+}
@@ -0,0 +1,229 @@
+// 大请求体上传基准: clients 个连接同时各上传 body_mb 的 POST, 看耗时和进程峰值内存(VmHWM)
+// stream:    on_body_begin 返回 sink, 边收边丢, 内存只有接收缓冲
+// throttled: sink 每收 1MB 暂停, 10ms 后由定时器 resume(), 验证背压: 速率被限住, 内存不涨
+// buffered:  默认行为, 整个 body 攒在内存里再调 on_http(峰值内存随并发 x body 增长, 放在最后跑)
+// 用法: ./bench_body_stream [workers] [clients] [body_mb] [port]
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "server.h"
+#include "unified_protocol_factory.h"
+#include "app_handler_v2.h"
+#include "common_def.h"
+
+using namespace myframe;
+
+namespace {
+
+const size_t THROTTLE_BYTES = 1 << 20;
+const uint32_t THROTTLE_MS = 10;
+
+std::atomic<uint64_t> g_body_bytes(0);
+
+class CountSink : public HttpBodySink {
+public:
+    size_t on_body_chunk(const char* data, size_t len) override {
+        (void)data;
+        _got += len;
+        return len;
+    }
+    void on_body_end(const HttpRequest& req, HttpResponse& res) override {
+        (void)req;
+        g_body_bytes.fetch_add(_got, std::memory_order_relaxed);
+        res.set_text(std::to_string(_got));
+    }
+protected:
+    uint64_t _got = 0;
+};
+
+class UploadHandler;
+
+// 收满预算就暂停, 由 UploadHandler 的定时器恢复
+class ThrottledSink : public CountSink {
+public:
+    explicit ThrottledSink(UploadHandler* h) : _handler(h) {}
+    size_t on_body_chunk(const char* data, size_t len) override;
+    void refill() { _budget = THROTTLE_BYTES; _waiting = false; }
+    std::weak_ptr<ThrottledSink> self;
+private:
+    UploadHandler* _handler;
+    size_t _budget = THROTTLE_BYTES;
+    bool _waiting = false;
+};
+
+class UploadHandler : public IApplicationHandler {
+public:
+    void on_http(const HttpRequest& req, HttpResponse& res) override {
+        g_body_bytes.fetch_add(req.body.size(), std::memory_order_relaxed);
+        res.set_text(std::to_string(req.body.size()));
+    }
+
+    std::shared_ptr<HttpBodySink> on_body_begin(const HttpRequest& req) override {
+        if (req.url == "/stream") return std::make_shared<CountSink>();
+        if (req.url == "/throttled") {
+            auto sink = std::make_shared<ThrottledSink>(this);
+            sink->self = sink;
+            return sink;
+        }
+        return nullptr;
+    }
+
+    void handle_timeout(std::shared_ptr<timer_msg>& t_msg) override {
+        auto& m = paused();
+        auto it = m.find(t_msg->_timer_id);
+        if (it == m.end()) return;
+        std::shared_ptr<ThrottledSink> sink = it->second.lock();
+        m.erase(it);
+        if (!sink) return;
+        sink->refill();
+        sink->resume();
+    }
+
+    void pause_later(const std::weak_ptr<ThrottledSink>& sink) {
+        uint32_t id = schedule_timeout(THROTTLE_MS);
+        if (id) paused()[id] = sink;
+    }
+
+private:
+    // 定时器和 sink 都在连接所在线程, 按线程各记各的
+    static std::map<uint32_t, std::weak_ptr<ThrottledSink>>& paused() {
+        thread_local std::map<uint32_t, std::weak_ptr<ThrottledSink>> m;
+        return m;
+    }
+};
+
+size_t ThrottledSink::on_body_chunk(const char* data, size_t len) {
+    size_t take = len < _budget ? len : _budget;
+    _budget -= take;
+    CountSink::on_body_chunk(data, take);
+    if (!_budget && !_waiting) {
+        _waiting = true;
+        _handler->pause_later(self);
+    }
+    return take;
+}
+
+int connect_to(unsigned short port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 发一个 body_bytes 的 POST, 读回响应里的字节数
+bool upload(unsigned short port, const char* path, uint64_t body_bytes, const std::string& block)
+{
+    int fd = connect_to(port);
+    if (fd < 0) return false;
+    char head[256];
+    int n = snprintf(head, sizeof(head),
+                     "POST %s HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: %llu\r\nConnection: close\r\n\r\n",
+                     path, (unsigned long long)body_bytes);
+    bool ok = send(fd, head, (size_t)n, MSG_NOSIGNAL) == n;
+    for (uint64_t sent = 0; ok && sent < body_bytes;) {
+        size_t k = body_bytes - sent < block.size() ? (size_t)(body_bytes - sent) : block.size();
+        ssize_t w = send(fd, block.data(), k, MSG_NOSIGNAL);
+        if (w <= 0) ok = false;
+        else sent += (uint64_t)w;
+    }
+    std::string rsp;
+    char tmp[4096];
+    ssize_t r;
+    while (ok && (r = recv(fd, tmp, sizeof(tmp), 0)) > 0) rsp.append(tmp, (size_t)r);
+    close(fd);
+    size_t pos = rsp.find("\r\n\r\n");
+    return ok && pos != std::string::npos && strtoull(rsp.c_str() + pos + 4, 0, 10) == body_bytes;
+}
+
+long vm_hwm_kb()
+{
+    FILE* f = fopen("/proc/self/status", "r");
+    if (!f) return -1;
+    char line[256];
+    long kb = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "VmHWM:", 6) == 0) {
+            kb = atol(line + 6);
+            break;
+        }
+    }
+    fclose(f);
+    return kb;
+}
+
+void run_mode(const char* name, const char* path, int clients, uint64_t body_bytes, unsigned short port)
+{
+    std::string block(256 * 1024, 'x');
+    std::atomic<int> ok(0);
+    g_body_bytes.store(0);
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> ths;
+    for (int i = 0; i < clients; i++) {
+        ths.emplace_back([&]() {
+            if (upload(port, path, body_bytes, block)) ok.fetch_add(1);
+        });
+    }
+    for (auto& t : ths) t.join();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    double mb = (double)g_body_bytes.load() / (1024.0 * 1024.0);
+    printf("%-10s %8.2f s  %8.1f MB/s  ok=%d/%d  VmHWM %ld MB\n", name, sec, mb / sec, ok.load(), clients,
+           vm_hwm_kb() / 1024);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int workers = argc > 1 ? atoi(argv[1]) : 2;
+    int clients = argc > 2 ? atoi(argv[2]) : 4;
+    int body_mb = argc > 3 ? atoi(argv[3]) : 128;
+    unsigned short port = argc > 4 ? (unsigned short)atoi(argv[4]) : 19581;
+    if (workers <= 0) workers = 1;
+    if (clients <= 0) clients = 1;
+    if (body_mb <= 0) body_mb = 1;
+
+    UploadHandler handler;
+    auto factory = std::make_shared<UnifiedProtocolFactory>();
+    factory->register_http_handler(&handler);
+
+    server srv(workers);
+    srv.bind("127.0.0.1", port);
+    srv.set_business_factory(factory);
+    srv.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    uint64_t body_bytes = (uint64_t)body_mb << 20;
+    printf("workers: %d, clients: %d, body: %d MB each, VmHWM at start %ld MB\n", workers, clients, body_mb,
+           vm_hwm_kb() / 1024);
+    run_mode("stream", "/stream", clients, body_bytes, port);
+    // 限速模式按 100MB/s/连接算, body 太大时只传 1/8
+    run_mode("throttled", "/throttled", clients, body_bytes > (64u << 20) ? body_bytes / 8 : body_bytes, port);
+    run_mode("buffered", "/buffered", clients, body_bytes, port);
+
+    srv.stop();
+    srv.join();
+    return 0;
+}
@@ -0,0 +1,173 @@
+// 跨线程消息基准：MPSC 邮箱(base_net_thread::put_obj_msg) vs 旧的 mutex+deque+socketpair 通道
+// 用法: ./bench_channel_mailbox [producers] [msgs_per_producer]
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "base_net_thread.h"
+
+namespace {
+
+const int BENCH_MSG_OP = 0x7f01;
+
+// 旧实现的等价副本: 每条消息一次 mutex + 一次 send(tag), 消费方 epoll + recv 后换队列
+class legacy_channel
+{
+    public:
+        legacy_channel() : _current(0), _received(0), _run(true)
+        {
+            socketpair(AF_UNIX, SOCK_STREAM, 0, _fd);
+            _efd = epoll_create(1);
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.fd = _fd[0];
+            epoll_ctl(_efd, EPOLL_CTL_ADD, _fd[0], &ev);
+        }
+
+        ~legacy_channel()
+        {
+            close(_fd[0]);
+            close(_fd[1]);
+            close(_efd);
+        }
+
+        void put_msg(uint32_t obj_id, std::shared_ptr<normal_msg> & p_msg)
+        {
+            std::lock_guard<std::mutex> lck(_mutex);
+            _queue[1 - _current].push_back(std::make_pair(obj_id, p_msg));
+            send(_fd[1], CHANNEL_MSG_TAG, sizeof(CHANNEL_MSG_TAG), MSG_DONTWAIT);
+        }
+
+        void run()
+        {
+            std::string recv_buf;
+            char t_buf[SIZE_LEN_32768];
+            struct epoll_event evs[4];
+            while (_run.load())
+            {
+                int n = epoll_wait(_efd, evs, 4, DEFAULT_EPOLL_WAITE);
+                if (n <= 0)
+                    continue;
+                ssize_t ret = recv(_fd[0], t_buf, sizeof(t_buf), MSG_DONTWAIT);
+                if (ret > 0)
+                    recv_buf.append(t_buf, ret);
+
+                std::deque<std::pair<uint32_t, std::shared_ptr<normal_msg> > > processing;
+                {
+                    std::lock_guard<std::mutex> lck(_mutex);
+                    if (_queue[_current].empty())
+                        _current = 1 - _current;
+                    processing.swap(_queue[_current]);
+                }
+                size_t i = processing.size();
+                _received.fetch_add(i, std::memory_order_relaxed);
+                size_t k = i * sizeof(CHANNEL_MSG_TAG);
+                recv_buf.erase(0, k < recv_buf.size() ? k : recv_buf.size());
+            }
+        }
+
+        std::atomic<uint64_t> & received() { return _received; }
+        void stop() { _run.store(false); }
+
+    private:
+        std::mutex _mutex;
+        std::deque<std::pair<uint32_t, std::shared_ptr<normal_msg> > > _queue[2];
+        int _current;
+        int _fd[2];
+        int _efd;
+        std::atomic<uint64_t> _received;
+        std::atomic<bool> _run;
+};
+
+class counting_thread : public base_net_thread
+{
+    public:
+        std::atomic<uint64_t> _received{0};
+
+    protected:
+        virtual bool handle_thread_msg(std::shared_ptr<normal_msg> & p_msg)
+        {
+            if (p_msg && p_msg->_msg_op == BENCH_MSG_OP)
+            {
+                _received.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            return false;
+        }
+};
+
+template <class SEND>
+double run_producers(int producers, uint64_t per_producer, std::atomic<uint64_t> & received, SEND send_one)
+{
+    uint64_t total = per_producer * producers;
+    std::atomic<bool> go(false);
+    std::vector<std::thread> ths;
+    for (int p = 0; p < producers; p++)
+    {
+        ths.emplace_back([&]() {
+            while (!go.load()) {}
+            for (uint64_t i = 0; i < per_producer; i++)
+            {
+                std::shared_ptr<normal_msg> msg = std::make_shared<normal_msg>(BENCH_MSG_OP);
+                send_one(msg);
+            }
+        });
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    go.store(true);
+    for (auto & t : ths)
+        t.join();
+    while (received.load() < total)
+        std::this_thread::yield();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return total / sec;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    int producers = argc > 1 ? atoi(argv[1]) : 4;
+    uint64_t per_producer = argc > 2 ? strtoull(argv[2], NULL, 10) : 200000;
+    if (producers <= 0)
+        producers = 1;
+    if (!per_producer)
+        per_producer = 1;
+
+    printf("producers: %d, msgs/producer: %llu\n", producers, (unsigned long long)per_producer);
+
+    {
+        legacy_channel ch;
+        std::thread consumer([&]() { ch.run(); });
+        double rate = run_producers(producers, per_producer, ch.received(),
+                [&](std::shared_ptr<normal_msg> & msg) { ch.put_msg(OBJ_ID_THREAD, msg); });
+        ch.stop();
+        consumer.join();
+        printf("%-18s %12.0f msgs/sec\n", "socketpair+mutex", rate);
+    }
+
+    {
+        counting_thread worker;
+        worker.start();
+        ObjId id;
+        id._id = OBJ_ID_THREAD;
+        id._thread_index = worker.get_thread_index();
+        double rate = run_producers(producers, per_producer, worker._received,
+                [&](std::shared_ptr<normal_msg> & msg) { base_net_thread::put_obj_msg(id, msg); });
+        worker.stop();
+        worker.join_thread();
+        printf("%-18s %12.0f msgs/sec\n", "mpsc+eventfd", rate);
+    }
+
+    return 0;
+}
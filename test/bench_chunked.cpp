@@ -0,0 +1,145 @@
+// 分块编码 body 解码基准: 一个 body_kb 大小、每块 chunk 字节的分块响应, 每次到达 read 字节
+// legacy: 旧 http_req_process::get_chuncked 的等价副本, 追加进 _chunked_body,
+//         每块 substr 拷出数据再 substr 重建剩余部分
+// decoder: http_chunked_decoder 在接收缓冲上原地解析, 数据段直接交出, 未解完的字节留在缓冲里
+// 用法: ./bench_chunked [body_kb] [chunk] [read]
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+
+#include "common_util.h"
+#include "http_chunked_decoder.h"
+
+namespace {
+
+std::string make_chunked(size_t body, size_t chunk)
+{
+    std::string out;
+    char line[32];
+    for (size_t off = 0; off < body; off += chunk)
+    {
+        size_t n = body - off < chunk ? body - off : chunk;
+        snprintf(line, sizeof(line), "%zx\r\n", n);
+        out += line;
+        out.append(n, (char)('a' + off % 26));
+        out += "\r\n";
+    }
+    out += "0\r\n\r\n";
+    return out;
+}
+
+// 旧实现: 业务层 process_recv_body 只累计长度
+struct legacy_decoder
+{
+    int64_t _cur_chunked_len = -1;
+    int64_t _cur_chunked_rec_len = -1;
+    std::string _chunked_body;
+    uint64_t _got = 0;
+
+    size_t sink(const char * buf, size_t len)
+    {
+        _got += len + (buf[len - 1] == '\n');
+        return len;
+    }
+
+    size_t feed(const char * buf, size_t len, int & result)
+    {
+        result = 0;
+        _chunked_body.append(buf, len);
+        while (1)
+        {
+            if (_cur_chunked_len == -1)
+            {
+                std::string sTmp;
+                int nRet = GetStringByLabel(_chunked_body, "", "\r\n", sTmp, 0, 1);
+                if (nRet == -1)
+                    break;
+                _cur_chunked_len = strtoul(sTmp.c_str(), 0, 16);
+                _cur_chunked_rec_len = nRet;
+                if (_cur_chunked_len == 0)
+                {
+                    result = 1;
+                    break;
+                }
+            }
+            if (_cur_chunked_len + 2 + _cur_chunked_rec_len > (int64_t)_chunked_body.length())
+                break;
+            sink(_chunked_body.substr(_cur_chunked_rec_len, _cur_chunked_len).c_str(), _cur_chunked_len);
+            _chunked_body = _chunked_body.substr(_cur_chunked_rec_len + 2 + _cur_chunked_len);
+            _cur_chunked_len = -1;
+            if (_chunked_body.empty())
+                break;
+        }
+        return len;
+    }
+};
+
+double run_legacy(const std::string & wire, size_t read, uint64_t & got)
+{
+    legacy_decoder d;
+    auto t0 = std::chrono::steady_clock::now();
+    int result = 0;
+    for (size_t off = 0; off < wire.size() && !result; off += read)
+    {
+        size_t n = wire.size() - off < read ? wire.size() - off : read;
+        d.feed(wire.data() + off, n, result);
+    }
+    got = d._got;
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// 模拟接收缓冲: [begin, end) 是已到达未消费的字节, 每次读再到 read 字节
+double run_decoder(const std::string & wire, size_t read, uint64_t & got)
+{
+    myframe::http_chunked_decoder d;
+    got = 0;
+    size_t begin = 0, end = 0;
+    bool done = false;
+    auto t0 = std::chrono::steady_clock::now();
+    while (!done && end < wire.size())
+    {
+        end = end + read < wire.size() ? end + read : wire.size();
+        while (1)
+        {
+            size_t used = 0;
+            std::string_view data;
+            int r = d.decode(wire.data() + begin, end - begin, used, data);
+            begin += used;
+            if (r == myframe::http_chunked_decoder::DONE)
+            {
+                done = true;
+                break;
+            }
+            if (r != myframe::http_chunked_decoder::DATA)
+                break;
+            got += data.size() + (data[data.size() - 1] == '\n');
+            d.data_consumed(data.size());
+            begin += data.size();
+        }
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    size_t body_kb = argc > 1 ? (size_t)atoi(argv[1]) : 16384;
+    size_t chunk = argc > 2 ? (size_t)atoi(argv[2]) : 4096;
+    size_t read = argc > 3 ? (size_t)atoi(argv[3]) : 32768;
+    if (!body_kb) body_kb = 1;
+    if (!chunk) chunk = 4096;
+    if (!read) read = 32768;
+
+    std::string wire = make_chunked(body_kb * 1024, chunk);
+    printf("body: %zu KB, chunk: %zu bytes, read: %zu bytes, wire: %zu bytes\n", body_kb, chunk, read, wire.size());
+
+    uint64_t got = 0;
+    double ms = run_legacy(wire, read, got);
+    printf("legacy   %10.2f ms  %8.1f MB/s  (body %llu)\n", ms, body_kb / 1024.0 / (ms / 1000), (unsigned long long)got);
+    ms = run_decoder(wire, read, got);
+    printf("decoder  %10.2f ms  %8.1f MB/s  (body %llu)\n", ms, body_kb / 1024.0 / (ms / 1000), (unsigned long long)got);
+    return 0;
+}
@@ -0,0 +1,111 @@
+// 响应压缩基准: 一份 body_kb 大小的 JSON 行情快照, 每个请求都要 gzip 一次
+// init:    每次 deflateInit2 + deflate + deflateEnd(按请求新建 z_stream)
+// pooled:  http_compress_body, 线程内复用 z_stream(deflateReset)
+// small:   同样两种方式压 2KB 的小 JSON, 初始化开销占大头
+// cached:  http_compress_response 带 compress_key, 只有第一次真正压缩, 之后按长度和 compress_version 校验后直接取共享缓冲区
+// 用法: ./bench_compress [body_kb] [loops]
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <zlib.h>
+
+#include "http_compress.h"
+
+using namespace myframe;
+
+namespace {
+
+std::string make_json(size_t bytes)
+{
+    std::string out = "{\"quotes\":[";
+    char item[160];
+    for (int i = 0; out.size() < bytes; i++)
+    {
+        snprintf(item, sizeof(item),
+                 "%s{\"symbol\":\"SYM%04d\",\"price\":%d.%02d,\"change\":%d.%02d,\"volume\":%d,\"exchange\":\"NASDAQ\"}",
+                 i ? "," : "", i, 100 + i % 900, i % 100, i % 7, (i * 13) % 100, 1000 + (i * 7919) % 1000000);
+        out += item;
+    }
+    out += "]}";
+    return out;
+}
+
+bool init_each(const std::string & body, std::string & out)
+{
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    if (deflateInit2(&z, http_compress_level(), Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+    out.resize(deflateBound(&z, body.size()));
+    z.next_in = (Bytef *)body.data();
+    z.avail_in = (uInt)body.size();
+    z.next_out = (Bytef *)&out[0];
+    z.avail_out = (uInt)out.size();
+    int ret = deflate(&z, Z_FINISH);
+    out.resize(out.size() - z.avail_out);
+    deflateEnd(&z);
+    return ret == Z_STREAM_END;
+}
+
+template <typename F>
+double run(int loops, F fn)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < loops; i++)
+        fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void report(const char * name, int loops, double ms, size_t in, size_t out)
+{
+    printf("%-14s %9.2f ms  %9.2f us/req  %8.1f MB/s  %zu -> %zu bytes\n", name, ms, ms * 1000 / loops,
+           (double)in * loops / (1024.0 * 1024.0) / (ms / 1000), in, out);
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    size_t body_kb = argc > 1 ? (size_t)atoi(argv[1]) : 64;
+    int loops = argc > 2 ? atoi(argv[2]) : 2000;
+    if (!body_kb) body_kb = 64;
+    if (loops <= 0) loops = 2000;
+
+    std::string body = make_json(body_kb * 1024);
+    std::string small = make_json(2048);
+    std::string out;
+    printf("level %d, body %zu bytes, small %zu bytes, loops %d\n", http_compress_level(), body.size(), small.size(),
+           loops);
+
+    double ms = run(loops, [&]() { init_each(body, out); });
+    report("init", loops, ms, body.size(), out.size());
+    ms = run(loops, [&]() { http_compress_body(HTTP_ENCODING_GZIP, body.data(), body.size(), out); });
+    report("pooled", loops, ms, body.size(), out.size());
+
+    int small_loops = loops * 10;
+    ms = run(small_loops, [&]() { init_each(small, out); });
+    report("small init", small_loops, ms, small.size(), out.size());
+    ms = run(small_loops, [&]() { http_compress_body(HTTP_ENCODING_GZIP, small.data(), small.size(), out); });
+    report("small pooled", small_loops, ms, small.size(), out.size());
+
+    size_t compressed = 0;
+    ms = run(loops, [&]() {
+        HttpResponse res;
+        res.set_json(body);
+        http_compress_response("gzip, deflate, br", res);
+        compressed = res.body_view().size();
+    });
+    report("response", loops, ms, body.size(), compressed);
+    ms = run(loops, [&]() {
+        HttpResponse res;
+        res.set_json(body);
+        res.compress_key = "quotes";
+        res.compress_version = 1;
+        http_compress_response("gzip, deflate, br", res);
+        compressed = res.body_view().size();
+    });
+    report("cached", loops, ms, body.size(), compressed);
+    return 0;
+}
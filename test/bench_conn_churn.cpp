@@ -0,0 +1,165 @@
+// 连接建立/关闭风暴基准: 工作线程侧每个新连接的创建、登记、销毁开销
+// 1) id 表: 保持 live 个在线对象, 每次插入一个新对象并删掉最老的, unordered_map vs obj_id_table
+// 2) 整条路径: socketpair -> base_connect + http_res_process/app_http_data_process -> 注册到容器 -> 关闭
+//    malloc: obj_pool 关闭(每次 new/delete 都走 malloc); pooled: 连接和协议栈从线程内池复用
+// 用法: ./bench_conn_churn [live_conns] [cycles]
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "base_connect.h"
+#include "base_data_process.h"
+#include "common_obj_container.h"
+#include "http_res_process.h"
+#include "app_http_data_process.h"
+#include "obj_id_table.h"
+#include "obj_pool.h"
+
+namespace {
+
+typedef base_connect<base_data_process> churn_connect;
+
+struct dummy_obj
+{
+    uint32_t id;
+};
+
+double ns_per_op(std::chrono::steady_clock::time_point t0, size_t ops)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / (ops ? ops : 1);
+}
+
+void bench_table(int live, int cycles)
+{
+    std::vector<std::shared_ptr<dummy_obj> > objs;
+    for (int i = 0; i < 64; i++)
+        objs.push_back(std::make_shared<dummy_obj>());
+
+    // 旧实现: 自增 id + unordered_map
+    {
+        std::unordered_map<uint32_t, std::shared_ptr<dummy_obj> > m;
+        std::deque<uint32_t> ids;
+        uint32_t next = OBJ_ID_BEGIN;
+        uint64_t hit = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < live + cycles; i++)
+        {
+            do { next++; } while (m.find(next) != m.end());
+            m[next] = objs[i & 63];
+            ids.push_back(next);
+            hit += m.find(ids[ids.size() / 2]) != m.end();
+            if ((int)ids.size() > live)
+            {
+                m.erase(ids.front());
+                ids.pop_front();
+            }
+        }
+        printf("table  unordered_map  %8.1f ns/churn  (hits %llu)\n", ns_per_op(t0, live + cycles), (unsigned long long)hit);
+    }
+
+    {
+        obj_id_table<dummy_obj> t;
+        std::deque<uint32_t> ids;
+        uint64_t hit = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < live + cycles; i++)
+        {
+            ids.push_back(t.insert(objs[i & 63]));
+            hit += t.get(ids[ids.size() / 2]) != NULL;
+            if ((int)ids.size() > live)
+            {
+                t.erase(ids.front());
+                ids.pop_front();
+            }
+        }
+        printf("table  obj_id_table   %8.1f ns/churn  (hits %llu)\n", ns_per_op(t0, live + cycles), (unsigned long long)hit);
+    }
+}
+
+std::shared_ptr<base_net_obj> open_conn(common_obj_container & container, bool pooled)
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0)
+    {
+        perror("socketpair");
+        exit(1);
+    }
+    close(sv[1]);
+
+    std::shared_ptr<churn_connect> conn;
+    if (pooled)
+        conn = myframe::make_pooled_shared<churn_connect>(sv[0]);
+    else
+        conn = std::shared_ptr<churn_connect>(new churn_connect(sv[0]));
+
+    // 与 HttpProbe 相同的协议栈
+    http_res_process * p = new http_res_process(conn);
+    p->set_process(new app_http_data_process(p, NULL));
+    conn->set_process(p);
+    conn->set_net_container(&container);
+    return conn;
+}
+
+void bench_path(const char * name, bool pooled, int live, int cycles)
+{
+    myframe::obj_pool::set_capacity(pooled ? 4096 : 0);
+
+    common_obj_container container(0);
+    std::deque<uint32_t> ids;
+    for (int i = 0; i < live; i++)
+        ids.push_back(open_conn(container, pooled)->get_id()._id);
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < cycles; i++)
+    {
+        ids.push_back(open_conn(container, pooled)->get_id()._id);
+        uint32_t old = ids.front();
+        ids.pop_front();
+        std::shared_ptr<base_net_obj> obj = container.find(old);
+        if (obj)
+        {
+            obj->destroy();
+            container.erase(old);
+        }
+    }
+    double ns = ns_per_op(t0, cycles);
+    printf("path   %-14s %8.1f ns/conn  %9.0f conns/s  (live %u, pool cached %zu)\n",
+            name, ns, 1e9 / ns, container.size(), myframe::obj_pool::cached());
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    int live = argc > 1 ? atoi(argv[1]) : 4000;
+    int cycles = argc > 2 ? atoi(argv[2]) : 200000;
+    if (live < 0)
+        live = 0;
+    if (cycles <= 0)
+        cycles = 1;
+
+    // 每个在线连接一个 fd
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0)
+    {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+        getrlimit(RLIMIT_NOFILE, &rl);
+        if ((rlim_t)live + 64 > rl.rlim_cur)
+            live = (int)rl.rlim_cur - 64;
+    }
+
+    printf("live: %d, cycles: %d\n", live, cycles);
+    bench_table(live, cycles * 10);
+    bench_path("malloc", false, live, cycles);
+    bench_path("pooled", true, live, cycles);
+    return 0;
+}
@@ -0,0 +1,194 @@
+// 大流量传输基准：水平触发(每次事件一块) vs 边缘触发(读写到 EAGAIN, 受每连接预算限制)
+// upload: 对端线程阻塞写入, 框架侧 real_recv 计数; download: 框架侧 real_send 发送, 对端线程读取
+// 用法: ./bench_et_transfer [conns] [mb_per_conn]
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "base_connect.h"
+#include "base_data_process.h"
+#include "common_obj_container.h"
+#include "string_pool.h"
+
+namespace {
+
+const size_t CHUNK = 64 * 1024;
+
+class bench_process : public base_data_process
+{
+    public:
+        bench_process(std::shared_ptr<base_net_obj> p, size_t to_send)
+            : base_data_process(p), _received(0), _left(to_send)
+        {
+        }
+
+        virtual size_t process_recv_buf(const char *, size_t len)
+        {
+            _received += len;
+            return len;
+        }
+
+        virtual std::string *get_send_buf()
+        {
+            if (!_left)
+                return NULL;
+            size_t n = _left < CHUNK ? _left : CHUNK;
+            _left -= n;
+            std::string * s = myframe::string_acquire();
+            s->assign(n, 'x');
+            return s;
+        }
+
+        size_t _received;
+        size_t _left;
+};
+
+typedef base_connect<bench_process> bench_connect;
+
+// 回环上建立 n 对 TCP 连接, 返回 (框架侧 fd, 对端 fd)
+bool make_pairs(int n, std::vector<std::pair<int, int> > & pairs)
+{
+    int lfd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t alen = sizeof(addr);
+    if (lfd < 0 || bind(lfd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(lfd, n) < 0
+            || getsockname(lfd, (struct sockaddr*)&addr, &alen) < 0)
+    {
+        perror("listen");
+        return false;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        int cfd = socket(AF_INET, SOCK_STREAM, 0);
+        if (cfd < 0 || connect(cfd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+        {
+            perror("connect");
+            return false;
+        }
+        int sfd = accept(lfd, NULL, NULL);
+        if (sfd < 0)
+        {
+            perror("accept");
+            return false;
+        }
+        pairs.push_back(std::make_pair(sfd, cfd));
+    }
+    close(lfd);
+    return true;
+}
+
+void run_mode(const char * name, bool upload, bool edge, int conns, size_t bytes_per_conn)
+{
+    std::vector<std::pair<int, int> > pairs;
+    if (!make_pairs(conns, pairs))
+        exit(1);
+
+    common_obj_container container(0);
+    std::vector<std::shared_ptr<bench_connect> > objs;
+    for (auto & p : pairs)
+    {
+        std::shared_ptr<bench_connect> conn = std::make_shared<bench_connect>(p.first);
+        conn->set_edge_triggered(edge);
+        conn->set_process(new bench_process(conn, upload ? 0 : bytes_per_conn));
+        conn->set_net_container(&container);
+        objs.push_back(conn);
+    }
+
+    std::atomic<size_t> peer_bytes(0);
+    std::vector<std::thread> peers;
+    auto t0 = std::chrono::steady_clock::now();
+    for (auto & p : pairs)
+    {
+        int fd = p.second;
+        peers.emplace_back([fd, upload, bytes_per_conn, &peer_bytes]() {
+            std::vector<char> buf(CHUNK, 'y');
+            size_t done = 0;
+            while (done < bytes_per_conn)
+            {
+                ssize_t n;
+                if (upload)
+                {
+                    size_t want = bytes_per_conn - done < CHUNK ? bytes_per_conn - done : CHUNK;
+                    n = send(fd, buf.data(), want, MSG_NOSIGNAL);
+                }
+                else
+                {
+                    n = recv(fd, buf.data(), buf.size(), 0);
+                }
+                if (n <= 0)
+                    break;
+                done += n;
+            }
+            peer_bytes.fetch_add(done);
+        });
+    }
+
+    if (!upload)
+    {
+        for (auto & c : objs)
+            c->notice_send();
+    }
+
+    uint64_t loops = 0;
+    size_t total = bytes_per_conn * conns;
+    for (;;)
+    {
+        size_t got = 0;
+        if (upload)
+        {
+            for (auto & c : objs)
+                got += c->process()->_received;
+        }
+        else
+        {
+            got = peer_bytes.load();
+        }
+        if (got >= total)
+            break;
+        container.obj_process();
+        loops++;
+    }
+
+    for (auto & t : peers)
+        t.join();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    printf("%-10s %-4s %10.1f MB/s %10llu loops %8.1f KB/loop\n", upload ? "upload" : "download", name,
+            total / sec / (1024.0 * 1024.0), (unsigned long long)loops, loops ? total / 1024.0 / loops : 0.0);
+
+    for (auto & p : pairs)
+        close(p.second);
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    int conns = argc > 1 ? atoi(argv[1]) : 4;
+    size_t mb = argc > 2 ? (size_t)atoi(argv[2]) : 256;
+    if (conns <= 0)
+        conns = 1;
+    if (!mb)
+        mb = 1;
+
+    printf("conns: %d, %zu MB per conn, et budget: %zu bytes\n", conns, mb, common_epoll::edge_io_budget());
+    size_t bytes = mb * 1024 * 1024;
+    run_mode("LT", true, false, conns, bytes);
+    run_mode("ET", true, true, conns, bytes);
+    run_mode("LT", false, false, conns, bytes);
+    run_mode("ET", false, true, conns, bytes);
+    return 0;
+}
@@ -0,0 +1,182 @@
+// HPACK 编码基准: 一条连接上连续编码响应头, 比较吞吐和压缩后的字节数
+// legacy:  旧实现的数据结构(动态表是新条目插在最前的 vector, 按 (name,value) 线性查找,
+//          静态表名字查 std::map, 字符串不用 Huffman); 表示方式按 RFC 修正过, 输出能被解码
+// encoder: hpack::Encoder(环形表 + 哈希索引, Huffman 只在更短时用, 逐条决定是否入表)
+// 两种头: api(常见的 JSON 接口响应) 和 wide(每个响应 24 个自定义头, 表里条目多)
+// 两种编码的输出都先用 hpack::Decoder 解一遍核对; 用法: ./bench_hpack_encoder [responses]
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "hpack.h"
+
+namespace {
+
+typedef hpack::Decoder::HeaderList header_list;
+
+// 旧实现
+class legacy_encoder
+{
+    public:
+        legacy_encoder() : _size(0), _max(4096)
+        {
+            const std::vector<hpack::HeaderField> & tbl = hpack::static_table();
+            for (uint32_t i = 0; i < tbl.size(); i++)
+            {
+                if (_static_names.find(tbl[i].name) == _static_names.end())
+                    _static_names[tbl[i].name] = i + 1;
+            }
+        }
+
+        void encode(std::string & out, const std::string & name, const std::string & value)
+        {
+            for (size_t i = 0; i < _dyn.size(); i++)
+            {
+                if (_dyn[i].name == name && _dyn[i].value == value)
+                {
+                    hpack::encode_integer(out, (uint32_t)(62 + i), 7, 0x80);
+                    return;
+                }
+            }
+            auto it = _static_names.find(name);
+            uint32_t name_idx = it == _static_names.end() ? 0 : it->second;
+            hpack::encode_integer(out, name_idx, 6, 0x40);
+            if (!name_idx) hpack::encode_string(out, name, false);
+            hpack::encode_string(out, value, false);
+
+            size_t sz = 32 + name.size() + value.size();
+            if (sz > _max)
+            {
+                _dyn.clear();
+                _size = 0;
+                return;
+            }
+            while (_size + sz > _max && !_dyn.empty())
+            {
+                _size -= _dyn.back().sz;
+                _dyn.pop_back();
+            }
+            _dyn.insert(_dyn.begin(), entry{name, value, sz});
+            _size += sz;
+        }
+
+    private:
+        struct entry { std::string name; std::string value; size_t sz; };
+        std::vector<entry> _dyn;
+        size_t _size;
+        size_t _max;
+        std::map<std::string, uint32_t> _static_names;
+};
+
+// 每 25 个响应换一次 Date(一秒内的响应数); 其余取值按响应序号轮换
+void api_headers(int n, header_list & h)
+{
+    static const char * const types[] = {"application/json", "application/json; charset=utf-8", "text/html; charset=utf-8"};
+    char buf[96];
+    h.clear();
+    h.emplace_back(":status", n % 20 == 7 ? "404" : "200");
+    h.emplace_back("content-type", types[n % 3]);
+    h.emplace_back("content-length", std::to_string(200 + (n * 7919) % 30000));
+    snprintf(buf, sizeof(buf), "Wed, 12 Jun 2024 08:%02d:%02d GMT", (n / 25 / 60) % 60, (n / 25) % 60);
+    h.emplace_back("date", buf);
+    h.emplace_back("server", "myframe");
+    h.emplace_back("cache-control", "private, max-age=0, no-cache");
+    h.emplace_back("vary", "Accept-Encoding");
+    h.emplace_back("access-control-allow-origin", "https://www.example.com");
+    h.emplace_back("strict-transport-security", "max-age=31536000; includeSubDomains");
+    snprintf(buf, sizeof(buf), "%08x-%04x-4c5e-a7b3-%012x", (unsigned)n * 2654435761u, (unsigned)n & 0xffff, (unsigned)n);
+    h.emplace_back("x-request-id", buf);
+    if (n % 10 == 0)
+        h.emplace_back("set-cookie", "session=9f8e7d6c5b4a39281706f5e4d3c2b1a0; Path=/; HttpOnly; Secure");
+}
+
+void wide_headers(int n, header_list & h)
+{
+    h.clear();
+    h.emplace_back(":status", "200");
+    h.emplace_back("content-type", "application/grpc");
+    for (int i = 0; i < 24; i++)
+        h.emplace_back("x-meta-" + std::to_string(i), "value-" + std::to_string((i + n / 50) % 40));
+}
+
+size_t plain_size(const header_list & h)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < h.size(); i++)
+        n += h[i].first.size() + h[i].second.size() + 2;   // 不用表也不用 Huffman 的字面量
+    return n;
+}
+
+template <typename Enc>
+bool verify(void (*make)(int, header_list &), int count)
+{
+    Enc enc;
+    hpack::Decoder dec;
+    header_list h, out;
+    std::string blk;
+    for (int n = 0; n < count; n++)
+    {
+        make(n, h);
+        blk.clear();
+        for (size_t i = 0; i < h.size(); i++)
+            enc.encode(blk, h[i].first, h[i].second);
+        out.clear();
+        if (!dec.decode((const unsigned char *)blk.data(), blk.size(), out) || out != h)
+            return false;
+    }
+    return true;
+}
+
+template <typename Enc>
+void run(const char * name, void (*make)(int, header_list &), int count)
+{
+    // 头先生成好, 只计编码
+    std::vector<header_list> all(count);
+    size_t plain = 0;
+    for (int n = 0; n < count; n++)
+    {
+        make(n, all[n]);
+        plain += plain_size(all[n]);
+    }
+    Enc enc;
+    std::string blk;
+    size_t bytes = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int n = 0; n < count; n++)
+    {
+        blk.clear();
+        const header_list & h = all[n];
+        for (size_t i = 0; i < h.size(); i++)
+            enc.encode(blk, h[i].first, h[i].second);
+        bytes += blk.size();
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    printf("  %-8s %8.2f ms  %7.1f ns/resp  %6.1f bytes/resp  %5.1f%% of plain\n",
+           name, ms, ms * 1e6 / count, (double)bytes / count, 100.0 * bytes / plain);
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 200000;
+    if (count <= 0) count = 200000;
+
+    if (!verify<legacy_encoder>(api_headers, 2000) || !verify<hpack::Encoder>(api_headers, 2000)
+        || !verify<legacy_encoder>(wide_headers, 2000) || !verify<hpack::Encoder>(wide_headers, 2000))
+    {
+        printf("decode check failed\n");
+        return 1;
+    }
+
+    printf("api, %d responses\n", count);
+    run<legacy_encoder>("legacy", api_headers, count);
+    run<hpack::Encoder>("encoder", api_headers, count);
+    printf("wide, %d responses\n", count);
+    run<legacy_encoder>("legacy", wide_headers, count);
+    run<hpack::Encoder>("encoder", wide_headers, count);
+    return 0;
+}
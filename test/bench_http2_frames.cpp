@@ -0,0 +1,144 @@
+// HTTP/2 收包基准: 不走网络, 把一条连接上的帧按批喂给 http2_process, 统计每个请求的处理耗时
+// 请求都是小请求(HEADERS 带 END_STREAM, 头用 HPACK 动态表, 十几个字节), 响应体 2 字节
+// get:    每批 batch 个 GET, 每批都在帧边界上
+// post:   每个请求多一个 64 字节的 DATA 帧(会产生 WINDOW_UPDATE)
+// split:  同样的 GET 流, 但按 1000 字节切, 帧跨两次读; 接收缓冲的处理方式和连接一样(没消费的留着, 下次连同新数据再给)
+// 输出里 segments/read 是每次读之后交给 writev 的片段数
+// 用法: ./bench_http2_frames [requests] [batch]
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "http2_process.h"
+#include "http2_frame.h"
+#include "hpack.h"
+#include "send_slice.h"
+
+using namespace myframe;
+using namespace h2;
+
+namespace {
+
+struct ok_handler : IApplicationHandler
+{
+    size_t requests = 0;
+    void on_http(const HttpRequest &, HttpResponse & res) override
+    {
+        requests++;
+        res.body = "ok";
+    }
+};
+
+std::string make_stream(int count, bool post)
+{
+    std::string in(CONNECTION_PREFACE, CONNECTION_PREFACE_LEN);
+    in += make_settings_frame(false);
+    // 流量窗口开大, 响应不会因窗口停下
+    in += make_window_update(0, 1 << 30);
+    hpack::Encoder enc;
+    std::string blk;
+    for (int i = 0; i < count; i++)
+    {
+        uint32_t sid = 1 + 2 * (uint32_t)i;
+        blk.clear();
+        enc.begin_block(blk);
+        enc.encode(blk, ":method", post ? "POST" : "GET");
+        enc.encode(blk, ":scheme", "https");
+        enc.encode(blk, ":authority", "api.example.com");
+        enc.encode(blk, ":path", i % 2 ? "/api/v1/items" : "/api/v1/status");
+        enc.encode(blk, "user-agent", "bench/1.0");
+        enc.encode(blk, "accept", "application/json");
+        in += make_frame_header((uint32_t)blk.size(), HEADERS, post ? 0x4 : 0x5, sid);
+        in += blk;
+        if (post)
+        {
+            in += make_frame_header(64, DATA, 0x1, sid);
+            in.append(64, 'x');
+        }
+    }
+    return in;
+}
+
+// 帧边界的位置, 按批切分用
+void frame_ends(const std::string & in, std::vector<size_t> & ends)
+{
+    size_t off = CONNECTION_PREFACE_LEN;
+    ends.push_back(off);
+    while (off + 9 <= in.size())
+    {
+        off += 9 + read24((const unsigned char *)in.data() + off);
+        ends.push_back(off);
+    }
+}
+
+// 每次读完取走全部待发数据, 相当于连接的一次 writev; segs 是 iovec 片段数
+size_t drain(http2_process & p, size_t & segs)
+{
+    size_t bytes = 0;
+    send_slice s;
+    while (p.get_send_slice(s))
+    {
+        bytes += s.size();
+        segs++;
+    }
+    return bytes;
+}
+
+void run(const char * name, const std::string & in, const std::vector<size_t> & cuts, int count)
+{
+    ok_handler h;
+    http2_process p(nullptr, &h);
+    std::string pending;   // 连接接收缓冲里没消费的部分
+    size_t out = 0, segs = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    size_t prev = 0;
+    for (size_t i = 0; i < cuts.size(); i++)
+    {
+        pending.append(in, prev, cuts[i] - prev);
+        prev = cuts[i];
+        size_t used = p.process_recv_buf(pending.data(), pending.size());
+        pending.erase(0, used);
+        out += drain(p, segs);
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    printf("%-6s %8.2f ms  %7.1f ns/req  %zu/%d answered  %zu bytes out  %.2f segments/read\n",
+           name, ms, ms * 1e6 / count, h.requests, count, out, (double)segs / cuts.size());
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 200000;
+    int batch = argc > 2 ? atoi(argv[2]) : 32;
+    if (count <= 0) count = 200000;
+    if (batch <= 0) batch = 32;
+    printf("%d requests, %d frames per read\n", count, batch);
+
+    std::string get = make_stream(count, false);
+    std::string post = make_stream(count, true);
+    std::vector<size_t> ends, cuts;
+
+    frame_ends(get, ends);
+    for (size_t i = 0; i < ends.size(); i += batch)
+        cuts.push_back(ends[i]);
+    cuts.push_back(get.size());
+    run("get", get, cuts, count);
+
+    ends.clear();
+    cuts.clear();
+    frame_ends(post, ends);
+    for (size_t i = 0; i < ends.size(); i += batch * 2)
+        cuts.push_back(ends[i]);
+    cuts.push_back(post.size());
+    run("post", post, cuts, count);
+
+    cuts.clear();
+    for (size_t off = 1000; off < get.size(); off += 1000)
+        cuts.push_back(off);
+    cuts.push_back(get.size());
+    run("split", get, cuts, count);
+    return 0;
+}
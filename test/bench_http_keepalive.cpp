@@ -0,0 +1,170 @@
+// HTTP/1.x 长连接与流水线基准(wrk 风格: 每个客户端线程一条连接, 循环发请求读响应)
+// close:     每个请求带 Connection: close, 读完响应重连
+// keepalive: 同一条连接上一问一答
+// pipeline:  一次发出 depth 个请求, 再按顺序读回 depth 个响应(服务端一次 writev 合并发出)
+// 用法: ./bench_http_keepalive [workers] [client_threads] [seconds] [depth] [port]
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "server.h"
+#include "unified_protocol_factory.h"
+#include "app_handler_v2.h"
+
+using namespace myframe;
+
+namespace {
+
+class TinyHandler : public IApplicationHandler {
+public:
+    void on_http(const HttpRequest& req, HttpResponse& res) override {
+        (void)req;
+        res.set_text("ok");
+    }
+};
+
+int connect_to(unsigned short port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 从 buf 头部取出一个完整响应(头 + Content-Length 指定的 body), 多读到的字节留给下一个响应
+bool read_response(int fd, std::string& buf, bool& closed)
+{
+    closed = false;
+    char tmp[16384];
+    for (;;) {
+        size_t hdr_end = buf.find("\r\n\r\n");
+        if (hdr_end != std::string::npos) {
+            size_t body = 0;
+            size_t cl = buf.find("Content-Length:");
+            if (cl == std::string::npos) cl = buf.find("content-length:");
+            if (cl != std::string::npos && cl < hdr_end) body = (size_t)atol(buf.c_str() + cl + 15);
+            if (buf.size() >= hdr_end + 4 + body) {
+                size_t conn = buf.find("Connection: close");
+                closed = conn != std::string::npos && conn < hdr_end;
+                buf.erase(0, hdr_end + 4 + body);
+                return true;
+            }
+        }
+        ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+        if (n <= 0) return false;
+        buf.append(tmp, (size_t)n);
+    }
+}
+
+void run_mode(const char* name, const std::string& one_req, int depth, int clients, int seconds, unsigned short port)
+{
+    std::string batch;
+    for (int i = 0; i < depth; i++) batch += one_req;
+
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> ok(0), fail(0), conns(0);
+    std::vector<std::thread> ths;
+    for (int i = 0; i < clients; i++) {
+        ths.emplace_back([&]() {
+            std::string buf;
+            bool closed = false;
+            int fd = -1;
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (fd < 0) {
+                    buf.clear();
+                    if ((fd = connect_to(port)) < 0) {
+                        fail.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+                    conns.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (send(fd, batch.data(), batch.size(), MSG_NOSIGNAL) != (ssize_t)batch.size()) {
+                    fail.fetch_add(1, std::memory_order_relaxed);
+                    close(fd);
+                    fd = -1;
+                    continue;
+                }
+                int got = 0;
+                while (got < depth && read_response(fd, buf, closed)) {
+                    got++;
+                    if (closed) break;
+                }
+                ok.fetch_add(got, std::memory_order_relaxed);
+                if (got < depth || closed) {
+                    if (got < depth && !closed) fail.fetch_add(1, std::memory_order_relaxed);
+                    close(fd);
+                    fd = -1;
+                }
+            }
+            if (fd >= 0) close(fd);
+        });
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stop.store(true);
+    for (auto& t : ths) t.join();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    printf("%-12s %10.0f req/sec  (ok=%llu fail=%llu connections=%llu)\n", name, ok.load() / sec,
+           (unsigned long long)ok.load(), (unsigned long long)fail.load(), (unsigned long long)conns.load());
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int workers = argc > 1 ? atoi(argv[1]) : 2;
+    int clients = argc > 2 ? atoi(argv[2]) : 16;
+    int seconds = argc > 3 ? atoi(argv[3]) : 3;
+    int depth = argc > 4 ? atoi(argv[4]) : 16;
+    unsigned short port = argc > 5 ? (unsigned short)atoi(argv[5]) : 19580;
+    if (workers <= 0) workers = 1;
+    if (clients <= 0) clients = 1;
+    if (seconds <= 0) seconds = 1;
+    if (depth <= 0) depth = 1;
+
+    TinyHandler handler;
+    auto factory = std::make_shared<UnifiedProtocolFactory>();
+    factory->register_http_handler(&handler);
+
+    server srv(workers);
+    srv.set_reuseport(true, false);
+    // 基准期间不因请求数上限断开
+    srv.set_http_keepalive(60000, 0);
+    srv.bind("127.0.0.1", port);
+    srv.set_business_factory(factory);
+    srv.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    printf("workers: %d, clients: %d, %ds per mode, pipeline depth %d\n", workers, clients, seconds, depth);
+    run_mode("close", "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n", 1, clients, seconds, port);
+    run_mode("keepalive", "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n", 1, clients, seconds, port);
+    char name[32];
+    snprintf(name, sizeof(name), "pipeline x%d", depth);
+    run_mode(name, "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n", depth, clients, seconds, port);
+
+    srv.stop();
+    srv.join();
+    return 0;
+}
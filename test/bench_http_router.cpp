@@ -0,0 +1,250 @@
+// 路由查找基准: 40 个资源 x 8 条路由(静态/参数/多级参数/通配) = 320 条, 请求在各路由上均匀分布
+// linear: 按注册顺序逐条比对方法和路径(手写 if 链的形态, 逐段比较, 不分配内存)
+// radix:  HttpRouter 的压缩前缀树, 一遍走完路径
+// query:  每个请求取 3 个 query 参数, 旧 HttpRequest::query_param(每次 substr 出 query 串)
+//         vs split(parse_query_string 切成列表再比对, HttpRouteParams 原来的做法)
+//         vs scan(find_query_param 在 query 串上原地扫, HttpRouteParams::query 现在的做法);
+//         params 一行是路由查找加 3 次 HttpRouteParams::query
+// 用法: ./bench_http_router [loops]
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "http_router.h"
+
+using namespace myframe;
+
+namespace {
+
+const int RESOURCES = 40;
+
+struct linear_route
+{
+    std::string method;
+    std::string pattern;
+    int id;
+};
+
+// 逐段比对, ':' 段匹配任意非空段, '*' 匹配剩余
+bool linear_match(const std::string & pattern, std::string_view path)
+{
+    size_t i = 0, j = 0;
+    while (i < pattern.size())
+    {
+        char c = pattern[i];
+        if (c == '*')
+            return true;
+        if (c == ':')
+        {
+            size_t pe = pattern.find('/', i);
+            if (pe == std::string::npos) pe = pattern.size();
+            size_t se = path.find('/', j);
+            if (se == std::string_view::npos) se = path.size();
+            if (se == j) return false;
+            i = pe;
+            j = se;
+            continue;
+        }
+        if (j >= path.size() || path[j] != c)
+            return false;
+        i++;
+        j++;
+    }
+    return j == path.size();
+}
+
+int linear_find(const std::vector<linear_route> & routes, const std::string & method, std::string_view url)
+{
+    std::string_view path = url.substr(0, url.find('?'));
+    for (size_t i = 0; i < routes.size(); i++)
+    {
+        if (routes[i].method == method && linear_match(routes[i].pattern, path))
+            return routes[i].id;
+    }
+    return -1;
+}
+
+// 旧 HttpRequest::query_param 的副本
+std::string legacy_query_param(const std::string & url, const std::string & name)
+{
+    size_t query_pos = url.find('?');
+    if (query_pos == std::string::npos) return std::string();
+
+    std::string query = url.substr(query_pos + 1);
+    std::string search = name + "=";
+    size_t pos = query.find(search);
+    if (pos == std::string::npos) return std::string();
+
+    size_t start = pos + search.length();
+    size_t end = query.find('&', start);
+    if (end == std::string::npos) end = query.length();
+
+    return query.substr(start, end - start);
+}
+
+double elapsed_ms(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    int loops = argc > 1 ? atoi(argv[1]) : 200;
+    if (loops <= 0) loops = 200;
+
+    std::vector<linear_route> linear;
+    HttpRouter router;
+    std::vector<std::pair<std::string, std::string>> reqs;
+    int hits = 0;
+    auto add = [&](const char * method, const std::string & pattern, const std::string & sample) {
+        int id = (int)linear.size();
+        linear.push_back({method, pattern, id});
+        router.add(method, pattern, [id, &hits](const HttpRequest &, HttpResponse &, const HttpRouteParams &) {
+            hits += id;
+        });
+        reqs.emplace_back(method, sample + "?page=2&limit=50&sort=name");
+    };
+    for (int r = 0; r < RESOURCES; r++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "/api/v1/res%02d", r);
+        std::string base = name;
+        add("GET", base, base);
+        add("POST", base, base);
+        add("GET", base + "/:id", base + "/12345");
+        add("PUT", base + "/:id", base + "/12345");
+        add("DELETE", base + "/:id", base + "/12345");
+        add("GET", base + "/:id/items", base + "/12345/items");
+        add("GET", base + "/:id/items/:item", base + "/12345/items/678");
+        add("GET", base + "/files/*path", base + "/files/a/b/c.txt");
+    }
+
+    // 两种查找结果应当一致
+    for (size_t i = 0; i < reqs.size(); i++)
+    {
+        HttpRouteParams params;
+        unsigned allowed;
+        const HttpRouter::Handler * h = router.find(reqs[i].first, reqs[i].second, params, allowed);
+        if (!h || linear_find(linear, reqs[i].first, reqs[i].second) != (int)i)
+        {
+            printf("mismatch at %s %s\n", reqs[i].first.c_str(), reqs[i].second.c_str());
+            return 1;
+        }
+    }
+    printf("routes: %zu, requests per loop: %zu, loops: %d\n", router.size(), reqs.size(), loops);
+    double total = (double)loops * reqs.size();
+
+    long sum = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int l = 0; l < loops; l++)
+        for (size_t i = 0; i < reqs.size(); i++)
+            sum += linear_find(linear, reqs[i].first, reqs[i].second);
+    double ms = elapsed_ms(t0);
+    printf("linear  %10.2f ms  %8.1f ns/lookup  (sum %ld)\n", ms, ms * 1e6 / total, sum);
+
+    sum = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (int l = 0; l < loops; l++)
+    {
+        for (size_t i = 0; i < reqs.size(); i++)
+        {
+            HttpRouteParams params;
+            unsigned allowed;
+            if (router.find(reqs[i].first, reqs[i].second, params, allowed))
+                sum += (long)params.param_count();
+        }
+    }
+    ms = elapsed_ms(t0);
+    printf("radix   %10.2f ms  %8.1f ns/lookup  (params %ld)\n", ms, ms * 1e6 / total, sum);
+
+    HttpRequest req;
+    HttpResponse res;
+    t0 = std::chrono::steady_clock::now();
+    for (int l = 0; l < loops; l++)
+    {
+        for (size_t i = 0; i < reqs.size(); i++)
+        {
+            req.method = reqs[i].first;
+            req.url = reqs[i].second;
+            router.dispatch(req, res);
+        }
+    }
+    ms = elapsed_ms(t0);
+    printf("dispatch%10.2f ms  %8.1f ns/request (hits %d)\n", ms, ms * 1e6 / total, hits);
+
+    size_t qlen = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (int l = 0; l < loops; l++)
+    {
+        for (size_t i = 0; i < reqs.size(); i++)
+        {
+            const std::string & url = reqs[i].second;
+            qlen += legacy_query_param(url, "page").size() + legacy_query_param(url, "limit").size()
+                + legacy_query_param(url, "sort").size();
+        }
+    }
+    ms = elapsed_ms(t0);
+    printf("query legacy %7.2f ms  %8.1f ns/request  (%zu)\n", ms, ms * 1e6 / total, qlen);
+
+    std::vector<std::string_view> queries;
+    for (size_t i = 0; i < reqs.size(); i++)
+    {
+        std::string_view url = reqs[i].second;
+        size_t q = url.find('?');
+        queries.push_back(q == std::string_view::npos ? std::string_view() : url.substr(q + 1));
+    }
+
+    qlen = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (int l = 0; l < loops; l++)
+    {
+        for (size_t i = 0; i < queries.size(); i++)
+        {
+            HttpRouteParams::QueryList list;
+            parse_query_string(queries[i], list);
+            static const char * const names[] = {"page", "limit", "sort"};
+            for (size_t n = 0; n < 3; n++)
+            {
+                for (size_t k = 0; k < list.size(); k++)
+                    if (list[k].first == names[n]) { qlen += list[k].second.size(); break; }
+            }
+        }
+    }
+    ms = elapsed_ms(t0);
+    printf("query split  %7.2f ms  %8.1f ns/request  (%zu)\n", ms, ms * 1e6 / total, qlen);
+
+    qlen = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (int l = 0; l < loops; l++)
+    {
+        for (size_t i = 0; i < queries.size(); i++)
+        {
+            qlen += find_query_param(queries[i], "page").size() + find_query_param(queries[i], "limit").size()
+                + find_query_param(queries[i], "sort").size();
+        }
+    }
+    ms = elapsed_ms(t0);
+    printf("query scan   %7.2f ms  %8.1f ns/request  (%zu)\n", ms, ms * 1e6 / total, qlen);
+
+    qlen = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (int l = 0; l < loops; l++)
+    {
+        for (size_t i = 0; i < reqs.size(); i++)
+        {
+            HttpRouteParams params;
+            unsigned allowed;
+            router.find(reqs[i].first, reqs[i].second, params, allowed);
+            qlen += params.query("page").size() + params.query("limit").size() + params.query("sort").size();
+        }
+    }
+    ms = elapsed_ms(t0);
+    printf("query params %7.2f ms  %8.1f ns/request  (%zu, includes the route lookup)\n", ms, ms * 1e6 / total, qlen);
+    return 0;
+}
@@ -0,0 +1,152 @@
+// IO 引擎基准：epoll(就绪通知) vs io_uring(完成通知, multishot recv + 批量提交)
+// 每个客户端线程持有一条连接, 循环: 发送一个 HTTP 请求 -> 读完整响应; 响应带 Connection: close 时重连
+// 用法: ./bench_io_engine [workers] [client_threads] [seconds] [base_port]
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "server.h"
+#include "unified_protocol_factory.h"
+#include "app_handler_v2.h"
+
+using namespace myframe;
+
+namespace {
+
+class TinyHandler : public IApplicationHandler {
+public:
+    void on_http(const HttpRequest& req, HttpResponse& res) override {
+        (void)req;
+        res.set_text("ok");
+    }
+};
+
+int connect_to(unsigned short port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 读到一个完整响应(头 + Content-Length 指定的 body); 服务端要求关闭时 closed 置位
+bool read_response(int fd, std::string& buf, bool& closed)
+{
+    buf.clear();
+    closed = false;
+    char tmp[4096];
+    for (;;) {
+        size_t hdr_end = buf.find("\r\n\r\n");
+        if (hdr_end != std::string::npos) {
+            size_t body = 0;
+            size_t cl = buf.find("Content-Length:");
+            if (cl == std::string::npos) cl = buf.find("content-length:");
+            if (cl != std::string::npos && cl < hdr_end) body = (size_t)atol(buf.c_str() + cl + 15);
+            if (buf.size() >= hdr_end + 4 + body) {
+                size_t conn = buf.find("Connection: close");
+                closed = conn != std::string::npos && conn < hdr_end;
+                return true;
+            }
+        }
+        ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+        if (n <= 0) return false;
+        buf.append(tmp, (size_t)n);
+    }
+}
+
+double run_mode(const char* engine, int workers, int clients, int seconds, unsigned short port)
+{
+    // 引擎在每个线程的容器构造时选择
+    setenv("MYFRAME_IO_ENGINE", engine, 1);
+
+    TinyHandler handler;
+    auto factory = std::make_shared<UnifiedProtocolFactory>();
+    factory->register_http_handler(&handler);
+
+    server srv(workers);
+    srv.set_reuseport(true, false);
+    srv.bind("127.0.0.1", port);
+    srv.set_business_factory(factory);
+    srv.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> ok(0), fail(0);
+    std::vector<std::thread> ths;
+    for (int i = 0; i < clients; i++) {
+        ths.emplace_back([&]() {
+            static const char req[] = "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+            std::string buf;
+            bool closed = false;
+            int fd = -1;
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (fd < 0 && (fd = connect_to(port)) < 0) {
+                    fail.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                if (send(fd, req, sizeof(req) - 1, MSG_NOSIGNAL) != (ssize_t)(sizeof(req) - 1)
+                        || !read_response(fd, buf, closed)) {
+                    fail.fetch_add(1, std::memory_order_relaxed);
+                    close(fd);
+                    fd = -1;
+                    continue;
+                }
+                ok.fetch_add(1, std::memory_order_relaxed);
+                if (closed) {
+                    close(fd);
+                    fd = -1;
+                }
+            }
+            if (fd >= 0) close(fd);
+        });
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stop.store(true);
+    for (auto& t : ths) t.join();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    double rate = ok.load() / sec;
+    printf("%-8s %10.0f req/sec  (ok=%llu fail=%llu)\n", engine, rate,
+           (unsigned long long)ok.load(), (unsigned long long)fail.load());
+    return rate;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int workers = argc > 1 ? atoi(argv[1]) : 2;
+    int clients = argc > 2 ? atoi(argv[2]) : 16;
+    int seconds = argc > 3 ? atoi(argv[3]) : 3;
+    unsigned short port = argc > 4 ? (unsigned short)atoi(argv[4]) : 19480;
+    if (workers <= 0) workers = 1;
+    if (clients <= 0) clients = 1;
+    if (seconds <= 0) seconds = 1;
+
+    printf("workers: %d, clients: %d, %ds per engine\n", workers, clients, seconds);
+    run_mode("epoll", workers, clients, seconds, port);
+    run_mode("uring", workers, clients, seconds, (unsigned short)(port + 1));
+    return 0;
+}
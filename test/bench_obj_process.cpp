@@ -0,0 +1,132 @@
+// 事件循环开销基准：obj_process 每轮耗时 vs 已注册的空闲连接数
+// 每轮只有一个连接可读; 对照组模拟旧实现对 _obj_net_map 的全量扫描(含每轮 4 次 getenv)
+// 用法: ./bench_obj_process [loops] [max_idle_conns]
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "base_connect.h"
+#include "base_data_process.h"
+#include "common_obj_container.h"
+
+namespace {
+
+typedef base_connect<base_data_process> bench_connect;
+
+std::shared_ptr<base_net_obj> make_conn(common_obj_container & container, int fd)
+{
+    std::shared_ptr<bench_connect> conn = std::make_shared<bench_connect>(fd);
+    conn->set_process(new base_data_process(conn));
+    conn->set_net_container(&container);
+    return conn;
+}
+
+// 旧 obj_process 在进入 epoll_wait 之前对每个 real_net 对象做的工作
+uint32_t legacy_scan(std::unordered_map<uint32_t, std::shared_ptr<base_net_obj> > & net_map)
+{
+    uint64_t now = GetMilliSecond();
+    uint32_t idle_skip_ms = 0; if (const char* e = ::getenv("MYFRAME_IDLE_SKIP_MS")) { int v = atoi(e); if (v > 0) idle_skip_ms = (uint32_t)v; }
+    if (!idle_skip_ms) { const char* preset = ::getenv("MYFRAME_PERF_PRESET"); if (preset && (strcmp(preset, "0") != 0 && strcasecmp(preset, "false") != 0)) idle_skip_ms = 50; }
+    uint32_t idle_scan_max = 0; if (const char* s = ::getenv("MYFRAME_IDLE_SCAN_MAX")) { int v = atoi(s); if (v > 0) idle_scan_max = (uint32_t)v; }
+
+    uint32_t ticked = 0;
+    for (const auto & u : net_map)
+    {
+        bool active = u.second->wants_tick() || (idle_skip_ms && (now - u.second->last_active_ms() < idle_skip_ms));
+        if (!active && idle_scan_max) { active = true; --idle_scan_max; }
+        if (active || u.second->get_real_net())
+            ticked++;
+    }
+    return ticked;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    int loops = argc > 1 ? atoi(argv[1]) : 20000;
+    int max_conns = argc > 2 ? atoi(argv[2]) : 8000;
+    if (loops <= 0)
+        loops = 1;
+
+    // 每个连接占用两个 fd
+    struct rlimit rl;
+    if (!getrlimit(RLIMIT_NOFILE, &rl))
+    {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+        int cap = (int)((rl.rlim_cur - 64) / 2);
+        if (max_conns > cap)
+            max_conns = cap;
+    }
+
+    printf("loops: %d\n", loops);
+    // legacy 列 = 当前循环开销 + 旧实现额外的全量扫描
+    printf("%10s %18s %18s\n", "idle_conns", "ready-list ns/loop", "legacy ns/loop");
+
+    static const int counts[] = {0, 100, 1000, 4000, 8000, 20000, 50000};
+    for (int idle : counts)
+    {
+        if (idle > max_conns)
+            break;
+
+        common_obj_container container(0);
+        std::unordered_map<uint32_t, std::shared_ptr<base_net_obj> > legacy_map;
+        std::vector<int> peers;
+
+        for (int i = 0; i < idle; i++)
+        {
+            int sv[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0)
+            {
+                perror("socketpair");
+                return 1;
+            }
+            std::shared_ptr<base_net_obj> conn = make_conn(container, sv[0]);
+            legacy_map[conn->get_id()._id] = conn;
+            peers.push_back(sv[1]);
+        }
+
+        int active[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, active) < 0)
+        {
+            perror("socketpair");
+            return 1;
+        }
+        make_conn(container, active[0]);
+
+        // 每轮写一个字节, 保证 epoll_wait 立即返回, 测到的是循环本身的开销
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < loops; i++)
+        {
+            ssize_t r = write(active[1], "x", 1);
+            (void)r;
+            container.obj_process();
+        }
+        double ready_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / loops;
+
+        int scan_loops = loops < 2000 ? loops : 2000;
+        uint64_t sink = 0;
+        t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < scan_loops; i++)
+        {
+            sink += legacy_scan(legacy_map);
+        }
+        double legacy_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / scan_loops;
+
+        printf("%10d %18.0f %18.0f%s\n", idle, ready_ns, ready_ns + legacy_ns, sink == (uint64_t)-1 ? " " : "");
+
+        close(active[1]);
+        for (int fd : peers)
+            close(fd);
+    }
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+// 接收缓冲微基准：std::string(栈缓冲中转 + append + erase 前缀) vs recv_buffer(直接写入 + 移动读游标)
+// 模拟流水线请求: 每次 recv 到 32KB, 剩下半帧留到下一次
+// batch: 一次 process_recv_buf 消费所有完整帧; single: 每次只消费一帧(如 HTTP 每次处理一个请求), 循环调用到不够一帧
+// 用法: ./bench_recv_buffer [frame_size] [total_mb]
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "recv_buffer.h"
+
+namespace {
+
+const size_t CHUNK = 32768;
+
+// 模拟 process_recv_buf: 只消费完整的帧
+size_t parse_frames(const char * buf, size_t len, size_t frame, bool single, uint64_t & sum)
+{
+    size_t used = 0;
+    while (len - used >= frame)
+    {
+        sum += (unsigned char)buf[used];
+        used += frame;
+        if (single)
+            break;
+    }
+    return used;
+}
+
+double run_string(const std::vector<char> & src, size_t frame, bool single, uint64_t & sum)
+{
+    std::string rb;
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t off = 0; off < src.size(); off += CHUNK)
+    {
+        char t_buf[CHUNK];
+        size_t n = src.size() - off < CHUNK ? src.size() - off : CHUNK;
+        memcpy(t_buf, &src[off], n); // recv 到栈缓冲
+        rb.append(t_buf, n);
+        size_t p;
+        while ((p = parse_frames(rb.data(), rb.size(), frame, single, sum)) > 0)
+            rb.erase(0, p);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+double run_recv_buffer(const std::vector<char> & src, size_t frame, bool single, uint64_t & sum)
+{
+    myframe::recv_buffer rb;
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t off = 0; off < src.size(); off += CHUNK)
+    {
+        size_t n = src.size() - off < CHUNK ? src.size() - off : CHUNK;
+        rb.reserve(n);
+        memcpy(rb.write_ptr(), &src[off], n); // recv 直接写入
+        rb.commit(n);
+        size_t p;
+        while ((p = parse_frames(rb.data(), rb.size(), frame, single, sum)) > 0)
+            rb.consume(p);
+        rb.shrink();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    size_t frame = argc > 1 ? (size_t)atol(argv[1]) : 100;
+    size_t mb = argc > 2 ? (size_t)atol(argv[2]) : 512;
+    if (!frame) frame = 1;
+    if (!mb) mb = 1;
+
+    std::vector<char> src(mb * 1024 * 1024);
+    for (size_t i = 0; i < src.size(); i++)
+        src[i] = (char)(i * 131);
+
+    printf("frame: %zu bytes, %zu MB in %zu-byte reads\n", frame, mb, CHUNK);
+    for (int single = 0; single < 2; single++)
+    {
+        uint64_t s1 = 0, s2 = 0;
+        double t1 = run_string(src, frame, single, s1);
+        double t2 = run_recv_buffer(src, frame, single, s2);
+        const char * mode = single ? "single" : "batch";
+        printf("%-7s %-12s %10.1f MB/s\n", mode, "std::string", mb / t1);
+        printf("%-7s %-12s %10.1f MB/s\n", mode, "recv_buffer", mb / t2);
+        if (s1 != s2)
+            printf("checksum mismatch %llu != %llu\n", (unsigned long long)s1, (unsigned long long)s2);
+    }
+    return 0;
+}
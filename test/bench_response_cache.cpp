@@ -0,0 +1,137 @@
+// 响应缓存基准: 一个返回 JSON 行情快照的 on_http, 客户端都带 Accept-Encoding: gzip
+// handler: 每个请求生成 body、gzip 压缩、序列化响应头(没有缓存时的路径)
+// local:   组键 + 本线程缓存查找 + 拼状态行/Date/Connection, body 只增加引用计数
+// shared:  同上, 但本线程没有, 到进程内共享层(加锁)查
+// 用法: ./bench_response_cache [body_kb] [loops]
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <string>
+
+#include "http_response_cache.h"
+#include "http_response_head.h"
+#include "http_compress.h"
+#include "string_pool.h"
+
+using namespace myframe;
+
+namespace {
+
+std::string make_json(size_t bytes)
+{
+    std::string out = "{\"quotes\":[";
+    char item[160];
+    for (int i = 0; out.size() < bytes; i++)
+    {
+        snprintf(item, sizeof(item),
+                 "%s{\"symbol\":\"SYM%04d\",\"price\":%d.%02d,\"change\":%d.%02d,\"volume\":%d,\"exchange\":\"NASDAQ\"}",
+                 i ? "," : "", i, 100 + i % 900, i % 100, i % 7, (i * 13) % 100, 1000 + (i * 7919) % 1000000);
+        out += item;
+    }
+    out += "]}";
+    return out;
+}
+
+const std::string METHOD = "GET";
+const std::string HOST = "127.0.0.1:8080";
+const std::string URL = "/api/quotes?market=us";
+const std::string ACCEPT = "gzip, deflate, br";
+
+std::string_view request_header(std::string_view name)
+{
+    if (name.size() == 15 && strncasecmp(name.data(), "Accept-Encoding", 15) == 0)
+        return ACCEPT;
+    return std::string_view();
+}
+
+void on_http(size_t body_bytes, HttpResponse & res)
+{
+    res.set_json(make_json(body_bytes));
+    res.set_cache(1000000);
+    http_compress_response(ACCEPT, res);
+}
+
+// 命中时发出的两段: 新拼的头 + 共享的 tail
+size_t serve_hit(const http_cached_ptr & e)
+{
+    std::string scratch;
+    std::string_view line = http_status_line(e->status, e->reason, scratch);
+    std::string_view date = http_date_header();
+    std::string * head = string_acquire();
+    head->append(line.data(), line.size());
+    head->append(date.data(), date.size());
+    head->append("Connection: keep-alive\r\n", 24);
+    shared_buffer tail = e->tail;
+    size_t n = head->size() + tail->size();
+    string_release(head);
+    return n;
+}
+
+template <typename F>
+double run(int loops, F fn)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < loops; i++)
+        fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void report(const char * name, int loops, double ms, size_t bytes)
+{
+    printf("%-8s %9.2f ms  %9.3f us/req  %zu bytes/resp\n", name, ms, ms * 1000 / loops, bytes);
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    size_t body_kb = argc > 1 ? (size_t)atoi(argv[1]) : 8;
+    int loops = argc > 2 ? atoi(argv[2]) : 20000;
+    if (!body_kb) body_kb = 8;
+    if (loops <= 0) loops = 20000;
+    size_t body_bytes = body_kb * 1024;
+
+    http_response_cache_set(64 << 20, 64 << 20);
+    printf("body %zu bytes, compress level %d, loops %d\n", body_bytes, http_compress_level(), loops);
+
+    size_t bytes = 0;
+    int handler_loops = loops / 10 ? loops / 10 : 1;
+    double ms = run(handler_loops, [&]() {
+        HttpResponse res;
+        on_http(body_bytes, res);
+        std::string * head = http_response_head(res.status, res.reason, res.headers, (int64_t)res.body.size());
+        bytes = head->size() + res.body.size();
+        string_release(head);
+    });
+    report("handler", handler_loops, ms, bytes);
+
+    std::string key;
+    http_cache_key(METHOD, HOST, URL, key);
+    HttpResponse res;
+    on_http(body_bytes, res);
+    http_cached_ptr entry = http_cache_make_entry(res, request_header, 0);
+    http_response_cache::local().put(key, entry);
+
+    std::string lookup_key;
+    ms = run(loops, [&]() {
+        http_cache_key(METHOD, HOST, URL, lookup_key);
+        http_cached_ptr e;
+        if (http_response_cache::local().find(lookup_key, request_header, 1, e) == http_response_cache::FRESH)
+            bytes = serve_hit(e);
+    });
+    report("local", loops, ms, bytes);
+
+    http_response_cache::local().clear();
+    http_response_cache::shared().put(key, entry);
+    ms = run(loops, [&]() {
+        http_cache_key(METHOD, HOST, URL, lookup_key);
+        http_cached_ptr e;
+        if (http_response_cache::shared().find(lookup_key, request_header, 1, e) == http_response_cache::FRESH)
+            bytes = serve_hit(e);
+    });
+    report("shared", loops, ms, bytes);
+
+    http_cache_stats s = http_response_cache_stats();
+    printf("stores %llu, bytes %llu\n", (unsigned long long)s.stores, (unsigned long long)s.bytes);
+    return 0;
+}
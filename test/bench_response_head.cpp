@@ -0,0 +1,108 @@
+// HTTP/1.1 响应头序列化基准: hello-world 响应(Content-Type + Connection, 12 字节 body)
+// legacy:      旧 app_http_data_process 的拼法, to_string 补 Content-Length 进 map, new 一个 string 逐段 +=
+// legacy+date: 同上, 每次再用 SecToHttpTime(time()) 补一个 Date 头
+// writer:      myframe::http_response_head, 预拼状态行 + 线程缓存的 Date, 一次 reserve 写进池化缓冲
+// 用法: ./bench_response_head [loops]
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <map>
+#include <string>
+#include <time.h>
+
+#include "common_util.h"
+#include "http_response_head.h"
+#include "string_pool.h"
+
+namespace {
+
+const char BODY[] = "Hello World!";
+
+std::map<std::string, std::string> make_headers()
+{
+    std::map<std::string, std::string> h;
+    h["Content-Type"] = "text/plain";
+    h["Connection"] = "keep-alive";
+    return h;
+}
+
+std::string * legacy_head(int status, const std::string & reason, std::map<std::string, std::string> & headers,
+                          size_t body_len, bool date)
+{
+    if (headers.find("Content-Length") == headers.end())
+        headers["Content-Length"] = std::to_string(body_len);
+    if (date)
+        headers["Date"] = SecToHttpTime(time(NULL));
+
+    std::string * head = new std::string;
+    *head += "HTTP/1.1 ";
+    *head += std::to_string(status);
+    *head += " ";
+    *head += reason;
+    *head += "\r\n";
+    for (auto it = headers.begin(); it != headers.end(); ++it) {
+        *head += it->first; *head += ": "; *head += it->second; *head += "\r\n";
+    }
+    *head += "\r\n";
+    return head;
+}
+
+template <typename F>
+double run(int loops, uint64_t & bytes, F fn)
+{
+    bytes = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < loops; i++)
+        bytes += fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void report(const char * name, int loops, double ms, uint64_t bytes)
+{
+    printf("%-12s %10.2f ms  %8.1f ns/head  %6.1f Mheads/s  (%llu bytes)\n", name, ms, ms * 1e6 / loops,
+           loops / ms / 1000.0, (unsigned long long)bytes);
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    int loops = argc > 1 ? atoi(argv[1]) : 2000000;
+    if (loops <= 0) loops = 2000000;
+
+    const std::string reason = "OK";
+    const size_t body_len = sizeof(BODY) - 1;
+
+    std::string * sample = myframe::http_response_head(200, reason, make_headers(), (int64_t)body_len);
+    printf("loops: %d, head:\n%s", loops, sample->c_str());
+    myframe::string_release(sample);
+
+    uint64_t bytes;
+    double ms = run(loops, bytes, [&]() {
+        std::map<std::string, std::string> h = make_headers();
+        std::string * s = legacy_head(200, reason, h, body_len, false);
+        size_t n = s->size();
+        delete s;
+        return n;
+    });
+    report("legacy", loops, ms, bytes);
+
+    ms = run(loops, bytes, [&]() {
+        std::map<std::string, std::string> h = make_headers();
+        std::string * s = legacy_head(200, reason, h, body_len, true);
+        size_t n = s->size();
+        delete s;
+        return n;
+    });
+    report("legacy+date", loops, ms, bytes);
+
+    ms = run(loops, bytes, [&]() {
+        std::map<std::string, std::string> h = make_headers();
+        std::string * s = myframe::http_response_head(200, reason, h, (int64_t)body_len);
+        size_t n = s->size();
+        myframe::string_release(s);
+        return n;
+    });
+    report("writer", loops, ms, bytes);
+    return 0;
+}
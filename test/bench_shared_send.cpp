@@ -0,0 +1,186 @@
+// 共享发送基准: 同一份缓存的响应体(默认 64KB)发给大量连接
+// copy: 每个连接 put_send_copy 一份 body; shared: put_send_shared 只挂引用, writev 直接从共享缓冲区取数据
+// 每个连接另有一个独占的小响应头; 框架侧发送缓冲区压小并且入队完成后对端才开始读,
+// 模拟慢客户端: body 大部分留在发送队列里, 可以看到排队内存的差别; 之后由一个 epoll 线程读空
+// 用法: ./bench_shared_send [conns] [body_kb]
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "base_connect.h"
+#include "base_data_process.h"
+#include "common_obj_container.h"
+#include "send_slice.h"
+
+namespace {
+
+class bench_process : public base_data_process
+{
+    public:
+        bench_process(std::shared_ptr<base_net_obj> p) : base_data_process(p) {}
+
+        virtual size_t process_recv_buf(const char *, size_t len)
+        {
+            return len;
+        }
+};
+
+typedef base_connect<bench_process> bench_connect;
+
+size_t rss_kb()
+{
+    long pages = 0, resident = 0;
+    FILE * fp = fopen("/proc/self/statm", "r");
+    if (!fp)
+        return 0;
+    if (fscanf(fp, "%ld %ld", &pages, &resident) != 2)
+        resident = 0;
+    fclose(fp);
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE) / 1024;
+}
+
+// 每个连接两个 fd, 按 RLIMIT_NOFILE 收紧连接数
+int clamp_conns(int conns)
+{
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0)
+    {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+        getrlimit(RLIMIT_NOFILE, &rl);
+        int max = rl.rlim_cur > 128 ? (int)((rl.rlim_cur - 64) / 2) : 32;
+        if (conns > max)
+        {
+            printf("RLIMIT_NOFILE=%llu, conns clamped %d -> %d\n", (unsigned long long)rl.rlim_cur, conns, max);
+            conns = max;
+        }
+    }
+    return conns;
+}
+
+void run_mode(const char * name, bool shared, int conns, const std::string & body)
+{
+    std::vector<std::pair<int, int> > pairs;
+    for (int i = 0; i < conns; i++)
+    {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0)
+        {
+            perror("socketpair");
+            exit(1);
+        }
+        fcntl(sv[0], F_SETFL, fcntl(sv[0], F_GETFL) | O_NONBLOCK);
+        fcntl(sv[1], F_SETFL, fcntl(sv[1], F_GETFL) | O_NONBLOCK);
+        int sndbuf = 4096;
+        setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+        pairs.push_back(std::make_pair(sv[0], sv[1]));
+    }
+
+    common_obj_container container(0);
+    std::vector<std::shared_ptr<bench_connect> > objs;
+    for (auto & p : pairs)
+    {
+        std::shared_ptr<bench_connect> conn = std::make_shared<bench_connect>(p.first);
+        conn->set_process(new bench_process(conn));
+        conn->set_net_container(&container);
+        objs.push_back(conn);
+    }
+
+    char head[128];
+    int head_len = snprintf(head, sizeof(head), "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\n\r\n", body.size());
+    size_t total = (size_t)conns * (head_len + body.size());
+
+    // 共享模式下整个 body 只有这一份
+    myframe::shared_buffer cached = myframe::make_shared_buffer(body.data(), body.size());
+
+    size_t rss0 = rss_kb();
+    auto t0 = std::chrono::steady_clock::now();
+    for (auto & c : objs)
+    {
+        bench_process * p = c->process();
+        p->put_send_copy(std::string(head, head_len));
+        if (shared)
+            p->put_send_shared(cached);
+        else
+            p->put_send_copy(body);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    size_t rss1 = rss_kb();
+
+    std::atomic<size_t> peer_bytes(0);
+    std::thread drainer([&pairs, &peer_bytes, total]() {
+        int efd = epoll_create1(0);
+        for (auto & p : pairs)
+        {
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.fd = p.second;
+            epoll_ctl(efd, EPOLL_CTL_ADD, p.second, &ev);
+        }
+        std::vector<char> buf(256 * 1024);
+        struct epoll_event evs[256];
+        size_t done = 0;
+        while (done < total)
+        {
+            int n = epoll_wait(efd, evs, 256, 100);
+            for (int i = 0; i < n; i++)
+            {
+                ssize_t r;
+                while ((r = recv(evs[i].data.fd, buf.data(), buf.size(), 0)) > 0)
+                    done += r;
+            }
+            peer_bytes.store(done);
+        }
+        close(efd);
+    });
+
+    uint64_t loops = 0;
+    while (peer_bytes.load() < total)
+    {
+        container.obj_process();
+        loops++;
+    }
+    drainer.join();
+    auto t2 = std::chrono::steady_clock::now();
+
+    double enq_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    double all_ms = std::chrono::duration<double, std::milli>(t2 - t0).count();
+    printf("%-7s enqueue %8.1f ms  total %8.1f ms  %8.1f MB/s  queued rss +%7.1f MB  user copies %8.1f MB  %llu loops\n",
+            name, enq_ms, all_ms, total / (all_ms / 1000.0) / (1024.0 * 1024.0),
+            rss1 > rss0 ? (rss1 - rss0) / 1024.0 : 0.0,
+            shared ? 0.0 : (double)conns * body.size() / (1024.0 * 1024.0),
+            (unsigned long long)loops);
+
+    for (auto & p : pairs)
+        close(p.second);
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    int conns = argc > 1 ? atoi(argv[1]) : 10000;
+    size_t kb = argc > 2 ? (size_t)atoi(argv[2]) : 64;
+    if (conns <= 0)
+        conns = 1;
+    if (!kb)
+        kb = 1;
+    conns = clamp_conns(conns);
+
+    std::string body(kb * 1024, 'b');
+    printf("conns: %d, body: %zu KB\n", conns, kb);
+    // 先跑 shared: copy 模式释放的内存留在堆里, 会干扰后面的 rss 统计
+    run_mode("shared", true, conns, body);
+    run_mode("copy", false, conns, body);
+    return 0;
+}
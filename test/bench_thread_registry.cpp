@@ -0,0 +1,135 @@
+// 线程注册表基准: N 个生产者线程轮流向 M 个工作线程投递消息
+// mutex+map: 旧 put_obj_msg 的等价副本, 每条消息持全局 mutex 查 unordered_map 并投递
+// registry: 现在的 put_obj_msg, 按线程索引无锁查槽位
+// 用法: ./bench_thread_registry [producers] [workers] [msgs_per_producer]
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "base_net_thread.h"
+
+namespace {
+
+const int BENCH_MSG_OP = 0x7f02;
+
+class counting_thread : public base_net_thread
+{
+    public:
+        std::atomic<uint64_t> _received{0};
+
+    protected:
+        virtual bool handle_thread_msg(std::shared_ptr<normal_msg> & p_msg)
+        {
+            if (p_msg && p_msg->_msg_op == BENCH_MSG_OP)
+            {
+                _received.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            return false;
+        }
+};
+
+std::mutex legacy_mutex;
+std::unordered_map<uint32_t, base_net_thread *> legacy_map;
+
+void legacy_put_obj_msg(ObjId & id, std::shared_ptr<normal_msg> & p_msg)
+{
+    std::lock_guard<std::mutex> lock(legacy_mutex);
+    auto it = legacy_map.find(id._thread_index);
+    if (it == legacy_map.end() || !it->second)
+        return;
+    it->second->put_msg(id._id, p_msg);
+}
+
+uint64_t received(const std::vector<std::unique_ptr<counting_thread> > & workers)
+{
+    uint64_t n = 0;
+    for (auto & w : workers)
+        n += w->_received.load(std::memory_order_relaxed);
+    return n;
+}
+
+template <class SEND>
+double run(int producers, const std::vector<std::unique_ptr<counting_thread> > & workers, uint64_t per_producer, SEND send_one)
+{
+    uint64_t base = received(workers);
+    uint64_t total = per_producer * producers;
+    std::atomic<bool> go(false);
+    std::vector<std::thread> ths;
+    for (int p = 0; p < producers; p++)
+    {
+        ths.emplace_back([&, p]() {
+            std::vector<ObjId> ids(workers.size());
+            for (size_t w = 0; w < workers.size(); w++)
+            {
+                ids[w]._id = OBJ_ID_THREAD;
+                ids[w]._thread_index = workers[w]->get_thread_index();
+            }
+            while (!go.load()) {}
+            for (uint64_t i = 0; i < per_producer; i++)
+            {
+                std::shared_ptr<normal_msg> msg = std::make_shared<normal_msg>(BENCH_MSG_OP);
+                send_one(ids[(i + p) % ids.size()], msg);
+            }
+        });
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    go.store(true);
+    for (auto & t : ths)
+        t.join();
+    while (received(workers) - base < total)
+        std::this_thread::yield();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return total / sec;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    int producers = argc > 1 ? atoi(argv[1]) : 4;
+    int worker_num = argc > 2 ? atoi(argv[2]) : 4;
+    uint64_t per_producer = argc > 3 ? strtoull(argv[3], NULL, 10) : 200000;
+    if (producers <= 0)
+        producers = 1;
+    if (worker_num <= 0)
+        worker_num = 1;
+    if (!per_producer)
+        per_producer = 1;
+
+    std::vector<std::unique_ptr<counting_thread> > workers;
+    for (int i = 0; i < worker_num; i++)
+    {
+        workers.emplace_back(new counting_thread());
+        legacy_map[workers.back()->get_thread_index()] = workers.back().get();
+        workers.back()->start();
+    }
+
+    printf("producers: %d, workers: %d, msgs/producer: %llu\n", producers, worker_num, (unsigned long long)per_producer);
+
+    // 预热一轮(邮箱节点、消息分配), 两种方式都在同样的状态下计时
+    run(producers, workers, per_producer,
+            [](ObjId & id, std::shared_ptr<normal_msg> & msg) { base_net_thread::put_obj_msg(id, msg); });
+
+    double rate = run(producers, workers, per_producer,
+            [](ObjId & id, std::shared_ptr<normal_msg> & msg) { legacy_put_obj_msg(id, msg); });
+    printf("%-12s %12.0f msgs/sec\n", "mutex+map", rate);
+
+    rate = run(producers, workers, per_producer,
+            [](ObjId & id, std::shared_ptr<normal_msg> & msg) { base_net_thread::put_obj_msg(id, msg); });
+    printf("%-12s %12.0f msgs/sec\n", "registry", rate);
+
+    for (auto & w : workers)
+    {
+        w->stop();
+        w->join_thread();
+    }
+    return 0;
+}
@@ -0,0 +1,184 @@
+// 定时器微基准：分层时间轮(base_timer) vs 旧的 multimap 实现
+// 用法: ./bench_timer_wheel [timer_count]
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <map>
+#include <set>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <unistd.h>
+
+#include "base_timer.h"
+#include "common_obj_container.h"
+#include "common_util.h"
+
+namespace {
+
+// 旧实现的等价副本：multimap<到期时间, timer> + timer_id 集合
+// 旧版本没有取消接口，这里用 id -> iterator 索引模拟 O(log n) 的取消
+class multimap_timer
+{
+    public:
+        uint32_t add_timer(std::shared_ptr<timer_msg> & t_msg)
+        {
+            uint64_t reach_time = GetMilliSecond() + t_msg->_time_length;
+            do {
+                _timerid++;
+            } while (_timerid_set.count(_timerid));
+            _timerid_set.insert(_timerid);
+            t_msg->_timer_id = _timerid;
+            _index[_timerid] = _timer_list.insert(std::make_pair(reach_time, t_msg));
+            return _timerid;
+        }
+
+        bool cancel_timer(uint32_t timer_id)
+        {
+            auto it = _index.find(timer_id);
+            if (it == _index.end())
+                return false;
+            _timer_list.erase(it->second);
+            _timerid_set.erase(timer_id);
+            _index.erase(it);
+            return true;
+        }
+
+        size_t check_timer()
+        {
+            uint64_t now = GetMilliSecond();
+            size_t fired = 0;
+            auto it = _timer_list.begin();
+            while (it != _timer_list.end() && it->first <= now)
+            {
+                _timerid_set.erase(it->second->_timer_id);
+                _index.erase(it->second->_timer_id);
+                it = _timer_list.erase(it);
+                fired++;
+            }
+            return fired;
+        }
+
+        bool is_empty() { return _timer_list.empty(); }
+
+    private:
+        typedef std::multimap<uint64_t, std::shared_ptr<timer_msg> > timer_map;
+        timer_map _timer_list;
+        std::set<uint32_t> _timerid_set;
+        std::unordered_map<uint32_t, timer_map::iterator> _index;
+        uint32_t _timerid = TIMER_ID_BEGIN;
+};
+
+// 容器里不存在该 obj_id，handle_timeout 只做一次查找
+const uint32_t BENCH_OBJ_ID = 0x7ffffff0;
+
+std::vector<std::shared_ptr<timer_msg> > make_msgs(size_t n, uint32_t max_ms, uint32_t seed)
+{
+    std::vector<std::shared_ptr<timer_msg> > msgs;
+    msgs.reserve(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        std::shared_ptr<timer_msg> t(new timer_msg);
+        t->_obj_id = BENCH_OBJ_ID;
+        t->_timer_type = APPLICATION_TIMER_TYPE;
+        t->_time_length = 1 + common_random(&seed) % max_ms;
+        msgs.push_back(t);
+    }
+    return msgs;
+}
+
+double elapsed_ns(std::chrono::steady_clock::time_point begin)
+{
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin).count();
+}
+
+template <class ADD, class CANCEL, class CHECK, class EMPTY>
+void run_case(const char * name, size_t n, ADD add, CANCEL cancel, CHECK check, EMPTY empty)
+{
+    // 1. add: 长超时(类似连接空闲定时器)
+    std::vector<std::shared_ptr<timer_msg> > msgs = make_msgs(n, 60000, 7);
+    std::vector<uint32_t> ids(n);
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++)
+        ids[i] = add(msgs[i]);
+    double add_ns = elapsed_ns(t0);
+
+    // 2. cancel: 全部取消
+    t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++)
+        cancel(ids[i]);
+    double cancel_ns = elapsed_ns(t0);
+
+    // 3. churn: 每次活动都重置空闲定时器(取消 + 重新添加)
+    std::vector<std::shared_ptr<timer_msg> > live = make_msgs(n, 60000, 11);
+    for (size_t i = 0; i < n; i++)
+        ids[i] = add(live[i]);
+    uint32_t seed = 13;
+    size_t churn_ops = n * 4;
+    t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < churn_ops; i++)
+    {
+        size_t k = common_random(&seed) % n;
+        cancel(ids[k]);
+        ids[k] = add(live[k]);
+    }
+    double churn_ns = elapsed_ns(t0);
+    for (size_t i = 0; i < n; i++)
+        cancel(ids[i]);
+
+    // 4. expire: 短超时全部到期, 模拟事件循环每 1ms 检查一次, 只统计 check_timer 耗时
+    std::vector<std::shared_ptr<timer_msg> > shorts = make_msgs(n, 200, 17);
+    for (size_t i = 0; i < n; i++)
+        add(shorts[i]);
+    double check_ns = 0;
+    size_t rounds = 0;
+    while (!empty())
+    {
+        t0 = std::chrono::steady_clock::now();
+        check();
+        check_ns += elapsed_ns(t0);
+        rounds++;
+        usleep(1000);
+    }
+
+    printf("%-10s add %7.1f ns/op  cancel %7.1f ns/op  churn %7.1f ns/op  expire %7.1f ns/timer (%zu checks)\n",
+            name, add_ns / n, cancel_ns / n, churn_ns / churn_ops, check_ns / n, rounds);
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    size_t n = 100000;
+    if (argc > 1)
+    {
+        long v = atol(argv[1]);
+        if (v > 0)
+            n = (size_t)v;
+    }
+
+    printf("timers: %zu\n", n);
+
+    {
+        multimap_timer mt;
+        run_case("multimap", n,
+                [&](std::shared_ptr<timer_msg> & t) { return mt.add_timer(t); },
+                [&](uint32_t id) { mt.cancel_timer(id); },
+                [&]() { mt.check_timer(); },
+                [&]() { return mt.is_empty(); });
+    }
+
+    {
+        common_obj_container container(0);
+        base_timer * wheel = container.get_timer();
+        std::vector<uint32_t> expect_list;
+        run_case("wheel", n,
+                [&](std::shared_ptr<timer_msg> & t) { return wheel->add_timer(t); },
+                [&](uint32_t id) { wheel->cancel_timer(id); },
+                [&]() { wheel->check_timer(expect_list); },
+                [&]() { return wheel->is_empty(); });
+    }
+
+    return 0;
+}
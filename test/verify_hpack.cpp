@@ -0,0 +1,236 @@
+// HPACK 解码器校验: RFC 7541 附录 C 的请求/响应示例(含 Huffman), 逐块比对解出的头和动态表状态
+// 另有几条应当失败的输入(越界索引、块中间的表大小更新、超过上限的表大小), 以及编码器输出能否被解码器原样解出
+// 用法: ./verify_hpack, 全部通过返回 0
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "hpack.h"
+
+namespace {
+
+struct block_case
+{
+    const char * hex;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::vector<std::pair<std::string, std::string>> table;   // 新的在前
+    size_t table_size;
+};
+
+std::string unhex(const char * h)
+{
+    std::string out;
+    int hi = -1;
+    for (; *h; ++h)
+    {
+        int v;
+        if (*h >= '0' && *h <= '9') v = *h - '0';
+        else if (*h >= 'a' && *h <= 'f') v = *h - 'a' + 10;
+        else continue;
+        if (hi < 0) hi = v;
+        else { out.push_back((char)(hi << 4 | v)); hi = -1; }
+    }
+    return out;
+}
+
+int failures = 0;
+
+void check(bool ok, const char * what)
+{
+    if (!ok)
+    {
+        printf("FAIL %s\n", what);
+        failures++;
+    }
+}
+
+// 一组连续的块用同一个解码器(同一连接)
+void run_sequence(const char * name, size_t table_max, const std::vector<block_case> & blocks)
+{
+    hpack::Decoder dec(table_max);
+    for (size_t i = 0; i < blocks.size(); i++)
+    {
+        const block_case & c = blocks[i];
+        std::string raw = unhex(c.hex);
+        hpack::Decoder::HeaderList out;
+        char what[128];
+        snprintf(what, sizeof(what), "%s block %zu decode", name, i + 1);
+        if (!dec.decode((const unsigned char *)raw.data(), raw.size(), out))
+        {
+            check(false, what);
+            return;
+        }
+        snprintf(what, sizeof(what), "%s block %zu headers", name, i + 1);
+        check(out == c.headers, what);
+
+        const hpack::DynamicTable & t = dec.table();
+        bool same = t.count() == c.table.size();
+        for (size_t j = 0; same && j < t.count(); j++)
+            same = t.at(j).name == c.table[j].first && t.at(j).value == c.table[j].second;
+        snprintf(what, sizeof(what), "%s block %zu table", name, i + 1);
+        check(same && t.size() == c.table_size, what);
+    }
+    printf("%-28s %zu blocks\n", name, blocks.size());
+}
+
+bool decodes(hpack::Decoder & dec, const char * hex)
+{
+    std::string raw = unhex(hex);
+    hpack::Decoder::HeaderList out;
+    return dec.decode((const unsigned char *)raw.data(), raw.size(), out);
+}
+
+} // namespace
+
+int main()
+{
+    const std::pair<std::string, std::string> AUTH(":authority", "www.example.com");
+    const std::pair<std::string, std::string> NO_CACHE("cache-control", "no-cache");
+    const std::pair<std::string, std::string> CUSTOM("custom-key", "custom-value");
+
+    std::vector<block_case> requests = {
+        {"828684410f7777772e6578616d706c652e636f6d",
+         {{":method", "GET"}, {":scheme", "http"}, {":path", "/"}, AUTH},
+         {AUTH}, 57},
+        {"828684be58086e6f2d6361636865",
+         {{":method", "GET"}, {":scheme", "http"}, {":path", "/"}, AUTH, NO_CACHE},
+         {NO_CACHE, AUTH}, 110},
+        {"828785bf400a637573746f6d2d6b65790c637573746f6d2d76616c7565",
+         {{":method", "GET"}, {":scheme", "https"}, {":path", "/index.html"}, AUTH, CUSTOM},
+         {CUSTOM, NO_CACHE, AUTH}, 164},
+    };
+    // C.3 和 C.4 是同样的头, 只是字符串换成 Huffman
+    std::vector<block_case> requests_huffman = requests;
+    requests_huffman[0].hex = "828684418cf1e3c2e5f23a6ba0ab90f4ff";
+    requests_huffman[1].hex = "828684be5886a8eb10649cbf";
+    requests_huffman[2].hex = "828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf";
+    run_sequence("C.3 requests", 4096, requests);
+    run_sequence("C.4 requests (huffman)", 4096, requests_huffman);
+
+    const std::pair<std::string, std::string> S302(":status", "302");
+    const std::pair<std::string, std::string> S307(":status", "307");
+    const std::pair<std::string, std::string> PRIVATE("cache-control", "private");
+    const std::pair<std::string, std::string> DATE21("date", "Mon, 21 Oct 2013 20:13:21 GMT");
+    const std::pair<std::string, std::string> DATE22("date", "Mon, 21 Oct 2013 20:13:22 GMT");
+    const std::pair<std::string, std::string> LOCATION("location", "https://www.example.com");
+    const std::pair<std::string, std::string> GZIP("content-encoding", "gzip");
+    const std::pair<std::string, std::string> COOKIE("set-cookie", "foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1");
+
+    // 表上限 256, 第二、三块开始淘汰
+    std::vector<block_case> responses = {
+        {"4803333032580770726976617465611d4d6f6e2c203231204f637420323031332032303a31333a323120474d54"
+         "6e1768747470733a2f2f7777772e6578616d706c652e636f6d",
+         {S302, PRIVATE, DATE21, LOCATION},
+         {LOCATION, DATE21, PRIVATE, S302}, 222},
+        {"4803333037c1c0bf",
+         {S307, PRIVATE, DATE21, LOCATION},
+         {S307, LOCATION, DATE21, PRIVATE}, 222},
+        {"88c1611d4d6f6e2c203231204f637420323031332032303a31333a323220474d54c05a04677a69707738666f6f3d"
+         "4153444a4b48514b425a584f5157454f50495541585157454f49553b206d61782d6167653d333630303b2076657273696f6e3d31",
+         {{":status", "200"}, PRIVATE, DATE22, LOCATION, GZIP, COOKIE},
+         {COOKIE, GZIP, DATE22}, 215},
+    };
+    std::vector<block_case> responses_huffman = responses;
+    responses_huffman[0].hex = "488264025885aec3771a4b6196d07abe941054d444a8200595040b8166e082a62d1bff"
+                               "6e919d29ad171863c78f0b97c8e9ae82ae43d3";
+    responses_huffman[1].hex = "4883640effc1c0bf";
+    responses_huffman[2].hex = "88c16196d07abe941054d444a8200595040b8166e084a62d1bffc05a839bd9ab"
+                               "77ad94e7821dd7f2e6c7b335dfdfcd5b3960d5af27087f3672c1ab270fb5291f9587316065c003ed4ee5b1063d5007";
+    run_sequence("C.5 responses", 256, responses);
+    run_sequence("C.6 responses (huffman)", 256, responses_huffman);
+
+    {
+        hpack::Decoder dec;
+        check(!decodes(dec, "be"), "index past the dynamic table rejected");
+        check(!decodes(dec, "80"), "index 0 rejected");
+        check(!decodes(dec, "823f00"), "size update after a field rejected");
+        check(!decodes(dec, "3fe21f"), "size update above the limit rejected");
+        check(decodes(dec, "20"), "size update to 0 accepted");
+    }
+    {
+        // 上限 64 只放得下一条, 后加的把前面的挤掉; 大于上限的条目清空整个表
+        hpack::Decoder dec(64);
+        check(decodes(dec, "4001610161") && decodes(dec, "4001620162"), "small table adds");
+        check(dec.table().count() == 1 && dec.table().at(0).name == "b" && dec.table().size() == 34,
+              "small table evicts oldest");
+        std::string big(1, (char)0x40);
+        hpack::encode_string(big, "c", false);
+        hpack::encode_string(big, std::string(40, 'v'), false);
+        hpack::Decoder::HeaderList out;
+        check(dec.decode((const unsigned char *)big.data(), big.size(), out) && out.size() == 1,
+              "oversized entry decodes");
+        check(dec.table().count() == 0 && dec.table().size() == 0, "oversized entry empties table");
+    }
+    {
+        // 40 条让环形缓冲区扩容两次, 顺序不变; 再用表大小更新缩小, 留下的是最新的
+        hpack::Decoder dec;
+        std::string blk;
+        for (int i = 0; i < 40; i++)
+        {
+            blk.push_back((char)0x40);
+            hpack::encode_string(blk, "x-n" + std::to_string(i), false);
+            hpack::encode_string(blk, std::to_string(i), false);
+        }
+        hpack::Decoder::HeaderList out;
+        bool ok = dec.decode((const unsigned char *)blk.data(), blk.size(), out);
+        bool order = ok && dec.table().count() == 40;
+        for (size_t j = 0; order && j < 40; j++)
+            order = dec.table().at(j).value == std::to_string(39 - j);
+        check(order, "ring keeps newest-first order across growth");
+        check(decodes(dec, "3fc907") && dec.table().count() < 40 && dec.table().size() <= 1000
+              && dec.table().at(0).value == "39", "size update shrinks table");
+    }
+    {
+        // 编码器和解码器对打: 随机的一串响应头, 中途改对端表大小, 每块都要原样解出
+        static const char * const names[] = {":status", "content-type", "server", "cache-control", "vary",
+                                             "x-trace", "set-cookie", "authorization", "content-length", "date"};
+        static const char * const values[] = {"200", "404", "text/html", "application/json", "myframe",
+                                              "no-cache", "accept-encoding", "abc", "session=0123456789abcdef0123",
+                                              "Mon, 21 Oct 2013 20:13:21 GMT"};
+        hpack::Encoder enc;
+        hpack::Decoder dec;
+        unsigned seed = 1;
+        bool ok = true;
+        size_t raw = 0, coded = 0;
+        for (int b = 0; ok && b < 2000; b++)
+        {
+            if (b % 97 == 0)
+                enc.set_max_table_size(b % 3 == 0 ? 0 : (b % 3 == 1 ? 256 : 4096));
+            hpack::Decoder::HeaderList fields;
+            int n = 1 + b % 9;
+            for (int i = 0; i < n; i++)
+            {
+                seed = seed * 1103515245 + 12345;
+                std::string value = values[(seed >> 8) % 10];
+                if ((seed >> 20) % 5 == 0) value += std::to_string(b);
+                fields.emplace_back(names[(seed >> 16) % 10], value);
+                raw += fields.back().first.size() + fields.back().second.size();
+            }
+            std::string blk;
+            enc.begin_block(blk);
+            for (size_t i = 0; i < fields.size(); i++)
+                enc.encode(blk, fields[i].first, fields[i].second);
+            coded += blk.size();
+            hpack::Decoder::HeaderList out;
+            ok = dec.decode((const unsigned char *)blk.data(), blk.size(), out) && out == fields
+                 && dec.table().count() == enc.table().count() && dec.table().size() == enc.table().size();
+        }
+        check(ok, "encoder output decodes to the same fields and table");
+        printf("%-28s %zu -> %zu bytes\n", "encoder round trip", raw, coded);
+    }
+    {
+        // 敏感头不进表, 发成 Never Indexed(0001xxxx)
+        hpack::Encoder enc;
+        std::string blk;
+        enc.encode(blk, "authorization", "Bearer 0123456789abcdef");
+        check(!blk.empty() && (blk[0] & 0xf0) == 0x10 && enc.table().count() == 0, "authorization never indexed");
+    }
+
+    if (failures)
+    {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all HPACK checks passed\n");
+    return 0;
+}
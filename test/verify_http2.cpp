@@ -0,0 +1,541 @@
+// HTTP/2 连接校验: 不走网络, 把帧直接喂给 http2_process, 解析它写出的帧逐条比对
+// 流量控制: 连接窗口在 DATA 到达时就还, 暂停的 sink 只扣住自己流的窗口, 不挡同一连接上的其他流;
+//          RST_STREAM / 窗口超限不重复给连接记账, 重置后迟到的 DATA 只给连接记账
+// 收包: 同一串帧在任意字节处切成两次读(以及逐字节喂)得到的请求和输出都和一次读完一样; 含 HEADERS+CONTINUATION 带 END_STREAM
+// 连接错误: 超过 16384 的帧回 FRAME_SIZE_ERROR, 头块中间插进别的帧回 PROTOCOL_ERROR, 都带 GOAWAY 并抛异常
+// 帧顺序: 流的 END_STREAM / RST_STREAM 之后不再有这个流的 WINDOW_UPDATE
+// 压缩: 协商了 gzip 的拉取式响应, 每个 DATA 帧不超过帧大小上限, 解压后和原文一致(需要 zlib)
+// 用法: ./verify_http2, 全部通过返回 0
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "http2_process.h"
+#include "http2_frame.h"
+#include "hpack.h"
+#include "send_slice.h"
+
+using namespace myframe;
+using namespace h2;
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char * what)
+{
+    if (!ok)
+    {
+        printf("FAIL %s\n", what);
+        failures++;
+    }
+}
+
+struct frame
+{
+    uint8_t type;
+    uint8_t flags;
+    uint32_t sid;
+    std::string payload;
+};
+
+// sink 一个字节都不收, 流停在暂停状态
+struct stall_sink : HttpBodySink
+{
+    size_t on_body_chunk(const char *, size_t) override { return 0; }
+    void on_body_end(const HttpRequest &, HttpResponse & res) override { res.body = "done"; }
+};
+
+// 只收前 1000 字节, 之后停住
+struct half_sink : HttpBodySink
+{
+    size_t got = 0;
+    size_t on_body_chunk(const char *, size_t len) override
+    {
+        size_t n = got < 1000 ? (1000 - got < len ? 1000 - got : len) : 0;
+        got += n;
+        return n;
+    }
+    void on_body_end(const HttpRequest &, HttpResponse & res) override { res.body = "done"; }
+};
+
+// 压不动的伪随机字节: deflate 攒满一块才吐出, 一次吐出的常常比一次 pull 的 max 多
+std::string noise(size_t len, unsigned seed)
+{
+    std::string out;
+    for (size_t i = 0; i < len; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        out.push_back((char)(seed >> 16));
+    }
+    return out;
+}
+
+const std::string & gzip_body()
+{
+    static const std::string body = noise(256 * 1024, 1);
+    return body;
+}
+
+struct handler : IApplicationHandler
+{
+    size_t requests = 0;
+    std::vector<std::string> seen;   // "方法 路径 请求体长度"
+    void on_http(const HttpRequest & req, HttpResponse & res) override
+    {
+        requests++;
+        seen.push_back(req.method + " " + req.url + " " + std::to_string(req.body.size()));
+        if (req.url == "/gzip")
+        {
+            // 每次给满 max, 压缩后的输出常常比 max 多
+            size_t off = 0;
+            res.set_content_type("text/plain");
+            res.set_generator([off](std::string & out, size_t max) mutable {
+                const std::string & body = gzip_body();
+                size_t n = body.size() - off < max ? body.size() - off : max;
+                out.append(body, off, n);
+                off += n;
+                return off == body.size() ? HttpBodySource::DONE : HttpBodySource::MORE;
+            });
+            return;
+        }
+        res.body = "ok";
+    }
+    std::shared_ptr<HttpBodySink> on_body_begin(const HttpRequest & req) override
+    {
+        if (req.url == "/stall")
+            return std::make_shared<stall_sink>();
+        if (req.url == "/half")
+            return std::make_shared<half_sink>();
+        return nullptr;
+    }
+};
+
+std::string preface()
+{
+    return std::string(CONNECTION_PREFACE, CONNECTION_PREFACE_LEN) + make_settings_frame(false);
+}
+
+std::string request(hpack::Encoder & enc, uint32_t sid, const char * method, const char * path, bool end_stream,
+        const char * accept_encoding = NULL)
+{
+    std::string blk;
+    enc.begin_block(blk);
+    enc.encode(blk, ":method", method);
+    enc.encode(blk, ":scheme", "http");
+    enc.encode(blk, ":authority", "x");
+    enc.encode(blk, ":path", path);
+    if (accept_encoding)
+        enc.encode(blk, "accept-encoding", accept_encoding);
+    return make_frame_header((uint32_t)blk.size(), HEADERS, end_stream ? 0x5 : 0x4, sid) + blk;
+}
+
+// 头块拆成 HEADERS(带 END_STREAM, 不带 END_HEADERS) + 两个 CONTINUATION
+std::string continued_request(hpack::Encoder & enc, uint32_t sid, const char * path)
+{
+    std::string blk;
+    enc.begin_block(blk);
+    enc.encode(blk, ":method", "GET");
+    enc.encode(blk, ":scheme", "http");
+    enc.encode(blk, ":authority", "x");
+    enc.encode(blk, ":path", path);
+    enc.encode(blk, "user-agent", "verify_http2");
+    size_t a = blk.size() / 3, b = blk.size() * 2 / 3;
+    return make_frame_header((uint32_t)a, HEADERS, 0x1, sid) + blk.substr(0, a)
+         + make_frame_header((uint32_t)(b - a), CONTINUATION, 0, sid) + blk.substr(a, b - a)
+         + make_frame_header((uint32_t)(blk.size() - b), CONTINUATION, 0x4, sid) + blk.substr(b);
+}
+
+std::string data(uint32_t sid, size_t len, bool end_stream)
+{
+    return make_frame_header((uint32_t)len, DATA, end_stream ? 0x1 : 0, sid) + std::string(len, 'd');
+}
+
+// 和连接一样: 没消费的字节留着, 下次连同新数据一起给
+void feed(http2_process & p, std::string & pending, const std::string & in)
+{
+    pending += in;
+    size_t used = p.process_recv_buf(pending.data(), pending.size());
+    pending.erase(0, used);
+}
+
+std::vector<frame> drain(http2_process & p)
+{
+    std::string all;
+    send_slice s;
+    while (p.get_send_slice(s))
+        all.append(s.data(), s.size());
+    std::vector<frame> out;
+    size_t off = 0;
+    while (off + 9 <= all.size())
+    {
+        const unsigned char * q = (const unsigned char *)all.data() + off;
+        uint32_t len = read24(q);
+        out.push_back(frame{q[3], q[4], read32(q + 5) & 0x7fffffffu, all.substr(off + 9, len)});
+        off += 9 + len;
+    }
+    return out;
+}
+
+// sid 上 WINDOW_UPDATE 的增量之和
+uint32_t credit(const std::vector<frame> & frames, uint32_t sid)
+{
+    uint32_t sum = 0;
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        if (frames[i].type == WINDOW_UPDATE && frames[i].sid == sid)
+            sum += read32((const unsigned char *)frames[i].payload.data()) & 0x7fffffffu;
+    }
+    return sum;
+}
+
+bool has(const std::vector<frame> & frames, uint8_t type, uint32_t sid)
+{
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        if (frames[i].type == type && frames[i].sid == sid)
+            return true;
+    }
+    return false;
+}
+
+bool same(const std::vector<frame> & a, const std::vector<frame> & b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (a[i].type != b[i].type || a[i].flags != b[i].flags || a[i].sid != b[i].sid || a[i].payload != b[i].payload)
+            return false;
+    }
+    return true;
+}
+
+// GOAWAY 里的错误码, 没有 GOAWAY 时是 0xffffffff
+uint32_t goaway_code(const std::vector<frame> & frames)
+{
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        if (frames[i].type == GOAWAY && frames[i].payload.size() >= 8)
+            return read32((const unsigned char *)frames[i].payload.data() + 4);
+    }
+    return 0xffffffffu;
+}
+
+// sid 的 END_STREAM 或 RST_STREAM 之后还有这个流的 WINDOW_UPDATE
+bool credit_after_close(const std::vector<frame> & frames, uint32_t sid)
+{
+    bool closed = false;
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        if (frames[i].sid != sid)
+            continue;
+        if (closed && frames[i].type == WINDOW_UPDATE)
+            return true;
+        if (frames[i].type == RST_STREAM || ((frames[i].type == DATA || frames[i].type == HEADERS) && (frames[i].flags & 0x1)))
+            closed = true;
+    }
+    return false;
+}
+
+void flow_control()
+{
+    {
+        handler h;
+        http2_process p(nullptr, &h);
+        hpack::Encoder enc;
+        std::string rest;
+        feed(p, rest, preface() + request(enc, 1, "POST", "/stall", false) + data(1, 1000, false));
+        std::vector<frame> out = drain(p);
+        check(credit(out, 0) == 1000 && credit(out, 1) == 0, "paused sink holds only its stream window");
+
+        feed(p, rest, make_rst_stream(1, CANCEL));
+        out = drain(p);
+        check(credit(out, 0) == 0, "RST_STREAM does not credit the connection twice");
+        check(!has(out, WINDOW_UPDATE, 1), "no WINDOW_UPDATE for the reset stream");
+
+        // 对端发出 RST_STREAM 之前已在路上的 DATA: 丢掉, 只给连接记账
+        feed(p, rest, data(1, 500, true));
+        out = drain(p);
+        check(credit(out, 0) == 500 && !has(out, WINDOW_UPDATE, 1) && h.requests == 0,
+              "DATA after RST_STREAM credits the connection only");
+    }
+    {
+        handler h;
+        http2_process p(nullptr, &h);
+        hpack::Encoder enc;
+        std::string rest;
+        feed(p, rest, preface() + request(enc, 1, "POST", "/stall", false));
+        drain(p);
+        // 初始窗口 65535, 第五帧超出
+        for (int i = 0; i < 4; i++)
+            feed(p, rest, data(1, 16384, false));
+        feed(p, rest, data(1, 100, false));
+        std::vector<frame> out = drain(p);
+        bool rst = false;
+        for (size_t i = 0; i < out.size(); i++)
+        {
+            if (out[i].type == RST_STREAM && out[i].sid == 1)
+                rst = read32((const unsigned char *)out[i].payload.data()) == FLOW_CONTROL_ERROR;
+        }
+        check(rst, "window overrun resets the stream with FLOW_CONTROL_ERROR");
+        check(credit(out, 0) == 4 * 16384 + 100, "window overrun returns everything to the connection");
+        check(!has(out, WINDOW_UPDATE, 1), "no WINDOW_UPDATE for the overrun stream");
+    }
+    {
+        // 流 1 暂停并占满自己的窗口(65535), 流 3 照样能传完: 连接窗口没有跟着被扣住
+        handler h;
+        http2_process p(nullptr, &h);
+        hpack::Encoder enc;
+        std::string rest;
+        std::string in = preface() + request(enc, 1, "POST", "/stall", false);
+        for (int i = 0; i < 3; i++)
+            in += data(1, 16384, false);
+        in += data(1, 16383, false);
+        feed(p, rest, in);
+        std::vector<frame> out = drain(p);
+        check(credit(out, 0) == 65535 && credit(out, 1) == 0, "full paused stream leaves the connection window open");
+
+        feed(p, rest, request(enc, 3, "POST", "/echo", false) + data(3, 1000, false) + data(3, 0, true));
+        out = drain(p);
+        check(h.seen.size() == 1 && h.seen[0] == "POST /echo 1000" && has(out, DATA, 3),
+              "second stream uploads and finishes behind a paused one");
+        check(credit(out, 0) == 1000 && !has(out, WINDOW_UPDATE, 1), "paused stream still gets no credit");
+    }
+    printf("%-28s done\n", "flow control");
+}
+
+void split_reads()
+{
+    hpack::Encoder enc;
+    std::string in = preface();
+    in += request(enc, 1, "GET", "/a", true);
+    in += request(enc, 3, "POST", "/b", false) + data(3, 100, false) + data(3, 20, true);
+    in += make_frame_header(8, PING, 0, 0) + "pingpong";
+    in += continued_request(enc, 5, "/c");
+    const char * expect[] = {"GET /a 0", "POST /b 120", "GET /c 0"};
+
+    std::vector<frame> whole;
+    {
+        handler h;
+        http2_process p(nullptr, &h);
+        std::string rest;
+        feed(p, rest, in);
+        whole = drain(p);
+        bool ok = h.seen.size() == 3 && rest.empty();
+        for (size_t i = 0; ok && i < 3; i++)
+            ok = h.seen[i] == expect[i];
+        check(ok, "one read decodes every request, CONTINUATION included");
+        check(has(whole, DATA, 5) && has(whole, PING, 0), "continued request and PING answered");
+    }
+
+    size_t bad = 0;
+    for (size_t cut = 1; cut < in.size(); cut++)
+    {
+        handler h;
+        http2_process p(nullptr, &h);
+        std::string rest;
+        bool ok = true;
+        try
+        {
+            feed(p, rest, in.substr(0, cut));
+            feed(p, rest, in.substr(cut));
+        }
+        catch (const std::exception &)
+        {
+            ok = false;
+        }
+        ok = ok && h.seen.size() == 3 && rest.empty() && same(drain(p), whole);
+        for (size_t i = 0; ok && i < 3; i++)
+            ok = h.seen[i] == expect[i];
+        if (!ok)
+        {
+            if (!bad)
+                printf("  first bad split at byte %zu of %zu\n", cut, in.size());
+            bad++;
+        }
+    }
+    check(bad == 0, "split at any byte gives the same requests and frames");
+
+    {
+        // 逐字节喂: 每次读只多一个字节
+        handler h;
+        http2_process p(nullptr, &h);
+        std::string rest;
+        bool ok = true;
+        try
+        {
+            for (size_t i = 0; i < in.size(); i++)
+                feed(p, rest, in.substr(i, 1));
+        }
+        catch (const std::exception &)
+        {
+            ok = false;
+        }
+        check(ok && h.seen.size() == 3 && same(drain(p), whole), "byte-at-a-time reads give the same requests and frames");
+    }
+    printf("%-28s %zu split points\n", "split reads", in.size() - 1);
+}
+
+// 输入必须让连接出错: 抛异常, 并且先写出带 ec 的 GOAWAY
+void connection_error(const std::string & in, ErrorCode ec, const char * what)
+{
+    handler h;
+    http2_process p(nullptr, &h);
+    std::string rest;
+    bool thrown = false;
+    try
+    {
+        feed(p, rest, in);
+    }
+    catch (const std::exception &)
+    {
+        thrown = true;
+    }
+    check(thrown && goaway_code(drain(p)) == (uint32_t)ec, what);
+}
+
+void connection_errors()
+{
+    hpack::Encoder enc;
+    std::string blk;
+    enc.begin_block(blk);
+    enc.encode(blk, ":method", "GET");
+    enc.encode(blk, ":scheme", "http");
+    enc.encode(blk, ":authority", "x");
+    enc.encode(blk, ":path", "/");
+    // 头块没完(无 END_HEADERS)
+    std::string open = make_frame_header((uint32_t)blk.size(), HEADERS, 0x1, 1) + blk;
+
+    connection_error(preface() + make_frame_header(16385, DATA, 0, 1) + std::string(16385, 'd'),
+                     FRAME_SIZE_ERROR, "frame above 16384 bytes is FRAME_SIZE_ERROR");
+    // 只到帧头就该报错, 不等整帧到齐
+    connection_error(preface() + make_frame_header(1 << 20, DATA, 0, 1),
+                     FRAME_SIZE_ERROR, "oversize frame header alone is FRAME_SIZE_ERROR");
+    connection_error(preface() + open + make_frame_header(8, PING, 0, 0) + "pingpong",
+                     PROTOCOL_ERROR, "frame inside a header block is PROTOCOL_ERROR");
+    connection_error(preface() + open + make_frame_header(0, CONTINUATION, 0x4, 3),
+                     PROTOCOL_ERROR, "CONTINUATION on another stream is PROTOCOL_ERROR");
+    connection_error(preface() + make_frame_header(0, CONTINUATION, 0x4, 1),
+                     PROTOCOL_ERROR, "CONTINUATION without HEADERS is PROTOCOL_ERROR");
+    printf("%-28s done\n", "connection errors");
+}
+
+void frame_order()
+{
+    {
+        // 请求体和响应在同一次读里处理完: 流的额度不能写在响应的 END_STREAM 后面
+        handler h;
+        http2_process p(nullptr, &h);
+        hpack::Encoder enc;
+        std::string rest;
+        feed(p, rest, preface() + request(enc, 1, "POST", "/echo", false) + data(1, 100, false) + data(1, 0, true));
+        std::vector<frame> out = drain(p);
+        check(h.requests == 1 && has(out, DATA, 1), "buffered POST answered");
+        check(!credit_after_close(out, 1), "no WINDOW_UPDATE after END_STREAM");
+        check(credit(out, 0) == 100, "connection still credited for the body");
+    }
+    {
+        // sink 收了一部分(流额度已排队), 随后窗口超限被重置
+        handler h;
+        http2_process p(nullptr, &h);
+        hpack::Encoder enc;
+        std::string rest;
+        std::string in = preface() + request(enc, 1, "POST", "/half", false);
+        for (int i = 0; i < 5; i++)
+            in += data(1, 16384, false);
+        feed(p, rest, in);
+        std::vector<frame> out = drain(p);
+        check(has(out, RST_STREAM, 1), "overrun stream reset");
+        check(!credit_after_close(out, 1), "no WINDOW_UPDATE after RST_STREAM");
+    }
+    printf("%-28s done\n", "frame order");
+}
+
+void gzip_stream()
+{
+#ifdef HAVE_ZLIB
+    handler h;
+    http2_process p(nullptr, &h);
+    hpack::Encoder enc;
+    std::string rest;
+    const std::string & body = gzip_body();
+
+    // 窗口开大, 一次取完
+    std::string in = preface() + make_window_update(0, 1 << 24) + request(enc, 1, "GET", "/gzip", true, "gzip");
+    in += make_window_update(1, 1 << 24);
+    std::vector<frame> out;
+    try
+    {
+        feed(p, rest, in);
+        out = drain(p);
+    }
+    catch (const std::exception & e)
+    {
+        printf("  %s\n", e.what());
+        check(false, "gzip stream sent without a connection error");
+        return;
+    }
+
+    hpack::Decoder dec;
+    bool gzip = false, oversize = false, ended = false;
+    std::string packed;
+    for (size_t i = 0; i < out.size(); i++)
+    {
+        if (out[i].type == HEADERS && out[i].sid == 1)
+        {
+            hpack::Decoder::HeaderList fields;
+            dec.decode((const unsigned char *)out[i].payload.data(), out[i].payload.size(), fields);
+            for (size_t k = 0; k < fields.size(); k++)
+                gzip = gzip || (fields[k].first == "content-encoding" && fields[k].second == "gzip");
+        }
+        if (out[i].type == DATA && out[i].sid == 1)
+        {
+            oversize = oversize || out[i].payload.size() > 16384;
+            ended = (out[i].flags & 0x1) != 0;   // END_STREAM
+            packed += out[i].payload;
+        }
+    }
+    check(gzip, "streamed response negotiated gzip");
+    check(!oversize, "no DATA frame above SETTINGS_MAX_FRAME_SIZE");
+    check(ended, "stream ends with END_STREAM");
+
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    std::string plain(body.size() + 1, '\0');
+    inflateInit2(&z, 16 + MAX_WBITS);
+    z.next_in = (Bytef *)&packed[0];
+    z.avail_in = (uInt)packed.size();
+    z.next_out = (Bytef *)&plain[0];
+    z.avail_out = (uInt)plain.size();
+    int ret = inflate(&z, Z_FINISH);
+    plain.resize(plain.size() - z.avail_out);
+    inflateEnd(&z);
+    check(ret == Z_STREAM_END && plain == body, "gzip stream inflates to the original body");
+    printf("%-28s %zu -> %zu bytes\n", "gzip stream", body.size(), packed.size());
+#endif
+}
+
+} // namespace
+
+int main()
+{
+    split_reads();
+    connection_errors();
+    flow_control();
+    frame_order();
+    gzip_stream();
+
+    if (failures)
+    {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all HTTP/2 checks passed\n");
+    return 0;
+}